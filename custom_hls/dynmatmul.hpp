@@ -0,0 +1,122 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef DYNMATMUL_HPP
+#define DYNMATMUL_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Multiplies two dynamic operands streamed in as activations:
+ *   out[r] = in0[r] x in1[r],  in0[r]: M x K,  in1[r]: K x N
+ *
+ * For every repetition r, the K x N operand on in1 is first captured into an
+ * on-chip buffer laid out for PE x SIMD parallel access. The M x K operand is
+ * then streamed row by row through the buffer, SIMD inputs per cycle, producing
+ * N/PE output words per row with PE accumulators each.
+ *
+ * in1 is expected row-major (k outer, n inner) with PE elements per word.
+ * The buffer is owned by the caller so that its partitioning and storage
+ * binding can be set next to its declaration.
+ */
+template<
+	unsigned K, unsigned N, unsigned M,
+	unsigned SIMD, unsigned PE, unsigned NumReps,
+	typename TA, typename TB, typename TO
+>
+void StreamingDynMatMul(
+	hls::stream<ap_uint<SIMD*TA::width>> &in0,
+	hls::stream<ap_uint<PE*TB::width>>   &in1,
+	hls::stream<ap_uint<PE*TO::width>>   &out,
+	TB  buf[PE][SIMD][(K/SIMD)*(N/PE)]
+) {
+	static_assert(K%SIMD == 0, "SIMD must divide K.");
+	static_assert(N%PE == 0, "PE must divide N.");
+	constexpr unsigned  SF = K/SIMD;
+	constexpr unsigned  NF = N/PE;
+	constexpr unsigned  AW = TA::width;
+	constexpr unsigned  BW = TB::width;
+	constexpr unsigned  OW = TO::width;
+
+	ap_uint<SIMD*AW>  row[SF];
+
+	for(unsigned  r = 0; r < NumReps; r++) {
+		// Capture the buffered operand
+		for(unsigned  i = 0; i < K*NF; i++) {
+#pragma HLS pipeline II=1 style=flp
+			unsigned const  k  = i / NF;
+			unsigned const  nf = i % NF;
+			ap_uint<PE*BW> const  w = in1.read();
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				ap_uint<BW> const  bits = w((pe+1)*BW-1, pe*BW);
+				buf[pe][k%SIMD][nf*SF + k/SIMD] = *reinterpret_cast<TB const*>(&bits);
+			}
+		}
+
+		// Stream the other operand against it
+		unsigned  nf = 0;
+		unsigned  sf = 0;
+		TO  acc[PE];
+#pragma HLS array_partition variable=acc complete dim=1
+		for(unsigned  i = 0; i < M*NF*SF; i++) {
+#pragma HLS pipeline II=1 style=flp
+			// each input row is read once and reused for all NF output folds
+			if(nf == 0)  row[sf] = in0.read();
+			ap_uint<SIMD*AW> const  a = row[sf];
+
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				TO  sum = (sf == 0)? TO(0) : acc[pe];
+				for(unsigned  s = 0; s < SIMD; s++) {
+#pragma HLS unroll
+					ap_uint<AW> const  abits = a((s+1)*AW-1, s*AW);
+					TA const  av = *reinterpret_cast<TA const*>(&abits);
+					sum += av * buf[pe][s][nf*SF + sf];
+				}
+				acc[pe] = sum;
+			}
+
+			if(++sf == SF) {
+				ap_uint<PE*OW>  y;
+				for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+					y((pe+1)*OW-1, pe*OW) = ap_uint<OW>(acc[pe]);
+				}
+				out.write(y);
+				sf = 0;
+				if(++nf == NF)  nf = 0;
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,123 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef LAYERNORM_HPP
+#define LAYERNORM_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Integer layer normalization (without affine part) over rows of NumChannels:
+ *   out[c] = clip(round(2^FracBits * (x[c] - mean) / sqrt(var + eps)))
+ *
+ * All row statistics are kept exact in integers: with S = sum(x) and
+ * Q = sum(x^2), the normalized value is (C*x - S) / sqrt(C*Q - S^2 + EpsTerm),
+ * where EpsTerm = round(C^2 * eps). The reciprocal square root of the (large)
+ * denominator is taken from a table indexed by its TableBits leading bits after
+ * an even normalization shift, so that the shift can be halved exactly.
+ * rsqrt_table[m] holds round(2^RsBits / sqrt(m)).
+ */
+template<
+	unsigned NumChannels, unsigned PE, unsigned NumReps,
+	unsigned TableBits, unsigned RsBits, unsigned FracBits,
+	unsigned long long EpsTerm,
+	typename TI, typename TO
+>
+void StreamingLayerNorm(
+	hls::stream<ap_uint<PE*TI::width>> &in,
+	hls::stream<ap_uint<PE*TO::width>> &out,
+	ap_uint<RsBits+1> const  rsqrt_table[1<<TableBits]
+) {
+	static_assert(NumChannels%PE == 0, "PE must divide NumChannels.");
+	static_assert(RsBits > FracBits, "RsBits must exceed FracBits for rounding.");
+	constexpr unsigned  NF = NumChannels/PE;
+	constexpr unsigned  IW = TI::width;
+	constexpr unsigned  OW = TO::width;
+	ap_int<64> const  OMIN = -(ap_int<64>(1) << (OW-1));
+	ap_int<64> const  OMAX =  (ap_int<64>(1) << (OW-1)) - 1;
+
+	ap_uint<PE*IW>  buf[NF];
+
+	for(unsigned  r = 0; r < NumReps; r++) {
+		// Pass 1: buffer the row and accumulate its sum and sum of squares
+		ap_int<64>   sum = 0;
+		ap_uint<64>  sumsq = 0;
+		for(unsigned  nf = 0; nf < NF; nf++) {
+#pragma HLS pipeline II=1 style=flp
+			ap_uint<PE*IW> const  x = in.read();
+			buf[nf] = x;
+			ap_int<64>   psum = 0;
+			ap_uint<64>  psumsq = 0;
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				ap_uint<IW> const  bits = x((pe+1)*IW-1, pe*IW);
+				TI const  v = *reinterpret_cast<TI const*>(&bits);
+				psum   += v;
+				psumsq += v*v;
+			}
+			sum   += psum;
+			sumsq += psumsq;
+		}
+
+		// Row statistics: C^2 * (var + eps) and its table-based rsqrt
+		ap_int<64> const   cvar = ap_int<64>(NumChannels)*ap_int<64>(sumsq) - sum*sum;
+		ap_uint<64> const  den = ap_uint<64>(cvar) + EpsTerm;
+		unsigned  k = 0;
+		if(den != 0) {
+			unsigned const  msb = 63 - den.countLeadingZeros();
+			if(msb >= TableBits)  k = msb - (TableBits-1);
+			k += k & 1;
+		}
+		ap_uint<TableBits> const  m = den >> k;
+		ap_uint<RsBits+1> const  rs = rsqrt_table[m];
+		unsigned const  shift = RsBits + k/2 - FracBits;
+
+		// Pass 2: normalize
+		for(unsigned  nf = 0; nf < NF; nf++) {
+#pragma HLS pipeline II=1 style=flp
+			ap_uint<PE*IW> const  x = buf[nf];
+			ap_uint<PE*OW>  y;
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				ap_uint<IW> const  bits = x((pe+1)*IW-1, pe*IW);
+				TI const  v = *reinterpret_cast<TI const*>(&bits);
+				ap_int<64> const  c = ap_int<64>(NumChannels)*v - sum;
+				ap_int<64>  q = (c*rs + (ap_int<64>(1) << (shift-1))) >> shift;
+				if(q < OMIN)  q = OMIN;
+				if(q > OMAX)  q = OMAX;
+				y((pe+1)*OW-1, pe*OW) = q(OW-1, 0);
+			}
+			out.write(y);
+		}
+	}
+}
+
+#endif
@@ -104,4 +104,49 @@ void StreamingLookup_ext(
 	oob_count =  oob_count_int;
 	oob_irq   = (oob_count_int != 0);
 }
+/**
+ * Elementwise table lookup over a folded, PE-parallel stream.
+ *
+ * Each of the PE lanes owns a private copy of its part of the table so that
+ * all PE lookups of an input word complete in the same cycle. The table is
+ * organized as [PE][NF][NumEntries] with NF = NumChannels/PE and is indexed
+ * by the offset of the input value from the smallest representable input,
+ * i.e. by the raw input bits with the sign bit flipped for signed inputs.
+ */
+template <
+	unsigned  NumChannels,	// number of channels, each may have its own table
+	unsigned  PE,			// number of parallel lookups per cycle
+	unsigned  NumReps,		// number of vectors (pixels) per frame
+	bool      InputSigned,	// whether InputType is a signed type
+	typename  InputType,	// ap_(u)int type of a single input element
+	typename  OutputType,	// ap_(u)int type of a single output element
+	unsigned  NumEntries = 1 << InputType::width
+>
+void StreamingLookupActivation(
+	hls::stream<ap_uint<PE*InputType::width>>  &in,
+	hls::stream<ap_uint<PE*OutputType::width>> &out,
+	OutputType const  table[PE][NumChannels/PE][NumEntries]
+) {
+	static_assert(NumChannels%PE == 0, "PE must divide NumChannels.");
+	constexpr unsigned  NF = NumChannels/PE;
+	constexpr unsigned  IW = InputType::width;
+	constexpr unsigned  OW = OutputType::width;
+
+	unsigned  nf = 0;
+	for(unsigned  i = 0; i < NumReps*NF; i++) {
+#pragma HLS pipeline II=1 style=flp
+		ap_uint<PE*IW> const  x = in.read();
+		ap_uint<PE*OW>  y;
+		for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+			ap_uint<IW>  idx = x((pe+1)*IW-1, pe*IW);
+			if(InputSigned)  idx[IW-1] = !idx[IW-1];
+			OutputType const  v = table[pe][nf][idx];
+			y((pe+1)*OW-1, pe*OW) = ap_uint<OW>(v);
+		}
+		out.write(y);
+		if(++nf == NF)  nf = 0;
+	}
+}
+
 #endif
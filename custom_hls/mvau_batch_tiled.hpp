@@ -0,0 +1,132 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef MVAU_BATCH_TILED_HPP
+#define MVAU_BATCH_TILED_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Matrix-vector-activation unit with batch-tiled weight reuse:
+ *   out[r] = activation(W x in[r])
+ *
+ * The input vectors are processed in groups of up to Reuse vectors. Within a
+ * group, the loop over the MH/PE neuron folds is the outermost one so that each
+ * weight tile (SF words of PE x SIMD weights) is held against all vectors of the
+ * group before the next tile is consumed. The weight stream is hence expected
+ * as: for each group, for each neuron fold, the tile repeated once per vector of
+ * the group. This is the order produced by WeightTileReplay and lets the weights
+ * be fetched once per group rather than once per vector.
+ *
+ * The input vectors of a group are captured during the first neuron fold. The
+ * results are collected on chip and emitted vector by vector once the group
+ * is complete, which costs NF extra cycles per vector.
+ */
+template<
+	unsigned MW, unsigned MH, unsigned SIMD, unsigned PE, unsigned Reuse,
+	typename TI, typename TW, typename TO, typename TA
+>
+void Matrix_Vector_Activate_Stream_BatchTiled(
+	hls::stream<ap_uint<SIMD*TI::width>>     &in,
+	hls::stream<ap_uint<PE*TO::width>>       &out,
+	hls::stream<ap_uint<PE*SIMD*TW::width>>  &weights,
+	TA const &activation,
+	unsigned const  reps
+) {
+	static_assert(MW%SIMD == 0, "SIMD must divide MW.");
+	static_assert(MH%PE == 0, "PE must divide MH.");
+	static_assert(Reuse > 0, "Groups must not be empty.");
+	constexpr unsigned  SF = MW/SIMD;
+	constexpr unsigned  NF = MH/PE;
+	constexpr unsigned  IW = TI::width;
+	constexpr unsigned  WW = TW::width;
+	constexpr unsigned  OW = TO::width;
+
+	ap_uint<SIMD*IW>  inBuf[Reuse][SF];
+	ap_uint<PE*OW>    outBuf[Reuse][NF];
+	decltype(activation.init(0,0))  acc[PE];
+#pragma HLS array_partition variable=acc complete dim=1
+
+	for(unsigned  base = 0; base < reps; base += Reuse) {
+		unsigned const  group = (reps-base < Reuse)? reps-base : Reuse;
+
+		// Hold every weight tile against all vectors of the group
+		unsigned  nf = 0;
+		unsigned  r  = 0;
+		unsigned  sf = 0;
+		for(unsigned  i = 0; i < NF*group*SF; i++) {
+#pragma HLS pipeline II=1 style=flp
+			ap_uint<SIMD*IW>  a;
+			if(nf == 0) {
+				a = in.read();
+				inBuf[r][sf] = a;
+			}
+			else  a = inBuf[r][sf];
+			ap_uint<PE*SIMD*WW> const  w = weights.read();
+
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				auto  sum = (sf == 0)? activation.init(nf, pe) : acc[pe];
+				for(unsigned  s = 0; s < SIMD; s++) {
+#pragma HLS unroll
+					ap_uint<IW> const  abits = a((s+1)*IW-1, s*IW);
+					ap_uint<WW> const  wbits = w((pe*SIMD+s+1)*WW-1, (pe*SIMD+s)*WW);
+					TI const  av = *reinterpret_cast<TI const*>(&abits);
+					TW const  wv = *reinterpret_cast<TW const*>(&wbits);
+					sum += av * wv;
+				}
+				acc[pe] = sum;
+			}
+
+			if(++sf == SF) {
+				ap_uint<PE*OW>  y;
+				for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+					y((pe+1)*OW-1, pe*OW) = ap_uint<OW>(activation.activate(nf, pe, acc[pe]));
+				}
+				outBuf[r][nf] = y;
+				sf = 0;
+				if(++r == group) {
+					r = 0;
+					nf++;
+				}
+			}
+		}
+
+		// Emit the results of the group vector by vector
+		for(unsigned  i = 0; i < group*NF; i++) {
+#pragma HLS pipeline II=1 style=flp
+			out.write(outBuf[i/NF][i%NF]);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef SOFTMAX_HPP
+#define SOFTMAX_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Integer softmax over rows of NumChannels elements:
+ *   out[c] = min(round(2^OW * e[c] / sum(e)), 2^OW-1),  e[c] = exp_table[max(x) - x[c]]
+ *
+ * exp_table[d] holds round(2^ExpBits * exp(-scale*d)) so that e[c] is a fixed-point
+ * value in [0, 1] with ExpBits fractional bits. Each row is read into a buffer
+ * (tracking its maximum), converted to exponentials (accumulating their sum), and
+ * finally normalized using a single reciprocal per row.
+ */
+template<
+	unsigned NumChannels, unsigned PE, unsigned NumReps,
+	unsigned ExpBits,
+	typename TI, typename TO
+>
+void StreamingSoftmax(
+	hls::stream<ap_uint<PE*TI::width>> &in,
+	hls::stream<ap_uint<PE*TO::width>> &out,
+	ap_uint<ExpBits+1> const  exp_table[PE][1<<TI::width]
+) {
+	static_assert(NumChannels%PE == 0, "PE must divide NumChannels.");
+	constexpr unsigned  NF = NumChannels/PE;
+	constexpr unsigned  IW = TI::width;
+	constexpr unsigned  OW = TO::width;
+	constexpr unsigned  RB = 32;	// fractional bits of the reciprocal
+
+	ap_uint<PE*IW>  buf[NF];
+	ap_uint<ExpBits+1>  ebuf[NF][PE];
+#pragma HLS array_partition variable=ebuf complete dim=2
+
+	for(unsigned  r = 0; r < NumReps; r++) {
+		// Pass 1: buffer the row and find its maximum
+		TI  mx = (TI(-1) < 0)? TI(ap_int<IW>(1) << (IW-1)) : TI(0);
+		for(unsigned  nf = 0; nf < NF; nf++) {
+#pragma HLS pipeline II=1 style=flp
+			ap_uint<PE*IW> const  x = in.read();
+			buf[nf] = x;
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				ap_uint<IW> const  bits = x((pe+1)*IW-1, pe*IW);
+				TI const  v = *reinterpret_cast<TI const*>(&bits);
+				if(v > mx)  mx = v;
+			}
+		}
+
+		// Pass 2: look up exponentials and accumulate their sum
+		ap_uint<64>  sum = 0;
+		for(unsigned  nf = 0; nf < NF; nf++) {
+#pragma HLS pipeline II=1 style=flp
+			ap_uint<PE*IW> const  x = buf[nf];
+			ap_uint<64>  psum = 0;
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				ap_uint<IW> const  bits = x((pe+1)*IW-1, pe*IW);
+				TI const  v = *reinterpret_cast<TI const*>(&bits);
+				ap_uint<IW> const  d = mx - v;
+				ap_uint<ExpBits+1> const  e = exp_table[pe][d];
+				ebuf[nf][pe] = e;
+				psum += e;
+			}
+			sum += psum;
+		}
+
+		// Pass 3: normalize with one reciprocal per row
+		// sum >= exp_table[0] = 2^ExpBits since the maximum contributes d = 0
+		ap_uint<RB+1> const  rcp = (ap_uint<RB+1>(1) << RB) / sum;
+		for(unsigned  nf = 0; nf < NF; nf++) {
+#pragma HLS pipeline II=1 style=flp
+			ap_uint<PE*OW>  y;
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				ap_uint<64>  q = ((ap_uint<64>(ebuf[nf][pe]) * rcp << OW) + (ap_uint<64>(1) << (RB-1))) >> RB;
+				if(q > (ap_uint<64>(1) << OW) - 1)  q = (ap_uint<64>(1) << OW) - 1;
+				y((pe+1)*OW-1, pe*OW) = q(OW-1, 0);
+			}
+			out.write(y);
+		}
+	}
+}
+
+#endif
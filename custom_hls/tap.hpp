@@ -0,0 +1,259 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef TAP_HPP
+#define TAP_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Word of a captured frame tagged with its position within the frame and
+ * the sequence number of the capture it belongs to.
+ */
+template<typename T>
+struct TapWord {
+	T            data;
+	ap_uint<32>  idx;
+	ap_uint<8>   seq;
+};
+
+/**
+ * End marker of a captured frame: the number of words queued for it.
+ */
+struct TapEnd {
+	ap_uint<32>  words;
+	ap_uint<8>   seq;
+};
+
+/**
+ * Forwards a stream of frames of N words and offers the words of selected
+ * frames to a capture queue.
+ *	- A frame is selected every `period` frames (0 disables sampling) and
+ *	  whenever `trigger` has changed its value since the previous frame.
+ *	- Captured words and the end marker of a captured frame are offered to
+ *	  `cap` and `end` by non-blocking writes so that the forwarded stream is
+ *	  never held up by the capture path. A selected frame that does not fit
+ *	  into the queues is counted in `dropped`.
+ */
+template<
+	unsigned N,	// number of data words in a frame
+	typename T	// type of stream-carried data words
+>
+void tap_forward(
+	hls::stream<T> &src,
+	hls::stream<T> &dst,
+	hls::stream<TapWord<T>> &cap,
+	hls::stream<TapEnd> &end,
+	ap_uint<32> const  period,
+	ap_uint<32> const  trigger,
+	ap_uint<32>       &dropped
+) {
+	static ap_uint<32>  phase = 0;
+	static ap_uint<32>  trigger_seen = 0;
+	static ap_uint<32>  lost = 0;
+	static ap_uint<8>   seq = 0;
+#pragma HLS reset variable=phase
+#pragma HLS reset variable=trigger_seen
+#pragma HLS reset variable=lost
+#pragma HLS reset variable=seq
+
+	bool const  take = ((period != 0) && (phase == 0)) || (trigger != trigger_seen);
+	trigger_seen = trigger;
+	phase = (phase+1 >= period)? ap_uint<32>(0) : ap_uint<32>(phase+1);
+
+	ap_uint<32>  queued = 0;
+	for(unsigned  i = 0; i < N; i++) {
+#pragma HLS pipeline II=1 style=flp
+		T const  x = src.read();
+		dst.write(x);
+		if(take) {
+			TapWord<T>  w;
+			w.data = x;
+			w.idx  = i;
+			w.seq  = seq;
+			if(cap.write_nb(w))  queued++;
+		}
+	}
+	if(take) {
+		TapEnd  e;
+		e.words = queued;
+		e.seq   = seq;
+		bool const  ended = (queued != 0) && end.write_nb(e);
+		if(!ended || (queued != N))  lost++;
+		seq++;
+	}
+	dropped = lost;
+}
+
+/**
+ * Drains captured words from the capture queue into a ring buffer of
+ * `slots` frames of N words in external memory. Words are written while the
+ * frame is still being forwarded; a frame ends once its end marker has
+ * arrived and that many words have been read. A frame only counts as
+ * captured in `count` if all of its N words were queued. A frame that lost
+ * words or its end marker is discarded and its slot is reused by the next
+ * capture; a lost marker shows as the next capture starting without it.
+ * Returns once a frame has ended or both queues are empty, a partially
+ * drained frame is continued by the next call.
+ */
+template<
+	unsigned N,	// number of data words in a frame
+	typename T,	// type of stream-carried data words
+	typename TM	// type of memory words, at least as wide as T
+>
+void tap_writer(
+	hls::stream<TapWord<T>> &cap,
+	hls::stream<TapEnd> &end,
+	TM *mem,
+	ap_uint<32> const  slots,
+	ap_uint<32>       &count
+) {
+	static ap_uint<32>  slot = 0;
+	static ap_uint<32>  captured = 0;
+	// frame being drained: capture sequence number, words read so far and
+	// the word count from its end marker once known
+	static bool         busy = false;
+	static ap_uint<8>   seq = 0;
+	static ap_uint<32>  received = 0;
+	static bool         known = false;
+	static ap_uint<32>  total = 0;
+	// end marker read ahead of the words of its frame
+	static bool         early = false;
+	static TapEnd       early_end;
+#pragma HLS reset variable=slot
+#pragma HLS reset variable=captured
+#pragma HLS reset variable=busy
+#pragma HLS reset variable=known
+#pragma HLS reset variable=early
+
+	bool  done = false;
+	bool  idle = false;
+	while(!done && !idle) {
+#pragma HLS pipeline II=1 style=flp
+		TapWord<T>  w;
+		TapEnd      e;
+		bool const  word = cap.read_nb(w);
+		bool const  next = word && busy && (w.seq != seq);
+		if(next && !known && end.read_nb(e)) {
+			// the marker of the current frame precedes the words of the next
+			if(e.seq == seq) {
+				known = true;
+				total = e.words;
+			}
+			else {
+				early = true;
+				early_end = e;
+			}
+		}
+		else if(!word) {
+			if(end.read_nb(e)) {
+				if(busy && !known && (e.seq == seq)) {
+					known = true;
+					total = e.words;
+				}
+				else {
+					// marker of a later capture, the current frame lost its own
+					if(!known)  busy = false;
+					early = true;
+					early_end = e;
+				}
+			}
+			else {
+				idle = true;
+			}
+		}
+
+		// the next capture ends the current frame
+		if(next) {
+			if(known && (total == N) && (received == N)) {
+				slot = (slot+1 >= slots)? ap_uint<32>(0) : ap_uint<32>(slot+1);
+				captured++;
+			}
+			busy = false;
+			done = true;
+		}
+		if(word) {
+			if(!busy) {
+				busy = true;
+				seq = w.seq;
+				received = 0;
+				known = early && (early_end.seq == w.seq);
+				total = early_end.words;
+				early = false;
+			}
+			mem[slot*N + w.idx] = TM(w.data);
+			received++;
+		}
+		if(busy && known && (received >= total)) {
+			if(total == N) {
+				slot = (slot+1 >= slots)? ap_uint<32>(0) : ap_uint<32>(slot+1);
+				captured++;
+			}
+			busy = false;
+			done = true;
+		}
+	}
+	count = captured;
+}
+
+/**
+ * Taps a stream of frames of N words into a ring buffer in external memory
+ * without backpressuring it. The capture queue of Depth words decouples the
+ * forwarded stream from the memory writes; it should hold a full frame
+ * unless the memory keeps up with the stream rate.
+ */
+template<
+	unsigned N,		// number of data words in a frame
+	unsigned Depth,	// capture queue depth in words
+	typename T,		// type of stream-carried data words
+	typename TM		// type of memory words
+>
+void tap(
+	hls::stream<T> &src,
+	hls::stream<T> &dst,
+	TM *mem,
+	ap_uint<32> const  slots,
+	ap_uint<32> const  period,
+	ap_uint<32> const  trigger,
+	ap_uint<32>       &count,
+	ap_uint<32>       &dropped
+) {
+#pragma HLS inline
+	static hls::stream<TapWord<T>>  cap("tap_cap");
+	static hls::stream<TapEnd>  end("tap_end");
+#pragma HLS stream variable=cap depth=Depth
+#pragma HLS stream variable=end depth=2
+
+	tap_forward<N>(src, dst, cap, end, period, trigger, dropped);
+	tap_writer<N>(cap, end, mem, slots, count);
+}
+
+#endif
@@ -0,0 +1,96 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef WEIGHT_PREFETCH_HPP
+#define WEIGHT_PREFETCH_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Replays a weight stream fetched from external memory tile by tile.
+ *
+ * The input carries numGroups copies of a weight buffer made up of NumTiles
+ * tiles of TileWords words each. Every tile is emitted Reuse times in a row
+ * so that a batch-tiled consumer can hold it against Reuse input vectors
+ * before moving on to the next one. The tiles are kept in an on-chip double
+ * buffer: while one half is being replayed, the next tile is prefetched into
+ * the other half, which hides the fetch behind the replay of the current tile.
+ */
+template<
+	unsigned TileWords, unsigned NumTiles, unsigned Reuse,
+	typename T
+>
+void WeightTileReplay(
+	hls::stream<T> &in,
+	hls::stream<T> &out,
+	unsigned const  numGroups
+) {
+	static_assert(TileWords > 0, "Tiles must not be empty.");
+	static_assert(Reuse > 0, "Every tile must be emitted at least once.");
+
+	T  buf[2][TileWords];
+#pragma HLS array_partition variable=buf complete dim=1
+
+	unsigned const  total_tiles = numGroups * NumTiles;
+	if(total_tiles == 0)  return;
+
+	// Fetch the first tile up front
+	for(unsigned  i = 0; i < TileWords; i++) {
+#pragma HLS pipeline II=1 style=flp
+		buf[0][i] = in.read();
+	}
+
+	// Replay the current tile while prefetching the next one
+	unsigned  tile = 0;
+	unsigned  cur  = 0;
+	unsigned  fill = 0;
+	unsigned  r = 0;
+	unsigned  w = 0;
+	for(unsigned  i = 0; i < total_tiles * Reuse * TileWords; i++) {
+#pragma HLS pipeline II=1 style=flp
+#pragma HLS dependence variable=buf inter false
+		if((tile+1 < total_tiles) && (fill < TileWords)) {
+			buf[1-cur][fill++] = in.read();
+		}
+		out.write(buf[cur][w]);
+		if(++w == TileWords) {
+			w = 0;
+			if(++r == Reuse) {
+				r = 0;
+				tile++;
+				cur  = 1-cur;
+				fill = 0;
+			}
+		}
+	}
+}
+
+#endif
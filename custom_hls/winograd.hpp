@@ -0,0 +1,255 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef WINOGRAD_HPP
+#define WINOGRAD_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+
+
+/**
+ * Winograd F(2x2, 3x3) input transform V = B^T d B.
+ *
+ * Consumes an (already padded) IFMDimH x IFMDimW feature map in raster order
+ * and produces, for every 4x4 input tile, the 16 transformed values of each
+ * channel. Tiles overlap by two pixels, so four input rows are kept in a
+ * circular line buffer, two of which are shared with the next tile row.
+ * Output order is tile row, tile column, tile position, channel.
+ */
+template<
+	unsigned IFMDimH, unsigned IFMDimW, unsigned C, unsigned SIMD,
+	typename TI, typename TO
+>
+void WinogradInputTransform(
+	hls::stream<ap_uint<SIMD*TI::width>> &in,
+	hls::stream<ap_uint<SIMD*TO::width>> &out
+) {
+	static_assert(C%SIMD == 0, "SIMD must divide C.");
+	static_assert(IFMDimH%2 == 0 && IFMDimW%2 == 0, "Input dimensions must be even.");
+	constexpr unsigned  CF = C/SIMD;
+	constexpr unsigned  TH = (IFMDimH-2)/2;
+	constexpr unsigned  TW = (IFMDimW-2)/2;
+	constexpr unsigned  ROW = IFMDimW*CF;
+	constexpr unsigned  IW = TI::width;
+	constexpr unsigned  OW = TO::width;
+	static signed char const  BT[4][4] = {
+		{ 1,  0, -1,  0 },
+		{ 0,  1,  1,  0 },
+		{ 0, -1,  1,  0 },
+		{ 0,  1,  0, -1 }
+	};
+
+	ap_uint<SIMD*IW>  rows[4][ROW];
+#pragma HLS array_partition variable=rows complete dim=1
+
+	// prime the first two rows
+	for(unsigned  i = 0; i < 2*ROW; i++) {
+#pragma HLS pipeline II=1 style=flp
+		rows[i/ROW][i%ROW] = in.read();
+	}
+	for(unsigned  th = 0; th < TH; th++) {
+		// two new rows complete the tiles of this tile row
+		for(unsigned  i = 0; i < 2*ROW; i++) {
+#pragma HLS pipeline II=1 style=flp
+			rows[(2*th + 2 + i/ROW)%4][i%ROW] = in.read();
+		}
+		for(unsigned  tw = 0; tw < TW; tw++) {
+			for(unsigned  x = 0; x < 16; x++) {
+				for(unsigned  cf = 0; cf < CF; cf++) {
+#pragma HLS pipeline II=1 style=flp
+					unsigned const  a = x / 4;
+					unsigned const  b = x % 4;
+					ap_uint<SIMD*OW>  v;
+					for(unsigned  s = 0; s < SIMD; s++) {
+#pragma HLS unroll
+						TO  acc = 0;
+						for(unsigned  i = 0; i < 4; i++) {
+#pragma HLS unroll
+							for(unsigned  j = 0; j < 4; j++) {
+#pragma HLS unroll
+								int const  coef = BT[a][i] * BT[b][j];
+								if(coef != 0) {
+									ap_uint<SIMD*IW> const  word = rows[(2*th + i)%4][(2*tw + j)*CF + cf];
+									ap_uint<IW> const  bits = word((s+1)*IW-1, s*IW);
+									TI const  val = *reinterpret_cast<TI const*>(&bits);
+									if(coef > 0)  acc += val;
+									else          acc -= val;
+								}
+							}
+						}
+						v((s+1)*OW-1, s*OW) = ap_uint<OW>(acc);
+					}
+					out.write(v);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Elementwise-product stage of a Winograd F(2x2, 3x3) convolution.
+ *
+ * For every tile, each of the 16 transformed input vectors of C channels is
+ * multiplied with its own C x K matrix of transformed weights. The input
+ * vector is read once with SIMD channels per word and reused for all K/PE
+ * output folds, producing PE accumulators per output word.
+ */
+template<
+	unsigned C, unsigned K, unsigned Tiles,
+	unsigned SIMD, unsigned PE,
+	typename TA, typename TW, typename TO
+>
+void WinogradMVAU(
+	hls::stream<ap_uint<SIMD*TA::width>> &in,
+	hls::stream<ap_uint<PE*TO::width>>   &out,
+	TW const  weights[16][PE][SIMD][(K/PE)*(C/SIMD)]
+) {
+	static_assert(C%SIMD == 0, "SIMD must divide C.");
+	static_assert(K%PE == 0, "PE must divide K.");
+	constexpr unsigned  SF = C/SIMD;
+	constexpr unsigned  NF = K/PE;
+	constexpr unsigned  AW = TA::width;
+	constexpr unsigned  OW = TO::width;
+
+	ap_uint<SIMD*AW>  vec[SF];
+	TO  acc[PE];
+#pragma HLS array_partition variable=acc complete dim=1
+
+	unsigned  x  = 0;
+	unsigned  nf = 0;
+	unsigned  sf = 0;
+	for(unsigned  i = 0; i < Tiles*16*NF*SF; i++) {
+#pragma HLS pipeline II=1 style=flp
+		if(nf == 0)  vec[sf] = in.read();
+		ap_uint<SIMD*AW> const  a = vec[sf];
+
+		for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+			TO  sum = (sf == 0)? TO(0) : acc[pe];
+			for(unsigned  s = 0; s < SIMD; s++) {
+#pragma HLS unroll
+				ap_uint<AW> const  abits = a((s+1)*AW-1, s*AW);
+				TA const  av = *reinterpret_cast<TA const*>(&abits);
+				sum += av * weights[x][pe][s][nf*SF + sf];
+			}
+			acc[pe] = sum;
+		}
+
+		if(++sf == SF) {
+			ap_uint<PE*OW>  y;
+			for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+				y((pe+1)*OW-1, pe*OW) = ap_uint<OW>(acc[pe]);
+			}
+			out.write(y);
+			sf = 0;
+			if(++nf == NF) {
+				nf = 0;
+				if(++x == 16)  x = 0;
+			}
+		}
+	}
+}
+
+/**
+ * Winograd F(2x2, 3x3) output transform Y = A^T M A / 4.
+ *
+ * Accumulates the 2x2 outputs of a tile while its 16 products M arrive,
+ * removes the factor of 4 that the integer weight transform introduced
+ * (exactly, as the unscaled result is an integer) and collects a full tile row
+ * before emitting it as two output rows in raster order. TS must hold the sum
+ * of nine inputs.
+ */
+template<
+	unsigned OFMDimH, unsigned OFMDimW, unsigned K, unsigned PE,
+	typename TI, typename TS, typename TO
+>
+void WinogradOutputTransform(
+	hls::stream<ap_uint<PE*TI::width>> &in,
+	hls::stream<ap_uint<PE*TO::width>> &out
+) {
+	static_assert(K%PE == 0, "PE must divide K.");
+	static_assert(OFMDimH%2 == 0 && OFMDimW%2 == 0, "Output dimensions must be even.");
+	constexpr unsigned  KF = K/PE;
+	constexpr unsigned  TH = OFMDimH/2;
+	constexpr unsigned  TW = OFMDimW/2;
+	constexpr unsigned  ROW = OFMDimW*KF;
+	constexpr unsigned  IW = TI::width;
+	constexpr unsigned  OW = TO::width;
+	static signed char const  AT[2][4] = {
+		{ 1, 1,  1,  0 },
+		{ 0, 1, -1, -1 }
+	};
+
+	TS  acc[4][PE][KF];
+#pragma HLS array_partition variable=acc complete dim=1
+#pragma HLS array_partition variable=acc complete dim=2
+	ap_uint<PE*OW>  rows[2][ROW];
+#pragma HLS array_partition variable=rows complete dim=1
+
+	for(unsigned  th = 0; th < TH; th++) {
+		for(unsigned  tw = 0; tw < TW; tw++) {
+			for(unsigned  i = 0; i < 16*KF; i++) {
+#pragma HLS pipeline II=1 style=flp
+				unsigned const  x  = i / KF;
+				unsigned const  kf = i % KF;
+				unsigned const  a  = x / 4;
+				unsigned const  b  = x % 4;
+				ap_uint<PE*IW> const  m = in.read();
+				for(unsigned  pe = 0; pe < PE; pe++) {
+#pragma HLS unroll
+					ap_uint<IW> const  bits = m((pe+1)*IW-1, pe*IW);
+					TI const  val = *reinterpret_cast<TI const*>(&bits);
+					for(unsigned  r = 0; r < 2; r++) {
+#pragma HLS unroll
+						for(unsigned  c = 0; c < 2; c++) {
+#pragma HLS unroll
+							int const  coef = AT[r][a] * AT[c][b];
+							TS  sum = (x == 0)? TS(0) : acc[2*r + c][pe][kf];
+							if(coef > 0)  sum += val;
+							if(coef < 0)  sum -= val;
+							acc[2*r + c][pe][kf] = sum;
+							if(x == 15) {
+								ap_uint<PE*OW>  &y = rows[r][(2*tw + c)*KF + kf];
+								y((pe+1)*OW-1, pe*OW) = ap_uint<OW>(TO(sum >> 2));
+							}
+						}
+					}
+				}
+			}
+		}
+		for(unsigned  i = 0; i < 2*ROW; i++) {
+#pragma HLS pipeline II=1 style=flp
+			out.write(rows[i/ROW][i%ROW]);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,274 @@
+/******************************************************************************
+ * Copyright (C) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION). HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @brief	Virtual FIFO spilling to off-chip memory through an AXI-MM master.
+ * @details
+ *	Stream words pass through an on-chip tail buffer and an on-chip head
+ *	buffer. While the off-chip ring buffer is empty, words bypass straight
+ *	from tail to head. Once the head buffer backs up and BURST_LEN words have
+ *	accumulated in the tail, they are written out as one burst, and bursts
+ *	are read back into the head buffer as soon as it has room for them.
+ *	Bypassing resumes only after the ring buffer has drained completely so
+ *	that the stream order is preserved. Every memory beat carries one
+ *	stream word.
+ *****************************************************************************/
+
+module dram_fifo #(
+	int unsigned  WIDTH,	// stream width, multiple of 8, at most 1024
+	int unsigned  DEPTH,	// off-chip capacity in stream words, multiple of BURST_LEN
+	int unsigned  BURST_LEN = 64,	// beats per burst, at most 128
+	int unsigned  ADDR_WIDTH = 64,
+	bit [63:0]  BASE_ADDR = 0,	// aligned to the burst size
+
+	localparam int unsigned  MEM_WIDTH = WIDTH <= 32? 32 : 2**$clog2(WIDTH),
+	localparam int unsigned  MEM_BYTES = MEM_WIDTH/8,
+	localparam int unsigned  BURSTS = DEPTH/BURST_LEN,
+	localparam int unsigned  BUF_DEPTH = 2*BURST_LEN,
+	localparam int unsigned  BUF_COUNT_BITS = $clog2(BUF_DEPTH+1)
+)(
+	//- Global Control ------------------
+	input	logic  ap_clk,
+	input	logic  ap_rst_n,
+
+	//- AXI Stream - Input --------------
+	output	logic  s_axis_tready,
+	input	logic  s_axis_tvalid,
+	input	logic [WIDTH-1:0]  s_axis_tdata,
+
+	//- AXI Stream - Output -------------
+	input	logic  m_axis_tready,
+	output	logic  m_axis_tvalid,
+	output	logic [WIDTH-1:0]  m_axis_tdata,
+
+	//- AXI-MM Master -------------------
+	output	logic [ADDR_WIDTH-1:0]  m_axi_gmem_AWADDR,
+	output	logic [7:0]  m_axi_gmem_AWLEN,
+	output	logic [2:0]  m_axi_gmem_AWSIZE,
+	output	logic [1:0]  m_axi_gmem_AWBURST,
+	output	logic [3:0]  m_axi_gmem_AWCACHE,
+	output	logic [2:0]  m_axi_gmem_AWPROT,
+	output	logic  m_axi_gmem_AWVALID,
+	input	logic  m_axi_gmem_AWREADY,
+
+	output	logic [MEM_WIDTH-1:0]  m_axi_gmem_WDATA,
+	output	logic [MEM_BYTES-1:0]  m_axi_gmem_WSTRB,
+	output	logic  m_axi_gmem_WLAST,
+	output	logic  m_axi_gmem_WVALID,
+	input	logic  m_axi_gmem_WREADY,
+
+	input	logic [1:0]  m_axi_gmem_BRESP,
+	input	logic  m_axi_gmem_BVALID,
+	output	logic  m_axi_gmem_BREADY,
+
+	output	logic [ADDR_WIDTH-1:0]  m_axi_gmem_ARADDR,
+	output	logic [7:0]  m_axi_gmem_ARLEN,
+	output	logic [2:0]  m_axi_gmem_ARSIZE,
+	output	logic [1:0]  m_axi_gmem_ARBURST,
+	output	logic [3:0]  m_axi_gmem_ARCACHE,
+	output	logic [2:0]  m_axi_gmem_ARPROT,
+	output	logic  m_axi_gmem_ARVALID,
+	input	logic  m_axi_gmem_ARREADY,
+
+	input	logic [MEM_WIDTH-1:0]  m_axi_gmem_RDATA,
+	input	logic [1:0]  m_axi_gmem_RRESP,
+	input	logic  m_axi_gmem_RLAST,
+	input	logic  m_axi_gmem_RVALID,
+	output	logic  m_axi_gmem_RREADY
+);
+
+	initial begin
+		if(WIDTH > 1024) begin
+			$error("%m: WIDTH must not exceed the AXI data width limit of 1024.");
+			$finish;
+		end
+		if(DEPTH % BURST_LEN != 0) begin
+			$error("%m: DEPTH must be a multiple of BURST_LEN.");
+			$finish;
+		end
+		if((BURST_LEN < 2) || (BURST_LEN > 128)) begin
+			$error("%m: BURST_LEN must be in [2, 128].");
+			$finish;
+		end
+		if(BASE_ADDR % (BURST_LEN*MEM_BYTES) != 0) begin
+			$error("%m: BASE_ADDR must be aligned to the burst size.");
+			$finish;
+		end
+	end
+
+	uwire  clk = ap_clk;
+	uwire  rst = !ap_rst_n;
+
+	//-----------------------------------------------------------------------
+	// On-chip Tail and Head Buffers
+	uwire [WIDTH-1:0]  tail_d;
+	uwire  tail_v;
+	logic  tail_r;
+	uwire [BUF_COUNT_BITS-1:0]  tail_cnt;
+	Q_srl #(.depth(BUF_DEPTH), .width(WIDTH)) tail (
+		.clock(clk), .reset(rst),
+		.i_d(s_axis_tdata), .i_v(s_axis_tvalid), .i_r(s_axis_tready),
+		.o_d(tail_d), .o_v(tail_v), .o_r(tail_r),
+		.count(tail_cnt), .maxcount()
+	);
+
+	logic [WIDTH-1:0]  head_d;
+	logic  head_v;
+	uwire  head_r;
+	uwire [BUF_COUNT_BITS-1:0]  head_cnt;
+	Q_srl #(.depth(BUF_DEPTH), .width(WIDTH)) head (
+		.clock(clk), .reset(rst),
+		.i_d(head_d), .i_v(head_v), .i_r(head_r),
+		.o_d(m_axis_tdata), .o_v(m_axis_tvalid), .o_r(m_axis_tready),
+		.count(head_cnt), .maxcount()
+	);
+
+	//-----------------------------------------------------------------------
+	// Ring Buffer Bookkeeping (in units of bursts)
+	localparam int unsigned  PTR_BITS = BURSTS > 1? $clog2(BURSTS) : 1;
+	localparam int unsigned  CNT_BITS = $clog2(BURSTS+1);
+
+	logic [PTR_BITS-1:0]  WPtr = 0;	// next burst slot to write
+	logic [PTR_BITS-1:0]  RPtr = 0;	// next burst slot to read
+	logic [CNT_BITS-1:0]  Used = 0;	// slots written or being written, not yet read back
+	logic [CNT_BITS-1:0]  Avail = 0;	// slots committed to memory, not yet requested
+
+	logic  AwPending = 0;	// write address not yet accepted
+	logic  WActive = 0;	// write data beats outstanding
+	logic  WrBusy = 0;	// write burst in progress until response
+	logic [7:0]  WCnt = 0;	// remaining write beats minus one
+	logic  ArPending = 0;	// read address not yet accepted
+	logic  RdBusy = 0;	// read burst in progress until last beat
+
+	// Bypass the ring buffer while it holds nothing
+	uwire  bypass = (Used == 0) && !WrBusy && !RdBusy;
+
+	uwire  wr_start = !WrBusy && (Used < BURSTS) && (tail_cnt >= BURST_LEN);
+	uwire  rd_start = !RdBusy && (Avail != 0) && (head_cnt <= BUF_DEPTH - BURST_LEN);
+
+	uwire  w_fire = m_axi_gmem_WVALID && m_axi_gmem_WREADY;
+	uwire  b_fire = m_axi_gmem_BVALID && m_axi_gmem_BREADY;
+	uwire  r_fire = m_axi_gmem_RVALID && m_axi_gmem_RREADY;
+	uwire  r_done = r_fire && m_axi_gmem_RLAST;
+
+	always_ff @(posedge clk) begin
+		if(rst) begin
+			WPtr <= 0;
+			RPtr <= 0;
+			Used <= 0;
+			Avail <= 0;
+			AwPending <= 0;
+			WActive <= 0;
+			WrBusy <= 0;
+			WCnt <= 0;
+			ArPending <= 0;
+			RdBusy <= 0;
+		end
+		else begin
+			// Write Path
+			if(wr_start) begin
+				AwPending <= 1;
+				WActive <= 1;
+				WrBusy <= 1;
+				WCnt <= BURST_LEN-1;
+				WPtr <= (WPtr == BURSTS-1)? 0 : WPtr+1;
+			end
+			else begin
+				if(m_axi_gmem_AWREADY)  AwPending <= 0;
+				if(w_fire) begin
+					if(WCnt == 0)  WActive <= 0;
+					WCnt <= WCnt - 1;
+				end
+				if(b_fire)  WrBusy <= 0;
+			end
+
+			// Read Path
+			if(rd_start) begin
+				ArPending <= 1;
+				RdBusy <= 1;
+				RPtr <= (RPtr == BURSTS-1)? 0 : RPtr+1;
+			end
+			else begin
+				if(m_axi_gmem_ARREADY)  ArPending <= 0;
+				if(r_done)  RdBusy <= 0;
+			end
+
+			// Occupancy
+			Used <= Used + wr_start - r_done;
+			Avail <= Avail + b_fire - rd_start;
+		end
+	end
+
+	//-----------------------------------------------------------------------
+	// Stream Routing
+	always_comb begin
+		if(bypass) begin
+			// hold the tail while a burst is started to keep BURST_LEN words
+			tail_r = head_r && !wr_start;
+			head_v = tail_v && !wr_start;
+			head_d = tail_d;
+		end
+		else begin
+			tail_r = WActive && m_axi_gmem_WREADY;
+			head_v = RdBusy && m_axi_gmem_RVALID;
+			head_d = m_axi_gmem_RDATA[WIDTH-1:0];
+		end
+	end
+
+	//-----------------------------------------------------------------------
+	// AXI-MM Channels
+	localparam int unsigned  BURST_BYTES = BURST_LEN*MEM_BYTES;
+	localparam bit [2:0]  SIZE = $clog2(MEM_BYTES);
+
+	assign	m_axi_gmem_AWADDR  = BASE_ADDR + (WPtr == 0? BURSTS-1 : WPtr-1) * BURST_BYTES;
+	assign	m_axi_gmem_AWLEN   = BURST_LEN-1;
+	assign	m_axi_gmem_AWSIZE  = SIZE;
+	assign	m_axi_gmem_AWBURST = 2'b01;	// INCR
+	assign	m_axi_gmem_AWCACHE = 4'b0011;
+	assign	m_axi_gmem_AWPROT  = 3'b000;
+	assign	m_axi_gmem_AWVALID = AwPending;
+
+	assign	m_axi_gmem_WDATA  = MEM_WIDTH'(tail_d);
+	assign	m_axi_gmem_WSTRB  = '1;
+	assign	m_axi_gmem_WLAST  = WCnt == 0;
+	assign	m_axi_gmem_WVALID = WActive && tail_v;
+
+	assign	m_axi_gmem_BREADY = WrBusy && !WActive;
+
+	assign	m_axi_gmem_ARADDR  = BASE_ADDR + (RPtr == 0? BURSTS-1 : RPtr-1) * BURST_BYTES;
+	assign	m_axi_gmem_ARLEN   = BURST_LEN-1;
+	assign	m_axi_gmem_ARSIZE  = SIZE;
+	assign	m_axi_gmem_ARBURST = 2'b01;	// INCR
+	assign	m_axi_gmem_ARCACHE = 4'b0011;
+	assign	m_axi_gmem_ARPROT  = 3'b000;
+	assign	m_axi_gmem_ARVALID = ArPending;
+
+	assign	m_axi_gmem_RREADY = RdBusy && head_r;
+
+endmodule : dram_fifo
@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright (C) 2023, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION). HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+
+module $TOP_MODULE_NAME$ #(
+	parameter  WIDTH = $WIDTH$,
+	parameter  DEPTH = $DEPTH$,
+	parameter  BURST_LEN = $BURST_LEN$,
+	parameter  BASE_ADDR = $BASE_ADDR$,
+	parameter  MEM_WIDTH = $MEM_WIDTH$
+)(
+	//- Global Control ------------------
+	(* X_INTERFACE_INFO = "xilinx.com:signal:clock:1.0 ap_clk CLK" *)
+	(* X_INTERFACE_PARAMETER = "ASSOCIATED_BUSIF in0_V:out_V:m_axi_gmem, ASSOCIATED_RESET ap_rst_n" *)
+	input	ap_clk,
+	(* X_INTERFACE_PARAMETER = "POLARITY ACTIVE_LOW" *)
+	input	ap_rst_n,
+
+	//- AXI Stream - Input --------------
+	output	in0_V_TREADY,
+	input	in0_V_TVALID,
+	input	[WIDTH-1:0]  in0_V_TDATA,
+
+	//- AXI Stream - Output -------------
+	input	out_V_TREADY,
+	output	out_V_TVALID,
+	output	[WIDTH-1:0]  out_V_TDATA,
+
+	//- AXI-MM Master -------------------
+	output	[63:0]  m_axi_gmem_AWADDR,
+	output	[7:0]  m_axi_gmem_AWLEN,
+	output	[2:0]  m_axi_gmem_AWSIZE,
+	output	[1:0]  m_axi_gmem_AWBURST,
+	output	[3:0]  m_axi_gmem_AWCACHE,
+	output	[2:0]  m_axi_gmem_AWPROT,
+	output	m_axi_gmem_AWVALID,
+	input	m_axi_gmem_AWREADY,
+	output	[MEM_WIDTH-1:0]  m_axi_gmem_WDATA,
+	output	[MEM_WIDTH/8-1:0]  m_axi_gmem_WSTRB,
+	output	m_axi_gmem_WLAST,
+	output	m_axi_gmem_WVALID,
+	input	m_axi_gmem_WREADY,
+	input	[1:0]  m_axi_gmem_BRESP,
+	input	m_axi_gmem_BVALID,
+	output	m_axi_gmem_BREADY,
+	output	[63:0]  m_axi_gmem_ARADDR,
+	output	[7:0]  m_axi_gmem_ARLEN,
+	output	[2:0]  m_axi_gmem_ARSIZE,
+	output	[1:0]  m_axi_gmem_ARBURST,
+	output	[3:0]  m_axi_gmem_ARCACHE,
+	output	[2:0]  m_axi_gmem_ARPROT,
+	output	m_axi_gmem_ARVALID,
+	input	m_axi_gmem_ARREADY,
+	input	[MEM_WIDTH-1:0]  m_axi_gmem_RDATA,
+	input	[1:0]  m_axi_gmem_RRESP,
+	input	m_axi_gmem_RLAST,
+	input	m_axi_gmem_RVALID,
+	output	m_axi_gmem_RREADY
+);
+
+	dram_fifo #(
+		.WIDTH(WIDTH),
+		.DEPTH(DEPTH),
+		.BURST_LEN(BURST_LEN),
+		.ADDR_WIDTH(64),
+		.BASE_ADDR(BASE_ADDR)
+	) impl (
+		.ap_clk(ap_clk),
+		.ap_rst_n(ap_rst_n),
+		.s_axis_tready(in0_V_TREADY),
+		.s_axis_tvalid(in0_V_TVALID),
+		.s_axis_tdata(in0_V_TDATA),
+		.m_axis_tready(out_V_TREADY),
+		.m_axis_tvalid(out_V_TVALID),
+		.m_axis_tdata(out_V_TDATA),
+		.m_axi_gmem_AWADDR(m_axi_gmem_AWADDR),
+		.m_axi_gmem_AWLEN(m_axi_gmem_AWLEN),
+		.m_axi_gmem_AWSIZE(m_axi_gmem_AWSIZE),
+		.m_axi_gmem_AWBURST(m_axi_gmem_AWBURST),
+		.m_axi_gmem_AWCACHE(m_axi_gmem_AWCACHE),
+		.m_axi_gmem_AWPROT(m_axi_gmem_AWPROT),
+		.m_axi_gmem_AWVALID(m_axi_gmem_AWVALID),
+		.m_axi_gmem_AWREADY(m_axi_gmem_AWREADY),
+		.m_axi_gmem_WDATA(m_axi_gmem_WDATA),
+		.m_axi_gmem_WSTRB(m_axi_gmem_WSTRB),
+		.m_axi_gmem_WLAST(m_axi_gmem_WLAST),
+		.m_axi_gmem_WVALID(m_axi_gmem_WVALID),
+		.m_axi_gmem_WREADY(m_axi_gmem_WREADY),
+		.m_axi_gmem_BRESP(m_axi_gmem_BRESP),
+		.m_axi_gmem_BVALID(m_axi_gmem_BVALID),
+		.m_axi_gmem_BREADY(m_axi_gmem_BREADY),
+		.m_axi_gmem_ARADDR(m_axi_gmem_ARADDR),
+		.m_axi_gmem_ARLEN(m_axi_gmem_ARLEN),
+		.m_axi_gmem_ARSIZE(m_axi_gmem_ARSIZE),
+		.m_axi_gmem_ARBURST(m_axi_gmem_ARBURST),
+		.m_axi_gmem_ARCACHE(m_axi_gmem_ARCACHE),
+		.m_axi_gmem_ARPROT(m_axi_gmem_ARPROT),
+		.m_axi_gmem_ARVALID(m_axi_gmem_ARVALID),
+		.m_axi_gmem_ARREADY(m_axi_gmem_ARREADY),
+		.m_axi_gmem_RDATA(m_axi_gmem_RDATA),
+		.m_axi_gmem_RRESP(m_axi_gmem_RRESP),
+		.m_axi_gmem_RLAST(m_axi_gmem_RLAST),
+		.m_axi_gmem_RVALID(m_axi_gmem_RVALID),
+		.m_axi_gmem_RREADY(m_axi_gmem_RREADY)
+	);
+
+endmodule
@@ -0,0 +1,254 @@
+/******************************************************************************
+ * Copyright (C) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION). HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @brief	Testbench for the off-chip memory backed virtual FIFO.
+ * @details
+ *	The output sink alternates between long stalls, which force the FIFO
+ *	to spill to the behavioural memory model, and free-running phases.
+ *****************************************************************************/
+module dram_fifo_tb;
+
+	localparam int unsigned  WIDTH = 24;
+	localparam int unsigned  DEPTH = 512;
+	localparam int unsigned  BURST_LEN = 16;
+	localparam bit [63:0]  BASE_ADDR = 64'h1000;
+	localparam int unsigned  MEM_WIDTH = 32;
+	localparam int unsigned  MEM_BYTES = MEM_WIDTH/8;
+	typedef logic [WIDTH-1:0]  dat_t;
+	typedef logic [MEM_WIDTH-1:0]  mem_t;
+
+	// Global Control
+	logic  clk = 0;
+	always #5ns clk = !clk;
+	logic  rst = 1;
+	initial begin
+		repeat(8) @(posedge clk);
+		rst <= 0;
+	end
+
+	//- AXI Stream ----------------------
+	uwire  s_axis_tready;
+	logic  s_axis_tvalid;
+	dat_t  s_axis_tdata;
+	logic  m_axis_tready;
+	uwire  m_axis_tvalid;
+	dat_t  m_axis_tdata;
+
+	//- AXI-MM --------------------------
+	uwire [63:0]  awaddr;
+	uwire [7:0]  awlen;
+	uwire  awvalid;
+	logic  awready;
+	mem_t  wdata;
+	uwire  wlast;
+	uwire  wvalid;
+	logic  wready;
+	logic  bvalid;
+	uwire  bready;
+	uwire [63:0]  araddr;
+	uwire [7:0]  arlen;
+	uwire  arvalid;
+	logic  arready;
+	mem_t  rdata;
+	logic  rlast;
+	logic  rvalid;
+	uwire  rready;
+
+	dram_fifo #(
+		.WIDTH(WIDTH), .DEPTH(DEPTH), .BURST_LEN(BURST_LEN), .BASE_ADDR(BASE_ADDR)
+	) dut (
+		.ap_clk(clk), .ap_rst_n(!rst),
+		.s_axis_tready, .s_axis_tvalid, .s_axis_tdata,
+		.m_axis_tready, .m_axis_tvalid, .m_axis_tdata,
+
+		.m_axi_gmem_AWADDR(awaddr), .m_axi_gmem_AWLEN(awlen), .m_axi_gmem_AWSIZE(),
+		.m_axi_gmem_AWBURST(), .m_axi_gmem_AWCACHE(), .m_axi_gmem_AWPROT(),
+		.m_axi_gmem_AWVALID(awvalid), .m_axi_gmem_AWREADY(awready),
+		.m_axi_gmem_WDATA(wdata), .m_axi_gmem_WSTRB(), .m_axi_gmem_WLAST(wlast),
+		.m_axi_gmem_WVALID(wvalid), .m_axi_gmem_WREADY(wready),
+		.m_axi_gmem_BRESP(2'b00), .m_axi_gmem_BVALID(bvalid), .m_axi_gmem_BREADY(bready),
+		.m_axi_gmem_ARADDR(araddr), .m_axi_gmem_ARLEN(arlen), .m_axi_gmem_ARSIZE(),
+		.m_axi_gmem_ARBURST(), .m_axi_gmem_ARCACHE(), .m_axi_gmem_ARPROT(),
+		.m_axi_gmem_ARVALID(arvalid), .m_axi_gmem_ARREADY(arready),
+		.m_axi_gmem_RDATA(rdata), .m_axi_gmem_RRESP(2'b00), .m_axi_gmem_RLAST(rlast),
+		.m_axi_gmem_RVALID(rvalid), .m_axi_gmem_RREADY(rready)
+	);
+
+	// Behavioural Memory
+	mem_t  Mem[longint unsigned];
+	int unsigned  MaxSpill = 0;
+	int unsigned  Spilled = 0;
+
+	initial begin
+		awready = 0;
+		wready = 0;
+		bvalid = 0;
+		@(posedge clk iff !rst);
+
+		forever begin
+			automatic longint unsigned  addr;
+
+			awready <= 1;
+			@(posedge clk iff awvalid);
+			awready <= 0;
+			addr = awaddr;
+			assert(awlen == BURST_LEN-1) else begin
+				$error("Unexpected write burst length.");
+				$stop;
+			end
+			assert((BASE_ADDR <= addr) && (addr < BASE_ADDR + DEPTH*MEM_BYTES)) else begin
+				$error("Write outside of the ring buffer.");
+				$stop;
+			end
+
+			for(int unsigned  i = 0; i < BURST_LEN; i++) begin
+				while($urandom()%5 < 1) @(posedge clk);
+				wready <= 1;
+				@(posedge clk iff wvalid);
+				wready <= 0;
+				Mem[addr] = wdata;
+				addr += MEM_BYTES;
+				assert(wlast == (i == BURST_LEN-1)) else begin
+					$error("Misplaced WLAST.");
+					$stop;
+				end
+			end
+
+			repeat($urandom()%8) @(posedge clk);
+			bvalid <= 1;
+			@(posedge clk iff bready);
+			bvalid <= 0;
+			Spilled += BURST_LEN;
+			if(Spilled > MaxSpill)  MaxSpill = Spilled;
+		end
+	end
+
+	initial begin
+		arready = 0;
+		rvalid = 0;
+		rlast = 'x;
+		rdata = 'x;
+		@(posedge clk iff !rst);
+
+		forever begin
+			automatic longint unsigned  addr;
+
+			arready <= 1;
+			@(posedge clk iff arvalid);
+			arready <= 0;
+			addr = araddr;
+			assert(arlen == BURST_LEN-1) else begin
+				$error("Unexpected read burst length.");
+				$stop;
+			end
+
+			repeat($urandom()%16) @(posedge clk);
+			for(int unsigned  i = 0; i < BURST_LEN; i++) begin
+				assert(Mem.exists(addr)) else begin
+					$error("Read from unwritten address 0x%0x.", addr);
+					$stop;
+				end
+				rvalid <= 1;
+				rdata <= Mem[addr];
+				rlast <= (i == BURST_LEN-1);
+				@(posedge clk iff rready);
+				addr += MEM_BYTES;
+			end
+			rvalid <= 0;
+			rlast <= 'x;
+			rdata <= 'x;
+			Spilled -= BURST_LEN;
+		end
+	end
+
+	// Stimulus: Feed
+	dat_t  Q[$];
+	initial begin
+		s_axis_tvalid = 0;
+		s_axis_tdata = 'x;
+		@(posedge clk iff !rst);
+
+		repeat(20000) begin
+			automatic dat_t  dat;
+			std::randomize(dat);
+
+			while($urandom()%7 < 1) @(posedge clk);
+
+			s_axis_tvalid <= 1;
+			s_axis_tdata  <= dat;
+			@(posedge clk iff s_axis_tready);
+			Q.push_back(dat);
+
+			s_axis_tvalid <= 0;
+			s_axis_tdata <= 'x;
+		end
+
+		// drain
+		while(Q.size)  @(posedge clk);
+		repeat(16) @(posedge clk);
+		assert(MaxSpill > 0) else begin
+			$error("FIFO never spilled to memory.");
+			$stop;
+		end
+		$display("Test completed: up to %0d words held off-chip.", MaxSpill);
+		$finish;
+	end
+
+	// Output Sink
+	initial begin
+		m_axis_tready = 0;
+		@(posedge clk iff !rst);
+
+		forever begin
+			// stall long enough to fill the on-chip buffers and spill
+			m_axis_tready <= 0;
+			repeat(200 + $urandom()%600) @(posedge clk);
+
+			repeat(500 + $urandom()%500) begin
+				automatic dat_t  dat;
+
+				m_axis_tready <= $urandom()%5 != 0;
+				@(posedge clk);
+				if(m_axis_tready && m_axis_tvalid) begin
+					assert(Q.size) else begin
+						$error("Spurious output.");
+						$stop;
+					end
+					dat = Q.pop_front();
+					assert(m_axis_tdata == dat) else begin
+						$error("Output mismatch: 0x%0x instead of 0x%0x", m_axis_tdata, dat);
+						$stop;
+					end
+				end
+			end
+		end
+	end
+
+endmodule : dram_fifo_tb
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Copyright (C) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION). HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @brief	Bit-serial Matrix Vector Unit (MVU) core compute kernel on LUTs.
+ * @details
+ *	The activations are processed one bit plane per cycle, MSB first, while
+ *	the flow control around the core holds the current input and weights
+ *	for ACTIVATION_WIDTH cycles. Every PE adds up the weights selected by
+ *	the current bit plane and folds this sum into a shift-accumulate over
+ *	the bit planes. No DSP slices are used.
+ *****************************************************************************/
+
+module mvu_bitserial #(
+	int unsigned  PE,
+	int unsigned  SIMD,
+	int unsigned  ACCU_WIDTH,
+	int unsigned  ACTIVATION_WIDTH,
+	int unsigned  WEIGHT_WIDTH,
+
+	bit  SIGNED_ACTIVATIONS = 0,
+
+	localparam int unsigned  BIT_SEL_WIDTH = ACTIVATION_WIDTH > 1? $clog2(ACTIVATION_WIDTH) : 1
+)(
+	// Global Control
+	input	logic  clk,
+	input	logic  rst,
+	input	logic  en,
+
+	// Input
+	input	logic  last,	// last bit plane of the last input of a dot product
+	input	logic  zero,	// ignore current inputs
+	input	logic [BIT_SEL_WIDTH-1:0]  bsel,	// current bit plane, counting down from ACTIVATION_WIDTH-1
+	input	logic signed [PE-1:0][SIMD-1:0][WEIGHT_WIDTH    -1:0]  w,	// signed weights
+	input	logic                [SIMD-1:0][ACTIVATION_WIDTH-1:0]  a,	// unsigned activations (override by SIGNED_ACTIVATIONS)
+
+	// Ouput
+	output	logic  vld,
+	output	logic signed [PE-1:0][ACCU_WIDTH-1:0]  p
+);
+
+	typedef logic signed [ACCU_WIDTH-1:0]  accu_t;
+
+	// Stage #1: control flags of the bit-plane sums
+	logic  Msb1 = 'x;
+	logic  Lsb1 = 'x;
+	logic  Zero1 = 1;
+	logic  Last1 = 0;
+	always_ff @(posedge clk) begin
+		if(rst) begin
+			Msb1  <= 'x;
+			Lsb1  <= 'x;
+			Zero1 <= 1;
+			Last1 <= 0;
+		end
+		else if(en) begin
+			Msb1  <= bsel == ACTIVATION_WIDTH-1;
+			Lsb1  <= bsel == 0;
+			Zero1 <= zero;
+			Last1 <= last && !zero;
+		end
+	end
+
+	// Stage #2: output valid
+	logic  Vld = 0;
+	always_ff @(posedge clk) begin
+		if(rst)      Vld <= 0;
+		else if(en)  Vld <= Last1;
+	end
+	assign	vld = Vld;
+
+	for(genvar  pe = 0; pe < PE; pe++) begin : genPE
+
+		// Sum of the weights selected by the current bit plane
+		accu_t  s;
+		always_comb begin
+			s = 0;
+			for(int unsigned  i = 0; i < SIMD; i++) begin
+				if(a[i][bsel])  s += accu_t'($signed(w[pe][i]));
+			end
+		end
+
+		// Stage #1: bit-plane sum
+		accu_t  S1 = 'x;
+		always_ff @(posedge clk) begin
+			if(rst)      S1 <= 'x;
+			else if(en)  S1 <= s;
+		end
+
+		// Stage #2: shift-accumulate over the bit planes of an input (Part)
+		// and accumulate over the inputs of a dot product (Accu)
+		// The MSB plane carries a negative weight for signed activations.
+		accu_t  Part = 'x;
+		accu_t  Accu = 0;
+		accu_t  P = 'x;
+		uwire accu_t  term = SIGNED_ACTIVATIONS && Msb1? -S1 : S1;
+		uwire accu_t  part = (Msb1? accu_t'(0) : accu_t'(Part << 1)) + term;
+		always_ff @(posedge clk) begin
+			if(rst) begin
+				Part <= 'x;
+				Accu <= 0;
+				P    <= 'x;
+			end
+			else if(en && !Zero1) begin
+				if(!Lsb1)  Part <= part;
+				else if(Last1) begin
+					P    <= Accu + part;
+					Accu <= 0;
+				end
+				else  Accu <= Accu + part;
+			end
+		end
+		assign	p[pe] = P;
+
+	end : genPE
+
+endmodule : mvu_bitserial
@@ -34,6 +34,7 @@
  *   - 4-bit MVU on DSP48 achieving 4 MACs/DSP,
  *   - (4,8]-bit MVU on DSP48 achieving 2 MACs/DSP,
  *   - [4,9]-bit MVU and VVU on DSP58 achieving 3 MACs/DSP,
+ *   - bit-serial MVU on LUTs taking ACTIVATION_WIDTH cycles per input.
  *  Folding hints:
  *	 - PE scaling should divide MH.
  *   - SIMD scaling should divide MW.
@@ -121,6 +122,10 @@ module mvu_vvu_axi #(
 				$finish;
 			end
 		end
+		if (COMPUTE_CORE == "mvu_bitserial" && PUMPED_COMPUTE) begin
+			$error("Bit-serial compute cannot be pumped");
+			$finish;
+		end
 		if (!IS_MVU) begin
 			if (COMPUTE_CORE != "mvu_vvu_8sx9_dsp58" && COMPUTE_CORE != "mvu_vvu_lut") begin
 				$error("VVU only supported on DSP58 or LUT-based implementation");
@@ -177,8 +182,27 @@ module mvu_vvu_axi #(
 	//- Flow Control Bracket around Compute Core ----------------------------
 	uwire en;
 	uwire istb = avld && s_axis_weights_tvalid;
-	assign ardy = en && s_axis_weights_tvalid;
-	assign s_axis_weights_tready = en && avld;
+	uwire adv;	// last compute cycle on the current input and weights
+	assign ardy = en && adv && s_axis_weights_tvalid;
+	assign s_axis_weights_tready = en && adv && avld;
+
+	//- Bit-Plane Sequencing for Bit-Serial Compute -------------------------
+	localparam int unsigned  BIT_SEL_WIDTH = ACTIVATION_WIDTH > 1? $clog2(ACTIVATION_WIDTH) : 1;
+	uwire [BIT_SEL_WIDTH-1:0]  bsel;
+	if(COMPUTE_CORE == "mvu_bitserial") begin : genBitSerial
+		// Hold every input for ACTIVATION_WIDTH cycles, MSB plane first
+		logic [BIT_SEL_WIDTH-1:0]  Bit = ACTIVATION_WIDTH-1;
+		always_ff @(posedge clk) begin
+			if(rst)              Bit <= ACTIVATION_WIDTH-1;
+			else if(en && istb)  Bit <= (Bit == 0)? ACTIVATION_WIDTH-1 : Bit-1;
+		end
+		assign	bsel = Bit;
+		assign	adv = Bit == 0;
+	end : genBitSerial
+	else begin : genBitParallel
+		assign	bsel = 'x;
+		assign	adv = 1;
+	end : genBitParallel
 
 	//- Conditionally Pumped DSP Compute ------------------------------------
 	typedef logic [PE-1:0][ACCU_WIDTH-1:0]  dsp_p_t;
@@ -205,7 +229,7 @@ module mvu_vvu_axi #(
 			assign	dsp_clk = clk;
 			assign	dsp_en  = en;
 
-			assign	dsp_last = alast && avld;
+			assign	dsp_last = alast && avld && adv;
 			assign	dsp_zero = !istb;
 			assign	dsp_w = mvu_w;
 			assign	dsp_a = amvau_i;
@@ -334,6 +358,13 @@ module mvu_vvu_axi #(
 				.last(dsp_last), .zero(dsp_zero), .w(dsp_w), .a(dsp_a),
 				.vld(dsp_vld), .p(dsp_p)
 			);
+		"mvu_bitserial":
+			mvu_bitserial #(.PE(PE), .SIMD(DSP_SIMD), .ACCU_WIDTH(ACCU_WIDTH), .ACTIVATION_WIDTH(ACTIVATION_WIDTH), .WEIGHT_WIDTH(WEIGHT_WIDTH),
+			.SIGNED_ACTIVATIONS(SIGNED_ACTIVATIONS)) core (
+				.clk(dsp_clk), .rst, .en(dsp_en),
+				.last(dsp_last), .zero(dsp_zero), .bsel, .w(dsp_w), .a(dsp_a),
+				.vld(dsp_vld), .p(dsp_p)
+			);
 		default: initial begin
 			$error("Unrecognized COMPUTE_CORE '%s'", COMPUTE_CORE);
 			$finish;
@@ -223,6 +223,12 @@ DOCKER_EXEC+="-e PYNQ_PASSWORD=$PYNQ_PASSWORD "
 DOCKER_EXEC+="-e PYNQ_TARGET_DIR=$PYNQ_TARGET_DIR "
 DOCKER_EXEC+="-e OHMYXILINX=$OHMYXILINX "
 DOCKER_EXEC+="-e NUM_DEFAULT_WORKERS=$NUM_DEFAULT_WORKERS "
+if [ ! -z "$FINN_BUILD_HOSTS" ];then
+  DOCKER_EXEC+="-e FINN_BUILD_HOSTS=$FINN_BUILD_HOSTS "
+fi
+if [ ! -z "$FINN_DETERMINISTIC_BUILD_DIRS" ];then
+  DOCKER_EXEC+="-e FINN_DETERMINISTIC_BUILD_DIRS=$FINN_DETERMINISTIC_BUILD_DIRS "
+fi
 # Workaround for FlexLM issue, see:
 # https://community.flexera.com/t5/InstallAnywhere-Forum/Issues-when-running-Xilinx-tools-or-Other-vendor-tools-in-docker/m-p/245820#M10647
 DOCKER_EXEC+="-e LD_PRELOAD=/lib/x86_64-linux-gnu/libudev.so.1 "
@@ -0,0 +1,51 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import qonnx.custom_op.registry as registry
+
+from finn.util.fpgadataflow import is_hls_node, is_rtl_node
+
+
+def exp_dram_bytes_per_layer(model):
+    """Estimates the number of bytes moved to or from external memory per sample
+    for dataflow layers in the given model, e.g. for external weights. Layers
+    without DRAM traffic are omitted. Ensure that all nodes have unique names
+    (by calling the GiveUniqueNodeNames transformation) prior to calling this
+    analysis pass to ensure all nodes are visible in the results.
+
+    Returns {node name : bytes per sample}."""
+
+    dram_dict = {}
+    for node in model.graph.node:
+        if is_hls_node(node) or is_rtl_node(node):
+            inst = registry.getCustomOp(node)
+            dram_bytes = inst.get_exp_dram_bytes()
+            if dram_bytes > 0:
+                dram_dict[node.name] = float(dram_bytes)
+
+    return dram_dict
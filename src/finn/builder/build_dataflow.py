@@ -41,6 +41,7 @@ from finn.builder.build_dataflow_config import (
     default_build_dataflow_steps,
 )
 from finn.builder.build_dataflow_steps import build_dataflow_step_lookup
+from finn.util.initializer_store import load_model, save_model
 
 
 # adapted from https://stackoverflow.com/a/39215961
@@ -118,7 +119,7 @@ def build_dataflow_cfg(model_filename, cfg: DataflowBuildConfig):
             "Building dataflow accelerator from intermediate checkpoint"
             + intermediate_model_filename
         )
-        model = ModelWrapper(intermediate_model_filename)
+        model = load_model(intermediate_model_filename)
     assert type(model) is ModelWrapper
     finn_build_dir = os.environ["FINN_BUILD_DIR"]
 
@@ -166,7 +167,10 @@ def build_dataflow_cfg(model_filename, cfg: DataflowBuildConfig):
                 intermediate_model_dir = cfg.output_dir + "/intermediate_models"
                 if not os.path.exists(intermediate_model_dir):
                     os.makedirs(intermediate_model_dir)
-                model.save("%s/%s" % (intermediate_model_dir, chkpt_name))
+                if cfg.intermediate_models_external_data:
+                    save_model(model, "%s/%s" % (intermediate_model_dir, chkpt_name))
+                else:
+                    model.save("%s/%s" % (intermediate_model_dir, chkpt_name))
             step_num += 1
         except:  # noqa
             # restore stdout/stderr
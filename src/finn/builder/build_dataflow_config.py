@@ -96,6 +96,9 @@ class VerificationStepType(str, Enum):
     STREAMLINED_PYTHON = "streamlined_python"
     #: verify after step_apply_folding_config, using C++ for each HLS node
     FOLDED_HLS_CPPSIM = "folded_hls_cppsim"
+    #: verify before step_create_stitched_ip, using the C++ models of all nodes
+    #: connected in the stitched topology in a single process
+    STITCHED_IP_CPPSIM = "stitched_ip_cppsim"
     #: verify after step_create_stitched_ip, using stitched-ip Verilog
     STITCHED_IP_RTLSIM = "stitched_ip_rtlsim"
 
@@ -220,6 +223,18 @@ class DataflowBuildConfig:
     #: the full list of layer IP build directories. By default, synthesis will not run.
     stitched_ip_gen_dcp: Optional[bool] = False
 
+    #: (Optional) Update the stitched-IP project of a previous run of the
+    #: create_stitched_ip step (e.g. from a checkpoint, or before switching
+    #: FIFOs to RTL for stitched-IP rtlsim) by replacing only the changed
+    #: layers and connections, instead of building it from scratch.
+    stitched_ip_incremental: Optional[bool] = False
+
+    #: (Optional) Run out-of-context synthesis separately for each layer, in
+    #: parallel, instead of for the whole stitched IP. Results are cached by
+    #: layer IP, so repeat builds only synthesize layers that changed. Faster
+    #: for resource estimates, but does not account for FIFOs and interconnect.
+    ooc_synth_per_node: Optional[bool] = False
+
     #: Insert a signature node to the stitched-IP to read/write information
     #: to the design: e.g. Customer signature, application signature, version
     signature: Optional[List[int]] = None
@@ -231,6 +246,13 @@ class DataflowBuildConfig:
     #: very high performance.
     mvau_wwidth_max: Optional[int] = 36
 
+    #: (Optional) Whether the RTL MVAU layers should be folded as bit-serial
+    #: units where the target_fps still allows it. Bit-serial MVAUs use LUTs
+    #: instead of DSPs and take one cycle per input bit, so this trades
+    #: throughput for DSPs on LUT-rich, DSP-poor parts. Only has an effect when
+    #: target_fps is set.
+    mvau_bit_serial: Optional[bool] = False
+
     #: (Optional) Whether thresholding layers (which implement quantized
     #: activations in FINN) will be implemented as stand-alone HW layers,
     #: instead of being part of MatrixVectorActivation layer. This gives larger
@@ -243,6 +265,12 @@ class DataflowBuildConfig:
     #: writeable weights is not enabled.
     minimize_bit_width: Optional[bool] = True
 
+    #: (Optional) Whether intermediate stream datatypes will additionally be
+    #: narrowed based on the value ranges propagated through the graph, e.g.
+    #: after thresholding layers whose thresholds can not all be crossed.
+    #: Only used if minimize_bit_width is enabled.
+    minimize_stream_widths: Optional[bool] = False
+
     #: Target board, only needed for generating full bitfiles where the FINN
     #: design is integrated into a shell.
     #: e.g. "Pynq-Z1" or "U250"
@@ -279,6 +307,20 @@ class DataflowBuildConfig:
     #: Only relevant when `auto_fifo_depths = True`
     large_fifo_mem_style: Optional[LargeFIFOMemStyle] = LargeFIFOMemStyle.AUTO
 
+    #: (Optional) FIFOs deeper than this will be implemented as virtual FIFOs
+    #: that spill to off-chip memory through an AXI-MM master (StreamingFIFO
+    #: impl_style=dram). If None, all FIFOs are kept on-chip.
+    #: Only relevant when `auto_fifo_depths = True` and
+    #: `auto_fifo_strategy = "largefifo_rtlsim"`
+    dram_fifo_depth_threshold: Optional[int] = None
+
+    #: (Optional) Byte address of the off-chip memory region reserved for the
+    #: ring buffers of virtual FIFOs, which are allocated one after another
+    #: starting from this address. There is no default as the region must be
+    #: reserved for the accelerator, so this is required whenever
+    #: `dram_fifo_depth_threshold` is set.
+    dram_fifo_base_addr: Optional[int] = None
+
     #: Target clock frequency (in nanoseconds) for Vitis HLS synthesis.
     #: e.g. `hls_clk_period_ns=5.0` will target a 200 MHz clock.
     #: If not specified it will default to synth_clk_period_ns
@@ -308,6 +350,12 @@ class DataflowBuildConfig:
     #: These can be useful for debugging if the build fails.
     save_intermediate_models: Optional[bool] = True
 
+    #: (Optional) Store the weights of intermediate models only once, as
+    #: content-addressed ONNX external data under intermediate_models/blobs,
+    #: instead of in every intermediate .onnx file. Saves disk space and time
+    #: for large models. The intermediate models still load as usual.
+    intermediate_models_external_data: Optional[bool] = False
+
     #: Whether hardware debugging will be enabled (e.g. ILA cores inserted to
     #: debug signals in the generated hardware)
     enable_hw_debug: Optional[bool] = False
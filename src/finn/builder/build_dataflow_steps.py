@@ -58,6 +58,7 @@ import finn.transformation.fpgadataflow.convert_to_hw_layers as to_hw
 import finn.transformation.streamline.absorb as absorb
 from finn.analysis.fpgadataflow.dataflow_performance import dataflow_performance
 from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.analysis.fpgadataflow.exp_dram_bytes_per_layer import exp_dram_bytes_per_layer
 from finn.analysis.fpgadataflow.hls_synth_res_estimation import hls_synth_res_estimation
 from finn.analysis.fpgadataflow.op_and_param_counts import (
     aggregate_dict_keys,
@@ -74,7 +75,7 @@ from finn.builder.build_dataflow_config import (
     ShellFlowType,
     VerificationStepType,
 )
-from finn.core.onnx_exec import execute_onnx
+from finn.core.onnx_exec import ExecutionSession
 from finn.core.rtlsim_exec import rtlsim_exec
 from finn.core.throughput_test import throughput_test_rtlsim
 from finn.transformation.fpgadataflow.annotate_cycles import AnnotateCycles
@@ -90,17 +91,22 @@ from finn.transformation.fpgadataflow.derive_characteristic import (
 from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
 from finn.transformation.fpgadataflow.insert_dwc import InsertDWC
 from finn.transformation.fpgadataflow.insert_fifo import InsertFIFO
+from finn.transformation.fpgadataflow.lower_winograd import LowerConvsToWinograd
 from finn.transformation.fpgadataflow.make_pynq_driver import MakePYNQDriver
 from finn.transformation.fpgadataflow.make_zynq_proj import ZynqBuild
 from finn.transformation.fpgadataflow.minimize_accumulator_width import (
     MinimizeAccumulatorWidth,
 )
+from finn.transformation.fpgadataflow.minimize_stream_widths import MinimizeStreamWidths
 from finn.transformation.fpgadataflow.minimize_weight_bit_width import (
     MinimizeWeightBitWidth,
 )
 from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
 from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
 from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
+from finn.transformation.fpgadataflow.prepare_stitched_cppsim import (
+    PrepareStitchedCppSim,
+)
 from finn.transformation.fpgadataflow.replace_verilog_relpaths import (
     ReplaceVerilogRelPaths,
 )
@@ -112,7 +118,10 @@ from finn.transformation.fpgadataflow.set_fifo_depths import (
 )
 from finn.transformation.fpgadataflow.set_folding import SetFolding
 from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
-from finn.transformation.fpgadataflow.synth_ooc import SynthOutOfContext
+from finn.transformation.fpgadataflow.synth_ooc import (
+    SynthOutOfContext,
+    SynthOutOfContextPerNode,
+)
 from finn.transformation.fpgadataflow.vitis_build import VitisBuild
 from finn.transformation.move_reshape import RemoveCNVtoFCFlatten
 from finn.transformation.qonnx.convert_qonnx_to_finn import ConvertQONNXtoFINN
@@ -125,6 +134,8 @@ from finn.util.basic import (
     get_rtlsim_trace_depth,
     pyverilate_get_liveness_threshold_cycles,
 )
+from finn.util.host_partitions import save_host_partitions
+from finn.util.initializer_store import save_model
 from finn.util.pyverilator import verilator_fifosim
 from finn.util.test import execute_parent
 
@@ -145,6 +156,8 @@ def verify_step(
     bsize_out = exp_out_npy_all.shape[0]
     assert bsize_in == bsize_out, "Batch sizes don't match for verification IO pair"
     all_res = True
+    # the same model runs once per verification sample
+    session = None
     for b in range(bsize_in):
         in_npy = np.expand_dims(in_npy_all[b], axis=0)
         exp_out_npy = np.expand_dims(exp_out_npy_all[b], axis=0)
@@ -180,7 +193,9 @@ def verify_step(
             if rtlsim_pre_hook is not None:
                 out_dict = rtlsim_exec(model, inp_dict, pre_hook=rtlsim_pre_hook)
             else:
-                out_dict = execute_onnx(model, inp_dict, True)
+                if session is None:
+                    session = ExecutionSession(model)
+                out_dict = session.run(inp_dict, cfg.verify_save_full_context)
             out_npy = out_dict[out_tensor_name]
         exp_oshape = exp_out_npy.shape
         if out_npy.shape != exp_oshape:
@@ -241,6 +256,7 @@ def prepare_for_stitched_ip_rtlsim(verify_model, cfg):
                     cfg._resolve_fpga_part(),
                     cfg.synth_clk_period_ns,
                     vitis=False,
+                    incremental=cfg.stitched_ip_incremental,
                 )
             )
     else:
@@ -380,8 +396,18 @@ def step_create_dataflow_partition(model: ModelWrapper, cfg: DataflowBuildConfig
     sdp_node = getCustomOp(sdp_node)
     dataflow_model_filename = sdp_node.get_nodeattr("model")
     if cfg.save_intermediate_models:
-        parent_model.save(cfg.output_dir + "/intermediate_models/dataflow_parent.onnx")
+        parent_model_fn = cfg.output_dir + "/intermediate_models/dataflow_parent.onnx"
+        if cfg.intermediate_models_external_data:
+            save_model(parent_model, parent_model_fn)
+        else:
+            parent_model.save(parent_model_fn)
     model = ModelWrapper(dataflow_model_filename)
+    # non-dataflow nodes before/after the partition, run on the host by the
+    # generated driver: save them next to it, independent of intermediate models
+    if DataflowOutputType.PYNQ_DRIVER in cfg.generate_outputs:
+        host_partitions = save_host_partitions(parent_model, cfg.output_dir + "/driver")
+        for kind, host_model_fn in host_partitions.items():
+            model.set_metadata_prop("host_%s_model" % kind, host_model_fn)
 
     # create a configuration json file that can be used to set the specialize layer config
     attrs = [
@@ -423,6 +449,7 @@ def step_target_fps_parallelization(model: ModelWrapper, cfg: DataflowBuildConfi
                 target_cycles_per_frame,
                 mvau_wwidth_max=cfg.mvau_wwidth_max,
                 two_pass_relaxation=cfg.folding_two_pass_relaxation,
+                mvau_bit_serial=cfg.mvau_bit_serial,
             )
         )
         # extract the suggested configuration and save it as json
@@ -436,6 +463,7 @@ def step_target_fps_parallelization(model: ModelWrapper, cfg: DataflowBuildConfi
             "runtime_writeable_weights",
             "depth_trigger_uram",
             "depth_trigger_bram",
+            "bitSerial",
         ]
         extract_model_config_to_json(model, cfg.output_dir + "/auto_folding_config.json", hw_attrs)
 
@@ -444,11 +472,13 @@ def step_target_fps_parallelization(model: ModelWrapper, cfg: DataflowBuildConfi
 
 def step_apply_folding_config(model: ModelWrapper, cfg: DataflowBuildConfig):
     """Apply the folding configuration file onto the model to set folding (parallelization)
-    and other attributes, if config file is specified."""
+    and other attributes, if config file is specified. Convolutions marked with
+    winograd=1 in the folding config are then lowered to Winograd F(2x2, 3x3)."""
 
     if cfg.folding_config_file is not None:
         model = model.transform(GiveUniqueNodeNames())
         model = model.transform(ApplyConfig(cfg.folding_config_file))
+        model = model.transform(LowerConvsToWinograd())
 
     if VerificationStepType.FOLDED_HLS_CPPSIM in cfg._resolve_verification_steps():
         # prepare cppsim
@@ -471,6 +501,10 @@ def step_generate_estimate_reports(model: ModelWrapper, cfg: DataflowBuildConfig
         estimate_layer_cycles = model.analysis(exp_cycles_per_layer)
         with open(report_dir + "/estimate_layer_cycles.json", "w") as f:
             json.dump(estimate_layer_cycles, f, indent=2)
+        estimate_layer_dram_bytes = model.analysis(exp_dram_bytes_per_layer)
+        if len(estimate_layer_dram_bytes) > 0:
+            with open(report_dir + "/estimate_layer_dram_bytes.json", "w") as f:
+                json.dump(estimate_layer_dram_bytes, f, indent=2)
         estimate_layer_resources = model.analysis(
             partial(res_estimation, fpgapart=cfg._resolve_fpga_part())
         )
@@ -493,16 +527,24 @@ def step_generate_estimate_reports(model: ModelWrapper, cfg: DataflowBuildConfig
             estimate_network_performance["critical_path_cycles"] * cfg.synth_clk_period_ns
         )
         estimate_network_performance["estimated_latency_ns"] = est_latency_ns
+        if len(estimate_layer_dram_bytes) > 0:
+            # external memory traffic at the estimated throughput
+            dram_bytes_per_sample = sum(estimate_layer_dram_bytes.values())
+            est_dram_bw = dram_bytes_per_sample * est_fps / (10**6)
+            estimate_network_performance["estimated_dram_bandwidth_MBps"] = est_dram_bw
         with open(report_dir + "/estimate_network_performance.json", "w") as f:
             json.dump(estimate_network_performance, f, indent=2)
     return model
 
 
 def step_minimize_bit_width(model: ModelWrapper, cfg: DataflowBuildConfig):
-    """Tighten the weight and accumulator bit widths for each layer."""
+    """Tighten the weight and accumulator bit widths for each layer, and
+    optionally the stream widths between layers."""
     if cfg.minimize_bit_width:
         model = model.transform(MinimizeWeightBitWidth())
         model = model.transform(MinimizeAccumulatorWidth())
+        if cfg.minimize_stream_widths:
+            model = model.transform(MinimizeStreamWidths())
         # make sure the changed datatypes are propagated through the network
         model = model.transform(InferDataTypes())
     return model
@@ -583,6 +625,8 @@ def step_set_fifo_depths(model: ModelWrapper, cfg: DataflowBuildConfig):
                     swg_exception=cfg.default_swg_exception,
                     vivado_ram_style=cfg.large_fifo_mem_style,
                     force_python_sim=force_python_sim,
+                    max_onchip_depth=cfg.dram_fifo_depth_threshold,
+                    dram_base_addr=cfg.dram_fifo_base_addr,
                 )
             )
             # InsertAndSetFIFODepths internally removes any shallow FIFOs
@@ -610,6 +654,7 @@ def step_set_fifo_depths(model: ModelWrapper, cfg: DataflowBuildConfig):
         "ram_style",
         "depth",
         "impl_style",
+        "dram_base_addr",
         "resType",
         "mem_mode",
         "runtime_writeable_weights",
@@ -638,6 +683,12 @@ def step_create_stitched_ip(model: ModelWrapper, cfg: DataflowBuildConfig):
     """Create stitched IP for a graph after all HLS IP blocks have been generated.
     Depends on the DataflowOutputType.STITCHED_IP output product."""
 
+    if VerificationStepType.STITCHED_IP_CPPSIM in cfg._resolve_verification_steps():
+        # fast functional check of the stitched topology before the Vivado run
+        verify_model = deepcopy(model)
+        verify_model = verify_model.transform(PrepareStitchedCppSim())
+        verify_model.set_metadata_prop("exec_mode", "stitched_cppsim")
+        verify_step(verify_model, cfg, "stitched_ip_cppsim", need_parent=True)
     if DataflowOutputType.STITCHED_IP in cfg.generate_outputs:
         stitched_ip_dir = cfg.output_dir + "/stitched_ip"
         model = model.transform(
@@ -646,6 +697,7 @@ def step_create_stitched_ip(model: ModelWrapper, cfg: DataflowBuildConfig):
                 cfg.synth_clk_period_ns,
                 vitis=cfg.stitched_ip_gen_dcp,
                 signature=cfg.signature,
+                incremental=cfg.stitched_ip_incremental,
             )
         )
         # TODO copy all ip sources into output dir? as zip?
@@ -761,14 +813,31 @@ def step_make_pynq_driver(model: ModelWrapper, cfg: DataflowBuildConfig):
 
 def step_out_of_context_synthesis(model: ModelWrapper, cfg: DataflowBuildConfig):
     """Run out-of-context synthesis and generate reports.
-    Depends on the DataflowOutputType.STITCHED_IP output product."""
+    Depends on the DataflowOutputType.STITCHED_IP output product, unless
+    ooc_synth_per_node is set."""
     if DataflowOutputType.OOC_SYNTH in cfg.generate_outputs:
-        assert DataflowOutputType.STITCHED_IP in cfg.generate_outputs, "OOC needs stitched IP"
-        model = model.transform(
-            SynthOutOfContext(part=cfg._resolve_fpga_part(), clk_period_ns=cfg.synth_clk_period_ns)
-        )
         report_dir = cfg.output_dir + "/report"
         os.makedirs(report_dir, exist_ok=True)
+        if cfg.ooc_synth_per_node:
+            model = model.transform(
+                SynthOutOfContextPerNode(
+                    part=cfg._resolve_fpga_part(), clk_period_ns=cfg.synth_clk_period_ns
+                )
+            )
+            node_res_dict = {}
+            for node in model.graph.node:
+                node_res = getCustomOp(node).get_nodeattr("res_synth")
+                if node_res != "":
+                    node_res_dict[node.name] = eval(node_res)
+            with open(report_dir + "/ooc_synth_per_node.json", "w") as f:
+                json.dump(node_res_dict, f, indent=2)
+        else:
+            assert DataflowOutputType.STITCHED_IP in cfg.generate_outputs, "OOC needs stitched IP"
+            model = model.transform(
+                SynthOutOfContext(
+                    part=cfg._resolve_fpga_part(), clk_period_ns=cfg.synth_clk_period_ns
+                )
+            )
         ooc_res_dict = model.get_metadata_prop("res_total_ooc_synth")
         ooc_res_dict = eval(ooc_res_dict)
 
@@ -26,12 +26,15 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-import copy
 import numpy as np
 import qonnx.analysis.topology as ta
+from qonnx.core.onnx_exec import execute_node
 from qonnx.core.onnx_exec import execute_onnx as execute_onnx_base
+from qonnx.util.basic import get_sanitize_quant_tensors, sanitize_quant_values
 
 from finn.core.rtlsim_exec import rtlsim_exec
+from finn.core.stitched_cppsim_exec import stitched_cppsim_exec
+from finn.util.basic import clone_model
 
 
 def execute_onnx(model, input_dict, return_full_exec_context=False, start_node=None, end_node=None):
@@ -89,14 +92,7 @@ def execute_onnx(model, input_dict, return_full_exec_context=False, start_node=N
     model_exec_mode = model.get_metadata_prop("exec_mode")
     if (model_exec_mode is None) or (model_exec_mode == ""):
         return execute_onnx_base()
-    elif model_exec_mode == "rtlsim":
-        # use stitched IP for rtlsim
-        rtlsim_exec(model, execution_context)
-    else:
-        raise Exception(
-            """Metadata property "exec_mode" is set to an unknown value. Can be left
-            unset or has to be set to "rtlsim" for execution using pyverilator!"""
-        )
+    _execute_whole_graph(model, model_exec_mode, execution_context)
 
     if return_full_exec_context:
         return execution_context
@@ -109,6 +105,163 @@ def execute_onnx(model, input_dict, return_full_exec_context=False, start_node=N
         return output_dict
 
 
+def _execute_whole_graph(model, model_exec_mode, execution_context):
+    """Executes the whole graph at once with the simulation selected by the
+    exec_mode metadata property, reading from and writing to the given
+    execution context."""
+    if model_exec_mode == "rtlsim":
+        # use stitched IP for rtlsim
+        rtlsim_exec(model, execution_context)
+    elif model_exec_mode == "stitched_cppsim":
+        # functional simulation of the whole graph with the per-node C++ models
+        stitched_cppsim_exec(model, execution_context)
+    else:
+        raise Exception(
+            """Metadata property "exec_mode" is set to an unknown value. Can be left
+            unset or has to be set to "rtlsim" for execution using pyverilator, or to
+            "stitched_cppsim" for the stitched C++ simulation!"""
+        )
+
+
+class ExecutionSession:
+    """Executes the same ModelWrapper repeatedly with different inputs, e.g. in
+    a validation loop, without rebuilding the execution context every time.
+
+    execute_onnx starts every call from model.make_empty_exec_context(), which
+    converts all initializers to numpy and allocates a zero buffer for every
+    tensor. A session does this analysis once: initializers are converted a
+    single time and shared between runs as read-only arrays, and the tensor
+    lifetimes are computed from the (topologically sorted) node list.
+
+    Node implementations replace the context entries of their outputs with
+    newly computed arrays and only look at the pre-existing entries for their
+    shape. The session therefore keeps a small pool of shape placeholders,
+    where tensors with disjoint lifetimes share one buffer, and drops every
+    intermediate tensor from the context after its last consumer has run, so
+    the peak memory is bounded by the live activations instead of all of them.
+    With return_full_exec_context=True nothing is dropped or shared, and the
+    returned context owns all its non-initializer buffers.
+
+    The session assumes that the model is not modified after its creation."""
+
+    def __init__(self, model):
+        if not model.check_all_tensor_shapes_specified():
+            raise Exception("Found unspecified tensor shapes, try infer_shapes")
+        ret = model.analysis(ta.nodes_topologically_sorted)
+        assert (
+            ret["nodes_topologically_sorted"] is True
+        ), """Nodes must be
+        topologically sorted."""
+        self.model = model
+        self.exec_mode = model.get_metadata_prop("exec_mode")
+        graph = model.graph
+        self.opset_version = None
+        for opset in model.model.opset_import:
+            if opset.domain in ["", "ai.onnx"]:
+                self.opset_version = opset.version
+        self.initializers = dict()
+        for init in graph.initializer:
+            arr = model.get_initializer(init.name)
+            arr.setflags(write=False)
+            self.initializers[init.name] = arr
+        self.input_names = [x.name for x in graph.input if x.name not in self.initializers]
+        self.output_names = [x.name for x in graph.output]
+        self.shapes = dict()
+        for vi in list(graph.input) + list(graph.value_info) + list(graph.output):
+            if vi.name not in self.initializers:
+                self.shapes[vi.name] = tuple(model.get_tensor_shape(vi.name))
+        self._plan_buffers()
+
+    def _plan_buffers(self):
+        """Computes which intermediate tensors die after each node and assigns
+        the tensors with disjoint lifetimes and equal shapes to shared
+        placeholder buffers."""
+        nodes = self.model.graph.node
+        # tensors that are never dropped from the context
+        persistent = set(self.initializers.keys())
+        persistent.update(self.input_names)
+        persistent.update(self.output_names)
+        last_use = dict()
+        for idx, node in enumerate(nodes):
+            for tname in list(node.input) + list(node.output):
+                if tname != "" and tname not in persistent:
+                    last_use[tname] = idx
+        self.free_after = [[] for _ in nodes]
+        for tname, idx in last_use.items():
+            self.free_after[idx].append(tname)
+        # placeholders, keyed by shape
+        self.buffer_of = dict()
+        self.buffers = []
+        free_buffers = dict()
+        for idx, node in enumerate(nodes):
+            for tname in node.output:
+                if tname not in last_use or tname not in self.shapes:
+                    continue
+                shape = self.shapes[tname]
+                if free_buffers.get(shape):
+                    buf_idx = free_buffers[shape].pop()
+                else:
+                    buf_idx = len(self.buffers)
+                    self.buffers.append(np.zeros(shape, dtype=np.float32))
+                self.buffer_of[tname] = buf_idx
+            for tname in self.free_after[idx]:
+                if tname in self.buffer_of:
+                    shape = self.shapes[tname]
+                    free_buffers.setdefault(shape, []).append(self.buffer_of[tname])
+
+    def _make_context(self, input_dict, full_context):
+        context = dict(self.initializers)
+        for tname, shape in self.shapes.items():
+            if full_context or tname not in self.buffer_of:
+                context[tname] = np.zeros(shape, dtype=np.float32)
+            else:
+                context[tname] = self.buffers[self.buffer_of[tname]]
+        for inp_name in input_dict.keys():
+            if inp_name in context:
+                if context[inp_name].shape == input_dict[inp_name].shape:
+                    context[inp_name] = input_dict[inp_name]
+                else:
+                    raise Exception(
+                        "Shape mismatch for provided input %s: found %s expected %s "
+                        % (
+                            inp_name,
+                            str(context[inp_name].shape),
+                            str(input_dict[inp_name].shape),
+                        )
+                    )
+        return context
+
+    def run(self, input_dict, return_full_exec_context=False):
+        """Executes the model with given named inputs. Returns a dict of named
+        outputs, or the full execution context if return_full_exec_context is
+        True, like execute_onnx."""
+        context = self._make_context(input_dict, return_full_exec_context)
+        if (self.exec_mode is None) or (self.exec_mode == ""):
+            graph = self.model.graph
+            sanitize = get_sanitize_quant_tensors() != 0
+            for idx, node in enumerate(graph.node):
+                execute_node(
+                    node,
+                    context,
+                    graph,
+                    return_full_exec_context,
+                    opset_version=self.opset_version,
+                )
+                if sanitize:
+                    # round output values to quantization annotation
+                    context = sanitize_quant_values(self.model, node.output, context)
+                if not return_full_exec_context:
+                    for tname in self.free_after[idx]:
+                        context.pop(tname, None)
+        else:
+            _execute_whole_graph(self.model, self.exec_mode, context)
+
+        if return_full_exec_context:
+            return context
+        else:
+            return {out_name: context[out_name] for out_name in self.output_names}
+
+
 def execute_onnx_and_make_model(model, input_dict):
     """Executes given ONNX ModelWrapper with given named inputs and return a new
     ModelWrapper where an initializer is provided for each tensor as taken from
@@ -117,7 +270,8 @@ def execute_onnx_and_make_model(model, input_dict):
 
     # retrieve the full execution context
     execution_context = execute_onnx(model, input_dict, True)
-    new_model = copy.deepcopy(model)
+    # the context holds all initializers too, no need to copy them
+    new_model = clone_model(model, initializers=False)
     # create value_info entries and initializers for everything
     for i in execution_context.keys():
         new_model.set_initializer(i, execution_context[i])
@@ -32,6 +32,7 @@ from qonnx.custom_op.registry import getCustomOp
 
 from finn.util.basic import pyverilate_get_liveness_threshold_cycles
 from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
+from finn.util.fpgadataflow import weight_reuse_batch_multiple
 from finn.util.pyverilator import pyverilate_stitched_ip
 
 try:
@@ -89,6 +90,14 @@ def rtlsim_exec(model, execution_context, pre_hook=None, post_hook=None):
             i_stream_w = first_node.get_instream_width(node_inp_ind)
             i_folded_shape = first_node.get_folded_input_shape(node_inp_ind)
         batchsize = i_tensor.shape[0]
+        # batch-tiled layers wait for complete groups of weightReuse frames
+        batch_multiple = weight_reuse_batch_multiple(model)
+        assert (
+            batchsize % batch_multiple == 0
+        ), "Batch size %d is not a multiple of the weightReuse %d of the model" % (
+            batchsize,
+            batch_multiple,
+        )
         # override batch size for input
         i_folded_shape = list(i_folded_shape)
         i_folded_shape[0] = batchsize
@@ -0,0 +1,89 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import os
+import shutil
+import subprocess
+from qonnx.core.datatype import DataType
+from qonnx.custom_op.registry import getCustomOp
+
+from finn.util.basic import make_build_dir
+
+
+def stitched_cppsim_exec(model, execution_context):
+    """Execute the given dataflow model with the stitched cppsim executable
+    (see PrepareStitchedCppSim), which is built first if the model has none.
+    The execution context contains the input values. If the model has the
+    stitched_cppsim_threads metadata property set to "0", the nodes run one
+    after the other instead of as concurrent threads."""
+    exe = model.get_metadata_prop("stitched_cppsim_exe")
+    if exe is None or not os.path.isfile(exe):
+        # imported here, the transformation imports the custom ops which in
+        # turn depend on onnx_exec
+        from finn.transformation.fpgadataflow.prepare_stitched_cppsim import (
+            PrepareStitchedCppSim,
+        )
+
+        model, _ = PrepareStitchedCppSim().apply(model)
+        exe = model.get_metadata_prop("stitched_cppsim_exe")
+    threaded = model.get_metadata_prop("stitched_cppsim_threads") != "0"
+
+    npy_dir = make_build_dir(prefix="stitched_cppsim_exec_")
+    batchsize = None
+    for i, i_vi in enumerate(model.graph.input):
+        i_name = i_vi.name
+        i_tensor = execution_context[i_name]
+        batchsize = i_tensor.shape[0]
+        first_node_onnx = model.find_consumer(i_name)
+        first_node = getCustomOp(first_node_onnx)
+        node_inp_ind = list(first_node_onnx.input).index(i_name)
+        i_folded_shape = list(first_node.get_folded_input_shape(node_inp_ind))
+        i_folded_shape[0] = batchsize
+        i_tensor = i_tensor.reshape(i_folded_shape)
+        if model.get_tensor_datatype(i_name) == DataType["BIPOLAR"]:
+            # store bipolar activations as binary
+            i_tensor = (i_tensor + 1) / 2
+        np.save(os.path.join(npy_dir, "input_%d.npy" % i), i_tensor.astype(np.float32))
+
+    cmd = [exe, npy_dir, str(batchsize)] + ([] if threaded else ["seq"])
+    ret = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if ret.returncode != 0:
+        raise Exception("Stitched cppsim failed:\n" + ret.stdout.decode("utf-8"))
+
+    for o, o_vi in enumerate(model.graph.output):
+        o_name = o_vi.name
+        o_shape = list(model.get_tensor_shape(o_name))
+        o_shape[0] = batchsize
+        output = np.load(os.path.join(npy_dir, "output_%d.npy" % o)).reshape(o_shape)
+        if model.get_tensor_datatype(o_name) == DataType["BIPOLAR"]:
+            # reinterpret binary output as bipolar
+            output = 2 * output - 1
+        execution_context[o_name] = output
+    shutil.rmtree(npy_dir)
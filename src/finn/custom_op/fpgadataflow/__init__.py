@@ -33,13 +33,16 @@ from finn.custom_op.fpgadataflow.concat import StreamingConcat
 from finn.custom_op.fpgadataflow.convolutioninputgenerator import (
     ConvolutionInputGenerator,
 )
+from finn.custom_op.fpgadataflow.depthwise_separable import DepthwiseSeparable
 from finn.custom_op.fpgadataflow.downsampler import DownSampler
 from finn.custom_op.fpgadataflow.duplicatestreams import DuplicateStreams
+from finn.custom_op.fpgadataflow.dynamic_matmul import DynamicMatMul
 from finn.custom_op.fpgadataflow.fmpadding import FMPadding
 from finn.custom_op.fpgadataflow.fmpadding_pixel import FMPadding_Pixel
 from finn.custom_op.fpgadataflow.globalaccpool import GlobalAccPool
 from finn.custom_op.fpgadataflow.labelselect import LabelSelect
 from finn.custom_op.fpgadataflow.lookup import Lookup
+from finn.custom_op.fpgadataflow.lookup_activation import LookupActivation
 from finn.custom_op.fpgadataflow.matrixvectoractivation import MVAU
 from finn.custom_op.fpgadataflow.pool import Pool
 from finn.custom_op.fpgadataflow.streamingdataflowpartition import (
@@ -50,10 +53,17 @@ from finn.custom_op.fpgadataflow.streamingdatawidthconverter import (
 )
 from finn.custom_op.fpgadataflow.streamingeltwise import StreamingEltwise
 from finn.custom_op.fpgadataflow.streamingfifo import StreamingFIFO
+from finn.custom_op.fpgadataflow.streaminglayernorm import StreamingLayerNorm
 from finn.custom_op.fpgadataflow.streamingmaxpool import StreamingMaxPool
+from finn.custom_op.fpgadataflow.streamingsoftmax import StreamingSoftmax
 from finn.custom_op.fpgadataflow.thresholding import Thresholding
 from finn.custom_op.fpgadataflow.upsampler import UpsampleNearestNeighbour
 from finn.custom_op.fpgadataflow.vectorvectoractivation import VVAU
+from finn.custom_op.fpgadataflow.winograd_input_transform import WinogradInputTransform
+from finn.custom_op.fpgadataflow.winograd_mvau import WinogradMVAU
+from finn.custom_op.fpgadataflow.winograd_output_transform import (
+    WinogradOutputTransform,
+)
 
 custom_op = dict()
 
@@ -68,16 +78,24 @@ custom_op["StreamingDataflowPartition"] = StreamingDataflowPartition
 custom_op["AddStreams"] = AddStreams
 custom_op["ChannelwiseOp"] = ChannelwiseOp
 custom_op["ConvolutionInputGenerator"] = ConvolutionInputGenerator
+custom_op["DepthwiseSeparable"] = DepthwiseSeparable
 custom_op["DownSampler"] = DownSampler
 custom_op["DuplicateStreams"] = DuplicateStreams
+custom_op["DynamicMatMul"] = DynamicMatMul
 custom_op["FMPadding"] = FMPadding
 custom_op["FMPadding_Pixel"] = FMPadding_Pixel
 custom_op["GlobalAccPool"] = GlobalAccPool
 custom_op["LabelSelect"] = LabelSelect
 custom_op["Lookup"] = Lookup
+custom_op["LookupActivation"] = LookupActivation
 custom_op["Pool"] = Pool
 custom_op["StreamingConcat"] = StreamingConcat
 custom_op["StreamingDataWidthConverter"] = StreamingDataWidthConverter
 custom_op["StreamingEltwise"] = StreamingEltwise
+custom_op["StreamingLayerNorm"] = StreamingLayerNorm
 custom_op["StreamingMaxPool"] = StreamingMaxPool
+custom_op["StreamingSoftmax"] = StreamingSoftmax
 custom_op["UpsampleNearestNeighbour"] = UpsampleNearestNeighbour
+custom_op["WinogradInputTransform"] = WinogradInputTransform
+custom_op["WinogradMVAU"] = WinogradMVAU
+custom_op["WinogradOutputTransform"] = WinogradOutputTransform
@@ -47,6 +47,10 @@ class AddStreams(HWCustomOp):
                 "PE": ("i", True, ""),
                 # FINN DataTypes for inputs; output datatype inferred from input
                 "inputDataType": ("s", True, ""),
+                # optional override for the output datatype, e.g. set by
+                # MinimizeStreamWidths when the range of the sum is known
+                # to be narrower than the worst case of inputDataType
+                "outputDataType": ("s", False, ""),
                 # number of input vectors, examples:
                 # [1] is a single vector (like a FC layer with batch=1)
                 # [4] is four vectors (like a FC layer with batch=4)
@@ -110,9 +114,10 @@ class AddStreams(HWCustomOp):
 
     def get_output_datatype(self, ind=0):
         """Returns FINN DataType of output."""
-        # we need to set output datatype to the next larger int or uint
-        # enhancement: consider specifying w/ explicit outputDataType attribute
-        # to allow overflow and use the same idt if user wants
+        odt_name = self.get_nodeattr("outputDataType")
+        if odt_name != "":
+            return DataType[odt_name]
+        # otherwise set output datatype to the next larger int or uint
         idt = DataType[self.get_nodeattr("inputDataType")]
         if idt.signed():
             return DataType.get_smallest_possible(2 * idt.min())
@@ -0,0 +1,251 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import warnings
+from onnx import helper
+from qonnx.core.datatype import DataType
+from qonnx.custom_op.registry import getCustomOp
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+
+# ONNX i/o tensor shape assumptions for DepthwiseSeparable:
+# input 0 is the output of a depthwise SWG, shape (1, OH, OW, k_h*k_w*Channels)
+# input 1 is the depthwise weight tensor, shape (Channels, 1, k_h, k_w)
+# (if dwNoActivation=0) the depthwise thresholds, shape (Channels, n_thres)
+# next is the pointwise weight tensor, shape (Channels, MH)
+# (if pwNoActivation=0) the pointwise thresholds, shape (MH, n_thres)
+# output 0 is the output tensor, shape (1, OH, OW, MH)
+
+
+class DepthwiseSeparable(HWCustomOp):
+    """Abstraction layer for a fused depthwise-separable convolution block,
+    i.e. a depthwise VVAU stage feeding a pointwise MVAU stage through an
+    internal stream. Since the channel parallelism of both stages is tied to
+    the same SIMD value, no FIFO or data width converter is needed between
+    them. The two stages are described by shadow VVAU/MVAU instances, which
+    execution, parameter generation and estimates are delegated to."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            "Channels": ("i", True, 0),
+            "Kernel": ("ints", True, []),  # [H, W]
+            "Dim": ("ints", True, []),  # [H, W]
+            # output channels of the pointwise stage
+            "MH": ("i", True, 0),
+            # parallelism over the kernel window of the depthwise stage
+            "KernelSIMD": ("i", False, 1),
+            # channel parallelism between the stages, i.e. PE of the
+            # depthwise stage and SIMD of the pointwise stage
+            "SIMD": ("i", True, 0),
+            # output channel parallelism of the pointwise stage
+            "PE": ("i", True, 0),
+            "resType": ("s", False, "auto", {"auto", "lut", "dsp"}),
+            # FINN DataTypes for inputs, weights, outputs of both stages
+            "inputDataType": ("s", True, ""),
+            "dwWeightDataType": ("s", True, ""),
+            "dwAccDataType": ("s", False, "INT32"),
+            "dwOutputDataType": ("s", True, ""),
+            "dwActVal": ("i", False, 0),
+            "dwNoActivation": ("i", False, 0, {0, 1}),
+            "pwWeightDataType": ("s", True, ""),
+            "pwAccDataType": ("s", False, "INT32"),
+            "outputDataType": ("s", True, ""),
+            "pwActVal": ("i", False, 0),
+            "pwNoActivation": ("i", False, 0, {0, 1}),
+            # use xnor-popcount in the pointwise stage
+            "binaryXnorMode": ("i", False, 0, {0, 1}),
+            # depth of the internal stream between the stages
+            "midFIFODepth": ("i", False, 2),
+        }
+        my_attrs.update(super().get_nodeattr_types())
+        return my_attrs
+
+    def get_param_tensor_names(self):
+        """Returns the names of the depthwise weights, depthwise thresholds,
+        pointwise weights and pointwise thresholds, with None in place of
+        the thresholds of a stage without activation."""
+        params = list(self.onnx_node.input[1:])
+        dw_w = params.pop(0)
+        dw_t = None if self.get_nodeattr("dwNoActivation") == 1 else params.pop(0)
+        pw_w = params.pop(0)
+        pw_t = None if self.get_nodeattr("pwNoActivation") == 1 else params.pop(0)
+        return (dw_w, dw_t, pw_w, pw_t)
+
+    def get_stage_insts(self, impl_style=""):
+        """Returns shadow instances of the depthwise (VVAU) and pointwise (MVAU)
+        stage as configured by the attributes of this node. impl_style selects
+        the backend variant of the shadow nodes, e.g. "hls"; the abstraction
+        layers are used if left empty."""
+        node = self.onnx_node
+        dw_w, dw_t, pw_w, pw_t = self.get_param_tensor_names()
+        mid = node.name + "_intermediate"
+        suffix = "_" + impl_style if impl_style != "" else ""
+        domain = "finn.custom_op.fpgadataflow"
+        if impl_style != "":
+            domain += "." + impl_style
+        dw_node = helper.make_node(
+            "VVAU" + suffix,
+            [x for x in [node.input[0], dw_w, dw_t] if x is not None],
+            [mid],
+            domain=domain,
+            backend="fpgadataflow",
+            name=node.name + "_dw",
+            Channels=self.get_nodeattr("Channels"),
+            Kernel=self.get_nodeattr("Kernel"),
+            Dim=self.get_nodeattr("Dim"),
+            PE=self.get_nodeattr("SIMD"),
+            SIMD=self.get_nodeattr("KernelSIMD"),
+            resType=self.get_nodeattr("resType"),
+            ActVal=self.get_nodeattr("dwActVal"),
+            inputDataType=self.get_nodeattr("inputDataType"),
+            weightDataType=self.get_nodeattr("dwWeightDataType"),
+            accDataType=self.get_nodeattr("dwAccDataType"),
+            outputDataType=self.get_nodeattr("dwOutputDataType"),
+            noActivation=self.get_nodeattr("dwNoActivation"),
+            mem_mode="internal_embedded",
+        )
+        pw_node = helper.make_node(
+            "MVAU" + suffix,
+            [x for x in [mid, pw_w, pw_t] if x is not None],
+            [node.output[0]],
+            domain=domain,
+            backend="fpgadataflow",
+            name=node.name + "_pw",
+            MW=self.get_nodeattr("Channels"),
+            MH=self.get_nodeattr("MH"),
+            SIMD=self.get_nodeattr("SIMD"),
+            PE=self.get_nodeattr("PE"),
+            numInputVectors=[1] + list(self.get_nodeattr("Dim")),
+            resType=self.get_nodeattr("resType"),
+            ActVal=self.get_nodeattr("pwActVal"),
+            inputDataType=self.get_nodeattr("dwOutputDataType"),
+            weightDataType=self.get_nodeattr("pwWeightDataType"),
+            accDataType=self.get_nodeattr("pwAccDataType"),
+            outputDataType=self.get_nodeattr("outputDataType"),
+            noActivation=self.get_nodeattr("pwNoActivation"),
+            binaryXnorMode=self.get_nodeattr("binaryXnorMode"),
+            mem_mode="internal_embedded",
+        )
+        return (getCustomOp(dw_node), getCustomOp(pw_node))
+
+    def get_normal_input_shape(self, ind=0):
+        dim_h, dim_w = self.get_nodeattr("Dim")
+        k_h, k_w = self.get_nodeattr("Kernel")
+        ch = self.get_nodeattr("Channels")
+        return tuple([1, dim_h, dim_w, k_h * k_w * ch])
+
+    def get_folded_input_shape(self, ind=0):
+        dw_inst, _ = self.get_stage_insts()
+        return dw_inst.get_folded_input_shape()
+
+    def get_normal_output_shape(self, ind=0):
+        dim_h, dim_w = self.get_nodeattr("Dim")
+        return tuple([1, dim_h, dim_w, self.get_nodeattr("MH")])
+
+    def get_folded_output_shape(self, ind=0):
+        _, pw_inst = self.get_stage_insts()
+        return pw_inst.get_folded_output_shape()
+
+    def make_shape_compatible_op(self, model):
+        oshape = self.get_normal_output_shape()
+        return super().make_const_shape_op(oshape)
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype()),
+                str(idt),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        pass
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("outputDataType")]
+
+    def get_instream_width(self, ind=0):
+        i_bits = self.get_input_datatype().bitwidth()
+        return i_bits * self.get_nodeattr("KernelSIMD") * self.get_nodeattr("SIMD")
+
+    def get_outstream_width(self, ind=0):
+        o_bits = self.get_output_datatype().bitwidth()
+        return o_bits * self.get_nodeattr("PE")
+
+    def get_midstream_width(self):
+        """Returns the width of the internal stream between the stages."""
+        m_bits = DataType[self.get_nodeattr("dwOutputDataType")].bitwidth()
+        return m_bits * self.get_nodeattr("SIMD")
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_stage_exp_cycles(self):
+        """Returns the expected cycles of the depthwise and pointwise stage."""
+        dw_inst, pw_inst = self.get_stage_insts()
+        return (dw_inst.get_exp_cycles(), pw_inst.get_exp_cycles())
+
+    def get_exp_cycles(self):
+        # the stages run concurrently, so the slower one sets the pace
+        return max(self.get_stage_exp_cycles())
+
+    def bram_estimation(self):
+        return sum([x.bram_estimation() for x in self.get_stage_insts()])
+
+    def uram_estimation(self):
+        return sum([x.uram_estimation() for x in self.get_stage_insts()])
+
+    def get_op_and_param_counts(self):
+        ret_dict = {}
+        for stage_inst in self.get_stage_insts():
+            for key, val in stage_inst.get_op_and_param_counts().items():
+                ret_dict[key] = ret_dict.get(key, 0) + val
+        return ret_dict
+
+    def execute_node(self, context, graph):
+        dw_inst, pw_inst = self.get_stage_insts()
+        mid = dw_inst.onnx_node.output[0]
+        context[mid] = np.zeros(dw_inst.get_normal_output_shape(), dtype=np.float32)
+        dw_inst.execute_node(context, graph)
+        pw_inst.execute_node(context, graph)
+        del context[mid]
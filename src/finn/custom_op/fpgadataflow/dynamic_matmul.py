@@ -0,0 +1,290 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import math
+import numpy as np
+import warnings
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+
+# ONNX i/o tensor shape assumptions for DynamicMatMul:
+# input 0 is the streamed operand, shape (..., M, K)
+# input 1 is the buffered operand, shape (..., K, N)
+# output 0 is the result, shape (..., M, N)
+# neither input has an initializer; the ... here is any number of leading
+# dimensions (e.g. batch and attention heads), which must match for both inputs
+
+
+class DynamicMatMul(HWCustomOp):
+    """Abstraction layer for HW implementation of a matrix multiplication
+    between two dynamic (activation) operands, such as Q*K^T and A*V in
+    attention blocks. For every leading index, input 1 is captured into an
+    on-chip buffer and input 0 is streamed against it row by row."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            # parallelization: SIMD folds K, PE folds N
+            "SIMD": ("i", True, 0),
+            "PE": ("i", True, 0),
+            # rows of input 0 per matrix
+            "M": ("i", True, 0),
+            # inner (reduction) dimension
+            "K": ("i", True, 0),
+            # columns of input 1 per matrix
+            "N": ("i", True, 0),
+            "inputDataType0": ("s", True, ""),
+            "inputDataType1": ("s", True, ""),
+            "outputDataType": ("s", True, ""),
+            # use DSPs or LUTs for the multipliers
+            "resType": ("s", False, "auto", {"auto", "lut", "dsp"}),
+            # memory resource for the buffered operand
+            "ram_style": ("s", False, "auto", {"auto", "block", "distributed"}),
+            # leading dimensions, i.e. number of independent matrix products
+            "numInputVectors": ("ints", False, [1]),
+            "inFIFODepths": ("ints", False, [2, 2]),
+        }
+        my_attrs.update(super().get_nodeattr_types())
+        return my_attrs
+
+    def get_normal_input_shape(self, ind=0):
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        m = self.get_nodeattr("M")
+        k = self.get_nodeattr("K")
+        n = self.get_nodeattr("N")
+        if ind == 0:
+            return tuple(vecs + [m, k])
+        else:
+            return tuple(vecs + [k, n])
+
+    def get_folded_input_shape(self, ind=0):
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        m = self.get_nodeattr("M")
+        k = self.get_nodeattr("K")
+        n = self.get_nodeattr("N")
+        simd = self.get_nodeattr("SIMD")
+        pe = self.get_nodeattr("PE")
+        assert k % simd == 0, "SIMD must divide K"
+        assert n % pe == 0, "PE must divide N"
+        if ind == 0:
+            return tuple(vecs + [m, k // simd, simd])
+        else:
+            return tuple(vecs + [k, n // pe, pe])
+
+    def get_normal_output_shape(self, ind=0):
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        return tuple(vecs + [self.get_nodeattr("M"), self.get_nodeattr("N")])
+
+    def get_folded_output_shape(self, ind=0):
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        n = self.get_nodeattr("N")
+        pe = self.get_nodeattr("PE")
+        return tuple(vecs + [self.get_nodeattr("M"), n // pe, pe])
+
+    def make_shape_compatible_op(self, model):
+        for ind in range(2):
+            exp_ishape = self.get_normal_input_shape(ind)
+            ishape = tuple(model.get_tensor_shape(self.onnx_node.input[ind]))
+            assert ishape == exp_ishape, "Unexpected shape for input %d." % ind
+        return super().make_const_shape_op(self.get_normal_output_shape())
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        for ind in range(2):
+            idt = model.get_tensor_datatype(node.input[ind])
+            if idt != self.get_input_datatype(ind):
+                warn_str = "inputDataType%d changing for %s: %s -> %s " % (
+                    ind,
+                    node.name,
+                    str(self.get_input_datatype(ind)),
+                    str(idt),
+                )
+                warnings.warn(warn_str)
+            self.set_nodeattr("inputDataType%d" % ind, idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        pass
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType" + str(ind))]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("outputDataType")]
+
+    def calc_accumulator_datatype(self):
+        """Returns the smallest DataType that can hold any dot product of
+        length K between values of the two input DataTypes."""
+        idt0 = self.get_input_datatype(0)
+        idt1 = self.get_input_datatype(1)
+        k = self.get_nodeattr("K")
+        prods = [a * b for a in (idt0.min(), idt0.max()) for b in (idt1.min(), idt1.max())]
+        acc_min = k * min(prods)
+        acc_max = k * max(prods)
+        if acc_min < 0:
+            return DataType.get_smallest_possible(min(acc_min, -acc_max - 1))
+        return DataType.get_smallest_possible(acc_max)
+
+    def get_instream_width(self, ind=0):
+        """Returns input stream width."""
+        ibits = self.get_input_datatype(ind).bitwidth()
+        if ind == 0:
+            return self.get_nodeattr("SIMD") * ibits
+        else:
+            return self.get_nodeattr("PE") * ibits
+
+    def get_outstream_width(self, ind=0):
+        """Returns output stream width."""
+        obits = self.get_output_datatype().bitwidth()
+        return self.get_nodeattr("PE") * obits
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def calc_bmem(self):
+        """Calculates and returns the depth of the buffer holding input 1."""
+        k = self.get_nodeattr("K")
+        n = self.get_nodeattr("N")
+        return (k * n) // (self.get_nodeattr("SIMD") * self.get_nodeattr("PE"))
+
+    def get_exp_cycles(self):
+        # for each of the numInputVectors products, input 1 is captured with PE
+        # elements per cycle before M rows of input 0 are streamed against it
+        simd = self.get_nodeattr("SIMD")
+        pe = self.get_nodeattr("PE")
+        m = self.get_nodeattr("M")
+        k = self.get_nodeattr("K")
+        n = self.get_nodeattr("N")
+        reps = np.prod(self.get_nodeattr("numInputVectors"))
+        load_cycles = k * (n // pe)
+        compute_cycles = m * (n // pe) * (k // simd)
+        return int(reps * (load_cycles + compute_cycles))
+
+    def bram_estimation(self):
+        """Estimates RAMB18s for the buffer of input 1, using the same
+        SDP-mode model as MVAU weight memories."""
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        W = self.get_input_datatype(1).bitwidth()
+        omega = self.calc_bmem()
+        mem_width = Q * W * P
+        if self.get_nodeattr("ram_style") == "distributed" or omega <= 128:
+            return 0
+        if mem_width == 1:
+            return math.ceil(omega / 16384)
+        elif mem_width == 2:
+            return math.ceil(omega / 8192)
+        elif mem_width <= 4:
+            return (math.ceil(omega / 4096)) * (math.ceil(mem_width / 4))
+        elif mem_width <= 9:
+            return (math.ceil(omega / 2048)) * (math.ceil(mem_width / 9))
+        elif mem_width <= 18 or omega > 512:
+            return (math.ceil(omega / 1024)) * (math.ceil(mem_width / 18))
+        else:
+            return (math.ceil(omega / 512)) * (math.ceil(mem_width / 36))
+
+    def bram_efficiency_estimation(self):
+        bram16_est = self.bram_estimation()
+        if bram16_est == 0:
+            return 1
+        bbits = self.get_input_datatype(1).bitwidth() * self.get_nodeattr("K")
+        bbits *= self.get_nodeattr("N")
+        return bbits / (bram16_est * 36 * 512)
+
+    def lut_estimation(self):
+        """Estimates LUTs following the MVAU model, with the buffered operand
+        taking the place of the weights."""
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        A = self.get_input_datatype(0).bitwidth()
+        W = self.get_input_datatype(1).bitwidth()
+        acc_bits = self.get_output_datatype().bitwidth()
+        c0 = 300
+        c1 = 1.1
+        c2 = 0
+        if self.get_nodeattr("ram_style") == "distributed" or self.calc_bmem() <= 128:
+            c2 = (P * Q * W) * math.ceil(self.calc_bmem() / 64)
+        if self.get_nodeattr("resType") == "dsp":
+            mult_luts = 0
+        else:
+            mult_luts = Q * (2 * math.ceil((W + A) / 6) - 1) * (W + A)
+        addertree_luts = (W + A) * (2 * Q - 1)
+        acc_luts = acc_bits
+        return int(c0 + c1 * (P * (mult_luts + addertree_luts + acc_luts)) + c2)
+
+    def dsp_estimation(self, fpgapart):
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        A = self.get_input_datatype(0).bitwidth()
+        W = self.get_input_datatype(1).bitwidth()
+        if self.get_nodeattr("resType") == "dsp":
+            return int(P * Q * np.ceil((W + A) / 48))
+        return 0
+
+    def get_op_and_param_counts(self):
+        bits0 = self.get_input_datatype(0).bitwidth()
+        bits1 = self.get_input_datatype(1).bitwidth()
+        reps = int(np.prod(self.get_nodeattr("numInputVectors")))
+        m = self.get_nodeattr("M")
+        k = self.get_nodeattr("K")
+        n = self.get_nodeattr("N")
+        # cannonicalize op type: highest bitwidth operand first
+        mac_op_type = "op_mac_%dbx%db" % (min(bits0, bits1), max(bits0, bits1))
+        return {mac_op_type: reps * m * k * n}
+
+    def execute_node(self, context, graph):
+        node = self.onnx_node
+        in0 = context[node.input[0]]
+        in1 = context[node.input[1]]
+        result = np.matmul(in0, in1)
+        oshape = context[node.output[0]].shape
+        context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
+
+    def derive_characteristic_fxns(self, period):
+        io_dict = {
+            "inputs": {
+                "in0": [0 for i in range(np.prod(self.get_folded_input_shape(0)[:-1]))],
+                "in1": [0 for i in range(np.prod(self.get_folded_input_shape(1)[:-1]))],
+            },
+            "outputs": {"out": []},
+        }
+        super().derive_characteristic_fxns(period, override_rtlsim_dict=io_dict)
+
+    def get_verilog_top_module_intf_names(self):
+        intf_names = super().get_verilog_top_module_intf_names()
+        sname = self.hls_sname()
+        intf_names["s_axis"] = [
+            ("in%d_%s" % (ind, sname), self.get_instream_width_padded(ind)) for ind in range(2)
+        ]
+        return intf_names
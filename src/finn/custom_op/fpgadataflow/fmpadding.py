@@ -31,6 +31,7 @@ import warnings
 from qonnx.core.datatype import DataType
 
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.nhwc_kernels import pad_nhwc, to_compute_array
 
 
 class FMPadding(HWCustomOp):
@@ -164,9 +165,7 @@ class FMPadding(HWCustomOp):
         # simulate behavior with Python functionality
         node = self.onnx_node
         pad = self.get_nodeattr("Padding")
-        inp_values = context[node.input[0]]
+        inp_values = to_compute_array(context[node.input[0]], self.get_input_datatype())
         oshape = context[node.output[0]].shape
-        result = np.pad(
-            inp_values, ((0, 0), (pad[0], pad[2]), (pad[1], pad[3]), (0, 0)), "constant"
-        )
+        result = pad_nhwc(inp_values, pad)
         context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
@@ -31,6 +31,7 @@ import warnings
 from qonnx.core.datatype import DataType
 
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.nhwc_kernels import global_sum_nhwc, to_compute_array
 
 
 class GlobalAccPool(HWCustomOp):
@@ -154,7 +155,7 @@ class GlobalAccPool(HWCustomOp):
     def execute_node(self, context, graph):
         # simulate behavior with Python functionality
         node = self.onnx_node
-        inp_values = context[node.input[0]]
+        inp_values = to_compute_array(context[node.input[0]], self.get_input_datatype())
         oshape = context[node.output[0]].shape
-        result = np.apply_over_axes(np.sum, inp_values, [1, 2])
+        result = global_sum_nhwc(inp_values)
         context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
@@ -33,13 +33,18 @@ from finn.custom_op.fpgadataflow.hls.concat_hls import StreamingConcat_hls
 from finn.custom_op.fpgadataflow.hls.convolutioninputgenerator_hls import (
     ConvolutionInputGenerator_hls,
 )
+from finn.custom_op.fpgadataflow.hls.depthwise_separable_hls import (
+    DepthwiseSeparable_hls,
+)
 from finn.custom_op.fpgadataflow.hls.downsampler_hls import DownSampler_hls
 from finn.custom_op.fpgadataflow.hls.duplicatestreams_hls import DuplicateStreams_hls
+from finn.custom_op.fpgadataflow.hls.dynamic_matmul_hls import DynamicMatMul_hls
 from finn.custom_op.fpgadataflow.hls.fmpadding_hls import FMPadding_hls
 from finn.custom_op.fpgadataflow.hls.fmpadding_pixel_hls import FMPadding_Pixel_hls
 from finn.custom_op.fpgadataflow.hls.globalaccpool_hls import GlobalAccPool_hls
 from finn.custom_op.fpgadataflow.hls.iodma_hls import IODMA_hls
 from finn.custom_op.fpgadataflow.hls.labelselect_hls import LabelSelect_hls
+from finn.custom_op.fpgadataflow.hls.lookup_activation_hls import LookupActivation_hls
 from finn.custom_op.fpgadataflow.hls.lookup_hls import Lookup_hls
 from finn.custom_op.fpgadataflow.hls.matrixvectoractivation_hls import MVAU_hls
 from finn.custom_op.fpgadataflow.hls.pool_hls import Pool_hls
@@ -47,11 +52,23 @@ from finn.custom_op.fpgadataflow.hls.streamingdatawidthconverter_hls import (
     StreamingDataWidthConverter_hls,
 )
 from finn.custom_op.fpgadataflow.hls.streamingeltwise_hls import StreamingEltwise_hls
+from finn.custom_op.fpgadataflow.hls.streaminglayernorm_hls import (
+    StreamingLayerNorm_hls,
+)
 from finn.custom_op.fpgadataflow.hls.streamingmaxpool_hls import StreamingMaxPool_hls
+from finn.custom_op.fpgadataflow.hls.streamingsoftmax_hls import StreamingSoftmax_hls
+from finn.custom_op.fpgadataflow.hls.tap_hls import Tap_hls
 from finn.custom_op.fpgadataflow.hls.thresholding_hls import Thresholding_hls
 from finn.custom_op.fpgadataflow.hls.tlastmarker_hls import TLastMarker_hls
 from finn.custom_op.fpgadataflow.hls.upsampler_hls import UpsampleNearestNeighbour_hls
 from finn.custom_op.fpgadataflow.hls.vectorvectoractivation_hls import VVAU_hls
+from finn.custom_op.fpgadataflow.hls.winograd_input_transform_hls import (
+    WinogradInputTransform_hls,
+)
+from finn.custom_op.fpgadataflow.hls.winograd_mvau_hls import WinogradMVAU_hls
+from finn.custom_op.fpgadataflow.hls.winograd_output_transform_hls import (
+    WinogradOutputTransform_hls,
+)
 
 custom_op = dict()
 
@@ -61,21 +78,30 @@ custom_op["AddStreams_hls"] = AddStreams_hls
 custom_op["ChannelwiseOp_hls"] = ChannelwiseOp_hls
 custom_op["CheckSum_hls"] = CheckSum_hls
 custom_op["ConvolutionInputGenerator_hls"] = ConvolutionInputGenerator_hls
+custom_op["DepthwiseSeparable_hls"] = DepthwiseSeparable_hls
 custom_op["DownSampler_hls"] = DownSampler_hls
 custom_op["DuplicateStreams_hls"] = DuplicateStreams_hls
+custom_op["DynamicMatMul_hls"] = DynamicMatMul_hls
 custom_op["FMPadding_hls"] = FMPadding_hls
 custom_op["FMPadding_Pixel_hls"] = FMPadding_Pixel_hls
 custom_op["GlobalAccPool_hls"] = GlobalAccPool_hls
 custom_op["IODMA_hls"] = IODMA_hls
 custom_op["LabelSelect_hls"] = LabelSelect_hls
 custom_op["Lookup_hls"] = Lookup_hls
+custom_op["LookupActivation_hls"] = LookupActivation_hls
 custom_op["Pool_hls"] = Pool_hls
 custom_op["StreamingConcat_hls"] = StreamingConcat_hls
 custom_op["StreamingEltwise_hls"] = StreamingEltwise_hls
 custom_op["StreamingDataWidthConverter_hls"] = StreamingDataWidthConverter_hls
+custom_op["StreamingLayerNorm_hls"] = StreamingLayerNorm_hls
 custom_op["StreamingMaxPool_hls"] = StreamingMaxPool_hls
+custom_op["StreamingSoftmax_hls"] = StreamingSoftmax_hls
+custom_op["Tap_hls"] = Tap_hls
 custom_op["Thresholding_hls"] = Thresholding_hls
 custom_op["TLastMarker_hls"] = TLastMarker_hls
 custom_op["UpsampleNearestNeighbour_hls"] = UpsampleNearestNeighbour_hls
+custom_op["WinogradInputTransform_hls"] = WinogradInputTransform_hls
+custom_op["WinogradMVAU_hls"] = WinogradMVAU_hls
+custom_op["WinogradOutputTransform_hls"] = WinogradOutputTransform_hls
 custom_op["MVAU_hls"] = MVAU_hls
 custom_op["VVAU_hls"] = VVAU_hls
@@ -27,6 +27,7 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import math
 import numpy as np
 import os
 import warnings
@@ -40,6 +41,10 @@ from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
 class CheckSum_hls(HWCustomOp, HLSBackend):
     """Class that corresponds to custom_hls checksum function."""
 
+    # AXI lite register offsets as laid out by Vitis HLS for the arguments
+    # of the generated top-level function
+    register_offsets = {"chk": 0x10, "drain": 0x20}
+
     def __init__(self, onnx_node, **kwargs):
         super().__init__(onnx_node, **kwargs)
 
@@ -130,6 +135,15 @@ class CheckSum_hls(HWCustomOp, HLSBackend):
     def get_ap_int_max_w(self):
         return max(super().get_ap_int_max_w(), 32)
 
+    def lut_estimation(self):
+        """Calculates resource estimations for LUTs: one 24-bit weighted
+        accumulation per subword, the XOR folding of subwords wider than
+        23 bits and the AXI lite slave."""
+        items_per_word = self.get_nodeattr("items_per_word")
+        subword_bits = self.get_instream_width() // items_per_word
+        folds = math.ceil(subword_bits / 23)
+        return items_per_word * (2 * 24 + 23 * (folds - 1)) + 150
+
     def get_normal_output_shape(self, ind=0):
         # same shape as input
         return self.get_normal_input_shape()
@@ -154,7 +168,7 @@ class CheckSum_hls(HWCustomOp, HLSBackend):
         if mode == "cppsim":
             code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
         else:
             raise Exception(
                 """Invalid value for attribute exec_mode! Is currently set to: {}
@@ -102,7 +102,7 @@ class StreamingConcat_hls(StreamingConcat, HLSBackend):
         if mode == "cppsim":
             code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
         else:
             raise Exception(
                 """Invalid value for attribute exec_mode! Is currently set to: {}
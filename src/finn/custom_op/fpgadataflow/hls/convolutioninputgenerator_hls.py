@@ -344,7 +344,7 @@ class ConvolutionInputGenerator_hls(ConvolutionInputGenerator, HLSBackend):
         if mode == "cppsim":
             code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
         else:
             raise Exception(
                 """Invalid value for attribute exec_mode! Is currently set to: {}
@@ -0,0 +1,330 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import os
+import re
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.depthwise_separable import DepthwiseSeparable
+from finn.custom_op.fpgadataflow.hlsbackend import HLSBackend
+from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
+
+
+class DepthwiseSeparable_hls(DepthwiseSeparable, HLSBackend):
+    """Corresponds to finn-hlslib Vector_Vector_Activate_Batch followed by
+    Matrix_Vector_Activate_Batch in a single dataflow region, with the weights
+    of both stages embedded into the IP."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {}
+        my_attrs.update(DepthwiseSeparable.get_nodeattr_types(self))
+        my_attrs.update(HLSBackend.get_nodeattr_types(self))
+        return my_attrs
+
+    def lut_estimation(self):
+        return sum([x.lut_estimation() for x in self.get_stage_insts("hls")])
+
+    def dsp_estimation(self, fpgapart):
+        return sum([x.dsp_estimation(fpgapart) for x in self.get_stage_insts("hls")])
+
+    def generate_params(self, model, path):
+        code_gen_dir = path
+        # let each stage write its params.h and thresh.h, then move them
+        # to per-stage files with per-stage variable names
+        for prefix, stage_inst in zip(["dw", "pw"], self.get_stage_insts("hls")):
+            stage_inst.generate_params(model, code_gen_dir)
+            for fname, var in [("params.h", "weights"), ("thresh.h", "threshs")]:
+                stage_file = "{}/{}".format(code_gen_dir, fname)
+                if not os.path.isfile(stage_file):
+                    continue
+                with open(stage_file, "r") as f:
+                    code = f.read()
+                code = re.sub(r"\b%s\b" % var, "%s_%s" % (prefix, var), code)
+                with open("{}/{}_{}".format(code_gen_dir, prefix, fname), "w") as f:
+                    f.write(code)
+                os.remove(stage_file)
+
+    def execute_node(self, context, graph):
+        mode = self.get_nodeattr("exec_mode")
+        node = self.onnx_node
+
+        if mode == "cppsim":
+            code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
+        else:
+            raise Exception(
+                """Invalid value for attribute exec_mode! Is currently set to: {}
+            has to be set to one of the following value ("cppsim", "rtlsim")""".format(
+                    mode
+                )
+            )
+
+        inp = context[node.input[0]]
+        assert str(inp.dtype) == "float32", "Input datatype is not float32"
+        reshaped_input = inp.reshape(self.get_folded_input_shape())
+        if self.get_input_datatype() == DataType["BIPOLAR"]:
+            # store bipolar activations as binary
+            reshaped_input = (reshaped_input + 1) / 2
+            export_idt = DataType["BINARY"]
+        else:
+            export_idt = self.get_input_datatype()
+        # make copy before saving the array
+        reshaped_input = reshaped_input.copy()
+        np.save(os.path.join(code_gen_dir, "input_0.npy"), reshaped_input)
+
+        if mode == "cppsim":
+            # execute the precompiled model
+            super().exec_precompiled_singlenode_model()
+            # load output npy file
+            super().npy_to_dynamic_output(context)
+            # reinterpret binary output as bipolar where needed
+            if self.get_output_datatype() == DataType["BIPOLAR"]:
+                out = context[node.output[0]]
+                out = 2 * out - 1
+                context[node.output[0]] = out
+            assert (
+                context[node.output[0]].shape == self.get_normal_output_shape()
+            ), "cppsim did not produce expected output shape"
+        elif mode == "rtlsim":
+            sim = self.get_rtlsim()
+            nbits = self.get_instream_width()
+            inp = npy_to_rtlsim_input("{}/input_0.npy".format(code_gen_dir), export_idt, nbits)
+            super().reset_rtlsim(sim)
+            super().toggle_clk(sim)
+            output = self.rtlsim(sim, inp)
+            odt = self.get_output_datatype()
+            target_bits = odt.bitwidth()
+            packed_bits = self.get_outstream_width()
+            out_npy_path = "{}/output.npy".format(code_gen_dir)
+            out_shape = self.get_folded_output_shape()
+            rtlsim_output_to_npy(output, out_npy_path, odt, out_shape, packed_bits, target_bits)
+
+            # load and reshape output
+            output = np.load(out_npy_path)
+            oshape = self.get_normal_output_shape()
+            output = np.asarray([output], dtype=np.float32).reshape(*oshape)
+            context[node.output[0]] = output
+
+    def global_includes(self):
+        dw_inst, pw_inst = self.get_stage_insts("hls")
+        self.code_gen_dict["$GLOBALS$"] = ['#include "weights.hpp"']
+        self.code_gen_dict["$GLOBALS$"] += ['#include "activations.hpp"']
+        self.code_gen_dict["$GLOBALS$"] += ['#include "mvau.hpp"']
+        if dw_inst.calc_tmem() != 0:
+            self.code_gen_dict["$GLOBALS$"] += ['#include "dw_thresh.h"']
+        if pw_inst.calc_tmem() != 0:
+            self.code_gen_dict["$GLOBALS$"] += ['#include "pw_thresh.h"']
+
+    def defines(self, var):
+        # Only ipgen mode: the pointwise stage has the same SIMD requirement
+        # as a standalone MatrixVectorActivation
+        if var == "ipgen":
+            SIMD = self.get_nodeattr("SIMD")
+            MW = self.get_nodeattr("Channels")
+            condition = SIMD >= (MW / 1024)
+            msg = (
+                f"HLS synthesis of DepthwiseSeparable requires: "
+                f"SIMD >= Channels / 1024. This is not fulfilled with: SIMD={SIMD} "
+                f"and Channels={MW} for node: {self.onnx_node.name}."
+            )
+            assert condition, msg
+        dim_h, dim_w = self.get_nodeattr("Dim")
+        k_h, k_w = self.get_nodeattr("Kernel")
+        self.code_gen_dict["$DEFINES$"] = [
+            """#define Channels1 {}\n #define InnerProdDim {}\n #define MH1 {}\n
+            #define KSIMD1 {}\n #define SIMD1 {}\n #define PE1 {}\n
+            #define numReps {}""".format(
+                self.get_nodeattr("Channels"),
+                k_h * k_w,
+                self.get_nodeattr("MH"),
+                self.get_nodeattr("KernelSIMD"),
+                self.get_nodeattr("SIMD"),
+                self.get_nodeattr("PE"),
+                dim_h * dim_w,
+            )
+        ]
+
+    def read_npy_data(self):
+        code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        dtype = self.get_input_datatype()
+        if dtype == DataType["BIPOLAR"]:
+            # use binary for bipolar storage
+            dtype = DataType["BINARY"]
+        elem_bits = dtype.bitwidth()
+        packed_bits = self.get_instream_width()
+        packed_hls_type = "ap_uint<%d>" % packed_bits
+        elem_hls_type = dtype.get_hls_datatype_str()
+        npy_type = "float"
+        npy_in = "%s/input_0.npy" % code_gen_dir
+        self.code_gen_dict["$READNPYDATA$"] = []
+        # note: the innermost dim is reversed for the input
+        self.code_gen_dict["$READNPYDATA$"].append(
+            'npy2apintstream<%s, %s, %d, %s>("%s", in0_%s, false);'
+            % (
+                packed_hls_type,
+                elem_hls_type,
+                elem_bits,
+                npy_type,
+                npy_in,
+                self.hls_sname(),
+            )
+        )
+
+    def docompute(self):
+        map_to_hls_mult_style = {
+            "auto": "ap_resource_dflt()",
+            "lut": "ap_resource_lut()",
+            "dsp": "ap_resource_dsp()",
+        }
+        res = map_to_hls_mult_style[self.get_nodeattr("resType")]
+        dw_inst, pw_inst = self.get_stage_insts("hls")
+        dw_args = dw_inst.get_template_param_values()
+        pw_args = pw_inst.get_template_param_values()
+        if dw_inst.calc_tmem() == 0:
+            odtype_hls_str = dw_inst.get_output_datatype().get_hls_datatype_str()
+            dw_threshs = "PassThroughActivation<%s>()" % odtype_hls_str
+        else:
+            dw_threshs = "dw_threshs"
+        if pw_inst.calc_tmem() == 0:
+            odtype_hls_str = pw_inst.get_output_datatype().get_hls_datatype_str()
+            pw_threshs = "PassThroughActivation<%s>()" % odtype_hls_str
+        else:
+            pw_threshs = "pw_threshs"
+        self.code_gen_dict["$DOCOMPUTE$"] = [
+            'hls::stream<ap_uint<{}>> intermediate ("intermediate");'.format(
+                self.get_midstream_width()
+            ),
+            "#pragma HLS stream variable=intermediate depth={}".format(
+                self.get_nodeattr("midFIFODepth")
+            ),
+            """Vector_Vector_Activate_Batch<Channels1, InnerProdDim, KSIMD1, SIMD1, 1, {}, {}, {}>
+            (in0_{}, intermediate, dw_weights, {}, numReps, {});""".format(
+                dw_args["TSrcI"],
+                dw_args["TDstI"],
+                dw_args["TWeightI"],
+                self.hls_sname(),
+                dw_threshs,
+                res,
+            ),
+            """Matrix_Vector_Activate_Batch<Channels1, MH1, SIMD1, PE1, 1, {}, {}, {}>
+            (intermediate, out_{}, pw_weights, {}, numReps, {});""".format(
+                pw_args["TSrcI"],
+                pw_args["TDstI"],
+                pw_args["TWeightI"],
+                self.hls_sname(),
+                pw_threshs,
+                res,
+            ),
+        ]
+
+    def dataoutstrm(self):
+        code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        dtype = self.get_output_datatype()
+        if dtype == DataType["BIPOLAR"]:
+            # use binary for bipolar storage
+            dtype = DataType["BINARY"]
+        elem_bits = dtype.bitwidth()
+        packed_bits = self.get_outstream_width()
+        packed_hls_type = "ap_uint<%d>" % packed_bits
+        elem_hls_type = dtype.get_hls_datatype_str()
+        npy_type = "float"
+        npy_out = "%s/output.npy" % code_gen_dir
+        shape = self.get_folded_output_shape()
+        shape_cpp_str = str(shape).replace("(", "{").replace(")", "}")
+
+        # note: the innermost dim is not reversed for the output
+        self.code_gen_dict["$DATAOUTSTREAM$"] = [
+            'apintstream2npy<%s, %s, %d, %s>(out_%s, %s, "%s", false);'
+            % (
+                packed_hls_type,
+                elem_hls_type,
+                elem_bits,
+                npy_type,
+                self.hls_sname(),
+                shape_cpp_str,
+                npy_out,
+            )
+        ]
+
+    def blackboxfunction(self):
+        self.code_gen_dict["$BLACKBOXFUNCTION$"] = [
+            """void {}(hls::stream<ap_uint<{}>> &in0_{},
+                hls::stream<ap_uint<{}>> &out_{}
+                )""".format(
+                self.onnx_node.name,
+                self.get_instream_width(),
+                self.hls_sname(),
+                self.get_outstream_width(),
+                self.hls_sname(),
+            )
+        ]
+
+    def pragmas(self):
+        dw_inst, pw_inst = self.get_stage_insts("hls")
+        self.code_gen_dict["$PRAGMAS$"] = [
+            "#pragma HLS INTERFACE axis port=in0_" + self.hls_sname()
+        ]
+        self.code_gen_dict["$PRAGMAS$"].append(
+            "#pragma HLS INTERFACE axis port=out_" + self.hls_sname()
+        )
+        self.code_gen_dict["$PRAGMAS$"].append("#pragma HLS INTERFACE ap_ctrl_none port=return")
+        self.code_gen_dict["$PRAGMAS$"].append("#pragma HLS DATAFLOW disable_start_propagation")
+        for prefix, stage_inst in zip(["dw", "pw"], [dw_inst, pw_inst]):
+            self.code_gen_dict["$PRAGMAS$"].append('#include "%s_params.h"' % prefix)
+            # the weight tensor is ap_uint<simd*prec> [PE][WMEM]
+            # partition for parallel access along the PE dimension (dim 1)
+            self.code_gen_dict["$PRAGMAS$"].append(
+                "#pragma HLS ARRAY_PARTITION variable=%s_weights.m_weights complete dim=1" % prefix
+            )
+            # the threshold tensor is acc_type [PE][TMEM][N_THRES]
+            # partition for parallel access along PE and N_THRES
+            # dimensions (dims 1 and 3)
+            if stage_inst.calc_tmem() != 0:
+                self.code_gen_dict["$PRAGMAS$"].append(
+                    "#pragma HLS ARRAY_PARTITION variable=%s_threshs.m_thresholds complete dim=1"
+                    % prefix
+                )
+                self.code_gen_dict["$PRAGMAS$"].append(
+                    "#pragma HLS ARRAY_PARTITION variable=%s_threshs.m_thresholds complete dim=3"
+                    % prefix
+                )
+
+    def get_ap_int_max_w(self):
+        # base class impl (max of inp/out stream widths)
+        max_of_io = super().get_ap_int_max_w()
+        # single PE weight entry of either stage
+        dw_inst, pw_inst = self.get_stage_insts()
+        dw_w = dw_inst.get_weight_datatype().bitwidth() * self.get_nodeattr("KernelSIMD")
+        pw_w = pw_inst.get_weight_datatype().bitwidth() * self.get_nodeattr("SIMD")
+        return max([max_of_io, self.get_midstream_width(), dw_w, pw_w])
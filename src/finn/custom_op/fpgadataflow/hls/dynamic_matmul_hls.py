@@ -0,0 +1,254 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import os
+
+from finn.custom_op.fpgadataflow.dynamic_matmul import DynamicMatMul
+from finn.custom_op.fpgadataflow.hlsbackend import HLSBackend
+from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
+
+
+class DynamicMatMul_hls(DynamicMatMul, HLSBackend):
+    """Class that corresponds to the custom_hls StreamingDynMatMul function."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {}
+        my_attrs.update(DynamicMatMul.get_nodeattr_types(self))
+        my_attrs.update(HLSBackend.get_nodeattr_types(self))
+        return my_attrs
+
+    def verify_node(self):
+        info_messages = []
+        # verify that "backend" is set to "fpgadataflow"
+        backend_value = self.get_nodeattr("backend")
+        if backend_value == "fpgadataflow":
+            info_messages.append("Attribute backend is set correctly")
+        else:
+            info_messages.append('Attribute backend should be set to "fpgadataflow"')
+
+        # verify that all necessary attributes exist
+        try:
+            self.get_nodeattr("code_gen_dir_cppsim")
+            self.get_nodeattr("executable_path")
+            self.get_nodeattr("SIMD")
+            self.get_nodeattr("PE")
+            self.get_nodeattr("M")
+            self.get_nodeattr("K")
+            self.get_nodeattr("N")
+            self.get_nodeattr("inputDataType0")
+            self.get_nodeattr("inputDataType1")
+            self.get_nodeattr("outputDataType")
+            info_messages.append("All necessary attributes exist")
+        except Exception:
+            info_messages.append("""The required DynamicMatMul attributes do not exist.""")
+
+        # the HLS kernel reinterprets the stream bits as ap_int/ap_uint
+        for ind in range(2):
+            if not self.get_input_datatype(ind).is_integer():
+                info_messages.append("Input %d must have an integer DataType" % ind)
+            elif self.get_input_datatype(ind).name == "BIPOLAR":
+                info_messages.append("Input %d: bipolar inputs are not supported" % ind)
+
+        return info_messages
+
+    def execute_node(self, context, graph):
+        mode = self.get_nodeattr("exec_mode")
+        node = self.onnx_node
+        exp_oshape = self.get_normal_output_shape()
+
+        if mode == "cppsim":
+            code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
+        else:
+            raise Exception(
+                """Invalid value for attribute exec_mode! Is currently set to: {}
+            has to be set to one of the following value ("cppsim", "rtlsim")""".format(
+                    mode
+                )
+            )
+
+        for ind in range(2):
+            inp = context[node.input[ind]]
+            assert str(inp.dtype) == "float32", "Input datatype is not float32"
+            assert inp.shape == self.get_normal_input_shape(ind), (
+                "Input%d shape doesn't match expected shape." % ind
+            )
+            # reshape input into folded form, make copy before saving array
+            reshaped_input = inp.reshape(self.get_folded_input_shape(ind)).copy()
+            np.save(os.path.join(code_gen_dir, "input_%d.npy" % ind), reshaped_input)
+
+        if mode == "cppsim":
+            # execute the precompiled model
+            super().exec_precompiled_singlenode_model()
+            # load output npy file
+            super().npy_to_dynamic_output(context)
+        elif mode == "rtlsim":
+            sim = self.get_rtlsim()
+            rtlsim_inp = [
+                npy_to_rtlsim_input(
+                    "{}/input_{}.npy".format(code_gen_dir, ind),
+                    self.get_input_datatype(ind),
+                    self.get_instream_width(ind),
+                )
+                for ind in range(2)
+            ]
+            super().reset_rtlsim(sim)
+            super().toggle_clk(sim)
+            io_dict = {
+                "inputs": {"in0": rtlsim_inp[0], "in1": rtlsim_inp[1]},
+                "outputs": {"out": []},
+            }
+            self.rtlsim_multi_io(sim, io_dict)
+            rtlsim_output = io_dict["outputs"]["out"]
+            odt = self.get_output_datatype()
+            target_bits = odt.bitwidth()
+            packed_bits = self.get_outstream_width()
+            out_npy_path = "{}/output.npy".format(code_gen_dir)
+            out_shape = self.get_folded_output_shape()
+            rtlsim_output_to_npy(
+                rtlsim_output, out_npy_path, odt, out_shape, packed_bits, target_bits
+            )
+            # load and reshape output
+            output = np.load(out_npy_path)
+            output = np.asarray([output], dtype=np.float32).reshape(*exp_oshape)
+            context[node.output[0]] = output
+
+        assert (
+            context[node.output[0]].shape == exp_oshape
+        ), """Output shape doesn't match expected shape."""
+
+    def global_includes(self):
+        self.code_gen_dict["$GLOBALS$"] = ['#include "dynmatmul.hpp"']
+
+    def defines(self, var):
+        numReps = int(np.prod(self.get_nodeattr("numInputVectors")))
+        self.code_gen_dict["$DEFINES$"] = [
+            "#define K1 {}\n#define N1 {}\n#define M1 {}\n"
+            "#define SIMD1 {}\n#define PE1 {}\n#define numReps {}".format(
+                self.get_nodeattr("K"),
+                self.get_nodeattr("N"),
+                self.get_nodeattr("M"),
+                self.get_nodeattr("SIMD"),
+                self.get_nodeattr("PE"),
+                numReps,
+            )
+        ]
+
+    def read_npy_data(self):
+        code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        npy_type = "float"
+        self.code_gen_dict["$READNPYDATA$"] = []
+        for ind in range(2):
+            dtype = self.get_input_datatype(ind)
+            npy_in = "%s/input_%d.npy" % (code_gen_dir, ind)
+            self.code_gen_dict["$READNPYDATA$"].append(
+                'npy2apintstream<%s, %s, %d, %s>("%s", in%d_%s);'
+                % (
+                    "ap_uint<%d>" % self.get_instream_width(ind),
+                    dtype.get_hls_datatype_str(),
+                    dtype.bitwidth(),
+                    npy_type,
+                    npy_in,
+                    ind,
+                    self.hls_sname(),
+                )
+            )
+
+    def strm_decl(self):
+        self.code_gen_dict["$STREAMDECLARATIONS$"] = []
+        for ind in range(2):
+            self.code_gen_dict["$STREAMDECLARATIONS$"].append(
+                'hls::stream<ap_uint<{}>> in{}_{} ("in{}_{}");'.format(
+                    self.get_instream_width(ind), ind, self.hls_sname(), ind, self.hls_sname()
+                )
+            )
+        self.code_gen_dict["$STREAMDECLARATIONS$"].append(
+            'hls::stream<ap_uint<{}>> out_{} ("out_{}");'.format(
+                self.get_outstream_width(), self.hls_sname(), self.hls_sname()
+            )
+        )
+
+    def docompute(self):
+        tb = self.get_input_datatype(1).get_hls_datatype_str()
+        self.code_gen_dict["$DOCOMPUTE$"] = [
+            "%s buf[PE1][SIMD1][(K1/SIMD1)*(N1/PE1)];" % tb,
+            "#pragma HLS ARRAY_PARTITION variable=buf complete dim=1",
+            "#pragma HLS ARRAY_PARTITION variable=buf complete dim=2",
+        ]
+        ram_style = self.get_nodeattr("ram_style")
+        if ram_style == "distributed":
+            self.code_gen_dict["$DOCOMPUTE$"].append(
+                "#pragma HLS BIND_STORAGE variable=buf type=RAM_S2P impl=LUTRAM"
+            )
+        elif ram_style == "block":
+            self.code_gen_dict["$DOCOMPUTE$"].append(
+                "#pragma HLS BIND_STORAGE variable=buf type=RAM_S2P impl=BRAM"
+            )
+        self.code_gen_dict["$DOCOMPUTE$"].append(
+            """StreamingDynMatMul<K1, N1, M1, SIMD1, PE1, numReps, {}, {}, {}>
+            (in0_{}, in1_{}, out_{}, buf);""".format(
+                self.get_input_datatype(0).get_hls_datatype_str(),
+                tb,
+                self.get_output_datatype().get_hls_datatype_str(),
+                self.hls_sname(),
+                self.hls_sname(),
+                self.hls_sname(),
+            )
+        )
+
+    def blackboxfunction(self):
+        self.code_gen_dict["$BLACKBOXFUNCTION$"] = [
+            """void {}(hls::stream<ap_uint<{}>> &in0_{}, hls::stream<ap_uint<{}>> &in1_{},
+                hls::stream<ap_uint<{}>> &out_{})""".format(
+                self.onnx_node.name,
+                self.get_instream_width(0),
+                self.hls_sname(),
+                self.get_instream_width(1),
+                self.hls_sname(),
+                self.get_outstream_width(),
+                self.hls_sname(),
+            )
+        ]
+
+    def pragmas(self):
+        self.code_gen_dict["$PRAGMAS$"] = [
+            "#pragma HLS INTERFACE axis port=in0_" + self.hls_sname()
+        ]
+        self.code_gen_dict["$PRAGMAS$"].append(
+            "#pragma HLS INTERFACE axis port=in1_" + self.hls_sname()
+        )
+        self.code_gen_dict["$PRAGMAS$"].append(
+            "#pragma HLS INTERFACE axis port=out_" + self.hls_sname()
+        )
+        self.code_gen_dict["$PRAGMAS$"].append("#pragma HLS INTERFACE ap_ctrl_none port=return")
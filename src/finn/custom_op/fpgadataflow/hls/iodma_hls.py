@@ -34,6 +34,7 @@ from qonnx.core.datatype import DataType
 
 from finn.custom_op.fpgadataflow.hlsbackend import HLSBackend
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.fpgadataflow import buffer_resource_estimation
 
 # the IODMA inerfaces a memory-mapped AXI interface and an AXI stream
 # direction "in": pulls data from AXI-MM to AXI stream
@@ -90,8 +91,15 @@ class IODMA_hls(HWCustomOp, HLSBackend):
             # DMA-specific parameters
             # width of axi-mm interface
             "intfWidth": ("i", False, 32),
-            # burst mode for axi-mm interface (wrap used for DRAM weights)
-            "burstMode": ("s", False, "increment", {"wrap", "increment"}),
+            # burst mode for axi-mm interface (wrap used for DRAM weights,
+            # prefetch for DRAM weights replayed by a batch-tiled consumer)
+            "burstMode": ("s", False, "increment", {"wrap", "increment", "prefetch"}),
+            # (burstMode = prefetch only) words per weight tile, number of
+            # times each tile is replayed, and number of frames (numReps)
+            # served by one fetch of the weight buffer
+            "prefetchTileWords": ("i", False, 0),
+            "prefetchReplays": ("i", False, 1),
+            "prefetchFrames": ("i", False, 1),
             # IODMA direction: in = read from DRAM, out = write to DRAM
             "direction": ("s", False, "in", {"in", "out"}),
             # shape describing input vecs per execution
@@ -199,9 +207,32 @@ class IODMA_hls(HWCustomOp, HLSBackend):
         ovalues = nbits // stream_width
         return ovalues
 
+    def get_exp_dram_bytes(self):
+        if self.get_nodeattr("burstMode") != "increment":
+            # weight traffic is accounted for by the consuming layer
+            return 0
+        itype_bits = self.get_input_datatype().bitwidth()
+        return itype_bits * np.prod(self.get_normal_input_shape()) // 8
+
+    def get_prefetch_buffers(self):
+        """Returns the (depth, width) in words and bits of the two halves of
+        the on-chip double buffer WeightTileReplay uses in prefetch mode."""
+        if self.get_nodeattr("burstMode") != "prefetch":
+            return []
+        tile = (self.get_nodeattr("prefetchTileWords"), self.get_nodeattr("streamWidth"))
+        return [tile, tile]
+
+    def bram_estimation(self):
+        return sum([buffer_resource_estimation(d, w)[0] for (d, w) in self.get_prefetch_buffers()])
+
+    def lut_estimation(self):
+        return sum([buffer_resource_estimation(d, w)[1] for (d, w) in self.get_prefetch_buffers()])
+
     def global_includes(self):
         self.code_gen_dict["$GLOBALS$"] = ['#include "dma.h"']
         self.code_gen_dict["$GLOBALS$"].append('#include "streamtools.h"')
+        if self.get_nodeattr("burstMode") == "prefetch":
+            self.code_gen_dict["$GLOBALS$"].append('#include "weight_prefetch.hpp"')
 
     def defines(self, var):
         itype_bits = self.get_input_datatype().bitwidth()
@@ -226,7 +257,7 @@ class IODMA_hls(HWCustomOp, HLSBackend):
         mode = self.get_nodeattr("burstMode")
         dwc_func = "StreamingDataWidthConverter_Batch"
         if direction == "in":
-            if mode == "wrap":
+            if mode in ["wrap", "prefetch"]:
                 func = "Mem2Stream_Batch_external_wmem"
             else:
                 func = "Mem2Stream_Batch"
@@ -234,9 +265,13 @@ class IODMA_hls(HWCustomOp, HLSBackend):
             func = "Stream2Mem_Batch"
         else:
             raise ValueError("Invalid IODMA direction, please set to in or out")
+        # in prefetch mode, the weight buffer is only fetched once per
+        # prefetchFrames frames and replayed on chip
+        prefetch = direction == "in" and mode == "prefetch"
+        num_reps = "numGroups" if prefetch else "numReps"
         # define templates for instantiation
-        dma_inst_template = func + "<DataWidth1, NumBytes1>(%s, %s, numReps);"
-        dwc_inst_template = dwc_func + "<%d, %d, %d>(%s, %s, numReps);"
+        dma_inst_template = func + "<DataWidth1, NumBytes1>(%s, %s, " + num_reps + ");"
+        dwc_inst_template = dwc_func + "<%d, %d, %d>(%s, %s, " + num_reps + ");"
         # do stream infrastructure and instantiations
         intfw = self.get_nodeattr("intfWidth")
         strmw = self.get_nodeattr("streamWidth")
@@ -249,10 +284,11 @@ class IODMA_hls(HWCustomOp, HLSBackend):
         if direction == "in":
             # AXI MM -> IODMA -> (DWCs) -> out
             # DWCs depend on AXI MM and out interface width
+            out_name = "dma2pf" if prefetch else "out_" + self.hls_sname()
             if strmw == intfw:
                 # case 0: AXI MM width = out width, no DWCs needed
                 self.code_gen_dict["$DOCOMPUTE$"] = [
-                    dma_inst_template % ("in0_" + self.hls_sname(), "out_" + self.hls_sname())
+                    dma_inst_template % ("in0_" + self.hls_sname(), out_name)
                 ]
             elif (strmw % intfw == 0) or (intfw % strmw == 0):
                 # case 1: AXI MM width divisible by out width or vice versa
@@ -266,7 +302,7 @@ class IODMA_hls(HWCustomOp, HLSBackend):
                         strmw,
                         total_bits // intfw,
                         "dma2dwc",
-                        "out_" + self.hls_sname(),
+                        out_name,
                     ),
                 ]
             else:
@@ -285,9 +321,29 @@ class IODMA_hls(HWCustomOp, HLSBackend):
                         strmw,
                         total_bits // width_lcm,
                         "lcm2out",
-                        "out_" + self.hls_sname(),
+                        out_name,
                     ),
                 ]
+            if prefetch:
+                tile_words = self.get_nodeattr("prefetchTileWords")
+                num_words = self.get_nodeattr("numInputVectors")[0]
+                assert (
+                    tile_words > 0 and num_words % tile_words == 0
+                ), "prefetchTileWords must divide the weight buffer"
+                self.code_gen_dict["$DOCOMPUTE$"] = [
+                    "unsigned const numGroups = numReps / %d;"
+                    % self.get_nodeattr("prefetchFrames"),
+                    "hls::stream<ap_uint<%d> > dma2pf;" % strmw,
+                ] + self.code_gen_dict["$DOCOMPUTE$"]
+                self.code_gen_dict["$DOCOMPUTE$"].append(
+                    "WeightTileReplay<%d, %d, %d>(dma2pf, out_%s, numGroups);"
+                    % (
+                        tile_words,
+                        num_words // tile_words,
+                        self.get_nodeattr("prefetchReplays"),
+                        self.hls_sname(),
+                    )
+                )
         elif direction == "out":
             # in0 -> (DWCs) -> IODMA -> AXI MM
             # DWCs depend on AXI MM and out interface width
@@ -34,6 +34,7 @@ from qonnx.core.datatype import DataType
 from finn.custom_op.fpgadataflow.hlsbackend import HLSBackend
 from finn.custom_op.fpgadataflow.matrixvectoractivation import MVAU
 from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
+from finn.util.fpgadataflow import buffer_resource_estimation
 
 # ONNX i/o tensor shape assumptions for MatrixVectorActivation_hls:
 # input 0 is the input tensor, shape (.., i_size) = (..., MW)
@@ -114,6 +115,12 @@ class MVAU_hls(MVAU, HLSBackend):
             thr_luts = (2**B - 1) * acc_bits * math.ceil(self.calc_tmem() / 64)
             comp_luts = (2**B - 1) * acc_bits
 
+        # on-chip vector buffers of the batch-tiled kernel, if shallow
+        if self.uses_batch_tiled_weights():
+            c2 += sum(
+                [buffer_resource_estimation(d, w)[1] for (d, w) in self.get_batch_tiled_buffers()]
+            )
+
         return int(
             c0 + c1 * (P * (mult_luts + addertree_luts + acc_luts + thr_luts + comp_luts)) + c2
         )
@@ -183,6 +190,8 @@ class MVAU_hls(MVAU, HLSBackend):
                 currently no other parameter value is supported!"""
             )
         self.code_gen_dict["$GLOBALS$"] += ['#include "mvau.hpp"']
+        if self.uses_batch_tiled_weights():
+            self.code_gen_dict["$GLOBALS$"] += ['#include "mvau_batch_tiled.hpp"']
         if self.calc_tmem() != 0:
             # TODO find a better way of checking for no pregenerated thresholds
             self.code_gen_dict["$GLOBALS$"] += ['#include "thresh.h"']
@@ -202,6 +211,9 @@ class MVAU_hls(MVAU, HLSBackend):
         mem_mode = self.get_nodeattr("mem_mode")
         numInputVectors = list(self.get_nodeattr("numInputVectors"))
         numReps = np.prod(numInputVectors)
+        if self.uses_batch_tiled_weights() and var == "ipgen":
+            # the synthesized kernel processes a full group per invocation
+            numReps = self.get_weight_reuse_group()
         self.code_gen_dict["$DEFINES$"] = [
             """#define MW1 {}\n #define MH1 {}\n
             #define SIMD1 {}\n #define PE1 {}\n #define WMEM1 {}\n
@@ -218,6 +230,12 @@ class MVAU_hls(MVAU, HLSBackend):
         if mem_mode == "internal_decoupled" or mem_mode == "external":
             wdt = self.get_weight_datatype()
             self.code_gen_dict["$DEFINES$"].append("#define WP1 {}\n".format(wdt.bitwidth()))
+        if self.uses_batch_tiled_weights():
+            # checks the buffer sizes against batch_tiled_max_buffer_depth
+            self.get_batch_tiled_buffers()
+            self.code_gen_dict["$DEFINES$"].append(
+                "#define WeightReuse1 {}\n".format(self.get_weight_reuse_group())
+            )
 
     def read_npy_data(self):
         code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
@@ -254,9 +272,14 @@ class MVAU_hls(MVAU, HLSBackend):
             elem_hls_type = wdt.get_hls_datatype_str()
             npy_type = "float"
             npy_in = "%s/weights.npy" % code_gen_dir
+            w_reps = "numReps"
+            if self.uses_batch_tiled_weights():
+                # tiles are already replayed for every input vector
+                npy_in = "%s/weights_tiled.npy" % code_gen_dir
+                w_reps = "1"
 
             self.code_gen_dict["$READNPYDATA$"].append(
-                'npy2apintstream<%s, %s, %d, %s>("%s", weights_%s, false, numReps);'
+                'npy2apintstream<%s, %s, %d, %s>("%s", weights_%s, false, %s);'
                 % (
                     packed_hls_type,
                     elem_hls_type,
@@ -264,6 +287,7 @@ class MVAU_hls(MVAU, HLSBackend):
                     npy_type,
                     npy_in,
                     self.hls_sname(),
+                    w_reps,
                 )
             )
 
@@ -321,6 +345,9 @@ class MVAU_hls(MVAU, HLSBackend):
             else:
                 export_wdt = wdt
             wdtype_hls_str = export_wdt.get_hls_datatype_str()
+            if self.uses_batch_tiled_weights():
+                self.docompute_batch_tiled(threshs)
+                return
             self.code_gen_dict["$DOCOMPUTE$"] = [
                 """Matrix_Vector_Activate_Stream_Batch<MW1, MH1, SIMD1, PE1, {}, {}, {}, {} >
                 (in0_{}, out_{}, weights_{}, {}, numReps, {});""".format(
@@ -342,6 +369,31 @@ class MVAU_hls(MVAU, HLSBackend):
                 currently no other parameter value is supported!"""
             )
 
+    def docompute_batch_tiled(self, threshs):
+        idt = self.get_input_datatype()
+        wdt = self.get_weight_datatype()
+        odt = self.get_output_datatype()
+        assert (
+            self.get_nodeattr("binaryXnorMode") == 0
+        ), "Batch-tiled weight reuse does not support binaryXnorMode"
+        for dt in [idt, wdt, odt]:
+            assert dt.is_integer() and dt != DataType["BIPOLAR"], (
+                "Batch-tiled weight reuse requires non-bipolar integer datatypes, "
+                "found %s in %s" % (str(dt), self.onnx_node.name)
+            )
+        self.code_gen_dict["$DOCOMPUTE$"] = [
+            """Matrix_Vector_Activate_Stream_BatchTiled<MW1, MH1, SIMD1, PE1, WeightReuse1,
+            {}, {}, {}>(in0_{}, out_{}, weights_{}, {}, numReps);""".format(
+                idt.get_hls_datatype_str(),
+                wdt.get_hls_datatype_str(),
+                odt.get_hls_datatype_str(),
+                self.hls_sname(),
+                self.hls_sname(),
+                self.hls_sname(),
+                threshs,
+            )
+        ]
+
     def dataoutstrm(self):
         code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         dtype = self.get_output_datatype()
@@ -486,7 +538,7 @@ class MVAU_hls(MVAU, HLSBackend):
         if mode == "cppsim":
             code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
         else:
             raise Exception(
                 """Invalid value for attribute exec_mode! Is currently set to: {}
@@ -550,8 +602,19 @@ class MVAU_hls(MVAU, HLSBackend):
                 # so use it as such for weight generation
                 if self.get_weight_datatype() == DataType["BIPOLAR"]:
                     export_wdt = DataType["BINARY"]
-                wei = npy_to_rtlsim_input("{}/weights.npy".format(code_gen_dir), export_wdt, wnbits)
+                w_file = "{}/weights.npy".format(self.get_nodeattr("code_gen_dir_ipgen"))
                 num_w_reps = np.prod(self.get_nodeattr("numInputVectors"))
+                if self.uses_batch_tiled_weights():
+                    # the synthesized kernel waits for a full group, so
+                    # replicate the frame weightReuse times and keep the
+                    # outputs of the first copy
+                    group = self.get_weight_reuse_group()
+                    w_stream = self.get_tiled_weight_stream(np.load(w_file), group)
+                    w_file = "{}/weights_tiled_rtlsim.npy".format(code_gen_dir)
+                    np.save(w_file, w_stream)
+                    inp = inp * self.get_nodeattr("weightReuse")
+                    num_w_reps = 1
+                wei = npy_to_rtlsim_input(w_file, export_wdt, wnbits)
                 io_dict = {
                     "inputs": {"in0": inp, "weights": wei * num_w_reps},
                     "outputs": {"out": []},
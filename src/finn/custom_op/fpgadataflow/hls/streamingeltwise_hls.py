@@ -80,7 +80,7 @@ class StreamingEltwise_hls(StreamingEltwise, HLSBackend):
         if mode == "cppsim":
             code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
         else:
             raise Exception(
                 """Invalid value for attribute exec_mode! Is currently set to: {}
@@ -184,6 +184,30 @@ class StreamingEltwise_hls(StreamingEltwise, HLSBackend):
                 "return  a+b;",
                 "}",
                 "};",
+                "template<typename TI1, typename TI2, typename TO>",
+                "struct mul {",
+                "TO operator()(TI1 const &a, TI2 const &b) const {",
+                "#pragma HLS inline",
+                "TO const  r = a*b;",
+                "#pragma HLS BIND_OP variable=r op=mul impl=%s"
+                % ("dsp" if self.uses_dsp() else "fabric"),
+                "return  r;",
+                "}",
+                "};",
+                "template<typename TI1, typename TI2, typename TO>",
+                "struct maximum {",
+                "TO operator()(TI1 const &a, TI2 const &b) const {",
+                "#pragma HLS inline",
+                "return  a>b? TO(a) : TO(b);",
+                "}",
+                "};",
+                "template<typename TI1, typename TI2, typename TO>",
+                "struct minimum {",
+                "TO operator()(TI1 const &a, TI2 const &b) const {",
+                "#pragma HLS inline",
+                "return  a<b? TO(a) : TO(b);",
+                "}",
+                "};",
             ]
         )
 
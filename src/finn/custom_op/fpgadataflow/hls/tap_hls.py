@@ -0,0 +1,375 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import math
+import numpy as np
+import os
+import warnings
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hlsbackend import HLSBackend
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
+
+
+class Tap_hls(HWCustomOp, HLSBackend):
+    """Class that corresponds to custom_hls tap function. Forwards its input
+    stream unchanged and copies selected frames into a ring buffer in DRAM
+    through an AXI-MM writer, without backpressuring the forwarded stream.
+    The second output holds the contents of the ring buffer."""
+
+    # AXI lite register offsets as laid out by Vitis HLS for the arguments
+    # of the generated top-level function
+    register_offsets = {
+        "count": 0x10,
+        "dropped": 0x20,
+        "mem": 0x30,
+        "slots": 0x3C,
+        "period": 0x44,
+        "trigger": 0x4C,
+    }
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            # number of data words in a frame
+            "words_per_frame": ("i", True, 0),
+            # FINN DataTypes for input
+            "inputDataType": ("s", True, ""),
+            # folded shape of input/output
+            "folded_shape": ("ints", True, []),
+            # number of frames held by the ring buffer in DRAM
+            "capture_slots": ("i", False, 4),
+            # depth of the on-chip capture queue in words, 0 for one frame.
+            # Smaller queues only capture complete frames if the memory
+            # keeps up with the stream.
+            "capture_depth": ("i", False, 0),
+            # sampling period in frames used for cppsim, the hardware
+            # period is programmed at runtime and is 0 (disabled) after reset
+            "sample_period": ("i", False, 1),
+        }
+        my_attrs.update(HWCustomOp.get_nodeattr_types(self))
+        my_attrs.update(HLSBackend.get_nodeattr_types(self))
+        return my_attrs
+
+    def make_shape_compatible_op(self, model):
+        oshape = self.get_normal_output_shape()
+        return super().make_const_shape_op(oshape)
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype().name),
+                str(idt.name),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        odt = self.get_output_datatype()
+        model.set_tensor_datatype(node.output[0], odt)
+        if len(node.output) > 1:
+            model.set_tensor_datatype(node.output[1], odt)
+
+    def verify_node(self):
+        pass
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_instream_width(self, ind=0):
+        dtype = DataType[self.get_nodeattr("inputDataType")]
+        folded_shape = self.get_nodeattr("folded_shape")
+        return folded_shape[-1] * dtype.bitwidth()
+
+    def get_outstream_width(self, ind=0):
+        return self.get_instream_width()
+
+    def get_mem_width(self):
+        """Returns the width of the AXI-MM data words, which carry one stream
+        word each, rounded up to a power of two of at least 32 bits."""
+        return max(32, 1 << (self.get_instream_width() - 1).bit_length())
+
+    def get_capture_depth(self):
+        depth = self.get_nodeattr("capture_depth")
+        if depth == 0:
+            depth = self.get_nodeattr("words_per_frame")
+        return depth
+
+    def get_folded_input_shape(self, ind=0):
+        return self.get_nodeattr("folded_shape")
+
+    def get_folded_output_shape(self, ind=0):
+        return self.get_nodeattr("folded_shape")
+
+    def get_normal_input_shape(self, ind=0):
+        # taps are inserted in between fpgadataflow nodes, merge the two
+        # innermost dimensions of the folded shape to get the normal shape
+        folded_shape = self.get_nodeattr("folded_shape")
+        return list(folded_shape[:-2]) + [folded_shape[-2] * folded_shape[-1]]
+
+    def get_normal_output_shape(self, ind=0):
+        return self.get_normal_input_shape()
+
+    def get_captures_shape(self):
+        """Returns the shape of the second output, the ring buffer contents."""
+        return [self.get_nodeattr("capture_slots")] + self.get_normal_output_shape()
+
+    def get_ap_int_max_w(self):
+        return max(super().get_ap_int_max_w(), self.get_mem_width())
+
+    def bram_estimation(self):
+        """Calculates resource estimation for BRAM: the capture queue holding
+        data words tagged with their 32-bit index, unless it is shallow
+        enough for shift registers, and the write buffer of the AXI-MM
+        adapter."""
+        depth = self.get_capture_depth()
+        width = self.get_instream_width() + 32
+        if depth <= 32:
+            queue_brams = 0
+        else:
+            queue_brams = math.ceil(depth / 512) * math.ceil(width / 36)
+        return queue_brams + math.ceil(self.get_mem_width() / 36)
+
+    def lut_estimation(self):
+        """Calculates resource estimations for LUTs: the AXI-MM and AXI lite
+        adapters dominate, shallow capture queues add shift registers."""
+        width = self.get_instream_width() + 32
+        if self.get_capture_depth() <= 32:
+            queue_luts = math.ceil(width / 2)
+        else:
+            queue_luts = 2 * math.ceil(math.log2(self.get_capture_depth()))
+        return 1200 + queue_luts
+
+    def get_number_output_values(self):
+        folded_oshape = self.get_folded_output_shape()
+        return np.prod(folded_oshape[:-1])
+
+    def npy_to_dynamic_output(self, context):
+        super().npy_to_dynamic_output(context)
+        node = self.onnx_node
+        code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        captures = np.load("{}/output_captures.npy".format(code_gen_dir))
+        if self.get_output_datatype() == DataType["BIPOLAR"]:
+            captures = 2 * captures - 1
+        context[node.output[1]] = captures.reshape(self.get_captures_shape())
+
+    def execute_node(self, context, graph):
+        mode = self.get_nodeattr("exec_mode")
+        node = self.onnx_node
+        inp = context[node.input[0]]
+
+        if mode == "cppsim":
+            self.dynamic_input_to_npy(context, 1)
+            self.exec_precompiled_singlenode_model()
+            self.npy_to_dynamic_output(context)
+        elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
+            expected_inp_shape = self.get_folded_input_shape()
+            reshaped_input = inp.reshape(expected_inp_shape)
+            if self.get_input_datatype() == DataType["BIPOLAR"]:
+                # store bipolar activations as binary
+                reshaped_input = (reshaped_input + 1) / 2
+                export_idt = DataType["BINARY"]
+            else:
+                export_idt = self.get_input_datatype()
+            reshaped_input = reshaped_input.copy()
+            np.save(os.path.join(code_gen_dir, "input_0.npy"), reshaped_input)
+            sim = self.get_rtlsim()
+            nbits = self.get_instream_width()
+            inp = npy_to_rtlsim_input("{}/input_0.npy".format(code_gen_dir), export_idt, nbits)
+            super().reset_rtlsim(sim)
+            super().toggle_clk(sim)
+            io_dict = {
+                "inputs": {"in0": inp},
+                "outputs": {"out": []},
+            }
+            self.rtlsim_multi_io(sim, io_dict)
+            output = io_dict["outputs"]["out"]
+            odt = self.get_output_datatype()
+            target_bits = odt.bitwidth()
+            packed_bits = self.get_outstream_width()
+            out_npy_path = "{}/output.npy".format(code_gen_dir)
+            out_shape = self.get_folded_output_shape()
+            rtlsim_output_to_npy(output, out_npy_path, odt, out_shape, packed_bits, target_bits)
+            output = np.load(out_npy_path)
+            oshape = self.get_normal_output_shape()
+            context[node.output[0]] = np.asarray([output], dtype=np.float32).reshape(*oshape)
+            # the tap registers are cleared on reset, which leaves the capture
+            # path idle and the ring buffer untouched
+            context[node.output[1]] = np.zeros(self.get_captures_shape(), dtype=np.float32)
+        else:
+            raise Exception(
+                """Invalid value for attribute exec_mode! Is currently set to: {}
+            has to be set to one of the following value ("cppsim", "rtlsim")""".format(
+                    mode
+                )
+            )
+
+    def global_includes(self):
+        self.code_gen_dict["$GLOBALS$"] = ['#include "tap.hpp"']
+
+    def defines(self, var):
+        self.code_gen_dict["$DEFINES$"] = [
+            "#define WORDS_PER_FRAME {}".format(self.get_nodeattr("words_per_frame")),
+            "#define CAPTURE_DEPTH {}".format(self.get_capture_depth()),
+            "#define CAPTURE_SLOTS {}".format(self.get_nodeattr("capture_slots")),
+            "#define WORD_SIZE {}".format(self.get_instream_width()),
+            "#define MEM_WIDTH {}".format(self.get_mem_width()),
+        ]
+
+    def read_npy_data(self):
+        code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        dtype = self.get_input_datatype()
+        elem_bits = dtype.bitwidth()
+        packed_bits = self.get_instream_width()
+        packed_hls_type = "ap_uint<%d>" % packed_bits
+        elem_hls_type = dtype.get_hls_datatype_str()
+        npy_type = "float"
+        npy_in = "%s/input_0.npy" % code_gen_dir
+        self.code_gen_dict["$READNPYDATA$"] = []
+        # note: the innermost dim is reversed for the input
+        self.code_gen_dict["$READNPYDATA$"].append(
+            'npy2apintstream<%s, %s, %d, %s>("%s", in0_%s, false);'
+            % (
+                packed_hls_type,
+                elem_hls_type,
+                elem_bits,
+                npy_type,
+                npy_in,
+                self.hls_sname(),
+            )
+        )
+
+    def strm_decl(self):
+        self.code_gen_dict["$STREAMDECLARATIONS$"] = []
+        self.code_gen_dict["$STREAMDECLARATIONS$"].append(
+            'hls::stream<ap_uint<{}>> in0_{} ("in0_{}");'.format(
+                self.get_instream_width(), self.hls_sname(), self.hls_sname()
+            )
+        )
+        self.code_gen_dict["$STREAMDECLARATIONS$"].append(
+            'hls::stream<ap_uint<{}>> out_{} ("out_{}");'.format(
+                self.get_outstream_width(), self.hls_sname(), self.hls_sname()
+            )
+        )
+        # host-side ring buffer and register values for cppsim
+        self.code_gen_dict["$STREAMDECLARATIONS$"] += [
+            "static ap_uint<MEM_WIDTH> mem[CAPTURE_SLOTS * WORDS_PER_FRAME];",
+            "ap_uint<32> slots = CAPTURE_SLOTS;",
+            "ap_uint<32> period = %d;" % self.get_nodeattr("sample_period"),
+            "ap_uint<32> trigger = 0;",
+            "ap_uint<32> count;",
+            "ap_uint<32> dropped;",
+        ]
+
+    def docompute(self):
+        self.code_gen_dict["$DOCOMPUTE$"] = [
+            """tap<WORDS_PER_FRAME, CAPTURE_DEPTH>(in0_%s, out_%s, mem, slots, period, trigger,
+            count, dropped);"""
+            % (self.hls_sname(), self.hls_sname())
+        ]
+
+    def dataoutstrm(self):
+        code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        dtype = self.get_output_datatype()
+        if dtype == DataType["BIPOLAR"]:
+            # use binary for bipolar storage
+            dtype = DataType["BINARY"]
+        elem_bits = dtype.bitwidth()
+        packed_bits = self.get_outstream_width()
+        packed_hls_type = "ap_uint<%d>" % packed_bits
+        elem_hls_type = dtype.get_hls_datatype_str()
+        npy_type = "float"
+        npy_out = "%s/output.npy" % code_gen_dir
+        shape = tuple(self.get_folded_output_shape())
+        shape_cpp_str = str(shape).replace("(", "{").replace(")", "}")
+        cap_shape = (self.get_nodeattr("capture_slots"),) + shape
+        cap_shape_cpp_str = str(cap_shape).replace("(", "{").replace(")", "}")
+
+        # note: the innermost dim is not reversed for the output
+        self.code_gen_dict["$DATAOUTSTREAM$"] = [
+            'apintstream2npy<%s, %s, %d, %s>(out_%s, %s, "%s", false);'
+            % (
+                packed_hls_type,
+                elem_hls_type,
+                elem_bits,
+                npy_type,
+                self.hls_sname(),
+                shape_cpp_str,
+                npy_out,
+            ),
+            'hls::stream<ap_uint<MEM_WIDTH>> captures ("captures");',
+            "for(unsigned i = 0; i < CAPTURE_SLOTS * WORDS_PER_FRAME; i++) captures.write(mem[i]);",
+            'apintstream2npy<ap_uint<MEM_WIDTH>, %s, %d, %s>(captures, %s, "%s", false);'
+            % (
+                elem_hls_type,
+                elem_bits,
+                npy_type,
+                cap_shape_cpp_str,
+                "%s/output_captures.npy" % code_gen_dir,
+            ),
+        ]
+
+    def blackboxfunction(self):
+        self.code_gen_dict["$BLACKBOXFUNCTION$"] = [
+            """using T = ap_uint<WORD_SIZE>;\n using TM = ap_uint<MEM_WIDTH>;\n
+            void {}(hls::stream<T> &in0_{}, hls::stream<T> &out_{},
+            ap_uint<32> &count, ap_uint<32> &dropped, TM *mem,
+            ap_uint<32> slots, ap_uint<32> period, ap_uint<32> trigger)""".format(
+                self.onnx_node.name, self.hls_sname(), self.hls_sname()
+            )
+        ]
+
+    def pragmas(self):
+        self.code_gen_dict["$PRAGMAS$"] = [
+            "#pragma HLS interface axis port=in0_" + self.hls_sname(),
+            "#pragma HLS interface axis port=out_" + self.hls_sname(),
+            "#pragma HLS interface m_axi offset=slave port=mem",
+        ]
+        for reg in self.register_offsets.keys():
+            self.code_gen_dict["$PRAGMAS$"].append(
+                "#pragma HLS interface s_axilite port=%s bundle=control" % reg
+            )
+        self.code_gen_dict["$PRAGMAS$"].append("#pragma HLS interface ap_ctrl_none port=return")
+        self.code_gen_dict["$PRAGMAS$"].append("#pragma HLS dataflow disable_start_propagation")
+
+    def get_verilog_top_module_intf_names(self):
+        intf_names = super().get_verilog_top_module_intf_names()
+        intf_names["axilite"] = ["s_axi_control"]
+        intf_names["aximm"] = [("m_axi_gmem", self.get_mem_width())]
+        return intf_names
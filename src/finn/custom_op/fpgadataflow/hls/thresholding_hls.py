@@ -281,7 +281,7 @@ class Thresholding_hls(Thresholding, HLSBackend):
         if mode == "cppsim":
             code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
         else:
             raise Exception(
                 """Invalid value for attribute exec_mode! Is currently set to: {}
@@ -341,7 +341,9 @@ class Thresholding_hls(Thresholding, HLSBackend):
                 wnbits = self.get_weightstream_width()
                 export_wdt = self.get_weight_datatype()
                 wei = npy_to_rtlsim_input(
-                    "{}/thresholds.npy".format(code_gen_dir), export_wdt, wnbits
+                    "{}/thresholds.npy".format(self.get_nodeattr("code_gen_dir_ipgen")),
+                    export_wdt,
+                    wnbits,
                 )
                 num_w_reps = np.prod(self.get_nodeattr("numInputVectors"))
                 io_dict = {
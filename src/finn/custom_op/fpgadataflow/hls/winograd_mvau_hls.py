@@ -0,0 +1,184 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import os
+
+from finn.custom_op.fpgadataflow.hlsbackend import HLSBackend
+from finn.custom_op.fpgadataflow.winograd_mvau import WinogradMVAU
+from finn.util.data_packing import (
+    npy_to_rtlsim_input,
+    numpy_to_hls_code,
+    rtlsim_output_to_npy,
+)
+
+
+class WinogradMVAU_hls(WinogradMVAU, HLSBackend):
+    """Class that corresponds to the custom_hls WinogradMVAU function."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {}
+        my_attrs.update(WinogradMVAU.get_nodeattr_types(self))
+        my_attrs.update(HLSBackend.get_nodeattr_types(self))
+        return my_attrs
+
+    def get_hw_compatible_weight_tensor(self, orig_weight_matrix):
+        """Convert the transformed weights of shape (16, MW, MH) into the
+        (16, PE, SIMD, WMEM) layout of the HLS implementation, where output
+        channel n*PE + pe and input channel s*SIMD + q are found at
+        [:, pe, q, n*SF + s]."""
+        mw = self.get_nodeattr("MW")
+        mh = self.get_nodeattr("MH")
+        pe = self.get_nodeattr("PE")
+        simd = self.get_nodeattr("SIMD")
+        assert orig_weight_matrix.shape == (16, mw, mh), "Unexpected weight shape"
+        sf = mw // simd
+        nf = mh // pe
+        ret = orig_weight_matrix.reshape(16, sf, simd, nf, pe)
+        ret = ret.transpose(0, 4, 2, 3, 1)
+        return ret.reshape(16, pe, simd, nf * sf)
+
+    def generate_params(self, model, path):
+        code_gen_dir = path
+        weights = model.get_initializer(self.onnx_node.input[1])
+        weight_tensor = self.get_hw_compatible_weight_tensor(weights)
+        wdt = self.get_weight_datatype()
+        weights_hls_code = numpy_to_hls_code(weight_tensor, wdt, "weights", False, False)
+        # write weights into params.h
+        with open("{}/params.h".format(code_gen_dir), "w") as f_weights:
+            f_weights.write("static " + weights_hls_code)
+
+    def execute_node(self, context, graph):
+        mode = self.get_nodeattr("exec_mode")
+        node = self.onnx_node
+
+        if mode == "cppsim":
+            code_gen_dir = self.get_nodeattr("code_gen_dir_cppsim")
+        elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
+        else:
+            raise Exception(
+                """Invalid value for attribute exec_mode! Is currently set to: {}
+            has to be set to one of the following value ("cppsim", "rtlsim")""".format(
+                    mode
+                )
+            )
+
+        inp = context[node.input[0]]
+        assert str(inp.dtype) == "float32", "Input datatype is not float32"
+        assert inp.shape == self.get_normal_input_shape(), "Input shape doesn't match expected"
+        export_idt = self.get_input_datatype()
+        reshaped_input = inp.reshape(self.get_folded_input_shape())
+        # make copy before saving the array
+        reshaped_input = reshaped_input.copy()
+        np.save(os.path.join(code_gen_dir, "input_0.npy"), reshaped_input)
+
+        if mode == "cppsim":
+            # execute the precompiled model
+            super().exec_precompiled_singlenode_model()
+            # load output npy file
+            super().npy_to_dynamic_output(context)
+        elif mode == "rtlsim":
+            sim = self.get_rtlsim()
+            nbits = self.get_instream_width()
+            inp = npy_to_rtlsim_input("{}/input_0.npy".format(code_gen_dir), export_idt, nbits)
+            super().reset_rtlsim(sim)
+            super().toggle_clk(sim)
+            output = self.rtlsim(sim, inp)
+            odt = self.get_output_datatype()
+            target_bits = odt.bitwidth()
+            packed_bits = self.get_outstream_width()
+            out_npy_path = "{}/output.npy".format(code_gen_dir)
+            out_shape = self.get_folded_output_shape()
+            rtlsim_output_to_npy(output, out_npy_path, odt, out_shape, packed_bits, target_bits)
+            # load and reshape output
+            output = np.load(out_npy_path)
+            oshape = self.get_normal_output_shape()
+            output = np.asarray([output], dtype=np.float32).reshape(*oshape)
+            context[node.output[0]] = output
+
+        assert (
+            context[node.output[0]].shape == self.get_normal_output_shape()
+        ), """Output shape doesn't match expected shape."""
+
+    def global_includes(self):
+        self.code_gen_dict["$GLOBALS$"] = ['#include "winograd.hpp"']
+
+    def defines(self, var):
+        th, tw = self.get_nodeattr("Tiles")
+        self.code_gen_dict["$DEFINES$"] = [
+            "#define MW1 {}\n#define MH1 {}\n#define Tiles1 {}\n"
+            "#define SIMD1 {}\n#define PE1 {}".format(
+                self.get_nodeattr("MW"),
+                self.get_nodeattr("MH"),
+                th * tw,
+                self.get_nodeattr("SIMD"),
+                self.get_nodeattr("PE"),
+            )
+        ]
+
+    def docompute(self):
+        self.code_gen_dict["$DOCOMPUTE$"] = [
+            """WinogradMVAU<MW1, MH1, Tiles1, SIMD1, PE1, {}, {}, {}>
+            (in0_{}, out_{}, weights);""".format(
+                self.get_input_datatype().get_hls_datatype_str(),
+                self.get_weight_datatype().get_hls_datatype_str(),
+                self.get_output_datatype().get_hls_datatype_str(),
+                self.hls_sname(),
+                self.hls_sname(),
+            )
+        ]
+
+    def blackboxfunction(self):
+        self.code_gen_dict["$BLACKBOXFUNCTION$"] = [
+            """void {}(hls::stream<ap_uint<{}>> &in0_{},
+                hls::stream<ap_uint<{}>> &out_{}
+                )""".format(
+                self.onnx_node.name,
+                self.get_instream_width(),
+                self.hls_sname(),
+                self.get_outstream_width(),
+                self.hls_sname(),
+            )
+        ]
+
+    def pragmas(self):
+        super().pragmas()
+        self.code_gen_dict["$PRAGMAS$"].append('#include "params.h"')
+        # the weight tensor is [16][PE][SIMD][WMEM], partition for parallel
+        # access along the PE and SIMD dimensions (dims 2 and 3)
+        self.code_gen_dict["$PRAGMAS$"].append(
+            "#pragma HLS ARRAY_PARTITION variable=weights complete dim=2"
+        )
+        self.code_gen_dict["$PRAGMAS$"].append(
+            "#pragma HLS ARRAY_PARTITION variable=weights complete dim=3"
+        )
@@ -34,6 +34,11 @@ from qonnx.core.datatype import DataType
 
 from finn.custom_op.fpgadataflow import templates
 from finn.util.basic import CppBuilder, get_rtlsim_trace_depth, make_build_dir
+from finn.util.build_dirs import (
+    build_dir_lock,
+    build_output_done,
+    mark_build_output_done,
+)
 from finn.util.hls import CallHLS
 from finn.util.pyverilator import make_single_source_file
 
@@ -178,7 +183,12 @@ class HLSBackend(ABC):
         builder = CallHLS()
         builder.append_tcl(code_gen_dir + "/hls_syn_{}.tcl".format(node.name))
         builder.set_ipgen_path(code_gen_dir + "/project_{}".format(node.name))
-        builder.build(code_gen_dir)
+        with build_dir_lock(code_gen_dir):
+            # deterministic build dirs may hold the IP from an earlier build
+            if not build_output_done(code_gen_dir, "ipgen"):
+                builder.build(code_gen_dir)
+                if os.path.isdir(builder.ipgen_path + "/sol1/impl/ip"):
+                    mark_build_output_done(code_gen_dir, "ipgen")
         ipgen_path = builder.ipgen_path
         assert os.path.isdir(ipgen_path), "IPGen failed: %s not found" % (ipgen_path)
         self.set_nodeattr("ipgen_path", ipgen_path)
@@ -28,19 +28,23 @@
 
 import numpy as np
 import os
+import threading
 import warnings
 from abc import abstractmethod
 from pyverilator.util.axi_utils import _read_signal, reset_rtlsim, rtlsim_multi_io
 from qonnx.custom_op.base import CustomOp
 from qonnx.util.basic import roundup_to_integer_multiple
 
-from finn.util.basic import pyverilate_get_liveness_threshold_cycles
+from finn.util.basic import make_build_dir, pyverilate_get_liveness_threshold_cycles
 
 try:
     from pyverilator import PyVerilator
 except ModuleNotFoundError:
     PyVerilator = None
 
+# scratch dirs for the npy files exchanged with rtlsim, per process and thread
+_rtlsim_io_dirs = {}
+
 
 class HWCustomOp(CustomOp):
     """HWCustomOp class all custom ops that can be implemented with either
@@ -136,6 +140,18 @@ class HWCustomOp(CustomOp):
         sim = PyVerilator(rtlsim_so)
         return sim
 
+    def get_rtlsim_io_dir(self):
+        """Returns a scratch dir for the input and output npy files of the
+        node-by-node rtlsim execution. The code_gen_dir_ipgen of a node may be
+        shared between builds (see finn.util.build_dirs), so the files go to a
+        dir private to the calling process and thread instead."""
+        key = (os.getpid(), threading.get_ident())
+        io_dir = _rtlsim_io_dirs.get(key)
+        if io_dir is None or not os.path.isdir(io_dir):
+            io_dir = make_build_dir("rtlsim_io_")
+            _rtlsim_io_dirs[key] = io_dir
+        return io_dir
+
     def node_res_estimation(self, fpgapart):
         """Returns summarized resource estimation of BRAMs and LUTs
         of the node as a dictionary."""
@@ -184,6 +200,12 @@ class HWCustomOp(CustomOp):
         by every node"""
         return 0
 
+    def get_exp_dram_bytes(self):
+        """Function for estimation of the number of bytes this node moves
+        to or from external memory per sample, is member function of
+        HWCustomOp class and only overridden by nodes that access DRAM"""
+        return 0
+
     def get_op_and_param_counts(self):
         """Return a dictionary with number of ops needed per inference for
         this layer as well as parameter count (weights, thresholds, etc.).
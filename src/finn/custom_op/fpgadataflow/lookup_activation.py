@@ -0,0 +1,263 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import warnings
+from math import ceil
+from qonnx.core.datatype import DataType
+from qonnx.util.basic import interleave_matrix_outer_dim_from_partitions
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+
+# ONNX i/o tensor shape assumptions for LookupActivation:
+# input 0 is the input tensor, shape (..., NumChannels)
+# input 1 is the lookup table, shape (NumChannels or 1, 2^inputBits), where
+#   entry [c, i] holds the output for channel c and input value inputDataType.min() + i
+# output 0 is the output tensor, shape (..., NumChannels) - same as input
+# the ... here can be any shape (representing groups of vectors)
+
+
+class LookupActivation(HWCustomOp):
+    """Abstraction layer for HW implementation of an elementwise table-lookup
+    activation. Unlike Thresholding, the table can express arbitrary (e.g.
+    non-monotonic) functions of a low-precision integer input."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            # parallelization; channels looked up per cycle, each PE has its
+            # own copy of (its part of) the table
+            "PE": ("i", True, 0),
+            # number of channels (each may have a different table)
+            "NumChannels": ("i", True, 0),
+            # string defining memory resource type for the table
+            "ram_style": ("s", False, "distributed", {"distributed", "block"}),
+            # FINN DataTypes for inputs, outputs
+            "inputDataType": ("s", True, ""),
+            "outputDataType": ("s", True, ""),
+            # number of input vectors, examples:
+            # [1] is a single vector (like a FC layer with batch=1)
+            # [4] is four vectors (like a FC layer with batch=4)
+            # [1, 4, 4] is four * four vectors (like a conv layer with batch=1)
+            "numInputVectors": ("ints", False, [1]),
+        }
+        my_attrs.update(super().get_nodeattr_types())
+        return my_attrs
+
+    def calc_tmem(self):
+        """Calculates and returns TMEM, the number of channel tables
+        stored per PE."""
+        chn = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        return chn // pe
+
+    def get_num_entries(self):
+        """Returns the number of table entries per channel, which covers
+        all values of the input datatype."""
+        idt = self.get_input_datatype()
+        return int(idt.max() - idt.min() + 1)
+
+    def make_shape_compatible_op(self, model):
+        oshape = self.get_normal_output_shape()
+        return super().make_const_shape_op(oshape)
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype().name),
+                str(idt.name),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        # set output datatype from property
+        odt = self.get_output_datatype()
+        model.set_tensor_datatype(node.output[0], odt)
+
+    def verify_node(self):
+        info_messages = []
+        # verify that "backend" is set to "fpgadataflow"
+        backend_value = self.get_nodeattr("backend")
+        if backend_value == "fpgadataflow":
+            info_messages.append("Attribute backend is set correctly")
+        else:
+            info_messages.append('Attribute backend should be set to "fpgadataflow"')
+
+        # verify that all necessary attributes exist
+        try:
+            self.get_nodeattr("NumChannels")
+            self.get_nodeattr("PE")
+            self.get_nodeattr("inputDataType")
+            self.get_nodeattr("outputDataType")
+            info_messages.append("All necessary attributes exist")
+        except Exception:
+            info_messages.append("""The required LookupActivation attributes do not exist.""")
+
+        # verify that the input datatype is suitable for table indexing
+        idt = self.get_input_datatype()
+        if idt.is_integer() and idt != DataType["BIPOLAR"]:
+            info_messages.append("Input datatype is suitable for table lookup")
+        else:
+            info_messages.append("LookupActivation needs a non-bipolar integer input")
+
+        return info_messages
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("outputDataType")]
+
+    def get_instream_width(self, ind=0):
+        i_bits = self.get_input_datatype().bitwidth()
+        return i_bits * self.get_nodeattr("PE")
+
+    def get_outstream_width(self, ind=0):
+        o_bits = self.get_output_datatype().bitwidth()
+        return o_bits * self.get_nodeattr("PE")
+
+    def get_folded_input_shape(self, ind=0):
+        ich = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        fold = ich // pe
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        folded_input_shape = tuple(vecs + [fold, pe])
+        return folded_input_shape
+
+    def get_folded_output_shape(self, ind=0):
+        # same shape as input
+        return self.get_folded_input_shape()
+
+    def get_normal_input_shape(self, ind=0):
+        ich = self.get_nodeattr("NumChannels")
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        normal_input_shape = tuple(vecs + [ich])
+        return normal_input_shape
+
+    def get_normal_output_shape(self, ind=0):
+        # same shape as input
+        return self.get_normal_input_shape()
+
+    def get_number_output_values(self):
+        nf = np.prod(self.get_folded_output_shape()[:-1])
+        return nf
+
+    def get_exp_cycles(self):
+        # Channels/PE * batch size * fmdim * fmdim
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_hw_compatible_table_tensor(self, orig_table):
+        """Convert the original lookup table of shape (NumChannels or 1, entries)
+        into a form suitable for the HLS implementation:
+        * ensure NumChannels % PE == 0 and the number of entries matches the input type
+        * duplicate shared tables for every channel
+        * interleave channels between PEs
+        * reshape into (PE, TMEM, entries) and return
+        """
+        chn = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        assert chn % pe == 0, "Requirement NumChannels divisable by PE is violated."
+        assert orig_table.ndim == 2, "Lookup table dimension is not as expected (2)."
+        n_entries = self.get_num_entries()
+        assert orig_table.shape[1] == n_entries, "Lookup table must cover all input values"
+        odt = self.get_output_datatype()
+        assert np.vectorize(odt.allowed)(
+            orig_table
+        ).all(), "Lookup table can't be expressed with type %s" % str(odt)
+        ret = orig_table
+        if ret.shape[0] == 1:
+            ret = np.tile(ret, (chn, 1))
+        assert ret.shape[0] == chn, "Channels of lookup table are not as expected"
+        # distribute rows between PEs
+        ret = interleave_matrix_outer_dim_from_partitions(ret, pe)
+        return ret.reshape(pe, self.calc_tmem(), n_entries)
+
+    def get_table_bits_per_pe(self):
+        """Returns the number of table bits stored by each PE."""
+        o_bits = self.get_output_datatype().bitwidth()
+        return self.calc_tmem() * self.get_num_entries() * o_bits
+
+    def bram_estimation(self):
+        """Calculates BRAM cost if resource set to BRAM. Every PE keeps its
+        own copy of its part of the table."""
+        style = self.get_nodeattr("ram_style")
+        P = self.get_nodeattr("PE")
+        obits = self.get_output_datatype().bitwidth()
+        depth = self.calc_tmem() * self.get_num_entries()
+        if style == "block":
+            return P * int(ceil(obits / 18)) * int(ceil(depth / 1024))
+        else:
+            return 0
+
+    def bram_efficiency_estimation(self):
+        bram16_est = self.bram_estimation()
+        if bram16_est == 0:
+            return 1
+        table_bits = self.get_nodeattr("PE") * self.get_table_bits_per_pe()
+        bram16_est_capacity = bram16_est * 18 * 1024
+        return table_bits / bram16_est_capacity
+
+    def lut_estimation(self):
+        """Calculates LUT cost, taking memory resource type into account"""
+        style = self.get_nodeattr("ram_style")
+        P = self.get_nodeattr("PE")
+        obits = self.get_output_datatype().bitwidth()
+        depth = self.calc_tmem() * self.get_num_entries()
+        # cost of index and output multiplexing
+        mux_cost = (self.get_input_datatype().bitwidth() + obits) * P
+        # cost of LUTRAM, 64 entries per LUT for each output bit
+        if style == "distributed":
+            lutram_cost = P * obits * int(ceil(depth / 64))
+        else:
+            lutram_cost = 0
+        return mux_cost + lutram_cost
+
+    def get_op_and_param_counts(self):
+        ret_dict = {}
+        table_param_type = "param_lut_%s" % self.get_output_datatype().name
+        ret_dict[table_param_type] = self.get_nodeattr("NumChannels") * self.get_num_entries()
+        return ret_dict
+
+    def execute_node(self, context, graph):
+        node = self.onnx_node
+        inp_values = context[node.input[0]]
+        table = context[node.input[1]]
+        chn = self.get_nodeattr("NumChannels")
+        if table.shape[0] == 1:
+            table = np.tile(table, (chn, 1))
+        # channels are in the last dimension, index by offset from input min
+        idx = (inp_values - self.get_input_datatype().min()).astype(np.int64)
+        y = table[np.arange(chn), idx]
+        context[node.output[0]] = np.asarray(y, dtype=np.float32)
@@ -42,6 +42,7 @@ from qonnx.util.basic import (
 
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
 from finn.util.data_packing import numpy_to_hls_code, pack_innermost_dim_as_hex_string
+from finn.util.fpgadataflow import buffer_resource_estimation
 
 # ONNX i/o tensor shape assumptions for MatrixVectorActivation:
 # input 0 is the input tensor, shape (.., i_size) = (..., MW)
@@ -51,6 +52,11 @@ from finn.util.data_packing import numpy_to_hls_code, pack_innermost_dim_as_hex_
 # the ... here can be any shape (representing groups of vectors)
 
 
+# maximum depth in words of each of the on-chip input and output buffers of
+# the batch-tiled MVAU kernel, which hold all vectors of a weight reuse group
+batch_tiled_max_buffer_depth = 8192
+
+
 class MVAU(HWCustomOp):
     """Abstraction layer for HW implementation of MatrixVectorActivation layers."""
 
@@ -123,6 +129,18 @@ class MVAU(HWCustomOp):
             # vector through the accelerator. This will get rid of any old
             # weight data from the weight FIFOs.
             "runtime_writeable_weights": ("i", False, 0, {0, 1}),
+            # (mem_mode = external, HLS only) number of frames that share one
+            # fetch of the external weights. Values > 1 select the batch-tiled
+            # kernel, which holds each weight tile against the input vectors of
+            # weightReuse frames before moving on. The batch size the accelerator
+            # is run with must be a multiple of this value. The input and output
+            # vectors of the frames are buffered on chip, which limits the
+            # value, see batch_tiled_max_buffer_depth.
+            "weightReuse": ("i", False, 1),
+            # request lowering of this layer (a 3x3, stride-1 convolution fed
+            # by a ConvolutionInputGenerator) to Winograd F(2x2, 3x3), see
+            # LowerConvsToWinograd. Layers that fail its checks stay direct.
+            "winograd": ("i", False, 0, {0, 1}),
         }
         my_attrs.update(super().get_nodeattr_types())
         return my_attrs
@@ -394,6 +412,11 @@ class MVAU(HWCustomOp):
         mem_width = Q * W * P
         mmode = self.get_nodeattr("mem_mode")
         mstyle = self.get_nodeattr("ram_style")
+        if self.uses_batch_tiled_weights():
+            # external weights, but the vectors of a reuse group are buffered
+            return sum(
+                [buffer_resource_estimation(d, w)[0] for (d, w) in self.get_batch_tiled_buffers()]
+            )
         if (
             (mmode == "internal_decoupled" and mstyle in ["distributed", "ultra"])
             or (mmode == "internal_embedded" and self.calc_wmem() <= 128)
@@ -451,8 +474,55 @@ class MVAU(HWCustomOp):
         # since mmv != 1 is not supported yet, we set mmv for now to 1
         mmv = 1
         exp_cycles = (mh / pe) * (mw / simd) * np.prod(num_inp_vec) / mmv
+        if self.uses_batch_tiled_weights():
+            # the batch-tiled kernel emits its buffered results after each group
+            exp_cycles += (mh / pe) * np.prod(num_inp_vec)
         return int(exp_cycles)
 
+    def uses_batch_tiled_weights(self):
+        """Returns True if external weights are fetched once for several frames
+        and replayed tile by tile (see weightReuse)."""
+        return self.get_nodeattr("mem_mode") == "external" and self.get_nodeattr("weightReuse") > 1
+
+    def get_weight_reuse_group(self):
+        """Returns the number of input vectors each weight tile is held against,
+        i.e. the input vectors of weightReuse frames."""
+        return self.get_nodeattr("weightReuse") * int(np.prod(self.get_nodeattr("numInputVectors")))
+
+    def get_batch_tiled_buffers(self):
+        """Returns the (depth, width) in words and bits of the on-chip input
+        and output buffers of the batch-tiled kernel, which hold the vectors
+        of a whole weight reuse group (see weightReuse)."""
+        group = self.get_weight_reuse_group()
+        sf = self.get_nodeattr("MW") // self.get_nodeattr("SIMD")
+        nf = self.get_nodeattr("MH") // self.get_nodeattr("PE")
+        ret = [(group * sf, self.get_instream_width()), (group * nf, self.get_outstream_width())]
+        assert max([depth for (depth, width) in ret]) <= batch_tiled_max_buffer_depth, (
+            "weightReuse=%d of %s needs on-chip buffers of more than %d words, reduce "
+            "weightReuse or increase SIMD/PE"
+            % (self.get_nodeattr("weightReuse"), self.onnx_node.name, batch_tiled_max_buffer_depth)
+        )
+        return ret
+
+    def get_tiled_weight_stream(self, weight_stream, group):
+        """Reorder a weight stream of shape (1, WMEM, PE*SIMD) into the order
+        expected by the batch-tiled kernel: each tile of MW/SIMD words (one
+        neuron fold) is repeated group times before the next tile follows."""
+        sf = self.get_nodeattr("MW") // self.get_nodeattr("SIMD")
+        nf = self.get_nodeattr("MH") // self.get_nodeattr("PE")
+        ret = weight_stream.reshape(nf, 1, sf, -1)
+        ret = np.repeat(ret, group, axis=1)
+        return ret.reshape(1, -1, weight_stream.shape[-1])
+
+    def get_exp_dram_bytes(self):
+        mem_mode = self.get_nodeattr("mem_mode")
+        if mem_mode != "external":
+            return 0
+        # external weights are fetched once per frame, or once per
+        # weightReuse frames for the batch-tiled kernel
+        wbytes = self.calc_wmem() * self.get_weightstream_width_padded() // 8
+        return wbytes / self.get_nodeattr("weightReuse")
+
     def minimize_accumulator_width(self, model):
         """Minimize the accumulator bit width according to the weight values,
         input data types, and size of dot product"""
@@ -754,6 +824,13 @@ class MVAU(HWCustomOp):
             weight_filename_sim = "{}/weights.npy".format(code_gen_dir)
             # save internal_decoupled weights for cppsim
             self.make_weight_file(weights, "decoupled_npy", weight_filename_sim)
+            if self.uses_batch_tiled_weights():
+                # cppsim runs a single frame, so each tile is replayed for
+                # the input vectors of that frame only
+                w_stream = np.load(weight_filename_sim)
+                num_vecs = int(np.prod(self.get_nodeattr("numInputVectors")))
+                w_tiled = self.get_tiled_weight_stream(w_stream, num_vecs)
+                np.save("{}/weights_tiled.npy".format(code_gen_dir), w_tiled)
             if mem_mode == "internal_decoupled":
                 # also save weights as Verilog .dat file
                 # This file will be ignored when synthesizing UltraScale memory.
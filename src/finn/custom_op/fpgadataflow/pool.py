@@ -30,6 +30,7 @@ import numpy as np
 from qonnx.core.datatype import DataType
 
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.nhwc_kernels import pool_windows_nhwc, to_compute_array
 
 
 class Pool(HWCustomOp):
@@ -202,14 +203,10 @@ class Pool(HWCustomOp):
         ch = self.get_nodeattr("Channels")
         k2 = k[0] * k[1]
 
-        inp_values = context[node.input[0]]
-        ishape = inp_values.shape
-        # reshape array to apply max or avg function only on kernel
-        tmp_shape = tuple(list(ishape)[:-1] + [k2, ch])
-        tmp_values = inp_values.reshape(tmp_shape)
-        if fnx == "MaxPool":
-            result = np.max(tmp_values, axis=3)
-        elif fnx == "QuantAvgPool":
+        inp_values = to_compute_array(context[node.input[0]], self.get_input_datatype())
+        assert inp_values.shape[-1] == k2 * ch, "Unexpected input shape for Pool"
+        shift_bits = 0
+        if fnx == "QuantAvgPool":
             # determine bits to shift
             ibits = self.get_input_datatype().bitwidth()
             obits = self.get_output_datatype().bitwidth()
@@ -218,7 +215,6 @@ class Pool(HWCustomOp):
             max_bit_width = int(max_value).bit_length()
             shift_bits = max_bit_width - obits
             shift_bits = shift_bits if shift_bits >= 0 else 0
-            result = np.sum(tmp_values, axis=3)
-            result = np.right_shift(result.astype(int), shift_bits)
+        result = pool_windows_nhwc(inp_values, k2, fnx, shift_bits)
         oshape = context[node.output[0]].shape
         context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
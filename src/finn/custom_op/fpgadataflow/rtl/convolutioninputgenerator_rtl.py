@@ -287,8 +287,6 @@ class ConvolutionInputGenerator_rtl(ConvolutionInputGenerator, RTLBackend):
 
     def execute_node(self, context, graph):
         mode = self.get_nodeattr("exec_mode")
-        code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
-
         if mode == "cppsim":
             ConvolutionInputGenerator.execute_node(self, context, graph)
             # if depthwise = 1
@@ -307,6 +305,7 @@ class ConvolutionInputGenerator_rtl(ConvolutionInputGenerator, RTLBackend):
                 im2col_out = im2col_out.reshape(1, ofm_h, ofm_w, ifm_ch * k_h * k_w)
                 context[node.output[0]] = im2col_out
         elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
             node = self.onnx_node
             exp_ishape = self.get_normal_input_shape()
             exp_oshape = self.get_normal_output_shape()
@@ -70,11 +70,10 @@ class FMPadding_rtl(FMPadding, RTLBackend):
 
     def execute_node(self, context, graph):
         mode = self.get_nodeattr("exec_mode")
-        code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
-
         if mode == "cppsim":
             FMPadding.execute_node(self, context, graph)
         elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
             node = self.onnx_node
             exp_ishape = self.get_normal_input_shape()
             exp_oshape = self.get_normal_output_shape()
@@ -55,7 +55,11 @@ class MVAU_rtl(MVAU, RTLBackend):
         super().__init__(onnx_node, **kwargs)
 
     def get_nodeattr_types(self):
-        my_attrs = {}
+        my_attrs = {
+            # process the activations one bit plane per cycle on LUTs instead
+            # of bit-parallel on DSPs, multiplying the cycles by the input bits
+            "bitSerial": ("i", False, 0, {0, 1}),
+        }
         my_attrs.update(MVAU.get_nodeattr_types(self))
         my_attrs.update(RTLBackend.get_nodeattr_types(self))
         return my_attrs
@@ -68,7 +72,7 @@ class MVAU_rtl(MVAU, RTLBackend):
         if mode == "cppsim":
             MVAU.execute_node(self, context, graph)
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
             # create a npy file fore each input of the node (in_ind is input index)
             in_ind = 0
             for inputs in node.input:
@@ -101,7 +105,9 @@ class MVAU_rtl(MVAU, RTLBackend):
                     wnbits = self.get_weightstream_width()
                     export_wdt = self.get_weight_datatype()
                     wei = npy_to_rtlsim_input(
-                        "{}/weights.npy".format(code_gen_dir), export_wdt, wnbits
+                        "{}/weights.npy".format(self.get_nodeattr("code_gen_dir_ipgen")),
+                        export_wdt,
+                        wnbits,
                     )
                     num_w_reps = np.prod(self.get_nodeattr("numInputVectors"))
                     io_dict = {
@@ -131,10 +137,30 @@ class MVAU_rtl(MVAU, RTLBackend):
                 )
             )
 
+    def get_exp_cycles(self):
+        exp_cycles = super().get_exp_cycles()
+        if self.get_nodeattr("bitSerial") == 1:
+            exp_cycles *= self.get_input_datatype().bitwidth()
+        return int(exp_cycles)
+
     def lut_estimation(self):
-        return 0
+        if self.get_nodeattr("bitSerial") == 0:
+            return 0
+        # bit-serial: per PE, a SIMD-input adder tree over the weights selected
+        # by the current bit plane, plus the shift and input accumulators
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        W = self.get_weight_datatype().bitwidth()
+        acc_bits = self.get_output_datatype().bitwidth()
+        c0 = 300
+        c1 = 1.1
+        addertree_luts = (W + np.ceil(np.log2(Q))) * (2 * Q - 1)
+        acc_luts = 2 * acc_bits
+        return int(c0 + c1 * (P * (addertree_luts + acc_luts)))
 
     def dsp_estimation(self, fpgapart):
+        if self.get_nodeattr("bitSerial") == 1:
+            return 0
         # multiplication
         P = self.get_nodeattr("PE")
         Q = self.get_nodeattr("SIMD")
@@ -156,6 +182,7 @@ class MVAU_rtl(MVAU, RTLBackend):
             rtllib_dir + "mvu_4sx4u.sv",
             rtllib_dir + "mvu_vvu_8sx9_dsp58.sv",
             rtllib_dir + "mvu_8sx8u_dsp48.sv",
+            rtllib_dir + "mvu_bitserial.sv",
         ]
         for f in sourcefiles:
             cmd.append("add_files -norecurse %s" % (f))
@@ -197,6 +224,8 @@ class MVAU_rtl(MVAU, RTLBackend):
     def _resolve_impl_style(self, dsp_block):
         # Based on target device and activation/weight-width, choose the
         # supported RTL compute core
+        if self.get_nodeattr("bitSerial") == 1:
+            return "mvu_bitserial"
         assert (
             self.get_nodeattr("resType") != "lut"
         ), """LUT-based RTL-MVU implementation currently not supported!
@@ -219,6 +248,9 @@ class MVAU_rtl(MVAU, RTLBackend):
                 return "mvu_8sx8u_dsp48"
 
     def generate_hdl(self, model, fpgapart, clk):
+        assert not self.uses_batch_tiled_weights(), (
+            "weightReuse > 1 is only supported by MVAU_hls, see %s" % self.onnx_node.name
+        )
         # Generate params as part of IP preparation
         code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
         self.generate_params(model, code_gen_dir)
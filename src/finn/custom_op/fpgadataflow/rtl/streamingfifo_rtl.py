@@ -25,17 +25,23 @@
 # CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+import math
 import numpy as np
 import os
 import shutil
 import warnings
 from qonnx.core.datatype import DataType
+from qonnx.util.basic import roundup_to_integer_multiple
 
 from finn.custom_op.fpgadataflow.rtlbackend import RTLBackend
 from finn.custom_op.fpgadataflow.streamingfifo import StreamingFIFO
 from finn.util.basic import get_rtlsim_trace_depth, make_build_dir
 from finn.util.data_packing import npy_to_rtlsim_input, rtlsim_output_to_npy
 
+# widest stream that impl_style=dram supports, one stream word per AXI-MM beat
+# and AXI4 data buses are limited to 1024 bits
+dram_fifo_max_width = 1024
+
 try:
     from pyverilator import PyVerilator
 except ModuleNotFoundError:
@@ -51,7 +57,15 @@ class StreamingFIFO_rtl(StreamingFIFO, RTLBackend):
             # Toggle between rtl or IPI implementation
             # rtl - use the rtl generated IP during stitching
             # vivado - use the AXI Infrastructure FIFO
-            "impl_style": ("s", False, "rtl", {"rtl", "vivado"}),
+            # dram - spill to off-chip memory through an AXI-MM master,
+            # with small on-chip buffers at both ends
+            "impl_style": ("s", False, "rtl", {"rtl", "vivado", "dram"}),
+            # byte address of the ring buffer in off-chip memory (impl_style=dram)
+            # the region of get_dram_bytes() bytes must be reserved for this FIFO,
+            # there is no default, -1 means not set
+            "dram_base_addr": ("i", False, -1),
+            # number of stream words per memory burst (impl_style=dram)
+            "dram_burst_len": ("i", False, 64),
         }
         my_attrs.update(StreamingFIFO.get_nodeattr_types(self))
         my_attrs.update(RTLBackend.get_nodeattr_types(self))
@@ -71,19 +85,69 @@ class StreamingFIFO_rtl(StreamingFIFO, RTLBackend):
                     "%s: rounding-up FIFO depth from %d to %d for impl_style=vivado"
                     % (self.onnx_node.name, old_depth, depth)
                 )
+        elif impl == "dram":
+            # the ring buffer holds whole bursts only
+            burst_len = self.get_dram_burst_len()
+            depth = roundup_to_integer_multiple(depth, burst_len)
 
         return depth
 
+    def get_dram_mem_width(self):
+        """Returns the width of the AXI-MM data bus for impl_style=dram, which
+        carries one stream word per beat."""
+        in_width = self.get_instream_width_padded()
+        assert in_width <= dram_fifo_max_width, (
+            "%s: stream width %d exceeds the AXI-MM data width limit of %d bits for "
+            "impl_style=dram" % (self.onnx_node.name, in_width, dram_fifo_max_width)
+        )
+        return max(32, 1 << (in_width - 1).bit_length())
+
+    def get_dram_burst_len(self):
+        """Returns the burst length for impl_style=dram, limited such that
+        bursts do not cross 4k boundaries and the on-chip buffers fit Q_srl."""
+        mem_bytes = self.get_dram_mem_width() // 8
+        burst_len = min(self.get_nodeattr("dram_burst_len"), 4096 // mem_bytes, 128)
+        return max(2, burst_len)
+
+    def get_dram_bytes(self):
+        """Returns the size of the off-chip ring buffer in bytes for impl_style=dram."""
+        return self.get_adjusted_depth() * self.get_dram_mem_width() // 8
+
+    def bram_estimation(self):
+        if self.get_nodeattr("impl_style") == "dram":
+            return 0
+        return super().bram_estimation()
+
+    def uram_estimation(self):
+        if self.get_nodeattr("impl_style") == "dram":
+            return 0
+        return super().uram_estimation()
+
+    def lut_estimation(self):
+        if self.get_nodeattr("impl_style") == "dram":
+            # head and tail buffers of two bursts each plus AXI-MM control
+            buf_depth = 2 * self.get_dram_burst_len()
+            W = self.get_instream_width()
+            ram_luts = 2 * (math.ceil(buf_depth / 32)) * (math.ceil(W / 2))
+            ctrl_luts = 300 + self.get_dram_mem_width() // 8
+            return int(ram_luts + ctrl_luts)
+        return super().lut_estimation()
+
     def get_verilog_top_module_intf_names(self):
         ret = super().get_verilog_top_module_intf_names()
         is_rtl = self.get_nodeattr("impl_style") == "rtl"
         is_depth_monitor = self.get_nodeattr("depth_monitor") == 1
         if is_rtl and is_depth_monitor:
             ret["ap_none"] = ["maxcount"]
+        if self.get_nodeattr("impl_style") == "dram":
+            ret["aximm"] = [("m_axi_gmem", self.get_dram_mem_width())]
         return ret
 
     def generate_hdl(self, model, fpgapart, clk):
         rtlsrc = os.environ["FINN_ROOT"] + "/finn-rtllib/fifo/hdl"
+        if self.get_nodeattr("impl_style") == "dram":
+            self.generate_dram_hdl(rtlsrc)
+            return
         template_path = rtlsrc + "/fifo_template.v"
 
         # save top module name so we can refer to it after this node has been renamed
@@ -120,6 +184,44 @@ class StreamingFIFO_rtl(StreamingFIFO, RTLBackend):
         self.set_nodeattr("ipgen_path", code_gen_dir)
         self.set_nodeattr("ip_path", code_gen_dir)
 
+    def generate_dram_hdl(self, rtlsrc):
+        """Fills in the template of the off-chip memory backed FIFO."""
+        topname = self.get_verilog_top_module_name()
+        self.set_nodeattr("gen_top_module", topname)
+
+        burst_len = self.get_dram_burst_len()
+        mem_bytes = self.get_dram_mem_width() // 8
+        base_addr = self.get_nodeattr("dram_base_addr")
+        assert base_addr >= 0, (
+            "%s: dram_base_addr must be set to the address of a reserved memory region"
+            % self.onnx_node.name
+        )
+        assert (
+            base_addr % (burst_len * mem_bytes) == 0
+        ), "%s: dram_base_addr must be aligned to the burst size of %d bytes" % (
+            self.onnx_node.name,
+            burst_len * mem_bytes,
+        )
+        code_gen_dict = {}
+        code_gen_dict["$TOP_MODULE_NAME$"] = topname
+        code_gen_dict["$WIDTH$"] = str(self.get_instream_width_padded())
+        code_gen_dict["$DEPTH$"] = str(self.get_adjusted_depth())
+        code_gen_dict["$BURST_LEN$"] = str(burst_len)
+        code_gen_dict["$BASE_ADDR$"] = "64'h%x" % base_addr
+        code_gen_dict["$MEM_WIDTH$"] = str(self.get_dram_mem_width())
+        code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+        with open(rtlsrc + "/dram_fifo_template.v", "r") as f:
+            template = f.read()
+        for key_name in code_gen_dict:
+            template = template.replace(key_name, code_gen_dict[key_name])
+        with open(os.path.join(code_gen_dir, topname + ".v"), "w") as f:
+            f.write(template)
+
+        shutil.copy(rtlsrc + "/Q_srl.v", code_gen_dir)
+        shutil.copy(rtlsrc + "/dram_fifo.sv", code_gen_dir)
+        self.set_nodeattr("ipgen_path", code_gen_dir)
+        self.set_nodeattr("ip_path", code_gen_dir)
+
     def execute_node(self, context, graph):
         mode = self.get_nodeattr("exec_mode")
         node = self.onnx_node
@@ -131,7 +233,7 @@ class StreamingFIFO_rtl(StreamingFIFO, RTLBackend):
             output = np.asarray([output], dtype=np.float32).reshape(*exp_shape)
             context[node.output[0]] = output
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
             # create a npy file for the input of the node
             assert (
                 str(inp.dtype) == "float32"
@@ -176,13 +278,15 @@ class StreamingFIFO_rtl(StreamingFIFO, RTLBackend):
 
     def code_generation_ipi(self):
         impl_style = self.get_nodeattr("impl_style")
-        if impl_style == "rtl":
+        if impl_style in ["rtl", "dram"]:
             code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
 
             sourcefiles = [
                 "Q_srl.v",
                 self.get_nodeattr("gen_top_module") + ".v",
             ]
+            if impl_style == "dram":
+                sourcefiles += ["dram_fifo.sv"]
 
             sourcefiles = [os.path.join(code_gen_dir, f) for f in sourcefiles]
 
@@ -251,13 +355,14 @@ class StreamingFIFO_rtl(StreamingFIFO, RTLBackend):
             return cmd
         else:
             raise Exception(
-                "FIFO implementation style %s not supported, please use rtl or vivado" % impl_style
+                "FIFO implementation style %s not supported, please use rtl, vivado or dram"
+                % impl_style
             )
 
     def prepare_rtlsim(self):
-        assert self.get_nodeattr("impl_style") != "vivado", (
+        assert self.get_nodeattr("impl_style") == "rtl", (
             "StreamingFIFO impl_style "
-            "cannot be vivado for rtlsim. Only impl_style=rtl supported."
+            "cannot be vivado or dram for rtlsim. Only impl_style=rtl supported."
         )
         # Modified to use generated (System-)Verilog instead of HLS output products
 
@@ -379,10 +379,10 @@ class Thresholding_rtl(Thresholding, RTLBackend):
 
     def execute_node(self, context, graph):
         mode = self.get_nodeattr("exec_mode")
-        code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
         if mode == "cppsim":
             Thresholding.execute_node(self, context, graph)
         elif mode == "rtlsim":
+            code_gen_dir = self.get_rtlsim_io_dir()
             node = self.onnx_node
             # create a npy file fore each input of the node (in_ind is input index)
             in_ind = 0
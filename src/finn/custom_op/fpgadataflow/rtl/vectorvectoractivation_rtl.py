@@ -62,7 +62,7 @@ class VVAU_rtl(VVAU, RTLBackend):
         if mode == "cppsim":
             VVAU.execute_node(self, context, graph)
         elif mode == "rtlsim":
-            code_gen_dir = self.get_nodeattr("code_gen_dir_ipgen")
+            code_gen_dir = self.get_rtlsim_io_dir()
             # create a npy file fore each input of the node (in_ind is input index)
             in_ind = 0
             for inputs in node.input:
@@ -106,7 +106,9 @@ class VVAU_rtl(VVAU, RTLBackend):
                     if self.get_weight_datatype() == DataType["BIPOLAR"]:
                         export_wdt = DataType["BINARY"]
                     wei = npy_to_rtlsim_input(
-                        "{}/weights.npy".format(code_gen_dir), export_wdt, wnbits
+                        "{}/weights.npy".format(self.get_nodeattr("code_gen_dir_ipgen")),
+                        export_wdt,
+                        wnbits,
                     )
                     dim_h, dim_w = self.get_nodeattr("Dim")
                     num_w_reps = dim_h * dim_w
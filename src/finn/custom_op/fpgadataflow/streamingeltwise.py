@@ -27,6 +27,7 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import math
 import numpy as np
 import warnings
 from qonnx.core.datatype import DataType
@@ -50,7 +51,10 @@ class StreamingEltwise(HWCustomOp):
                 "inputDataType0": ("s", True, ""),
                 "inputDataType1": ("s", True, ""),
                 # type of EltwiseFunction for the operation
-                "eltwiseOp": ("s", True, "", ["Add", "Sub", "AbsDiff"]),
+                "eltwiseOp": ("s", True, "", ["Add", "Sub", "AbsDiff", "Mul", "Max", "Min"]),
+                # use DSPs or LUTs for the multipliers of eltwiseOp=Mul, auto
+                # picks DSPs unless one of the operands is narrow (<= 4 bits)
+                "resType": ("s", False, "auto", {"auto", "lut", "dsp"}),
                 # number of input vectors, examples:
                 # [1] is a single vector (like a FC layer with batch=1)
                 # [4] is four vectors (like a FC layer with batch=4)
@@ -76,6 +80,9 @@ class StreamingEltwise(HWCustomOp):
             "Add": f"add<{tin0}, {tin1}, {tout}>()",
             "Sub": f"sub<{tin0}, {tin1}, {tout}>()",
             "AbsDiff": f"absdiff<{tin0}, {tin1}, {tout}>()",
+            "Mul": f"mul<{tin0}, {tin1}, {tout}>()",
+            "Max": f"maximum<{tin0}, {tin1}, {tout}>()",
+            "Min": f"minimum<{tin0}, {tin1}, {tout}>()",
         }
         return eltwise_ops[eltwise_op]
 
@@ -144,6 +151,21 @@ class StreamingEltwise(HWCustomOp):
         op = self.get_nodeattr("eltwiseOp")
         idt0 = self.get_input_datatype(0)
         idt1 = self.get_input_datatype(1)
+        if op in ["Mul", "Max", "Min"]:
+            # these are fine with mixed signedness, size from the output range
+            if op == "Mul":
+                cands = [a * b for a in (idt0.min(), idt0.max()) for b in (idt1.min(), idt1.max())]
+                out_min, out_max = min(cands), max(cands)
+            elif op == "Max":
+                out_min = max(idt0.min(), idt1.min())
+                out_max = max(idt0.max(), idt1.max())
+            else:
+                out_min = min(idt0.min(), idt1.min())
+                out_max = min(idt0.max(), idt1.max())
+            if out_min < 0:
+                return DataType.get_smallest_possible(min(out_min, -out_max - 1))
+            else:
+                return DataType.get_smallest_possible(out_max)
         assert idt0.signed() == idt1.signed(), (
             "%s: Inputs must have same signedness" % self.onnx_node.name
         )
@@ -189,6 +211,49 @@ class StreamingEltwise(HWCustomOp):
         # Channels/PE * batch size * fmdim * fmdim
         return np.prod(self.get_folded_output_shape()[:-1])
 
+    def uses_dsp(self):
+        """Returns whether the multipliers of eltwiseOp=Mul go into DSPs."""
+        if self.get_nodeattr("eltwiseOp") != "Mul":
+            return False
+        res_type = self.get_nodeattr("resType")
+        if res_type == "auto":
+            w0 = self.get_input_datatype(0).bitwidth()
+            w1 = self.get_input_datatype(1).bitwidth()
+            return min(w0, w1) > 4
+        return res_type == "dsp"
+
+    def lut_estimation(self):
+        op = self.get_nodeattr("eltwiseOp")
+        pe = self.get_nodeattr("PE")
+        w0 = self.get_input_datatype(0).bitwidth()
+        w1 = self.get_input_datatype(1).bitwidth()
+        obits = self.get_output_datatype().bitwidth()
+        if op in ["Add", "Sub"]:
+            # one adder per PE
+            luts_per_pe = obits
+        elif op == "AbsDiff":
+            # subtract both ways and select
+            luts_per_pe = 3 * obits
+        elif op in ["Max", "Min"]:
+            # comparator and output mux
+            luts_per_pe = max(w0, w1) + obits
+        elif op == "Mul":
+            if self.uses_dsp():
+                luts_per_pe = 0
+            else:
+                # same multiplier model as the MVAU
+                luts_per_pe = (2 * math.ceil((w0 + w1) / 6) - 1) * (w0 + w1)
+        else:
+            raise Exception("%s: Unknown eltWiseOp = %s" % (self.onnx_node.name, op))
+        return int(pe * luts_per_pe)
+
+    def dsp_estimation(self, fpgapart):
+        if not self.uses_dsp():
+            return 0
+        w0 = self.get_input_datatype(0).bitwidth()
+        w1 = self.get_input_datatype(1).bitwidth()
+        return int(self.get_nodeattr("PE") * np.ceil((w0 + w1) / 48))
+
     def execute_node(self, context, graph):
         # simulate behavior using Python
         node = self.onnx_node
@@ -199,14 +264,21 @@ class StreamingEltwise(HWCustomOp):
         ishape0 = inp0_values.shape
         ishape1 = inp1_values.shape
         assert ishape0 == ishape1, "Shapes of inputs should be the same for Streamingeltwise"
-        # subtraction
-        result = inp0_values - inp1_values
-        if eltwiseOp == "Sub":
-            context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
+        if eltwiseOp == "Add":
+            result = inp0_values + inp1_values
+        elif eltwiseOp == "Sub":
+            result = inp0_values - inp1_values
         elif eltwiseOp == "AbsDiff":
-            context[node.output[0]] = np.abs(np.asarray(result, dtype=np.float32)).reshape(oshape)
+            result = np.abs(inp0_values - inp1_values)
+        elif eltwiseOp == "Mul":
+            result = inp0_values * inp1_values
+        elif eltwiseOp == "Max":
+            result = np.maximum(inp0_values, inp1_values)
+        elif eltwiseOp == "Min":
+            result = np.minimum(inp0_values, inp1_values)
         else:
             raise Exception("%s: Unknown eltWiseOp = %s" % (node.name, eltwiseOp))
+        context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
 
     def get_verilog_top_module_intf_names(self):
         intf_names = super().get_verilog_top_module_intf_names()
@@ -0,0 +1,227 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import math
+import numpy as np
+import warnings
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+
+
+class StreamingLayerNorm(HWCustomOp):
+    """Abstraction layer for HW implementation of an integer layer normalization
+    over the innermost dimension, without the affine (gamma, beta) part. The
+    output is round(2^outFracBits * (x - mean) / sqrt(var + epsilon)), saturated
+    to the signed outputDataType. epsilon is given in units of the integer input,
+    i.e. the original epsilon divided by the square of the input scale.
+
+    Row statistics are computed exactly in integers, the reciprocal square root
+    comes from a table indexed by the leading rsqrtTableBits of C^2 * (var + eps)."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = super().get_nodeattr_types()
+        my_attrs.update(
+            {
+                "NumChannels": ("i", True, 0),
+                "PE": ("i", True, 0),
+                "inputDataType": ("s", True, ""),
+                # must be signed, the output has outFracBits fractional bits
+                "outputDataType": ("s", True, ""),
+                "outFracBits": ("i", False, 5),
+                "epsilon": ("f", False, 0.0),
+                # rsqrt table: index bits and fractional bits of the entries
+                "rsqrtTableBits": ("i", False, 10),
+                "rsqrtBits": ("i", False, 16),
+                # number of input vectors (rows), examples:
+                # [1] is a single vector
+                # [1, 4, 4] is four * four vectors (e.g. heads * sequence length)
+                "numInputVectors": ("ints", False, [1]),
+            }
+        )
+        return my_attrs
+
+    def get_normal_input_shape(self, ind=0):
+        ich = self.get_nodeattr("NumChannels")
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        return tuple(vecs + [ich])
+
+    def get_folded_input_shape(self, ind=0):
+        ich = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        assert ich % pe == 0, "PE must divide NumChannels"
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        return tuple(vecs + [ich // pe, pe])
+
+    def get_normal_output_shape(self, ind=0):
+        return self.get_normal_input_shape()
+
+    def get_folded_output_shape(self, ind=0):
+        return self.get_folded_input_shape()
+
+    def make_shape_compatible_op(self, model):
+        exp_ishape = self.get_normal_input_shape()
+        ishape = tuple(model.get_tensor_shape(self.onnx_node.input[0]))
+        assert ishape == exp_ishape, "Unexpected input shape."
+        return super().make_const_shape_op(self.get_normal_output_shape())
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype()),
+                str(idt),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        pass
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        odt = DataType[self.get_nodeattr("outputDataType")]
+        assert odt.signed(), "%s: outputDataType must be signed" % self.onnx_node.name
+        return odt
+
+    def get_instream_width(self, ind=0):
+        """Returns input stream width."""
+        return self.get_input_datatype().bitwidth() * self.get_nodeattr("PE")
+
+    def get_outstream_width(self, ind=0):
+        """Returns output stream width."""
+        return self.get_output_datatype().bitwidth() * self.get_nodeattr("PE")
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_eps_term(self):
+        """Returns epsilon scaled to the integer row statistics, C^2 * eps."""
+        ch = self.get_nodeattr("NumChannels")
+        return int(round(ch * ch * self.get_nodeattr("epsilon")))
+
+    def get_rsqrt_table(self):
+        """Returns the rsqrt table as integers, entry m holds
+        round(2^rsqrtBits / sqrt(m)), with entry 0 set to 0."""
+        tbits = self.get_nodeattr("rsqrtTableBits")
+        rbits = self.get_nodeattr("rsqrtBits")
+        m = np.arange(1, 2**tbits, dtype=np.float64)
+        table = np.round(2**rbits / np.sqrt(m)).astype(np.int64)
+        return np.concatenate([[0], table])
+
+    def execute_node(self, context, graph):
+        # bit-exact model of the HLS implementation
+        node = self.onnx_node
+        ch = self.get_nodeattr("NumChannels")
+        tbits = self.get_nodeattr("rsqrtTableBits")
+        rbits = self.get_nodeattr("rsqrtBits")
+        fbits = self.get_nodeattr("outFracBits")
+        odt = self.get_output_datatype()
+        table = self.get_rsqrt_table()
+        x = context[node.input[0]].astype(np.int64).reshape(-1, ch)
+        s = x.sum(axis=-1)
+        den = ch * (x * x).sum(axis=-1) - s * s + self.get_eps_term()
+        q = np.zeros_like(x)
+        for row in range(x.shape[0]):
+            # even normalization shift so that sqrt(2^k) = 2^(k/2) stays exact
+            k = max(0, int(den[row]).bit_length() - tbits)
+            k += k & 1
+            rs = table[int(den[row]) >> k]
+            shift = rbits + k // 2 - fbits
+            q[row] = ((ch * x[row] - s[row]) * rs + (1 << (shift - 1))) >> shift
+        q = np.clip(q, odt.min(), odt.max())
+        oshape = context[node.output[0]].shape
+        context[node.output[0]] = q.astype(np.float32).reshape(oshape)
+
+    def get_exp_cycles(self):
+        # two passes of NF cycles over each row: statistics, normalize. The
+        # loops are flushed after each row, so each adds its pipeline depth
+        # per row, and the rsqrt of the row statistics is computed in between.
+        pe = self.get_nodeattr("PE")
+        nf = self.get_nodeattr("NumChannels") // pe
+        rows = int(np.prod(self.get_folded_output_shape()[:-2]))
+        pe_tree = math.ceil(math.log2(pe)) if pe > 1 else 0
+        # stream read, squaring on the DSPs and the adder trees
+        stats_depth = 5 + pe_tree
+        # 64-bit products C*Q and S*S, leading-one detection and normalization
+        # shift, rsqrt table read
+        rsqrt_latency = 6 + 2 + 2
+        # buffer read, 64-bit product with the rsqrt, rounding and clipping
+        norm_depth = 2 + 6 + 2
+        row_cycles = 2 * nf + stats_depth + rsqrt_latency + norm_depth
+        return int(rows * row_cycles)
+
+    def bram_estimation(self):
+        # row buffer and the shared rsqrt table
+        pe = self.get_nodeattr("PE")
+        nf = self.get_nodeattr("NumChannels") // pe
+        ibits = self.get_input_datatype().bitwidth()
+        tbits = self.get_nodeattr("rsqrtTableBits")
+        rbits = self.get_nodeattr("rsqrtBits") + 1
+        count = 0
+        if nf > 128:
+            count += math.ceil(nf / 1024) * math.ceil(pe * ibits / 18)
+        if 2**tbits > 128:
+            count += math.ceil(2**tbits / 1024) * math.ceil(rbits / 18)
+        return int(count)
+
+    def lut_estimation(self):
+        # per PE: accumulators, centering subtractor, rounding and saturation,
+        # plus the shared leading-one detector and normalization shifter
+        pe = self.get_nodeattr("PE")
+        ch = self.get_nodeattr("NumChannels")
+        ibits = self.get_input_datatype().bitwidth()
+        obits = self.get_output_datatype().bitwidth()
+        acc_bits = 2 * ibits + math.ceil(math.log2(ch))
+        shifter_luts = 64 * 6
+        return int(pe * (2 * acc_bits + ibits + 2 * obits) + shifter_luts)
+
+    def dsp_estimation(self, fpgapart):
+        # per PE: the square for sum(x^2) and the product with the rsqrt
+        ibits = self.get_input_datatype().bitwidth()
+        return int(self.get_nodeattr("PE") * 2 * math.ceil(2 * ibits / 48))
+
+    def get_op_and_param_counts(self):
+        n_elems = int(np.prod(self.get_normal_output_shape()))
+        ibits = self.get_input_datatype().bitwidth()
+        rbits = self.get_nodeattr("rsqrtBits") + 1
+        return {
+            "op_layernorm_%db" % ibits: n_elems,
+            "param_rsqrttable_%db" % rbits: 2 ** self.get_nodeattr("rsqrtTableBits"),
+        }
@@ -27,14 +27,12 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 import numpy as np
-import onnxruntime as rt
 import warnings
-from onnx import TensorProto, helper
 from qonnx.core.datatype import DataType
 from qonnx.custom_op.general.maxpoolnhwc import compute_pool_output_dim
-from qonnx.util.basic import qonnx_make_model
 
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.nhwc_kernels import maxpool_nhwc, to_compute_array
 
 # TODO: consider splitting this into separate implementations for 1D and 2D
 # similar to what we do for ConvolutionInputGenerator
@@ -191,46 +189,11 @@ class StreamingMaxPool(HWCustomOp):
         pass
 
     def execute_node(self, context, graph):
-        # create a standard add node to help calculate the result
+        # simulate behavior with Python functionality
         node = self.onnx_node
         kernel_shape = self.get_nodeattr("PoolDim")
-        ceil_mode = self.get_nodeattr("CeilMode")
-        inp_values = context[node.input[0]]
-        dummy_out = context[node.output[0]]
-        # convert i/o NHWC -> NCHW
-        inp_values = np.transpose(inp_values, (0, 3, 1, 2))
-        dummy_out = np.transpose(dummy_out, (0, 3, 1, 2))
-        # handle 1d case
-        ishape = inp_values.shape
-        if ishape[2] == 1 or ishape[3] == 1:
-            inp_values = inp_values.reshape(ishape[0], ishape[1], ishape[2] * ishape[3])
-            kernel_shape = [kernel_shape[0] * kernel_shape[1]]
-        # execute as regular MaxPool
-        inp = helper.make_tensor_value_info(node.input[0], TensorProto.FLOAT, inp_values.shape)
-        outp = helper.make_tensor_value_info(node.output[0], TensorProto.FLOAT, dummy_out.shape)
-        node_mp = helper.make_node(
-            "MaxPool",
-            inputs=[node.input[0]],
-            outputs=[node.output[0]],
-            kernel_shape=kernel_shape,
-            strides=kernel_shape,
-            ceil_mode=ceil_mode,
-        )
-        graph_mp = helper.make_graph(
-            nodes=[node_mp],
-            name="single-mp-exec",
-            inputs=[inp],
-            outputs=[outp],
-        )
-
-        opset_version = self.onnx_opset_version
-        opset_imports = [helper.make_opsetid("", opset_version)]
-        onnx_kwargs = {"opset_imports": opset_imports}
-        model_mp = qonnx_make_model(graph_mp, **onnx_kwargs)
-        idict = {node.input[0]: inp_values}
-        sess = rt.InferenceSession(model_mp.SerializeToString())
-        result = sess.run(None, idict)
-        result = np.asarray(result, dtype=np.float32).reshape(dummy_out.shape)
-        # convert output NCHW -> NHWC
-        result = np.transpose(result, (0, 2, 3, 1))
+        inp_values = to_compute_array(context[node.input[0]], self.get_input_datatype())
+        oshape = context[node.output[0]].shape
+        result = maxpool_nhwc(inp_values, kernel_shape, oshape)
+        result = np.asarray(result, dtype=np.float32)
         context[node.output[0]] = result
@@ -0,0 +1,212 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import math
+import numpy as np
+import warnings
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+
+# fractional bits of the per-row reciprocal in the HLS implementation
+SOFTMAX_RCP_BITS = 32
+
+
+class StreamingSoftmax(HWCustomOp):
+    """Abstraction layer for HW implementation of an integer softmax over the
+    innermost dimension. The input is an integer tensor x with an associated
+    scale s (i.e. the original softmax input is s*x), the output is the
+    softmax probability p quantized as round(p * 2^obits), saturated to the
+    unsigned outputDataType. Exponentials are taken from a table indexed by
+    max(x) - x, normalization uses a single reciprocal per row."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = super().get_nodeattr_types()
+        my_attrs.update(
+            {
+                "NumChannels": ("i", True, 0),
+                "PE": ("i", True, 0),
+                "inputDataType": ("s", True, ""),
+                # must be unsigned, the output has obits fractional bits
+                "outputDataType": ("s", True, ""),
+                # scale of the integer input
+                "inputScale": ("f", False, 1.0),
+                # fractional bits of the exponential table entries
+                "expBits": ("i", False, 16),
+                # number of input vectors (rows), examples:
+                # [1] is a single vector
+                # [1, 4, 4] is four * four vectors (e.g. heads * sequence length)
+                "numInputVectors": ("ints", False, [1]),
+            }
+        )
+        return my_attrs
+
+    def get_normal_input_shape(self, ind=0):
+        ich = self.get_nodeattr("NumChannels")
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        return tuple(vecs + [ich])
+
+    def get_folded_input_shape(self, ind=0):
+        ich = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        assert ich % pe == 0, "PE must divide NumChannels"
+        vecs = list(self.get_nodeattr("numInputVectors"))
+        return tuple(vecs + [ich // pe, pe])
+
+    def get_normal_output_shape(self, ind=0):
+        return self.get_normal_input_shape()
+
+    def get_folded_output_shape(self, ind=0):
+        return self.get_folded_input_shape()
+
+    def make_shape_compatible_op(self, model):
+        exp_ishape = self.get_normal_input_shape()
+        ishape = tuple(model.get_tensor_shape(self.onnx_node.input[0]))
+        assert ishape == exp_ishape, "Unexpected input shape."
+        return super().make_const_shape_op(self.get_normal_output_shape())
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype()),
+                str(idt),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        pass
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        odt = DataType[self.get_nodeattr("outputDataType")]
+        assert not odt.signed(), "%s: outputDataType must be unsigned" % self.onnx_node.name
+        return odt
+
+    def get_instream_width(self, ind=0):
+        """Returns input stream width."""
+        return self.get_input_datatype().bitwidth() * self.get_nodeattr("PE")
+
+    def get_outstream_width(self, ind=0):
+        """Returns output stream width."""
+        return self.get_output_datatype().bitwidth() * self.get_nodeattr("PE")
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_exp_table(self):
+        """Returns the exponential table as integers, entry d holds
+        round(2^expBits * exp(-inputScale * d)) for d = max(x) - x."""
+        ibits = self.get_input_datatype().bitwidth()
+        scale = self.get_nodeattr("inputScale")
+        ebits = self.get_nodeattr("expBits")
+        d = np.arange(2**ibits, dtype=np.float64)
+        return np.round(np.exp(-scale * d) * 2**ebits).astype(np.int64)
+
+    def execute_node(self, context, graph):
+        # bit-exact model of the HLS implementation
+        node = self.onnx_node
+        x = context[node.input[0]].astype(np.int64)
+        obits = self.get_output_datatype().bitwidth()
+        d = x.max(axis=-1, keepdims=True) - x
+        e = self.get_exp_table()[d]
+        rcp = (1 << SOFTMAX_RCP_BITS) // e.sum(axis=-1, keepdims=True)
+        q = ((e * rcp << obits) + (1 << (SOFTMAX_RCP_BITS - 1))) >> SOFTMAX_RCP_BITS
+        q = np.minimum(q, self.get_output_datatype().max())
+        oshape = context[node.output[0]].shape
+        context[node.output[0]] = q.astype(np.float32).reshape(oshape)
+
+    def get_exp_cycles(self):
+        # three passes of NF cycles over each row: max, exp + sum, normalize.
+        # The loops are flushed after each row, so each adds its pipeline
+        # depth per row, and the reciprocal divide runs in between.
+        pe = self.get_nodeattr("PE")
+        nf = self.get_nodeattr("NumChannels") // pe
+        rows = int(np.prod(self.get_folded_output_shape()[:-2]))
+        pe_tree = math.ceil(math.log2(pe)) if pe > 1 else 0
+        # stream read and the comparator tree
+        max_depth = 2 + pe_tree
+        # buffer and exp table reads (2 cycles each) and the adder tree
+        exp_depth = 5 + pe_tree
+        # buffer read, e * reciprocal on the DSPs, rounding and saturation
+        norm_depth = 7
+        # the HLS divider computes one bit of the RB+1 bit quotient per stage
+        div_latency = SOFTMAX_RCP_BITS + 1 + 4
+        row_cycles = 3 * nf + max_depth + exp_depth + norm_depth + div_latency
+        return int(rows * row_cycles)
+
+    def bram_estimation(self):
+        # row buffers for inputs and exponentials, plus one table per PE
+        pe = self.get_nodeattr("PE")
+        nf = self.get_nodeattr("NumChannels") // pe
+        ibits = self.get_input_datatype().bitwidth()
+        ebits = self.get_nodeattr("expBits") + 1
+        count = 0
+        if nf > 128:
+            count += math.ceil(nf / 1024) * math.ceil(pe * ibits / 18)
+            count += pe * math.ceil(nf / 1024) * math.ceil(ebits / 18)
+        if 2**ibits > 128:
+            count += pe * math.ceil(2**ibits / 1024) * math.ceil(ebits / 18)
+        return int(count)
+
+    def lut_estimation(self):
+        # per PE: max comparator, sum adder and output rounding/saturation,
+        # plus a shared 32-bit divider for the row reciprocal
+        pe = self.get_nodeattr("PE")
+        ibits = self.get_input_datatype().bitwidth()
+        obits = self.get_output_datatype().bitwidth()
+        ebits = self.get_nodeattr("expBits") + 1
+        acc_bits = ebits + math.ceil(math.log2(self.get_nodeattr("NumChannels")))
+        divider_luts = SOFTMAX_RCP_BITS * (SOFTMAX_RCP_BITS + 1)
+        return int(pe * (2 * ibits + acc_bits + obits + ebits) + divider_luts)
+
+    def dsp_estimation(self, fpgapart):
+        # one multiplier per PE for e * reciprocal
+        ebits = self.get_nodeattr("expBits") + 1
+        return int(self.get_nodeattr("PE") * math.ceil((ebits + SOFTMAX_RCP_BITS) / 48))
+
+    def get_op_and_param_counts(self):
+        n_elems = int(np.prod(self.get_normal_output_shape()))
+        ibits = self.get_input_datatype().bitwidth()
+        ebits = self.get_nodeattr("expBits") + 1
+        return {
+            "op_softmax_%db" % ibits: n_elems,
+            "param_exptable_%db" % ebits: 2**ibits,
+        }
@@ -58,6 +58,75 @@ $SAVEASCNPY$
 
 """
 
+# templates for stitched cppsim: one function per node with the cppsim code
+# of the node, and a main connecting the nodes in the stitched topology
+stitched_cppsim_node_template = """
+#define AP_INT_MAX_W $AP_INT_MAX_W$
+#include "cnpy.h"
+#include "npy2apintstream.hpp"
+#include <vector>
+#include "bnn-library.h"
+
+// includes for network parameters
+$GLOBALS$
+
+// defines for network parameters
+$DEFINES$
+
+$NODEFUNCTION$ {
+$PRAGMAS$
+
+$STREAMDECLARATIONS$
+
+$READNPYDATA$
+
+$DOCOMPUTE$
+}
+"""
+
+stitched_cppsim_main_template = """
+#define AP_INT_MAX_W $AP_INT_MAX_W$
+#include "cnpy.h"
+#include "npy2apintstream.hpp"
+#include "stitched_cppsim.hpp"
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+$NODEFUNCTIONS$
+
+int main(int argc, char *argv[]) {
+    // usage: <npy dir> <batch size> [seq]
+    std::string npy_dir = argv[1];
+    size_t batch = std::stoul(argv[2]);
+    bool threaded = !(argc > 3 && std::string(argv[3]) == "seq");
+
+$STREAMDECLARATIONS$
+
+$READNPYDATA$
+
+    std::vector<std::function<void()>> stages = {
+$STAGES$
+    };
+    std::vector<std::thread> threads;
+    for(auto &stage : stages) {
+        if(threaded) {
+            threads.emplace_back(stage);
+        } else {
+            stage();
+        }
+    }
+
+$DATAOUTSTREAM$
+
+    for(auto &t : threads) {
+        t.join();
+    }
+    return 0;
+}
+"""
+
 # templates for single node ip generation
 
 # cpp file
@@ -27,13 +27,11 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 import numpy as np
-import onnxruntime as rt
 import warnings
-from onnx import TensorProto, helper
 from qonnx.core.datatype import DataType
-from qonnx.util.basic import qonnx_make_model
 
 from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.nhwc_kernels import to_compute_array, upsample_nearest_nhwc
 
 
 class UpsampleNearestNeighbour(HWCustomOp):
@@ -149,43 +147,22 @@ class UpsampleNearestNeighbour(HWCustomOp):
         return np.prod(folded_oshape[:-1])
 
     def execute_node(self, context, graph):
-        # create a standard resize node to help calculate the result
+        # simulate behavior with Python functionality
         node = self.onnx_node
-        inp_values = context[node.input[0]]
+        inp_values = to_compute_array(context[node.input[0]], self.get_input_datatype())
         ishape = inp_values.shape
         odim = self.get_nodeattr("OFMDim")
         idim = self.get_nodeattr("IFMDim")
+        scale = int(round(odim / idim))
         if ishape[1] == ishape[2]:
-            scales_val = [1, int(round(odim / idim)), int(round(odim / idim)), 1]
+            scales_val = [scale, scale]
         elif ishape[1] > 1 and ishape[2] == 1:
-            scales_val = [1, int(round(odim / idim)), 1, 1]
+            scales_val = [scale, 1]
         else:
-            warnings.warn(
+            raise Exception(
                 """HW abstraction layer for Upsample cannot be executed.
             Upsampling only supported for 1D H, or 2D square scaling"""
             )
         oshape = context[node.output[0]].shape
-        inp = helper.make_tensor_value_info(node.input[0], TensorProto.FLOAT, ishape)
-        scales = helper.make_tensor_value_info("scales", TensorProto.FLOAT, [4])
-        outp = helper.make_tensor_value_info(node.output[0], TensorProto.FLOAT, oshape)
-        node_resize = helper.make_node(
-            "Resize",
-            inputs=[node.input[0], "", "scales"],
-            outputs=[node.output[0]],
-            mode="nearest",
-        )
-        graph_resize = helper.make_graph(
-            nodes=[node_resize],
-            name="single-resize-exec",
-            inputs=[inp, scales],
-            outputs=[outp],
-        )
-
-        opset_version = 13
-        opset_imports = [helper.make_opsetid("", opset_version)]
-        onnx_kwargs = {"opset_imports": opset_imports}
-        model_resize = qonnx_make_model(graph_resize, **onnx_kwargs)
-        idict = {node.input[0]: inp_values, "scales": scales_val}
-        sess = rt.InferenceSession(model_resize.SerializeToString())
-        result = sess.run(None, idict)
+        result = upsample_nearest_nhwc(inp_values, scales_val)
         context[node.output[0]] = np.asarray(result, dtype=np.float32).reshape(oshape)
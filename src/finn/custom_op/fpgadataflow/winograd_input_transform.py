@@ -0,0 +1,166 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import warnings
+from math import ceil
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.winograd import input_transform
+
+# ONNX i/o tensor shape assumptions for WinogradInputTransform:
+# input 0 is the (already padded) input feature map, shape (1, H, W, NumChannels)
+# output 0 is the transformed tiles, shape (1, (H-2)/2, (W-2)/2, 16, NumChannels)
+
+
+class WinogradInputTransform(HWCustomOp):
+    """Abstraction layer for HW implementation of the Winograd F(2x2, 3x3)
+    input transform. Replaces the sliding window generator of a 3x3, stride-1
+    convolution: every 4x4 input tile (overlapping by 2 pixels) is transformed
+    into 16 values per channel."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            # parallelization; channels transformed per cycle
+            "SIMD": ("i", True, 0),
+            "NumChannels": ("i", True, 0),
+            # [H, W] of the (already padded) input feature map
+            "IFMDim": ("ints", True, []),
+            # FINN DataTypes for inputs, outputs
+            "inputDataType": ("s", True, ""),
+            "outputDataType": ("s", True, ""),
+        }
+        my_attrs.update(super().get_nodeattr_types())
+        return my_attrs
+
+    def get_tiles(self):
+        """Returns the number of tiles along H and W."""
+        ifm_h, ifm_w = self.get_nodeattr("IFMDim")
+        return ((ifm_h - 2) // 2, (ifm_w - 2) // 2)
+
+    def get_normal_input_shape(self, ind=0):
+        ifm_h, ifm_w = self.get_nodeattr("IFMDim")
+        return (1, ifm_h, ifm_w, self.get_nodeattr("NumChannels"))
+
+    def get_folded_input_shape(self, ind=0):
+        ifm_h, ifm_w = self.get_nodeattr("IFMDim")
+        ch = self.get_nodeattr("NumChannels")
+        simd = self.get_nodeattr("SIMD")
+        assert ch % simd == 0, "SIMD must divide NumChannels"
+        return (1, ifm_h, ifm_w, ch // simd, simd)
+
+    def get_normal_output_shape(self, ind=0):
+        th, tw = self.get_tiles()
+        return (1, th, tw, 16, self.get_nodeattr("NumChannels"))
+
+    def get_folded_output_shape(self, ind=0):
+        th, tw = self.get_tiles()
+        ch = self.get_nodeattr("NumChannels")
+        simd = self.get_nodeattr("SIMD")
+        return (1, th, tw, 16, ch // simd, simd)
+
+    def make_shape_compatible_op(self, model):
+        exp_ishape = self.get_normal_input_shape()
+        ishape = tuple(model.get_tensor_shape(self.onnx_node.input[0]))
+        assert ishape == exp_ishape, "Unexpected input shape for WinogradInputTransform."
+        return super().make_const_shape_op(self.get_normal_output_shape())
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype()),
+                str(idt),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        info_messages = []
+        ifm_h, ifm_w = self.get_nodeattr("IFMDim")
+        if ifm_h % 2 == 0 and ifm_w % 2 == 0 and ifm_h >= 4 and ifm_w >= 4:
+            info_messages.append("Input dimensions are valid for F(2x2, 3x3) tiling")
+        else:
+            info_messages.append("IFMDim must be even and at least 4 in both dimensions")
+        return info_messages
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("outputDataType")]
+
+    def get_instream_width(self, ind=0):
+        return self.get_nodeattr("SIMD") * self.get_input_datatype().bitwidth()
+
+    def get_outstream_width(self, ind=0):
+        return self.get_nodeattr("SIMD") * self.get_output_datatype().bitwidth()
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_exp_cycles(self):
+        # every input word is read once, then 16 words are produced per tile;
+        # the two phases do not overlap
+        return int(
+            np.prod(self.get_folded_input_shape()[:-1])
+            + np.prod(self.get_folded_output_shape()[:-1])
+        )
+
+    def bram_estimation(self):
+        """Estimates RAMB18s for the four-row line buffer."""
+        ifm_w = self.get_nodeattr("IFMDim")[1]
+        ch = self.get_nodeattr("NumChannels")
+        simd = self.get_nodeattr("SIMD")
+        width = simd * self.get_input_datatype().bitwidth()
+        depth = ifm_w * ch // simd
+        if depth <= 128:
+            return 0
+        return 4 * ceil(width / 18) * ceil(depth / 1024)
+
+    def lut_estimation(self):
+        """Estimates LUTs for the adders: every transformed value is the
+        sum of four inputs."""
+        simd = self.get_nodeattr("SIMD")
+        obits = self.get_output_datatype().bitwidth()
+        return int(300 + 3 * simd * obits)
+
+    def execute_node(self, context, graph):
+        node = self.onnx_node
+        inp = context[node.input[0]]
+        context[node.output[0]] = np.asarray(input_transform(inp), dtype=np.float32)
@@ -0,0 +1,233 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import math
+import numpy as np
+import warnings
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+
+# ONNX i/o tensor shape assumptions for WinogradMVAU:
+# input 0 is the transformed input tiles, shape (1, TH, TW, 16, MW)
+# input 1 is the transformed weights, shape (16, MW, MH), with an initializer
+# output 0 is the products summed over MW, shape (1, TH, TW, 16, MH)
+
+
+class WinogradMVAU(HWCustomOp):
+    """Abstraction layer for HW implementation of the elementwise-product stage
+    of a Winograd F(2x2, 3x3) convolution. For every tile, each of the 16
+    transformed input vectors is multiplied with its own MW x MH matrix of
+    transformed weights, i.e. 16 independent matrix-vector products per tile,
+    folded by SIMD over MW and PE over MH like an MVAU."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            "SIMD": ("i", True, 0),
+            "PE": ("i", True, 0),
+            # input and output channels
+            "MW": ("i", True, 0),
+            "MH": ("i", True, 0),
+            # number of tiles [TH, TW]
+            "Tiles": ("ints", True, []),
+            "resType": ("s", False, "auto", {"auto", "lut", "dsp"}),
+            # FINN DataTypes for inputs, weights, outputs
+            "inputDataType": ("s", True, ""),
+            "weightDataType": ("s", True, ""),
+            "outputDataType": ("s", True, ""),
+        }
+        my_attrs.update(super().get_nodeattr_types())
+        return my_attrs
+
+    def calc_wmem(self):
+        """Calculates and returns WMEM, the number of weight words per PE."""
+        mw = self.get_nodeattr("MW")
+        mh = self.get_nodeattr("MH")
+        return 16 * mw * mh // (self.get_nodeattr("SIMD") * self.get_nodeattr("PE"))
+
+    def get_normal_input_shape(self, ind=0):
+        th, tw = self.get_nodeattr("Tiles")
+        return (1, th, tw, 16, self.get_nodeattr("MW"))
+
+    def get_folded_input_shape(self, ind=0):
+        th, tw = self.get_nodeattr("Tiles")
+        mw = self.get_nodeattr("MW")
+        simd = self.get_nodeattr("SIMD")
+        assert mw % simd == 0, "SIMD must divide MW"
+        return (1, th, tw, 16, mw // simd, simd)
+
+    def get_normal_output_shape(self, ind=0):
+        th, tw = self.get_nodeattr("Tiles")
+        return (1, th, tw, 16, self.get_nodeattr("MH"))
+
+    def get_folded_output_shape(self, ind=0):
+        th, tw = self.get_nodeattr("Tiles")
+        mh = self.get_nodeattr("MH")
+        pe = self.get_nodeattr("PE")
+        assert mh % pe == 0, "PE must divide MH"
+        return (1, th, tw, 16, mh // pe, pe)
+
+    def make_shape_compatible_op(self, model):
+        exp_ishape = self.get_normal_input_shape()
+        ishape = tuple(model.get_tensor_shape(self.onnx_node.input[0]))
+        assert ishape == exp_ishape, "Unexpected input shape for WinogradMVAU."
+        return super().make_const_shape_op(self.get_normal_output_shape())
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype()),
+                str(idt),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        info_messages = []
+        for dt in [self.get_input_datatype(), self.get_weight_datatype()]:
+            if dt.is_integer() and dt != DataType["BIPOLAR"]:
+                info_messages.append("%s is supported" % str(dt))
+            else:
+                info_messages.append("WinogradMVAU needs non-bipolar integer operands")
+        return info_messages
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_weight_datatype(self):
+        """Returns FINN DataType of weights."""
+        return DataType[self.get_nodeattr("weightDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("outputDataType")]
+
+    def get_instream_width(self, ind=0):
+        return self.get_nodeattr("SIMD") * self.get_input_datatype().bitwidth()
+
+    def get_outstream_width(self, ind=0):
+        return self.get_nodeattr("PE") * self.get_output_datatype().bitwidth()
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_exp_cycles(self):
+        th, tw = self.get_nodeattr("Tiles")
+        mw = self.get_nodeattr("MW")
+        mh = self.get_nodeattr("MH")
+        sf = mw // self.get_nodeattr("SIMD")
+        nf = mh // self.get_nodeattr("PE")
+        return int(th * tw * 16 * sf * nf)
+
+    def bram_estimation(self):
+        """Estimates RAMB18s for the embedded weights, using the same
+        SDP-mode model as MVAU weight memories."""
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        W = self.get_weight_datatype().bitwidth()
+        omega = self.calc_wmem()
+        mem_width = Q * W * P
+        if omega <= 128:
+            return 0
+        if mem_width == 1:
+            return math.ceil(omega / 16384)
+        elif mem_width == 2:
+            return math.ceil(omega / 8192)
+        elif mem_width <= 4:
+            return (math.ceil(omega / 4096)) * (math.ceil(mem_width / 4))
+        elif mem_width <= 9:
+            return (math.ceil(omega / 2048)) * (math.ceil(mem_width / 9))
+        elif mem_width <= 18 or omega > 512:
+            return (math.ceil(omega / 1024)) * (math.ceil(mem_width / 18))
+        else:
+            return (math.ceil(omega / 512)) * (math.ceil(mem_width / 36))
+
+    def bram_efficiency_estimation(self):
+        bram16_est = self.bram_estimation()
+        if bram16_est == 0:
+            return 1
+        wbits = 16 * self.get_weight_datatype().bitwidth() * self.get_nodeattr("MW")
+        wbits *= self.get_nodeattr("MH")
+        return wbits / (bram16_est * 36 * 512)
+
+    def lut_estimation(self):
+        """Estimates LUTs following the MVAU model."""
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        A = self.get_input_datatype().bitwidth()
+        W = self.get_weight_datatype().bitwidth()
+        acc_bits = self.get_output_datatype().bitwidth()
+        c0 = 300
+        c1 = 1.1
+        c2 = 0
+        if self.calc_wmem() <= 128:
+            c2 = (P * Q * W) * math.ceil(self.calc_wmem() / 64)
+        if self.get_nodeattr("resType") == "dsp":
+            mult_luts = 0
+        else:
+            mult_luts = Q * (2 * math.ceil((W + A) / 6) - 1) * (W + A)
+        addertree_luts = (W + A) * (2 * Q - 1)
+        return int(c0 + c1 * (P * (mult_luts + addertree_luts + acc_bits)) + c2)
+
+    def dsp_estimation(self, fpgapart):
+        P = self.get_nodeattr("PE")
+        Q = self.get_nodeattr("SIMD")
+        A = self.get_input_datatype().bitwidth()
+        W = self.get_weight_datatype().bitwidth()
+        if self.get_nodeattr("resType") == "dsp":
+            return int(P * Q * np.ceil((W + A) / 48))
+        return 0
+
+    def get_op_and_param_counts(self):
+        th, tw = self.get_nodeattr("Tiles")
+        mw = self.get_nodeattr("MW")
+        mh = self.get_nodeattr("MH")
+        wbits = self.get_weight_datatype().bitwidth()
+        ibits = self.get_input_datatype().bitwidth()
+        # cannonicalize op type: highest bitwidth operand first
+        mac_op_type = "op_mac_%dbx%db" % (min(ibits, wbits), max(ibits, wbits))
+        return {
+            mac_op_type: th * tw * 16 * mw * mh,
+            "param_weight_%db" % wbits: 16 * mw * mh,
+        }
+
+    def execute_node(self, context, graph):
+        node = self.onnx_node
+        inp = context[node.input[0]]
+        w = context[node.input[1]]
+        result = np.einsum("nhwxc,xck->nhwxk", inp, w)
+        context[node.output[0]] = np.asarray(result, dtype=np.float32)
@@ -0,0 +1,159 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import warnings
+from qonnx.core.datatype import DataType
+
+from finn.custom_op.fpgadataflow.hwcustomop import HWCustomOp
+from finn.util.winograd import output_transform
+
+# ONNX i/o tensor shape assumptions for WinogradOutputTransform:
+# input 0 is the products per tile, shape (1, OH/2, OW/2, 16, NumChannels)
+# output 0 is the convolution output, shape (1, OH, OW, NumChannels)
+
+
+class WinogradOutputTransform(HWCustomOp):
+    """Abstraction layer for HW implementation of the Winograd F(2x2, 3x3)
+    output transform. Turns the 16 channel-summed products of every tile into
+    the 2x2 convolution outputs it covers, undoes the scaling of the
+    transformed weights and emits the outputs in raster order."""
+
+    def __init__(self, onnx_node, **kwargs):
+        super().__init__(onnx_node, **kwargs)
+
+    def get_nodeattr_types(self):
+        my_attrs = {
+            # parallelization; channels transformed per cycle
+            "PE": ("i", True, 0),
+            "NumChannels": ("i", True, 0),
+            # [H, W] of the output feature map, both even
+            "OFMDim": ("ints", True, []),
+            # FINN DataTypes for inputs, outputs
+            "inputDataType": ("s", True, ""),
+            "outputDataType": ("s", True, ""),
+        }
+        my_attrs.update(super().get_nodeattr_types())
+        return my_attrs
+
+    def get_tiles(self):
+        """Returns the number of tiles along H and W."""
+        ofm_h, ofm_w = self.get_nodeattr("OFMDim")
+        return (ofm_h // 2, ofm_w // 2)
+
+    def get_normal_input_shape(self, ind=0):
+        th, tw = self.get_tiles()
+        return (1, th, tw, 16, self.get_nodeattr("NumChannels"))
+
+    def get_folded_input_shape(self, ind=0):
+        th, tw = self.get_tiles()
+        ch = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        assert ch % pe == 0, "PE must divide NumChannels"
+        return (1, th, tw, 16, ch // pe, pe)
+
+    def get_normal_output_shape(self, ind=0):
+        ofm_h, ofm_w = self.get_nodeattr("OFMDim")
+        return (1, ofm_h, ofm_w, self.get_nodeattr("NumChannels"))
+
+    def get_folded_output_shape(self, ind=0):
+        ofm_h, ofm_w = self.get_nodeattr("OFMDim")
+        ch = self.get_nodeattr("NumChannels")
+        pe = self.get_nodeattr("PE")
+        return (1, ofm_h, ofm_w, ch // pe, pe)
+
+    def make_shape_compatible_op(self, model):
+        exp_ishape = self.get_normal_input_shape()
+        ishape = tuple(model.get_tensor_shape(self.onnx_node.input[0]))
+        assert ishape == exp_ishape, "Unexpected input shape for WinogradOutputTransform."
+        return super().make_const_shape_op(self.get_normal_output_shape())
+
+    def infer_node_datatype(self, model):
+        node = self.onnx_node
+        idt = model.get_tensor_datatype(node.input[0])
+        if idt != self.get_input_datatype():
+            warn_str = "inputDataType changing for %s: %s -> %s " % (
+                node.name,
+                str(self.get_input_datatype()),
+                str(idt),
+            )
+            warnings.warn(warn_str)
+        self.set_nodeattr("inputDataType", idt.name)
+        model.set_tensor_datatype(node.output[0], self.get_output_datatype())
+
+    def verify_node(self):
+        info_messages = []
+        ofm_h, ofm_w = self.get_nodeattr("OFMDim")
+        if ofm_h % 2 == 0 and ofm_w % 2 == 0:
+            info_messages.append("Output dimensions are valid for F(2x2, 3x3) tiling")
+        else:
+            info_messages.append("OFMDim must be even in both dimensions")
+        return info_messages
+
+    def get_input_datatype(self, ind=0):
+        """Returns FINN DataType of input."""
+        return DataType[self.get_nodeattr("inputDataType")]
+
+    def get_output_datatype(self, ind=0):
+        """Returns FINN DataType of output."""
+        return DataType[self.get_nodeattr("outputDataType")]
+
+    def get_sum_datatype(self):
+        """Returns the DataType of the unscaled output transform sums, each
+        adding nine input values."""
+        idt = self.get_input_datatype()
+        return DataType.get_smallest_possible(9 * min(idt.min(), -idt.max() - 1))
+
+    def get_instream_width(self, ind=0):
+        return self.get_nodeattr("PE") * self.get_input_datatype().bitwidth()
+
+    def get_outstream_width(self, ind=0):
+        return self.get_nodeattr("PE") * self.get_output_datatype().bitwidth()
+
+    def get_number_output_values(self):
+        return np.prod(self.get_folded_output_shape()[:-1])
+
+    def get_exp_cycles(self):
+        # the products of every tile are consumed at one word per cycle, then
+        # each completed row of tiles is emitted as two output rows
+        return int(
+            np.prod(self.get_folded_input_shape()[:-1])
+            + np.prod(self.get_folded_output_shape()[:-1])
+        )
+
+    def lut_estimation(self):
+        """Estimates LUTs for the four accumulators per channel."""
+        pe = self.get_nodeattr("PE")
+        sbits = self.get_sum_datatype().bitwidth()
+        return int(300 + 4 * pe * sbits)
+
+    def execute_node(self, context, graph):
+        node = self.onnx_node
+        inp = context[node.input[0]]
+        context[node.output[0]] = np.asarray(output_transform(inp), dtype=np.float32)
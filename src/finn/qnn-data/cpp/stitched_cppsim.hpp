@@ -0,0 +1,73 @@
+/******************************************************************************
+* Copyright (c) 2024, Advanced Micro Devices, Inc.
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+*   list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+*   this list of conditions and the following disclaimer in the documentation
+*   and/or other materials provided with the distribution.
+*
+* * Neither the name of FINN nor the names of its
+*   contributors may be used to endorse or promote products derived from
+*   this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+#ifndef STITCHED_CPPSIM_HPP
+#define STITCHED_CPPSIM_HPP
+
+#include <ap_int.h>
+#include <hls_stream.h>
+#include <cstddef>
+
+
+/**
+ * Functional model of a FIFO or of any other pure pass-through stage
+ * (e.g. TLastMarker): forwards numWords words. Differing word types are
+ * truncated or zero-extended, which also adapts between padded and
+ * unpadded stream widths.
+ */
+template<typename TI, typename TO>
+void StreamPassThroughModel(hls::stream<TI> &in, hls::stream<TO> &out, size_t const  numWords) {
+	for(size_t  i = 0; i < numWords; i++) {
+		out.write(TO(in.read()));
+	}
+}
+
+/**
+ * Functional model of a data width converter: the bits of numInWords input
+ * words are re-emitted as output words, least significant bits first.
+ */
+template<unsigned InWidth, unsigned OutWidth>
+void StreamDwcModel(
+	hls::stream<ap_uint<InWidth>> &in, hls::stream<ap_uint<OutWidth>> &out,
+	size_t const  numInWords
+) {
+	ap_uint<InWidth + OutWidth>  buf = 0;
+	unsigned  fill = 0;
+	for(size_t  i = 0; i < numInWords; i++) {
+		buf |= ap_uint<InWidth + OutWidth>(in.read()) << fill;
+		fill += InWidth;
+		while(fill >= OutWidth) {
+			out.write(ap_uint<OutWidth>(buf(OutWidth-1, 0)));
+			buf >>= OutWidth;
+			fill -= OutWidth;
+		}
+	}
+}
+
+#endif
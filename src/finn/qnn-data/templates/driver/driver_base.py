@@ -29,7 +29,7 @@
 import numpy as np
 import os
 import time
-from pynq import Overlay, allocate
+from pynq import MMIO, Overlay, allocate
 from pynq.ps import Clocks
 from qonnx.core.datatype import DataType
 from qonnx.util.basic import gen_finn_dt_tensor
@@ -88,6 +88,7 @@ class FINNExampleOverlay(Overlay):
         self.idma = []
         self.odma = []
         self.odma_handle = []
+        self.tap_buffers = {}
         if "input_dma_name" in io_shape_dict.keys():
             for idma_name in io_shape_dict["input_dma_name"]:
                 self.idma.append(getattr(self, idma_name))
@@ -110,6 +111,17 @@ class FINNExampleOverlay(Overlay):
         self.load_external_weights()
         self.load_runtime_weights()
 
+    def _dma_mem_target(self, dma_name):
+        """Returns where to allocate buffers for the given DMA: the memory bank
+        its AXI-MM port was connected to at link time on Alveo, otherwise the
+        device."""
+        mem_bank = self._io_shape_dict.get("dma_mem_bank", {})
+        if self.platform != "alveo" or dma_name not in mem_bank:
+            return self.device
+        # PYNQ exposes memory banks by their tag without brackets, e.g. HBM3
+        bank_name = mem_bank[dma_name].replace("[", "").replace("]", "")
+        return getattr(self, bank_name, self.device)
+
     def load_external_weights(self):
         """Load any existing external (DRAM) weights from the specified dir into the
         appropriate layer of the accelerator. Note that this must be enabled
@@ -140,7 +152,9 @@ class FINNExampleOverlay(Overlay):
             if idma_name in self.ip_dict.keys():
                 iwdma = getattr(self, idma_name)
                 weight_tensor = tmp_weight_dict[idma_name]
-                weight_buf = allocate(weight_tensor.shape, dtype=np.uint8)
+                weight_buf = allocate(
+                    weight_tensor.shape, dtype=np.uint8, target=self._dma_mem_target(idma_name)
+                )
                 weight_buf[:] = weight_tensor
                 # weight_buf.sync_to_device()
                 weight_buf.flush()
@@ -210,40 +224,130 @@ class FINNExampleOverlay(Overlay):
             # run accelerator to flush any stale weights from weight streamer FIFOs
             self.execute_on_buffers()
 
+    def _hook(self, name):
+        """Returns the register interface and the description of the named
+        hook layer."""
+        hook = self._io_shape_dict["hooks"][name]
+        # partitions with several AXI lite interfaces expose them separately
+        for ip_name in ["%s/%s" % (hook["ip"], hook["axilite"]), hook["ip"]]:
+            if ip_name in self.ip_dict.keys():
+                ip = self.ip_dict[ip_name]
+                return MMIO(ip["phys_addr"], ip["addr_range"]), hook
+        raise KeyError("No AXI lite interface found for hook %s" % name)
+
+    def read_checksum(self, name):
+        """Read the checksum of the last frame passing the named checksum
+        hook: an 8-bit frame counter followed by the 24-bit frame checksum."""
+        mmio, hook = self._hook(name)
+        return mmio.read(hook["regs"]["chk"])
+
+    def read_hooks(self):
+        """Read back all hook layers of the accelerator. Returns a dictionary
+        from hook name to its checksum or, for started taps, to the result
+        of read_tap."""
+        ret = {}
+        for name, hook in self._io_shape_dict.get("hooks", {}).items():
+            if hook["hook"] == "checksum":
+                ret[name] = self.read_checksum(name)
+            elif hook["hook"] == "tap" and name in self.tap_buffers:
+                ret[name] = self.read_tap(name)
+        return ret
+
+    def start_tap(self, name, period=1):
+        """Start capturing every period-th frame passing the named tap into its
+        ring buffer in DRAM, which is allocated on first use. With a period of
+        0, frames are only captured by trigger_tap."""
+        mmio, tap = self._hook(name)
+        regs = tap["regs"]
+        if name not in self.tap_buffers:
+            words = int(np.prod(tap["folded_shape"][:-1]))
+            buf = allocate(
+                shape=(tap["slots"] * words, tap["mem_width"] // 8),
+                dtype=np.uint8,
+                target=self.device,
+            )
+            addr = buf.device_address
+            mmio.write(regs["mem"], addr & 0xFFFFFFFF)
+            mmio.write(regs["mem"] + 4, (addr >> 32) & 0xFFFFFFFF)
+            mmio.write(regs["slots"], tap["slots"])
+            self.tap_buffers[name] = buf
+        mmio.write(regs["period"], period)
+
+    def stop_tap(self, name):
+        """Stop periodic captures at the named tap."""
+        mmio, tap = self._hook(name)
+        mmio.write(tap["regs"]["period"], 0)
+
+    def trigger_tap(self, name):
+        """Capture the next frame passing the named tap."""
+        mmio, tap = self._hook(name)
+        trigger = mmio.read(tap["regs"]["trigger"])
+        mmio.write(tap["regs"]["trigger"], (trigger + 1) & 0xFFFFFFFF)
+
+    def read_tap(self, name):
+        """Read back the frames captured at the named tap, oldest first, in
+        the normal shape of the tapped tensor. Returns the captures and the
+        number of selected frames that were dropped since the capture queue
+        was full. The oldest slot of the ring buffer may already be
+        overwritten by a capture in progress and is not returned."""
+        mmio, tap = self._hook(name)
+        assert name in self.tap_buffers, "Call start_tap before read_tap"
+        regs = tap["regs"]
+        slots = tap["slots"]
+        count = mmio.read(regs["count"])
+        dropped = mmio.read(regs["dropped"])
+        n_captures = min(count, slots - 1)
+        normal_shape = tuple(tap["normal_shape"])
+        if n_captures == 0:
+            return np.zeros((0,) + normal_shape, dtype=np.float32), dropped
+        buf = self.tap_buffers[name]
+        buf.invalidate()
+        folded_shape = tuple(tap["folded_shape"])
+        packed = np.asarray(buf).reshape((slots,) + folded_shape[:-1] + (tap["mem_width"] // 8,))
+        order = [(count - n_captures + i) % slots for i in range(n_captures)]
+        captures = packed_bytearray_to_finnpy(
+            packed[order],
+            DataType[tap["dtype"]],
+            (n_captures,) + folded_shape,
+            reverse_endian=True,
+            reverse_inner=True,
+        )
+        return captures.reshape((n_captures,) + normal_shape), dropped
+
     def idt(self, ind=0):
         return self._io_shape_dict["idt"][ind]
 
     def odt(self, ind=0):
         return self._io_shape_dict["odt"][ind]
 
-    def ishape_normal(self, ind=0):
+    def ishape_normal(self, ind=0, batch_size=None):
         ret = list(self._io_shape_dict["ishape_normal"][ind])
-        ret[0] = self.batch_size
+        ret[0] = self.batch_size if batch_size is None else batch_size
         return tuple(ret)
 
-    def oshape_normal(self, ind=0):
+    def oshape_normal(self, ind=0, batch_size=None):
         ret = list(self._io_shape_dict["oshape_normal"][ind])
-        ret[0] = self.batch_size
+        ret[0] = self.batch_size if batch_size is None else batch_size
         return tuple(ret)
 
-    def ishape_folded(self, ind=0):
+    def ishape_folded(self, ind=0, batch_size=None):
         ret = list(self._io_shape_dict["ishape_folded"][ind])
-        ret[0] = self.batch_size
+        ret[0] = self.batch_size if batch_size is None else batch_size
         return tuple(ret)
 
-    def oshape_folded(self, ind=0):
+    def oshape_folded(self, ind=0, batch_size=None):
         ret = list(self._io_shape_dict["oshape_folded"][ind])
-        ret[0] = self.batch_size
+        ret[0] = self.batch_size if batch_size is None else batch_size
         return tuple(ret)
 
-    def ishape_packed(self, ind=0):
+    def ishape_packed(self, ind=0, batch_size=None):
         ret = list(self._io_shape_dict["ishape_packed"][ind])
-        ret[0] = self.batch_size
+        ret[0] = self.batch_size if batch_size is None else batch_size
         return tuple(ret)
 
-    def oshape_packed(self, ind=0):
+    def oshape_packed(self, ind=0, batch_size=None):
         ret = list(self._io_shape_dict["oshape_packed"][ind])
-        ret[0] = self.batch_size
+        ret[0] = self.batch_size if batch_size is None else batch_size
         return tuple(ret)
 
     @property
@@ -260,6 +364,7 @@ class FINNExampleOverlay(Overlay):
 
     @batch_size.setter
     def batch_size(self, value):
+        self._check_batch_size(value)
         self._batch_size = value
         # free the old buffers by setting to None
         # (reference counting should care of it)
@@ -267,30 +372,57 @@ class FINNExampleOverlay(Overlay):
             self.ibuf_packed_device = None
         if self.obuf_packed_device is not None:
             self.obuf_packed_device = None
+        self._pipeline_buffers = None
+        self.ibuf_packed_device, self.obuf_packed_device = self._allocate_buffers()
+        self.obuf_packed = [np.empty_like(x) for x in self.obuf_packed_device]
+
+    @property
+    def batch_multiple(self):
+        """Number of samples every batch must be a multiple of, the weightReuse
+        of batch-tiled layers, which wait for complete groups of frames."""
+        return self._io_shape_dict.get("batch_multiple", 1)
+
+    def _check_batch_size(self, batch_size):
+        assert batch_size % self.batch_multiple == 0, (
+            "Batch size %d is not a multiple of %d, the accelerator would wait for "
+            "the rest of the batch forever" % (batch_size, self.batch_multiple)
+        )
+
+    def _allocate_buffers(self):
+        """Allocates one set of packed input and output device buffers for the
+        current batch size."""
         cacheable = {"alveo": False, "zynq-iodma": True}[self.platform]
-        self.ibuf_packed_device = []
-        self.obuf_packed_device = []
-        self.obuf_packed = []
+        idma_names = self._io_shape_dict.get("input_dma_name", ["idma0"])
+        odma_names = self._io_shape_dict.get("output_dma_name", ["odma0"])
+        ibufs = []
+        obufs = []
         for i in range(self.num_inputs):
             new_packed_ibuf = allocate(
-                shape=self.ishape_packed(i), dtype=np.uint8, cacheable=cacheable, target=self.device
+                shape=self.ishape_packed(i),
+                dtype=np.uint8,
+                cacheable=cacheable,
+                target=self._dma_mem_target(idma_names[i]),
             )
-            self.ibuf_packed_device.append(new_packed_ibuf)
+            ibufs.append(new_packed_ibuf)
         for o in range(self.num_outputs):
             new_packed_obuf = allocate(
-                shape=self.oshape_packed(o), dtype=np.uint8, cacheable=cacheable, target=self.device
+                shape=self.oshape_packed(o),
+                dtype=np.uint8,
+                cacheable=cacheable,
+                target=self._dma_mem_target(odma_names[o]),
             )
-            self.obuf_packed_device.append(new_packed_obuf)
-            self.obuf_packed.append(np.empty_like(new_packed_obuf))
+            obufs.append(new_packed_obuf)
+        return ibufs, obufs
 
-    def fold_input(self, ibuf_normal, ind=0):
+    def fold_input(self, ibuf_normal, ind=0, batch_size=None):
         """Reshapes input in desired shape.
         Gets input data (ibuf_normal), checks if data is in expected normal shape.
-        Returns folded input."""
+        Returns folded input. The optional batch_size parameter can be used for
+        batches smaller than ``self.batch_size``."""
         # ensure that shape is as expected
-        assert ibuf_normal.shape == self.ishape_normal(ind)
+        assert ibuf_normal.shape == self.ishape_normal(ind, batch_size)
         # convert to folded form
-        ibuf_folded = ibuf_normal.reshape(self.ishape_folded(ind))
+        ibuf_folded = ibuf_normal.reshape(self.ishape_folded(ind, batch_size))
         return ibuf_folded
 
     def pack_input(self, ibuf_folded, ind=0):
@@ -305,34 +437,40 @@ class FINNExampleOverlay(Overlay):
         )
         return ibuf_packed
 
-    def unpack_output(self, obuf_packed, ind=0):
+    def unpack_output(self, obuf_packed, ind=0, batch_size=None):
         """Unpacks the packed output buffer from accelerator.
-        Gets packed output and returns output data in folded shape."""
+        Gets packed output and returns output data in folded shape. The optional
+        batch_size parameter can be used for batches smaller than
+        ``self.batch_size``."""
         obuf_folded = packed_bytearray_to_finnpy(
             obuf_packed,
             self.odt(ind),
-            self.oshape_folded(ind),
+            self.oshape_folded(ind, batch_size),
             reverse_endian=True,
             reverse_inner=True,
             fast_mode=True,
         )
         return obuf_folded
 
-    def unfold_output(self, obuf_folded, ind=0):
+    def unfold_output(self, obuf_folded, ind=0, batch_size=None):
         """Unfolds output data to normal shape.
-        Gets folded output data and returns output data in normal shape."""
-        obuf_normal = obuf_folded.reshape(self.oshape_normal(ind))
+        Gets folded output data and returns output data in normal shape. The
+        optional batch_size parameter can be used for batches smaller than
+        ``self.batch_size``."""
+        obuf_normal = obuf_folded.reshape(self.oshape_normal(ind, batch_size))
         return obuf_normal
 
     def copy_input_data_to_device(self, data, ind=0):
-        """Copies given input data to PYNQ buffer."""
-        np.copyto(self.ibuf_packed_device[ind], data)
+        """Copies given input data to PYNQ buffer. Data for a smaller batch
+        fills the first samples of the buffer."""
+        np.copyto(self.ibuf_packed_device[ind][: data.shape[0]], data)
         self.ibuf_packed_device[ind].flush()
 
     def copy_output_data_from_device(self, data, ind=0):
-        """Copies PYNQ output buffer from device."""
+        """Copies PYNQ output buffer from device. A smaller data array receives
+        the first samples of the buffer."""
         self.obuf_packed_device[ind].invalidate()
-        np.copyto(data, self.obuf_packed_device[ind])
+        np.copyto(data, self.obuf_packed_device[ind][: data.shape[0]])
 
     def execute_on_buffers(self, asynch=False, batch_size=None):
         """Executes accelerator by setting up the DMA(s) on pre-allocated buffers.
@@ -347,6 +485,7 @@ class FINNExampleOverlay(Overlay):
         if batch_size is None:
             batch_size = self.batch_size
         assert batch_size <= self.batch_size, "Specified batch_size is too large."
+        self._check_batch_size(batch_size)
         if self.platform == "zynq-iodma":
             for o in range(self.num_outputs):
                 assert self.odma[o].read(0x00) & 0x4 != 0, "Output DMA %d is not idle" % (o)
@@ -394,6 +533,117 @@ class FINNExampleOverlay(Overlay):
         else:
             raise Exception("Unrecognized platform: %s" % self.platform)
 
+    def execute_pipelined(self, packed_batches):
+        """Executes the accelerator on an iterable of packed input batches with
+        double-buffered device buffers and yields the packed outputs of each
+        batch in order. Each batch is a packed input array (or a list of them
+        for multiple inputs) with at most ``self.batch_size`` samples. A final
+        partial batch is padded up to a multiple of ``self.batch_multiple``.
+
+        A producer thread pulls batch i+1 from the iterable and copies it into
+        the idle buffer set while batch i runs on the accelerator, and the
+        outputs of batch i-1 are handed to the caller in the meantime. Time
+        spent in each stage is recorded in ``self.pipeline_stats``.
+        """
+        import queue
+        import threading
+
+        if self._pipeline_buffers is None:
+            self._pipeline_buffers = [
+                (self.ibuf_packed_device, self.obuf_packed_device),
+                self._allocate_buffers(),
+            ]
+        stats = {
+            "copy_input[s]": 0.0,
+            "wait_accel[s]": 0.0,
+            "copy_output[s]": 0.0,
+            "consumer[s]": 0.0,
+            "batches": 0,
+            "samples": 0,
+        }
+        free_q = queue.Queue()
+        ready_q = queue.Queue()
+        for bset in self._pipeline_buffers:
+            free_q.put(bset)
+        stop = threading.Event()
+
+        def producer():
+            try:
+                for batch in packed_batches:
+                    if not type(batch) is list:
+                        batch = [batch]
+                    bset = free_q.get()
+                    if stop.is_set():
+                        return
+                    start = time.time()
+                    n = batch[0].shape[0]
+                    assert n <= self.batch_size, "Batch is larger than batch_size"
+                    for i in range(self.num_inputs):
+                        np.copyto(bset[0][i][:n], batch[i])
+                        bset[0][i].flush()
+                    stats["copy_input[s]"] += time.time() - start
+                    ready_q.put((bset, n))
+                ready_q.put(None)
+            except BaseException as e:
+                ready_q.put(e)
+
+        def drain(bset, n):
+            start = time.time()
+            outputs = []
+            for o in range(self.num_outputs):
+                bset[1][o].invalidate()
+                outputs.append(np.array(bset[1][o][:n]))
+            stats["copy_output[s]"] += time.time() - start
+            free_q.put(bset)
+            stats["batches"] += 1
+            stats["samples"] += n
+            return outputs if self.num_outputs > 1 else outputs[0]
+
+        default_bufs = (self.ibuf_packed_device, self.obuf_packed_device)
+        worker = threading.Thread(target=producer, daemon=True)
+        start_all = time.time()
+        worker.start()
+        prev = None
+        running = False
+        try:
+            while True:
+                item = ready_q.get()
+                if isinstance(item, BaseException):
+                    raise item
+                if item is not None:
+                    bset, n = item
+                    self.ibuf_packed_device, self.obuf_packed_device = bset
+                    # run a partial batch up to the next batch_multiple, the
+                    # outputs of the stale padding samples are dropped in drain
+                    n_run = -(-n // self.batch_multiple) * self.batch_multiple
+                    self.execute_on_buffers(asynch=True, batch_size=n_run)
+                    running = True
+                if prev is not None:
+                    # hand out batch i-1 while batch i runs
+                    outputs = drain(*prev)
+                    start = time.time()
+                    yield outputs
+                    stats["consumer[s]"] += time.time() - start
+                if item is None:
+                    break
+                start = time.time()
+                self.wait_until_finished()
+                running = False
+                stats["wait_accel[s]"] += time.time() - start
+                prev = item
+        finally:
+            if running:
+                self.wait_until_finished()
+            stop.set()
+            for bset in self._pipeline_buffers:
+                free_q.put(bset)
+            worker.join()
+            self.ibuf_packed_device, self.obuf_packed_device = default_bufs
+            runtime = time.time() - start_all
+            stats["runtime[s]"] = runtime
+            stats["throughput[images/s]"] = stats["samples"] / runtime if runtime > 0 else 0.0
+            self.pipeline_stats = stats
+
     def execute(self, input_npy):
         """Given a single or a list of input numpy array, first perform necessary
         packing and copying to device buffers, execute on accelerator, then unpack
@@ -489,3 +739,408 @@ class FINNExampleOverlay(Overlay):
         runtime = end - start
         res["unfold_output[ms]"] = runtime * 1000
         return res
+
+
+def device_pci_slot(device, index):
+    """Returns the PCIe slot (BDF) of the given Alveo device, or None if it
+    cannot be determined. XRT enumerates the user functions bound to the xocl
+    driver in BDF order, which is used as a fallback to map the device index."""
+    for attr in ["sysfs_path", "bdf"]:
+        val = getattr(device, attr, None)
+        if isinstance(val, str) and val != "":
+            return os.path.basename(val.rstrip("/"))
+    xocl_dir = "/sys/bus/pci/drivers/xocl"
+    if not os.path.isdir(xocl_dir):
+        return None
+    slots = sorted(x for x in os.listdir(xocl_dir) if x.count(":") == 2)
+    return slots[index] if index < len(slots) else None
+
+
+def pci_slot_numa_cpus(slot):
+    """Returns the set of CPUs on the NUMA node local to the given PCIe slot,
+    or None for non-NUMA systems."""
+    try:
+        with open("/sys/bus/pci/devices/%s/numa_node" % slot) as f:
+            node = int(f.read().strip())
+        if node < 0:
+            return None
+        with open("/sys/devices/system/node/node%d/cpulist" % node) as f:
+            cpulist = f.read().strip()
+    except (OSError, ValueError):
+        return None
+    cpus = set()
+    for rng in cpulist.split(","):
+        if rng == "":
+            continue
+        lo, _, hi = rng.partition("-")
+        cpus.update(range(int(lo), int(hi or lo) + 1))
+    return cpus
+
+
+class FINNMultiDeviceOverlay:
+    def __init__(
+        self,
+        bitfile_name,
+        platform,
+        io_shape_dict,
+        batch_size=1,
+        devices=None,
+        download=True,
+        runtime_weight_dir="runtime_weights/",
+        numa_aware=True,
+    ):
+        """Load the same FINN accelerator onto several Alveo cards and shard
+        batches across them.
+
+        Each card is driven by its own worker thread. With numa_aware, the
+        thread is pinned to the CPUs of the NUMA node local to the card before
+        the card's driver instance is created, so its host buffers are
+        allocated (and later packed into) on that node. Batches are split
+        proportionally to the throughput measured on each card for the
+        previous batches and outputs are gathered in the original order.
+
+        Parameters
+        ----------
+        bitfile_name: str
+            Path to accelerator .xclbin file
+        platform: str
+            FINN platform type, must be "alveo"
+        io_shape_dict: dict
+            Dictionary with particulars of the generated accelerator
+        batch_size: int
+            Maximum number of samples per accelerator call on each card, larger
+            shards are executed in several calls
+        devices: list
+            Indices into pynq.Device.devices of the cards to use, None for all.
+        download: bool
+            Whether to flash the bitstream.
+        runtime_weight_dir: str
+            Path to runtime weights folder.
+        numa_aware: bool
+            Whether to pin each card's worker to its local NUMA node.
+        """
+        from concurrent.futures import ThreadPoolExecutor
+        from pynq import Device
+
+        assert platform == "alveo", "Multi-device execution is only supported on Alveo"
+        if devices is None:
+            devices = list(range(len(Device.devices)))
+        assert len(devices) > 0, "No devices to run on"
+        self._io_shape_dict = io_shape_dict
+        self.platform = platform
+        self.devices = devices
+        self.cpus = []
+        self.workers = []
+        for dev_ind in devices:
+            cpus = None
+            if numa_aware and hasattr(os, "sched_setaffinity"):
+                slot = device_pci_slot(Device.devices[dev_ind], dev_ind)
+                cpus = pci_slot_numa_cpus(slot) if slot is not None else None
+            self.cpus.append(cpus)
+            self.workers.append(
+                ThreadPoolExecutor(
+                    max_workers=1,
+                    initializer=self._pin_worker,
+                    initargs=(cpus,),
+                )
+            )
+        # instantiate one driver per card from within its own worker thread
+        # (first-touch allocation on the local NUMA node)
+        futures = [
+            w.submit(
+                FINNExampleOverlay,
+                bitfile_name,
+                platform,
+                io_shape_dict,
+                batch_size=batch_size,
+                device=Device.devices[dev_ind],
+                download=download,
+                runtime_weight_dir=runtime_weight_dir,
+            )
+            for w, dev_ind in zip(self.workers, devices)
+        ]
+        self.accels = [f.result() for f in futures]
+        # measured throughput of each card in samples/s, start from equal shares
+        self.throughput = [1.0] * len(self.accels)
+        self.throughput_smoothing = 0.5
+
+    @staticmethod
+    def _pin_worker(cpus):
+        if cpus:
+            os.sched_setaffinity(0, cpus)
+
+    @property
+    def num_devices(self):
+        return len(self.accels)
+
+    @property
+    def num_inputs(self):
+        return self._io_shape_dict["num_inputs"]
+
+    @property
+    def num_outputs(self):
+        return self._io_shape_dict["num_outputs"]
+
+    @property
+    def batch_size(self):
+        return self.accels[0].batch_size
+
+    @property
+    def batch_multiple(self):
+        return self.accels[0].batch_multiple
+
+    def shard_sizes(self, n_samples):
+        """Splits n_samples across the cards proportionally to their measured
+        throughput, using the largest remainder for the leftover samples. Each
+        shard is a multiple of batch_multiple samples."""
+        m = self.batch_multiple
+        assert n_samples % m == 0, "Number of samples %d is not a multiple of %d" % (
+            n_samples,
+            m,
+        )
+        n_groups = n_samples // m
+        total = sum(self.throughput)
+        exact = [n_groups * t / total for t in self.throughput]
+        sizes = [int(x) for x in exact]
+        leftover = n_groups - sum(sizes)
+        order = sorted(range(len(exact)), key=lambda d: sizes[d] - exact[d])
+        for d in order[:leftover]:
+            sizes[d] += 1
+        return [x * m for x in sizes]
+
+    def _execute_shard(self, accel, inputs):
+        """Runs the given inputs (batch dimension first) on a single card in
+        calls of at most accel.batch_size samples and returns the outputs."""
+        n_samples = inputs[0].shape[0]
+        outputs = [[] for o in range(accel.num_outputs)]
+        for start in range(0, n_samples, accel.batch_size):
+            n = min(accel.batch_size, n_samples - start)
+            for i in range(accel.num_inputs):
+                ibuf_folded = accel.fold_input(inputs[i][start : start + n], ind=i, batch_size=n)
+                ibuf_packed = accel.pack_input(ibuf_folded, ind=i)
+                accel.copy_input_data_to_device(ibuf_packed, ind=i)
+            accel.execute_on_buffers(batch_size=n)
+            for o in range(accel.num_outputs):
+                obuf_packed = np.empty(accel.oshape_packed(o, n), dtype=np.uint8)
+                accel.copy_output_data_from_device(obuf_packed, ind=o)
+                obuf_folded = accel.unpack_output(obuf_packed, ind=o, batch_size=n)
+                outputs[o].append(accel.unfold_output(obuf_folded, ind=o, batch_size=n))
+        return [np.concatenate(x) for x in outputs]
+
+    def _timed_shard(self, accel, inputs):
+        start = time.time()
+        outputs = self._execute_shard(accel, inputs)
+        return outputs, time.time() - start
+
+    def execute(self, input_npy):
+        """Given a single or a list of input numpy arrays with any number of
+        samples in the batch dimension, shard them across the cards, execute
+        and return the outputs in the original sample order."""
+        if not type(input_npy) is list:
+            input_npy = [input_npy]
+        assert self.num_inputs == len(input_npy), "Not all accelerator inputs are specified."
+        n_samples = input_npy[0].shape[0]
+        sizes = self.shard_sizes(n_samples)
+        bounds = np.cumsum([0] + sizes)
+        futures = []
+        for d, (w, accel) in enumerate(zip(self.workers, self.accels)):
+            if sizes[d] == 0:
+                futures.append(None)
+                continue
+            shard = [x[bounds[d] : bounds[d + 1]] for x in input_npy]
+            futures.append(w.submit(self._timed_shard, accel, shard))
+        outputs = [[] for o in range(self.num_outputs)]
+        alpha = self.throughput_smoothing
+        for d, f in enumerate(futures):
+            if f is None:
+                continue
+            shard_outputs, runtime = f.result()
+            for o in range(self.num_outputs):
+                outputs[o].append(shard_outputs[o])
+            if runtime > 0:
+                rate = sizes[d] / runtime
+                self.throughput[d] = alpha * self.throughput[d] + (1 - alpha) * rate
+        outputs = [np.concatenate(x) for x in outputs]
+        if self.num_outputs == 1:
+            return outputs[0]
+        else:
+            return outputs
+
+    def throughput_test(self):
+        """Run all cards concurrently with empty inputs and report the aggregate
+        throughput alongside the per-card metrics of FINNExampleOverlay."""
+        res = {}
+        start = time.time()
+        futures = [
+            w.submit(accel.execute_on_buffers) for w, accel in zip(self.workers, self.accels)
+        ]
+        for f in futures:
+            f.result()
+        runtime = time.time() - start
+        res["runtime[ms]"] = runtime * 1000
+        res["throughput[images/s]"] = self.num_devices * self.batch_size / runtime
+        res["num_devices"] = self.num_devices
+        res["batch_size"] = self.batch_size
+        futures = [w.submit(accel.throughput_test) for w, accel in zip(self.workers, self.accels)]
+        for d, f in enumerate(futures):
+            dev_res = f.result()
+            self.throughput[d] = dev_res["throughput[images/s]"]
+            res["device%d" % self.devices[d]] = dev_res
+        return res
+
+
+class FINNHostPipeline:
+    def __init__(
+        self, accel, head_model="host_head.onnx", tail_model="host_tail.onnx", num_threads=0
+    ):
+        """Run the parts of the network outside the dataflow partition on the
+        host with onnxruntime, before (head) and after (tail) the accelerator.
+
+        Parameters
+        ----------
+        accel: FINNExampleOverlay
+            Driver of the accelerator running the dataflow partition
+        head_model: str
+            Path to the head ONNX model, skipped if the file does not exist
+        tail_model: str
+            Path to the tail ONNX model, skipped if the file does not exist
+        num_threads: int
+            Number of onnxruntime intra-op threads, 0 for its default
+        """
+        import onnxruntime as rt
+
+        self.accel = accel
+        opts = rt.SessionOptions()
+        opts.intra_op_num_threads = num_threads
+        self.head = None
+        self.tail = None
+        if head_model is not None and os.path.isfile(head_model):
+            self.head = rt.InferenceSession(head_model, sess_options=opts)
+        if tail_model is not None and os.path.isfile(tail_model):
+            self.tail = rt.InferenceSession(tail_model, sess_options=opts)
+        # sessions that only run with batch size 1, e.g. due to a Reshape
+        # with a constant batch dimension
+        self._per_sample = set()
+
+    def _run_session(self, sess, inputs):
+        """Runs the given onnxruntime session on a list of batched inputs and
+        returns the list of batched outputs."""
+        if sess is None:
+            return inputs
+        feed = {}
+        for inp, x in zip(sess.get_inputs(), inputs):
+            feed[inp.name] = x.astype(np.float32) if inp.type == "tensor(float)" else x
+        if sess not in self._per_sample:
+            try:
+                return sess.run(None, feed)
+            except Exception:
+                if inputs[0].shape[0] == 1:
+                    raise
+                self._per_sample.add(sess)
+        outputs = [
+            sess.run(None, {k: v[n : n + 1] for k, v in feed.items()})
+            for n in range(inputs[0].shape[0])
+        ]
+        return [np.concatenate(x) for x in zip(*outputs)]
+
+    def execute(self, input_npy):
+        """Given a single or a list of input numpy arrays for the full network,
+        run the head on the host, the dataflow partition on the accelerator and
+        the tail on the host, and return the output(s)."""
+        if not type(input_npy) is list:
+            input_npy = [input_npy]
+        accel_out = self.accel.execute(self._run_session(self.head, input_npy))
+        if not type(accel_out) is list:
+            accel_out = [accel_out]
+        outputs = self._run_session(self.tail, accel_out)
+        if len(outputs) == 1:
+            return outputs[0]
+        else:
+            return outputs
+
+    def execute_pipelined(self, batches):
+        """Executes the full network on an iterable of input batches (a numpy
+        array or a list of them for multiple inputs, with at most
+        accel.batch_size samples each) and yields the outputs of each batch in
+        order.
+
+        The head and input packing run in the producer thread of the
+        accelerator's execute_pipelined, and output unpacking and the tail run
+        while the next batch is on the accelerator, so the host parts overlap
+        with accelerator execution instead of adding to it. Time spent in each
+        stage is recorded in ``self.pipeline_stats``.
+        """
+        import queue
+        import threading
+
+        accel = self.accel
+        stats = {"head[s]": 0.0, "tail[s]": 0.0}
+
+        def prepare():
+            for batch in batches:
+                if not type(batch) is list:
+                    batch = [batch]
+                start = time.time()
+                accel_in = self._run_session(self.head, batch)
+                n = accel_in[0].shape[0]
+                packed = []
+                for i in range(accel.num_inputs):
+                    ibuf_folded = accel.fold_input(accel_in[i], ind=i, batch_size=n)
+                    packed.append(accel.pack_input(ibuf_folded, ind=i))
+                stats["head[s]"] += time.time() - start
+                yield packed
+
+        out_q = queue.Queue(maxsize=2)
+        stop = threading.Event()
+
+        def put(item):
+            while not stop.is_set():
+                try:
+                    out_q.put(item, timeout=0.1)
+                    return True
+                except queue.Full:
+                    pass
+            return False
+
+        def run():
+            accel_gen = accel.execute_pipelined(prepare())
+            try:
+                for obuf_packed in accel_gen:
+                    if not type(obuf_packed) is list:
+                        obuf_packed = [obuf_packed]
+                    start = time.time()
+                    n = obuf_packed[0].shape[0]
+                    accel_out = []
+                    for o in range(accel.num_outputs):
+                        obuf_folded = accel.unpack_output(obuf_packed[o], ind=o, batch_size=n)
+                        accel_out.append(accel.unfold_output(obuf_folded, ind=o, batch_size=n))
+                    outputs = self._run_session(self.tail, accel_out)
+                    stats["tail[s]"] += time.time() - start
+                    if not put(outputs[0] if len(outputs) == 1 else outputs):
+                        return
+                put(None)
+            except BaseException as e:
+                put(e)
+            finally:
+                accel_gen.close()
+
+        worker = threading.Thread(target=run, daemon=True)
+        start_all = time.time()
+        worker.start()
+        try:
+            while True:
+                item = out_q.get()
+                if isinstance(item, BaseException):
+                    raise item
+                if item is None:
+                    break
+                yield item
+        finally:
+            stop.set()
+            worker.join()
+            runtime = time.time() - start_all
+            stats.update(getattr(accel, "pipeline_stats", {}))
+            stats["runtime[s]"] = runtime
+            samples = stats.get("samples", 0)
+            stats["throughput[images/s]"] = samples / runtime if runtime > 0 else 0.0
+            self.pipeline_stats = stats
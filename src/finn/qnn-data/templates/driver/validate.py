@@ -28,9 +28,37 @@
 
 import argparse
 import numpy as np
+import os
 from driver import io_shape_dict
 from driver_base import FINNExampleOverlay
 
+
+def load_test_set_mmap(dataset, dataset_root):
+    """Returns the test images and labels of the given dataset as read-only
+    memory-mapped arrays. The test set is converted to .npy files in
+    dataset_root on first use, later runs map it without loading it."""
+    x_file = os.path.join(dataset_root, "%s_test_x.npy" % dataset)
+    y_file = os.path.join(dataset_root, "%s_test_y.npy" % dataset)
+    if not (os.path.isfile(x_file) and os.path.isfile(y_file)):
+        if dataset == "mnist":
+            from dataset_loading import mnist
+
+            trainx, trainy, testx, testy, valx, valy = mnist.load_mnist_data(
+                dataset_root, download=True, one_hot=False
+            )
+        elif dataset == "cifar10":
+            from dataset_loading import cifar
+
+            trainx, trainy, testx, testy, valx, valy = cifar.load_cifar_data(
+                dataset_root, download=True, one_hot=False
+            )
+        else:
+            raise Exception("Unrecognized dataset")
+        np.save(x_file, np.ascontiguousarray(testx))
+        np.save(y_file, np.ascontiguousarray(testy))
+    return np.load(x_file, mmap_mode="r"), np.load(y_file, mmap_mode="r")
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(
         description="Validate top-1 accuracy for FINN-generated accelerator"
@@ -56,23 +84,7 @@ if __name__ == "__main__":
     platform = args.platform
     dataset_root = args.dataset_root
 
-    if dataset == "mnist":
-        from dataset_loading import mnist
-
-        trainx, trainy, testx, testy, valx, valy = mnist.load_mnist_data(
-            dataset_root, download=True, one_hot=False
-        )
-    elif dataset == "cifar10":
-        from dataset_loading import cifar
-
-        trainx, trainy, testx, testy, valx, valy = cifar.load_cifar_data(
-            dataset_root, download=True, one_hot=False
-        )
-    else:
-        raise Exception("Unrecognized dataset")
-
-    test_imgs = testx
-    test_labels = testy
+    test_imgs, test_labels = load_test_set_mmap(dataset, dataset_root)
 
     ok = 0
     nok = 0
@@ -86,22 +98,28 @@ if __name__ == "__main__":
         runtime_weight_dir="runtime_weights/",
     )
 
-    n_batches = int(total / bsize)
+    n_batches = (total + bsize - 1) // bsize
+    packed_sample_shape = driver.ibuf_packed_device[0].shape[1:]
 
-    test_imgs = test_imgs.reshape(n_batches, bsize, -1)
-    test_labels = test_labels.reshape(n_batches, bsize)
+    def batches():
+        # slices of the memory-mapped test set, read by the producer thread
+        # when copied into the device buffer
+        for i in range(n_batches):
+            imgs = test_imgs[i * bsize : (i + 1) * bsize]
+            yield imgs.reshape((imgs.shape[0],) + packed_sample_shape)
 
-    for i in range(n_batches):
-        ibuf_normal = test_imgs[i].reshape(driver.ibuf_packed_device[0].shape)
-        exp = test_labels[i]
-        driver.copy_input_data_to_device(ibuf_normal)
-        driver.execute_on_buffers()
-        obuf_normal = np.empty_like(driver.obuf_packed_device[0])
-        driver.copy_output_data_from_device(obuf_normal)
-        ret = np.bincount(obuf_normal.flatten() == exp.flatten())
+    # batch i+1 is loaded and copied while batch i runs, and the outputs of
+    # batch i-1 are compared below in the meantime
+    for i, obuf_packed in enumerate(driver.execute_pipelined(batches())):
+        exp = test_labels[i * bsize : (i + 1) * bsize]
+        ret = np.bincount(obuf_packed.flatten() == exp.flatten(), minlength=2)
         nok += ret[0]
         ok += ret[1]
         print("batch %d / %d : total OK %d NOK %d" % (i + 1, n_batches, ok, nok))
 
     acc = 100.0 * ok / (total)
     print("Final accuracy: %f" % acc)
+    stats = driver.pipeline_stats
+    for stage in ["copy_input", "wait_accel", "copy_output", "consumer"]:
+        print("%s: %f s" % (stage, stats["%s[s]" % stage]))
+    print("End-to-end throughput: %f images/s" % stats["throughput[images/s]"])
@@ -0,0 +1,141 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import re
+import warnings
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.base import Transformation
+
+from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.util.platforms import platforms
+
+
+def get_hbm_platform(vitis_platform):
+    """Returns the FINN Platform matching the given Vitis platform name
+    (e.g. xilinx_u280_gen3x16_xdma_1_202211_1) if it has HBM, otherwise None."""
+    for name, platform_cls in platforms.items():
+        if name.lower() in vitis_platform.lower():
+            platform = platform_cls()
+            if platform.hbm_channels > 0:
+                return platform
+    return None
+
+
+def balance_hbm_channels(bandwidths, num_channels, load=None):
+    """Assigns streams with the given bandwidths to num_channels memory
+    channels. Streams are placed heaviest first, each on the currently
+    least-loaded channel, which spreads heavy streams over separate channels.
+    An initial per-channel load (e.g. from fixed assignments) can be given.
+
+    Returns (list of channel indices, list of per-channel loads)."""
+    load = [0.0] * num_channels if load is None else list(load)
+    assignment = [None] * len(bandwidths)
+    order = sorted(range(len(bandwidths)), key=lambda i: -bandwidths[i])
+    for i in order:
+        channel = min(range(num_channels), key=lambda c: load[c])
+        assignment[i] = channel
+        load[channel] += bandwidths[i]
+    return (assignment, load)
+
+
+def _iodma_bytes_per_sample(inst):
+    mode = inst.get_nodeattr("burstMode")
+    if mode == "increment":
+        return inst.get_exp_dram_bytes()
+    # external weight buffers are read once per frame, or once per group of
+    # prefetchFrames frames when replayed on chip
+    wbits = inst.get_input_datatype().bitwidth() * np.prod(inst.get_normal_input_shape())
+    frames = inst.get_nodeattr("prefetchFrames") if mode == "prefetch" else 1
+    return wbits / 8 / frames
+
+
+class AssignHBMChannels(Transformation):
+    """Bandwidth-aware placement of IODMA partitions onto HBM pseudo-channels.
+
+    The DRAM bandwidth each IODMA needs is derived from its bytes per sample and
+    the throughput given by the slowest layer of the design (cycle estimates from
+    the folding) at the kernel clock f_mhz. The partitions are then balanced over
+    the pseudo-channels of the platform with balance_hbm_channels, and the result
+    is stored in the mem_port attribute of each StreamingDataflowPartition, which
+    VitisLink uses for connectivity and MakePYNQDriver for buffer allocation.
+
+    Must be applied after CreateDataflowPartition. Partitions that already have a
+    mem_port are kept as they are, their load is accounted for. Does nothing for
+    platforms without HBM.
+    """
+
+    def __init__(self, platform, f_mhz=200):
+        super().__init__()
+        self.platform = platform
+        self.f_mhz = f_mhz
+
+    def apply(self, model):
+        hbm_platform = get_hbm_platform(self.platform)
+        if hbm_platform is None:
+            return (model, False)
+        num_channels = hbm_platform.hbm_channels
+        # the slowest layer sets the throughput of the whole design
+        max_cycles = 1
+        dma_partitions = []
+        for node in model.graph.node:
+            assert (
+                node.op_type == "StreamingDataflowPartition"
+            ), "CreateDataflowPartition needs to be applied before HBM channel assignment"
+            sdp_inst = getCustomOp(node)
+            kernel_model = ModelWrapper(sdp_inst.get_nodeattr("model"))
+            layer_cycles = kernel_model.analysis(exp_cycles_per_layer)
+            max_cycles = max([max_cycles] + list(layer_cycles.values()))
+            iodmas = kernel_model.get_nodes_by_op_type("IODMA_hls")
+            if len(iodmas) > 0:
+                dma_bytes = sum([_iodma_bytes_per_sample(getCustomOp(x)) for x in iodmas])
+                dma_partitions.append((sdp_inst, dma_bytes))
+
+        samples_per_sec = self.f_mhz * 10**6 / max_cycles
+        load = [0.0] * num_channels
+        to_assign = []
+        for sdp_inst, dma_bytes in dma_partitions:
+            gbytes = dma_bytes * samples_per_sec / 10**9
+            if gbytes > hbm_platform.hbm_channel_gbytes:
+                warnings.warn(
+                    "%s needs %.2f GB/s, more than one HBM pseudo-channel provides "
+                    "(%.2f GB/s), DRAM bandwidth will limit its throughput"
+                    % (sdp_inst.onnx_node.name, gbytes, hbm_platform.hbm_channel_gbytes)
+                )
+            fixed = re.fullmatch(r"HBM\[(\d+)\]", sdp_inst.get_nodeattr("mem_port"))
+            if fixed is not None:
+                load[int(fixed.group(1))] += gbytes
+            elif sdp_inst.get_nodeattr("mem_port") == "":
+                to_assign.append((sdp_inst, gbytes))
+
+        (assignment, load) = balance_hbm_channels([x[1] for x in to_assign], num_channels, load)
+        for (sdp_inst, _), channel in zip(to_assign, assignment):
+            sdp_inst.set_nodeattr("mem_port", "HBM[%d]" % channel)
+        return (model, False)
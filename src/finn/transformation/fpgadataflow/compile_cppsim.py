@@ -28,12 +28,14 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 import qonnx.custom_op.registry as registry
-from qonnx.transformation.base import NodeLocalTransformation
 
+from finn.transformation.fpgadataflow.scheduled_node_local import (
+    ScheduledNodeLocalTransformation,
+)
 from finn.util.fpgadataflow import is_hls_node
 
 
-class CompileCppSim(NodeLocalTransformation):
+class CompileCppSim(ScheduledNodeLocalTransformation):
     """For every node: compile C++ code in node attribute "code_gen_dir_cppsim"
     and save path to executables in node attribute "executable_path".
     All nodes in the graph must have the fpgadataflow backend attribute.
@@ -44,8 +46,14 @@ class CompileCppSim(NodeLocalTransformation):
 
     * num_workers (int or None) number of parallel workers, see documentation in
       NodeLocalTransformation for more details.
+
+    The per-node jobs are run longest first within the memory budget of the
+    build hosts, see ScheduledNodeLocalTransformation.
     """
 
+    job_kind = "cppsim"
+    default_job_mem = 2**30
+
     def __init__(self, num_workers=None):
         super().__init__(num_workers=num_workers)
 
@@ -27,17 +27,20 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+import copy
 import numpy as np
 import qonnx.core.data_layout as DataLayout
 import warnings
 from onnx import TensorProto, helper
 from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.core.onnx_exec import execute_onnx
 from qonnx.custom_op.registry import getCustomOp
 from qonnx.transformation.base import Transformation
 from qonnx.transformation.general import SortGraph
 from qonnx.transformation.infer_datatypes import InferDataTypes
 from qonnx.transformation.infer_shapes import InferShapes
-from qonnx.util.basic import get_by_name
+from qonnx.util.basic import get_by_name, qonnx_make_model
 from qonnx.util.onnx import nchw_to_nhwc
 
 
@@ -1136,6 +1139,239 @@ class InferLookupLayer(Transformation):
         return (model, graph_modified)
 
 
+class InferLookupActivation(Transformation):
+    """Convert elementwise subgraphs which map a low-precision integer tensor
+    to another integer tensor, e.g. a quantized GELU or SiLU of the form
+    MultiThreshold(f(x)), into LookupActivation HW layers. The lookup table is
+    obtained by executing the subgraph on every possible input value, so f does
+    not need to be monotonic. Only subgraphs with at most max_input_bits input
+    bits and per-channel (or scalar) parameters are converted. A lone
+    MultiThreshold is left to InferThresholdingLayer."""
+
+    # elementwise ops that may appear inside a converted subgraph
+    elementwise_ops = [
+        "Abs",
+        "Add",
+        "Ceil",
+        "Clip",
+        "Cos",
+        "Div",
+        "Elu",
+        "Erf",
+        "Exp",
+        "Floor",
+        "HardSigmoid",
+        "HardSwish",
+        "LeakyRelu",
+        "Log",
+        "Max",
+        "Min",
+        "Mul",
+        "Neg",
+        "Pow",
+        "Reciprocal",
+        "Relu",
+        "Round",
+        "Selu",
+        "Sigmoid",
+        "Sin",
+        "Softplus",
+        "Softsign",
+        "Sqrt",
+        "Sub",
+        "Tanh",
+    ]
+    # ops that terminate a converted subgraph if they produce an integer output
+    quantizer_ops = ["MultiThreshold", "Quant"]
+
+    def __init__(self, max_input_bits=8, max_nodes=32):
+        super().__init__()
+        self.max_input_bits = max_input_bits
+        self.max_nodes = max_nodes
+
+    def find_subgraph(self, model, start):
+        """Return the nodes (in graph order) and the integer output tensor of
+        the elementwise subgraph fed by tensor start, or None if there is no
+        suitable subgraph."""
+        graph_outputs = [x.name for x in model.graph.output]
+        nodes = []
+        terminals = []
+        to_visit = [start]
+        while len(to_visit) > 0:
+            tensor = to_visit.pop(0)
+            if tensor in graph_outputs:
+                return None
+            for consumer in model.find_consumers(tensor) or []:
+                if consumer in nodes:
+                    continue
+                if len(consumer.output) != 1 or len(nodes) == self.max_nodes:
+                    return None
+                odt = model.get_tensor_datatype(consumer.output[0])
+                if consumer.op_type in self.quantizer_ops and odt.is_integer():
+                    terminals.append(consumer.output[0])
+                elif consumer.op_type in self.elementwise_ops:
+                    to_visit.append(consumer.output[0])
+                else:
+                    return None
+                nodes.append(consumer)
+        if len(terminals) != 1 or len(nodes) < 2:
+            return None
+        # all dynamic inputs must come from within the subgraph
+        internal_tensors = [start] + [x.output[0] for x in nodes]
+        for node in nodes:
+            for inp in node.input:
+                if inp == "" or inp in internal_tensors:
+                    continue
+                if model.get_initializer(inp) is None:
+                    return None
+        node_list = list(model.graph.node)
+        nodes.sort(key=lambda x: node_list.index(x))
+        return (nodes, terminals[0])
+
+    def params_are_channelwise(self, model, nodes, ishape, ch_axis):
+        """Check that all parameters of the subgraph are either scalar or
+        per-channel, so that one table per channel suffices."""
+        n_ch = ishape[ch_axis]
+        for node in nodes:
+            for i, inp in enumerate(node.input):
+                param = model.get_initializer(inp)
+                if param is None:
+                    continue
+                pshape = list(param.shape)
+                if node.op_type == "MultiThreshold" and i == 1:
+                    # thresholds are given per channel in the first dimension
+                    if pshape[0] not in [1, n_ch]:
+                        return False
+                    continue
+                if len(pshape) > len(ishape):
+                    return False
+                pshape = [1] * (len(ishape) - len(pshape)) + pshape
+                for axis, dim in enumerate(pshape):
+                    if dim != 1 and axis != ch_axis:
+                        return False
+        return True
+
+    def compute_table(self, model, nodes, start, end, probe_shape, ch_axis):
+        """Execute the subgraph on all values of the input datatype and return
+        the resulting lookup table of shape (NumChannels or 1, 2^inputBits)."""
+        idt = model.get_tensor_datatype(start)
+        values = np.arange(idt.min(), idt.max() + 1, dtype=np.float32)
+        n_entries = len(values)
+        probe = values.reshape([n_entries] + [1] * (len(probe_shape) - 1))
+        probe = np.broadcast_to(probe, [n_entries] + list(probe_shape[1:])).copy()
+        inp = helper.make_tensor_value_info(start, TensorProto.FLOAT, probe.shape)
+        # all ops are elementwise, so the output has the same shape as the probe
+        outp = helper.make_tensor_value_info(end, TensorProto.FLOAT, probe.shape)
+        sub_graph = helper.make_graph(
+            nodes=[copy.deepcopy(x) for x in nodes],
+            name="lookup-table-exec",
+            inputs=[inp],
+            outputs=[outp],
+        )
+        sub_model = ModelWrapper(
+            qonnx_make_model(sub_graph, opset_imports=list(model.model.opset_import))
+        )
+        for node in nodes:
+            for tensor in list(node.input) + list(node.output):
+                param = model.get_initializer(tensor)
+                if param is not None:
+                    sub_model.set_initializer(tensor, param)
+                if tensor != "":
+                    sub_model.set_tensor_datatype(tensor, model.get_tensor_datatype(tensor))
+        sub_model = sub_model.transform(InferShapes())
+        result = execute_onnx(sub_model, {start: probe})[end]
+        n_ch = probe_shape[ch_axis]
+        table = np.moveaxis(result, ch_axis, -1).reshape(n_entries, n_ch).T
+        if (table == table[0]).all():
+            table = table[:1]
+        return np.asarray(table, dtype=np.float32)
+
+    def apply(self, model):
+        graph = model.graph
+        graph_modified = False
+        # candidate inputs are low-precision integer tensors
+        cands = [x.name for x in graph.input] + [x.output[0] for x in graph.node]
+        subgraphs = []
+        # outputs of the nodes of accepted subgraphs, all but the subgraph
+        # output disappear once the subgraph is replaced
+        claimed = set()
+        for start in cands:
+            if start in claimed and start not in [x[1] for x in subgraphs]:
+                continue
+            idt = model.get_tensor_datatype(start)
+            if not idt.is_integer() or idt == DataType["BIPOLAR"]:
+                continue
+            if idt.bitwidth() > self.max_input_bits:
+                continue
+            ishape = model.get_tensor_shape(start)
+            if ishape is None or len(ishape) < 2:
+                continue
+            ret = self.find_subgraph(model, start)
+            if ret is None:
+                continue
+            nodes, end = ret
+            # skip subgraphs that overlap with one already accepted
+            if any([x.output[0] in claimed for x in nodes]):
+                continue
+            odt = model.get_tensor_datatype(end)
+            if odt == DataType["BIPOLAR"]:
+                continue
+            if model.get_tensor_layout(start) == DataLayout.NCHW and len(ishape) == 4:
+                ch_axis = 1
+            else:
+                ch_axis = len(ishape) - 1
+            if not self.params_are_channelwise(model, nodes, ishape, ch_axis):
+                continue
+            # evaluate the subgraph with one element per value and channel
+            probe_shape = [1] * len(ishape)
+            probe_shape[ch_axis] = ishape[ch_axis]
+            table = self.compute_table(model, nodes, start, end, probe_shape, ch_axis)
+            if not np.vectorize(odt.allowed)(table).all():
+                warnings.warn("%s: Lookup table not representable as %s" % (end, odt.name))
+                continue
+            subgraphs.append((start, end, nodes, table))
+            claimed.update([x.output[0] for x in nodes])
+
+        for start, end, nodes, table in subgraphs:
+            insert_point = list(graph.node).index(nodes[0])
+            for node in nodes:
+                graph.node.remove(node)
+            lut_input = start
+            lut_output = end
+            # check layout of inputs/outputs, and convert if needed
+            if model.get_tensor_layout(lut_input) == DataLayout.NCHW:
+                lut_input = nchw_to_nhwc(lut_input, model, insert_point)
+                insert_point += 1
+            if model.get_tensor_layout(lut_output) == DataLayout.NCHW:
+                lut_output = nchw_to_nhwc(lut_output, model, insert_point, reverse=True)
+            lut_in_shape = model.get_tensor_shape(lut_input)
+            idt = model.get_tensor_datatype(start)
+            odt = model.get_tensor_datatype(end)
+            table_name = model.make_new_valueinfo_name()
+            model.set_initializer(table_name, table)
+            model.set_tensor_datatype(table_name, odt)
+            new_node = helper.make_node(
+                "LookupActivation",
+                [lut_input, table_name],
+                [lut_output],
+                domain="finn.custom_op.fpgadataflow",
+                backend="fpgadataflow",
+                NumChannels=int(lut_in_shape[-1]),
+                PE=1,
+                inputDataType=idt.name,
+                outputDataType=odt.name,
+                numInputVectors=list(lut_in_shape[:-1]),
+                name="LookupActivation_" + nodes[-1].name,
+            )
+            graph.node.insert(insert_point, new_node)
+            graph_modified = True
+
+        if graph_modified:
+            model = model.transform(InferShapes())
+            model = model.transform(InferDataTypes())
+        return (model, graph_modified)
+
+
 class InferConcatLayer(Transformation):
     """Convert suitable Concat nodes (operating on last/-1 axis)
     into StreamingConcat HW layers."""
@@ -1198,7 +1434,9 @@ class InferConcatLayer(Transformation):
 
 class InferStreamingEltwise(Transformation):
     """Convert eltwise Sub or Sub -> Abs to StreamingEltwise layer
-    with SubEltwise or AbsDiffEltwise op."""
+    with SubEltwise or AbsDiffEltwise op. Two-input Mul, Max and Min
+    between dynamic streams of the same shape (e.g. gating in GLU-style
+    blocks) become StreamingEltwise layers with the same eltwiseOp."""
 
     def apply(self, model):
         graph = model.graph
@@ -1206,7 +1444,7 @@ class InferStreamingEltwise(Transformation):
         graph_modified = False
         for node in graph.node:
             node_ind += 1
-            if node.op_type == "Sub":
+            if node.op_type in ["Sub", "Mul", "Max", "Min"] and len(node.input) == 2:
                 in0 = node.input[0]
                 in1 = node.input[1]
                 result = node.output[0]
@@ -1230,11 +1468,15 @@ class InferStreamingEltwise(Transformation):
                 if not (idt0.is_integer() and idt1.is_integer()):
                     continue
 
-                eltwiseOp = "Sub"
+                eltwiseOp = node.op_type
                 nodes_to_remove = [node]
                 # look for a downstream Abs node
                 res_consumer = model.find_consumer(result)
-                if (res_consumer is not None) and (res_consumer.op_type == "Abs"):
+                if (
+                    eltwiseOp == "Sub"
+                    and (res_consumer is not None)
+                    and (res_consumer.op_type == "Abs")
+                ):
                     eltwiseOp = "AbsDiff"
                     result = res_consumer.output[0]
                     nodes_to_remove.append(res_consumer)
@@ -1291,6 +1533,183 @@ class InferStreamingEltwise(Transformation):
         return (model, graph_modified)
 
 
+def find_scaled_integer_input(model, tensor):
+    """Returns (int_tensor, scale, mul_node) if tensor is an integer tensor
+    (scale 1, mul_node None) or the output of a Mul of an integer tensor with a
+    positive scalar initializer that has no other consumers. Returns None
+    otherwise."""
+    if model.get_tensor_datatype(tensor).is_integer():
+        return (tensor, 1.0, None)
+    producer = model.find_producer(tensor)
+    if producer is None or producer.op_type != "Mul":
+        return None
+    scale = model.get_initializer(producer.input[1])
+    if scale is None or scale.size != 1 or float(scale.flatten()[0]) <= 0:
+        return None
+    if not model.get_tensor_datatype(producer.input[0]).is_integer():
+        return None
+    if len(model.find_consumers(tensor)) != 1:
+        return None
+    return (producer.input[0], float(scale.flatten()[0]), producer)
+
+
+class InferStreamingSoftmax(Transformation):
+    """Convert Softmax layers over the innermost dimension with a (scaled)
+    integer input to StreamingSoftmax layers. The HW layer outputs the
+    probabilities as output_bits-bit unsigned fixed-point values, so a
+    Mul by 2^-output_bits is inserted behind it to keep the graph's
+    interface; the usual streamlining absorbs it into a following
+    MultiThreshold."""
+
+    def __init__(self, output_bits=8):
+        super().__init__()
+        self.output_bits = output_bits
+
+    def apply(self, model):
+        graph = model.graph
+        node_ind = 0
+        graph_modified = False
+        opset = max([x.version for x in model.model.opset_import if x.domain in ["", "ai.onnx"]])
+        for node in graph.node:
+            node_ind += 1
+            if node.op_type != "Softmax":
+                continue
+            in_shape = model.get_tensor_shape(node.input[0])
+            axis = get_by_name(node.attribute, "axis")
+            axis = axis.i if axis is not None else (-1 if opset >= 13 else 1)
+            # only the innermost dimension is supported
+            if axis % len(in_shape) != len(in_shape) - 1:
+                continue
+            src = find_scaled_integer_input(model, node.input[0])
+            if src is None:
+                continue
+            int_inp, scale, mul_node = src
+            idt = model.get_tensor_datatype(int_inp)
+            odt = DataType["UINT%d" % self.output_bits]
+            q_out = model.make_new_valueinfo_name()
+            model.set_tensor_shape(q_out, in_shape)
+            model.set_tensor_datatype(q_out, odt)
+            scale_name = model.make_new_valueinfo_name()
+            model.set_initializer(
+                scale_name, np.asarray(2.0**-self.output_bits, dtype=np.float32)
+            )
+            # create node with no parallelization first
+            new_node = helper.make_node(
+                "StreamingSoftmax",
+                [int_inp],
+                [q_out],
+                domain="finn.custom_op.fpgadataflow",
+                backend="fpgadataflow",
+                NumChannels=int(in_shape[-1]),
+                PE=1,
+                inputDataType=idt.name,
+                outputDataType=odt.name,
+                inputScale=scale,
+                numInputVectors=list(in_shape[:-1]),
+                name="StreamingSoftmax_" + node.name,
+            )
+            mul_out_node = helper.make_node("Mul", [q_out, scale_name], [node.output[0]])
+            graph.node.insert(node_ind, new_node)
+            graph.node.insert(node_ind + 1, mul_out_node)
+            # remove old nodes
+            graph.node.remove(node)
+            if mul_node is not None:
+                graph.node.remove(mul_node)
+            graph_modified = True
+        if graph_modified:
+            model = model.transform(SortGraph())
+            model = model.transform(InferShapes())
+            model = model.transform(InferDataTypes())
+        return (model, graph_modified)
+
+
+class InferStreamingLayerNorm(Transformation):
+    """Convert LayerNormalization layers over the innermost dimension with a
+    (scaled) integer input to StreamingLayerNorm layers. The HW layer only
+    normalizes, producing output_bits-bit signed values with frac_bits
+    fractional bits. The affine part and the fixed-point scale are kept as
+    Mul (and Add) nodes behind it, which the usual streamlining absorbs into
+    a following MultiThreshold."""
+
+    def __init__(self, output_bits=8, frac_bits=5):
+        super().__init__()
+        self.output_bits = output_bits
+        self.frac_bits = frac_bits
+
+    def apply(self, model):
+        graph = model.graph
+        node_ind = 0
+        graph_modified = False
+        for node in graph.node:
+            node_ind += 1
+            if node.op_type != "LayerNormalization":
+                continue
+            # the optional Mean/InvStdDev outputs can't be provided
+            if len([x for x in node.output if x != ""]) != 1:
+                continue
+            in_shape = model.get_tensor_shape(node.input[0])
+            axis = get_by_name(node.attribute, "axis")
+            axis = axis.i if axis is not None else -1
+            if axis % len(in_shape) != len(in_shape) - 1:
+                continue
+            gamma = model.get_initializer(node.input[1])
+            if gamma is None:
+                continue
+            has_beta = len(node.input) > 2 and node.input[2] != ""
+            src = find_scaled_integer_input(model, node.input[0])
+            if src is None:
+                continue
+            int_inp, scale, mul_node = src
+            eps = get_by_name(node.attribute, "epsilon")
+            eps = eps.f if eps is not None else 1e-5
+            idt = model.get_tensor_datatype(int_inp)
+            odt = DataType["INT%d" % self.output_bits]
+            q_out = model.make_new_valueinfo_name()
+            model.set_tensor_shape(q_out, in_shape)
+            model.set_tensor_datatype(q_out, odt)
+            # create node with no parallelization first
+            new_node = helper.make_node(
+                "StreamingLayerNorm",
+                [int_inp],
+                [q_out],
+                domain="finn.custom_op.fpgadataflow",
+                backend="fpgadataflow",
+                NumChannels=int(in_shape[-1]),
+                PE=1,
+                inputDataType=idt.name,
+                outputDataType=odt.name,
+                outFracBits=self.frac_bits,
+                # normalization is scale invariant up to epsilon
+                epsilon=eps / (scale * scale),
+                numInputVectors=list(in_shape[:-1]),
+                name="StreamingLayerNorm_" + node.name,
+            )
+            new_nodes = [new_node]
+            mul_param = model.make_new_valueinfo_name()
+            model.set_initializer(mul_param, (gamma * 2.0**-self.frac_bits).astype(np.float32))
+            if has_beta:
+                mul_out = model.make_new_valueinfo_name()
+                model.set_tensor_shape(mul_out, in_shape)
+                new_nodes.append(helper.make_node("Mul", [q_out, mul_param], [mul_out]))
+                new_nodes.append(
+                    helper.make_node("Add", [mul_out, node.input[2]], [node.output[0]])
+                )
+            else:
+                new_nodes.append(helper.make_node("Mul", [q_out, mul_param], [node.output[0]]))
+            for i, nd in enumerate(new_nodes):
+                graph.node.insert(node_ind + i, nd)
+            # remove old nodes
+            graph.node.remove(node)
+            if mul_node is not None:
+                graph.node.remove(mul_node)
+            graph_modified = True
+        if graph_modified:
+            model = model.transform(SortGraph())
+            model = model.transform(InferShapes())
+            model = model.transform(InferDataTypes())
+        return (model, graph_modified)
+
+
 class InferBinaryMatrixVectorActivation(Transformation):
     """Convert XnorPopcountMatMul layers to
     MatrixVectorActivation layers. Any immediately following MultiThreshold
@@ -1435,7 +1854,11 @@ class InferQuantizedMatrixVectorActivation(Transformation):
         graph_modified = False
         for n in graph.node:
             node_ind += 1
-            if n.op_type == "MatMul" and model.get_tensor_sparsity(n.input[1]) is None:
+            if (
+                n.op_type == "MatMul"
+                and model.get_tensor_sparsity(n.input[1]) is None
+                and model.get_initializer(n.input[1]) is not None
+            ):
                 mm_input = n.input[0]
                 mm_weight = n.input[1]
                 mm_output = n.output[0]
@@ -1556,6 +1979,72 @@ class InferQuantizedMatrixVectorActivation(Transformation):
         return (model, graph_modified)
 
 
+class InferDynamicMatMul(Transformation):
+    """Convert MatMul layers where both operands are quantized activations
+    (i.e. neither input has an initializer), such as the Q*K^T and A*V products
+    in attention blocks, to DynamicMatMul layers. Both inputs must have the
+    same leading dimensions, broadcasting is not supported."""
+
+    def __init__(self):
+        super().__init__()
+
+    def apply(self, model):
+        graph = model.graph
+        node_ind = 0
+        graph_modified = False
+        for n in graph.node:
+            node_ind += 1
+            if n.op_type != "MatMul":
+                continue
+            in0, in1 = n.input[0], n.input[1]
+            if model.get_initializer(in0) is not None or model.get_initializer(in1) is not None:
+                continue
+            idt0 = model.get_tensor_datatype(in0)
+            idt1 = model.get_tensor_datatype(in1)
+            if not (idt0.is_integer() and idt1.is_integer()):
+                continue
+            if idt0 == DataType["BIPOLAR"] or idt1 == DataType["BIPOLAR"]:
+                continue
+            in0_shape = model.get_tensor_shape(in0)
+            in1_shape = model.get_tensor_shape(in1)
+            # need at least one leading (batch) dim to populate numInputVectors
+            if len(in0_shape) < 3 or len(in0_shape) != len(in1_shape):
+                continue
+            if in0_shape[:-2] != in1_shape[:-2] or in0_shape[-1] != in1_shape[-2]:
+                continue
+            mm_output = n.output[0]
+            # create node with no parallelization first
+            new_node = helper.make_node(
+                "DynamicMatMul",
+                [in0, in1],
+                [mm_output],
+                domain="finn.custom_op.fpgadataflow",
+                backend="fpgadataflow",
+                M=int(in0_shape[-2]),
+                K=int(in0_shape[-1]),
+                N=int(in1_shape[-1]),
+                SIMD=1,
+                PE=1,
+                inputDataType0=idt0.name,
+                inputDataType1=idt1.name,
+                outputDataType="INT32",
+                numInputVectors=list(in0_shape[:-2]),
+                name="DynamicMatMul_" + n.name,
+            )
+            # size the output for the worst-case dot product of length K
+            odt = getCustomOp(new_node).calc_accumulator_datatype()
+            getCustomOp(new_node).set_nodeattr("outputDataType", odt.name)
+            model.set_tensor_datatype(mm_output, odt)
+            graph.node.insert(node_ind, new_node)
+            # remove old node
+            graph.node.remove(n)
+            graph_modified = True
+        if graph_modified:
+            model = model.transform(InferShapes())
+            model = model.transform(InferDataTypes())
+        return (model, graph_modified)
+
+
 class InferVectorVectorActivation(Transformation):
     """Convert MatMul layers with quantized inputs and weights to
     VectorVectorActivation layers, if the sparsity annotation
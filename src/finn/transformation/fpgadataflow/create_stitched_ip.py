@@ -27,6 +27,7 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import hashlib
 import json
 import multiprocessing as mp
 import os
@@ -35,13 +36,14 @@ import warnings
 from qonnx.custom_op.registry import getCustomOp
 from qonnx.transformation.base import Transformation
 from qonnx.util.basic import get_num_default_workers
-from shutil import copytree
+from shutil import copytree, rmtree
 
+from finn.transformation.fpgadataflow.insert_hook import hook_op_types
 from finn.transformation.fpgadataflow.replace_verilog_relpaths import (
     ReplaceVerilogRelPaths,
 )
 from finn.util.basic import make_build_dir
-from finn.util.fpgadataflow import is_hls_node, is_rtl_node
+from finn.util.fpgadataflow import is_hls_node, is_rtl_node, sim_only_attrs
 
 
 def is_external_input(model, node, i):
@@ -72,6 +74,29 @@ def is_external_output(model, node, i):
     return False
 
 
+def node_stitch_hash(node, create_cmds):
+    """Returns a hash over the attributes of the node and the TCL that
+    instantiates it, used to find cells that changed between two stitched IP
+    builds of a graph."""
+    h = hashlib.sha1()
+    h.update(node.op_type.encode())
+    for attr in sorted(node.attribute, key=lambda a: a.name):
+        if attr.name not in sim_only_attrs:
+            h.update(attr.SerializeToString())
+    h.update("\n".join(create_cmds).encode())
+    return h.hexdigest()
+
+
+def load_stitch_state(vivado_stitch_proj_dir):
+    """Returns the stitch state saved by CreateStitchedIP in given project dir,
+    or None if there is none."""
+    state_file = vivado_stitch_proj_dir + "/stitch_state.json"
+    if not os.path.isfile(state_file):
+        return None
+    with open(state_file, "r") as f:
+        return json.load(f)
+
+
 class CreateStitchedIP(Transformation):
     """Create a Vivado IP Block Design project from all the generated IPs of a
     graph. All nodes in the graph must have the fpgadataflow backend attribute,
@@ -84,15 +109,30 @@ class CreateStitchedIP(Transformation):
     value. A make_project.tcl script is also placed under the same folder,
     which is called to instantiate the per-layer IPs and stitch them together.
     The packaged block design IP can be found under the ip subdirectory.
+
+    If incremental is set and the model already has a stitched IP project, a
+    copy of that project is updated instead: only the cells of nodes that
+    changed and the stream connections that changed are replaced, e.g. after
+    FIFO resizing. The full block design is created if the changes touch
+    the top-level interfaces or nodes with AXI interfaces.
     """
 
-    def __init__(self, fpgapart, clk_ns, ip_name="finn_design", vitis=False, signature=[]):
+    def __init__(
+        self,
+        fpgapart,
+        clk_ns,
+        ip_name="finn_design",
+        vitis=False,
+        signature=[],
+        incremental=False,
+    ):
         super().__init__()
         self.fpgapart = fpgapart
         self.clk_ns = clk_ns
         self.ip_name = ip_name
         self.vitis = vitis
         self.signature = signature
+        self.incremental = incremental
         self.has_aximm = False
         self.has_m_axis = False
         self.m_axis_idx = 0
@@ -101,6 +141,13 @@ class CreateStitchedIP(Transformation):
         self.clock_reset_are_external = False
         self.create_cmds = []
         self.connect_cmds = []
+        # per-node instantiation, stream connections and external stream
+        # ports, kept to update the block design incrementally
+        self.node_create_cmds = {}
+        self.node_reconnect_cmds = {}
+        self.axi_nodes = []
+        self.stream_nets = []
+        self.ext_intf_ports = []
         # keep track of top-level interface names
         self.intf_names = {
             "clk": [],
@@ -109,6 +156,8 @@ class CreateStitchedIP(Transformation):
             "m_axis": [],
             "aximm": [],
             "axilite": [],
+            # hook layers and the external AXI lite interface to read them
+            "hooks": [],
         }
 
     def connect_clk_rst(self, node):
@@ -139,12 +188,20 @@ class CreateStitchedIP(Transformation):
                 "connect_bd_net [get_bd_ports ap_clk] [get_bd_pins %s/%s]"
                 % (inst_name, clock_intf_name)
             )
+        self.node_reconnect_cmds[inst_name] = [
+            "connect_bd_net [get_bd_ports ap_rst_n] [get_bd_pins %s/%s]"
+            % (inst_name, reset_intf_name),
+            "connect_bd_net [get_bd_ports ap_clk] [get_bd_pins %s/%s]"
+            % (inst_name, clock_intf_name),
+        ]
 
     def connect_axi(self, node):
         inst_name = node.name
         node_inst = getCustomOp(node)
         axilite_intf_name = node_inst.get_verilog_top_module_intf_names()["axilite"]
         aximm_intf_name = node_inst.get_verilog_top_module_intf_names()["aximm"]
+        if len(axilite_intf_name) != 0 or len(aximm_intf_name) != 0:
+            self.axi_nodes.append(inst_name)
         if len(axilite_intf_name) != 0:
             self.connect_cmds.append(
                 "make_bd_intf_pins_external "
@@ -155,6 +212,11 @@ class CreateStitchedIP(Transformation):
                 len(self.intf_names["axilite"]),
             )
             self.intf_names["axilite"].append(ext_if_name)
+            for hook, hook_op_type in hook_op_types.items():
+                if node.op_type == hook_op_type:
+                    self.intf_names["hooks"].append(
+                        {"name": inst_name, "hook": hook, "axilite": ext_if_name}
+                    )
         if len(aximm_intf_name) != 0:
             self.connect_cmds.append(
                 "make_bd_intf_pins_external [get_bd_intf_pins %s/%s]"
@@ -165,11 +227,17 @@ class CreateStitchedIP(Transformation):
                 "set_property name %s [get_bd_intf_ports m_axi_gmem_0]" % ext_if_name
             )
             self.connect_cmds.append("assign_bd_address")
-            seg_name = "%s/Data_m_axi_gmem/SEG_%s_Reg" % (inst_name, ext_if_name)
+            # HLS cores name their address space after the data interface,
+            # RTL module references after the interface itself
+            if is_hls_node(node):
+                addr_space = "Data_m_axi_gmem"
+            else:
+                addr_space = aximm_intf_name[0][0]
+            seg_name = "%s/%s/SEG_%s_Reg" % (inst_name, addr_space, ext_if_name)
             self.connect_cmds.append("set_property offset 0 [get_bd_addr_segs {%s}]" % (seg_name))
             # TODO should propagate this information from the node instead of 4G
             self.connect_cmds.append("set_property range 4G [get_bd_addr_segs {%s}]" % (seg_name))
-            self.intf_names["aximm"] = [(ext_if_name, aximm_intf_name[0][1])]
+            self.intf_names["aximm"].append((ext_if_name, aximm_intf_name[0][1]))
             self.has_aximm = True
 
     def connect_m_axis_external(self, node, idx=None):
@@ -193,6 +261,7 @@ class CreateStitchedIP(Transformation):
             self.intf_names["m_axis"].append(
                 ("m_axis_%d" % self.m_axis_idx, output_intf_names[i][1])
             )
+            self.ext_intf_ports.append((inst_name, output_intf_name, "m_axis_%d" % self.m_axis_idx))
             self.m_axis_idx += 1
 
     def connect_s_axis_external(self, node, idx=None):
@@ -215,6 +284,7 @@ class CreateStitchedIP(Transformation):
             self.intf_names["s_axis"].append(
                 ("s_axis_%d" % self.s_axis_idx, input_intf_names[i][1])
             )
+            self.ext_intf_ports.append((inst_name, input_intf_name, "s_axis_%d" % self.s_axis_idx))
             self.s_axis_idx += 1
 
     def connect_ap_none_external(self, node):
@@ -230,6 +300,10 @@ class CreateStitchedIP(Transformation):
             self.connect_cmds.append(
                 "set_property name %s [get_bd_ports %s_0]" % (input_intf_name, input_intf_name)
             )
+            self.node_reconnect_cmds[inst_name].append(
+                "connect_bd_net [get_bd_ports %s] [get_bd_pins %s/%s]"
+                % (input_intf_name, inst_name, input_intf_name)
+            )
 
     def insert_signature(self, checksum_count):
         signature_vlnv = "AMD:user:axi_info_top:1.0"
@@ -278,6 +352,53 @@ class CreateStitchedIP(Transformation):
         self.connect_cmds.append("set_property name s_axilite_info [get_bd_intf_ports s_axi_0]")
         self.connect_cmds.append("assign_bd_address")
 
+    def connect_stream_cmd(self, net):
+        return "connect_bd_intf_net [get_bd_intf_pins %s/%s] [get_bd_intf_pins %s/%s]" % tuple(net)
+
+    def update_cmds(self, prev_state, state):
+        """Returns the TCL to turn the block design described by prev_state into
+        the one described by state, replacing only the cells and stream nets that
+        changed. Returns None if this needs a full rebuild."""
+        for key in state.keys():
+            if key not in ["nodes", "nets", "axi_nodes"] and prev_state.get(key) != state[key]:
+                return None
+        changed = [x for x in state["nodes"] if prev_state["nodes"].get(x) != state["nodes"][x]]
+        removed = [x for x in prev_state["nodes"] if x not in state["nodes"]]
+        touched = set(changed + removed)
+        # address maps of AXI interfaces are only set up by a full rebuild
+        if any([x in state["axi_nodes"] or x in prev_state["axi_nodes"] for x in touched]):
+            return None
+        cmds = []
+        # deleting a cell keeps its nets, remove the stream nets first
+        for name in [x for x in prev_state["nodes"] if x in touched]:
+            cmds.append(
+                "delete_bd_objs -quiet [get_bd_intf_nets -quiet -of_objects "
+                "[get_bd_intf_pins -quiet -of_objects [get_bd_cells %s]]]" % name
+            )
+            cmds.append("delete_bd_objs [get_bd_cells %s]" % name)
+        for net in prev_state["nets"]:
+            if net not in state["nets"] and net[0] not in touched and net[2] not in touched:
+                cmds.append(
+                    "delete_bd_objs [get_bd_intf_nets -of_objects [get_bd_intf_pins %s/%s]]"
+                    % (net[2], net[3])
+                )
+        if changed != []:
+            # pick up regenerated sources of RTL module references
+            cmds.append("update_compile_order -fileset sources_1")
+        for name in changed:
+            cmds += self.node_create_cmds[name]
+            cmds += self.node_reconnect_cmds[name]
+            for inst_name, intf_name, port_name in state["ext_intf_ports"]:
+                if inst_name == name:
+                    cmds.append(
+                        "connect_bd_intf_net [get_bd_intf_ports %s] [get_bd_intf_pins %s/%s]"
+                        % (port_name, inst_name, intf_name)
+                    )
+        for net in state["nets"]:
+            if net not in prev_state["nets"] or net[0] in touched or net[2] in touched:
+                cmds.append(self.connect_stream_cmd(net))
+        return cmds
+
     def apply(self, model):
         # ensure non-relative readmemh .dat files
         model = model.transform(ReplaceVerilogRelPaths())
@@ -310,7 +431,8 @@ class CreateStitchedIP(Transformation):
             ip_dir_value = node_inst.get_nodeattr("ip_path")
             assert os.path.isdir(ip_dir_value), "IP generation directory doesn't exist."
             ip_dirs += [ip_dir_value]
-            self.create_cmds += node_inst.code_generation_ipi()
+            self.node_create_cmds[node.name] = node_inst.code_generation_ipi()
+            self.create_cmds += self.node_create_cmds[node.name]
             self.connect_clk_rst(node)
             self.connect_ap_none_external(node)
             self.connect_axi(node)
@@ -324,11 +446,9 @@ class CreateStitchedIP(Transformation):
                         "m_axis"
                     ][j][0]
                     dst_intf_name = node_inst.get_verilog_top_module_intf_names()["s_axis"][i][0]
-                    self.connect_cmds.append(
-                        "connect_bd_intf_net [get_bd_intf_pins %s/%s] "
-                        "[get_bd_intf_pins %s/%s]"
-                        % (producer.name, src_intf_name, node.name, dst_intf_name)
-                    )
+                    net = (producer.name, src_intf_name, node.name, dst_intf_name)
+                    self.stream_nets.append(net)
+                    self.connect_cmds.append(self.connect_stream_cmd(net))
 
         # process external inputs and outputs in top-level graph input order
         for input in model.graph.input:
@@ -355,47 +475,99 @@ class CreateStitchedIP(Transformation):
             checksum_layers = model.get_nodes_by_op_type("CheckSum_hls")
             self.insert_signature(len(checksum_layers))
 
+        # describe the block design to allow incremental updates later on
+        state = {
+            "fpgapart": self.fpgapart,
+            "clk_ns": self.clk_ns,
+            "ip_name": self.ip_name,
+            "vitis": self.vitis,
+            "signature": self.signature,
+            "intf_names": self.intf_names,
+            "ext_intf_ports": self.ext_intf_ports,
+            "axi_nodes": self.axi_nodes,
+            "nets": self.stream_nets,
+            "nodes": {},
+        }
+        for node in model.graph.node:
+            state["nodes"][node.name] = node_stitch_hash(node, self.node_create_cmds[node.name])
+        # normalize tuples to lists to compare against the saved state
+        state = json.loads(json.dumps(state))
+        prev_dir = model.get_metadata_prop("vivado_stitch_proj")
+        prev_state = None
+        if self.incremental and prev_dir is not None:
+            prev_state = load_stitch_state(prev_dir)
+        update_cmds = None
+        if prev_state is not None:
+            update_cmds = self.update_cmds(prev_state, state)
+        if update_cmds == []:
+            # nothing changed, keep using the previous project
+            model.set_metadata_prop("wrapper_filename", prev_state["wrapper_filename"])
+            model.set_metadata_prop("clk_ns", str(self.clk_ns))
+            return (model, False)
+
         # create a temporary folder for the project
         prjname = "finn_vivado_stitch_proj"
         vivado_stitch_proj_dir = make_build_dir(prefix="vivado_stitch_proj_")
         model.set_metadata_prop("vivado_stitch_proj", vivado_stitch_proj_dir)
-        # start building the tcl script
-        tcl = []
-        # create vivado project
-        tcl.append(
-            "create_project %s %s -part %s" % (prjname, vivado_stitch_proj_dir, self.fpgapart)
+        block_name = self.ip_name
+        bd_base = "%s/%s.srcs/sources_1/bd/%s" % (
+            vivado_stitch_proj_dir,
+            prjname,
+            block_name,
         )
-        # no warnings on long module names
-        tcl.append("set_msg_config -id {[BD 41-1753]} -suppress")
-        # add all the generated IP dirs to ip_repo_paths
+        bd_filename = "%s/%s.bd" % (bd_base, block_name)
         ip_dirs_str = " ".join(ip_dirs)
-        tcl.append("set_property ip_repo_paths [%s] [current_project]" % ip_dirs_str)
-        tcl.append("update_ip_catalog")
-        # create block design and instantiate all layers
-        block_name = self.ip_name
-        tcl.append('create_bd_design "%s"' % block_name)
-        tcl.extend(self.create_cmds)
-        tcl.extend(self.connect_cmds)
+        # start building the tcl script
+        tcl = []
+        if update_cmds is None:
+            # create vivado project
+            tcl.append(
+                "create_project %s %s -part %s" % (prjname, vivado_stitch_proj_dir, self.fpgapart)
+            )
+            # no warnings on long module names
+            tcl.append("set_msg_config -id {[BD 41-1753]} -suppress")
+            # add all the generated IP dirs to ip_repo_paths
+            tcl.append("set_property ip_repo_paths [%s] [current_project]" % ip_dirs_str)
+            tcl.append("update_ip_catalog")
+            # create block design and instantiate all layers
+            tcl.append('create_bd_design "%s"' % block_name)
+            tcl.extend(self.create_cmds)
+            tcl.extend(self.connect_cmds)
+        else:
+            # update a copy of the previous project, the packaged IP is redone
+            copytree(prev_dir, vivado_stitch_proj_dir, symlinks=True, dirs_exist_ok=True)
+            rmtree(vivado_stitch_proj_dir + "/ip", ignore_errors=True)
+            os.remove(vivado_stitch_proj_dir + "/stitch_state.json")
+            tcl.append("open_project %s/%s.xpr" % (vivado_stitch_proj_dir, prjname))
+            tcl.append("set_msg_config -id {[BD 41-1753]} -suppress")
+            tcl.append("set_property ip_repo_paths [%s] [current_project]" % ip_dirs_str)
+            # IPs may have been regenerated under the same paths
+            tcl.append("update_ip_catalog -rebuild")
+            tcl.append("open_bd_design [get_files %s]" % bd_filename)
+            tcl.extend(update_cmds)
         fclk_mhz = 1 / (self.clk_ns * 0.001)
         fclk_hz = fclk_mhz * 1000000
         model.set_metadata_prop("clk_ns", str(self.clk_ns))
         tcl.append("set_property CONFIG.FREQ_HZ %d [get_bd_ports /ap_clk]" % round(fclk_hz))
         tcl.append("validate_bd_design")
         tcl.append("save_bd_design")
-        # create wrapper hdl (for rtlsim later on)
-        bd_base = "%s/%s.srcs/sources_1/bd/%s" % (
-            vivado_stitch_proj_dir,
-            prjname,
-            block_name,
-        )
-        bd_filename = "%s/%s.bd" % (bd_base, block_name)
-        tcl.append("make_wrapper -files [get_files %s] -top" % bd_filename)
-        wrapper_filename = "%s/hdl/%s_wrapper.v" % (bd_base, block_name)
-        tcl.append("add_files -norecurse %s" % wrapper_filename)
+        if update_cmds is None:
+            # create wrapper hdl (for rtlsim later on)
+            tcl.append("make_wrapper -files [get_files %s] -top" % bd_filename)
+            wrapper_filename = "%s/hdl/%s_wrapper.v" % (bd_base, block_name)
+            tcl.append("add_files -norecurse %s" % wrapper_filename)
+            tcl.append("set_property top %s_wrapper [current_fileset]" % block_name)
+        else:
+            # top-level ports are unchanged, so is the wrapper
+            wrapper_filename = prev_state["wrapper_filename"].replace(
+                prev_dir, vivado_stitch_proj_dir
+            )
+            tcl.append("generate_target all [get_files %s]" % bd_filename)
         model.set_metadata_prop("wrapper_filename", wrapper_filename)
-        tcl.append("set_property top %s_wrapper [current_fileset]" % block_name)
         # synthesize to DCP and export stub, DCP and constraints
         if self.vitis:
+            if update_cmds is not None:
+                tcl.append("reset_run synth_1")
             tcl.append(
                 "set_property SYNTH_CHECKPOINT_MODE Hierarchical [ get_files %s ]" % bd_filename
             )
@@ -430,6 +602,9 @@ class CreateStitchedIP(Transformation):
             )
             % (vivado_stitch_proj_dir, block_vendor, block_library, block_name)
         )
+        if update_cmds is not None:
+            # the copied project was packaged before
+            tcl[-1] += " -force"
         # Allow user to customize clock in deployment of stitched IP
         tcl.append("set_property ipi_drc {ignore_freq_hz true} [ipx::current_core]")
         # in some cases, the IP packager seems to infer an aperture of 64K or 4G,
@@ -502,7 +677,7 @@ class CreateStitchedIP(Transformation):
             )
         # add a rudimentary driver mdd to get correct ranges in xparameters.h later on
         example_data_dir = os.environ["FINN_ROOT"] + "/src/finn/qnn-data/mdd-data"
-        copytree(example_data_dir, vivado_stitch_proj_dir + "/data")
+        copytree(example_data_dir, vivado_stitch_proj_dir + "/data", dirs_exist_ok=True)
 
         #####
         # Core Cleanup Operations
@@ -619,5 +794,8 @@ close $ofile
                     Please check logs under the parent directory."""
                     % (wrapper_filename, wrapper_filename_alt)
                 )
+        state["wrapper_filename"] = model.get_metadata_prop("wrapper_filename")
+        with open(vivado_stitch_proj_dir + "/stitch_state.json", "w") as f:
+            json.dump(state, f, indent=2)
 
         return (model, False)
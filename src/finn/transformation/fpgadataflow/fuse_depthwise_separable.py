@@ -0,0 +1,128 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+from onnx import helper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.base import Transformation
+from qonnx.transformation.infer_datatypes import InferDataTypes
+from qonnx.transformation.infer_shapes import InferShapes
+
+
+class FuseDepthwiseSeparable(Transformation):
+    """Fuse each depthwise VVAU whose output is consumed by a single pointwise
+    MVAU into one DepthwiseSeparable layer, so that the two stages share their
+    channel parallelism and need no FIFO or data width converter in between.
+    Works on the HW abstraction layers, i.e. between conversion to HW layers
+    and SpecializeLayers; MinimizeAccumulatorWidth and MinimizeWeightBitWidth
+    should be applied before fusing. A fused block always embeds its weights,
+    so layers with mem_mode=external or runtime-writeable weights are left
+    untouched."""
+
+    def __init__(self):
+        super().__init__()
+
+    def apply(self, model):
+        graph = model.graph
+        node_ind = 0
+        graph_modified = False
+        for node in graph.node:
+            node_ind += 1
+            if node.op_type != "VVAU":
+                continue
+            consumers = model.find_consumers(node.output[0])
+            if consumers is None or len(consumers) != 1 or consumers[0].op_type != "MVAU":
+                continue
+            consumer = consumers[0]
+            dw_inst = getCustomOp(node)
+            pw_inst = getCustomOp(consumer)
+            # weights must be available for embedding
+            if any(
+                [
+                    x.get_nodeattr("mem_mode") == "external"
+                    or x.get_nodeattr("runtime_writeable_weights") == 1
+                    for x in [dw_inst, pw_inst]
+                ]
+            ):
+                continue
+            # the MVAU must be a pointwise conv over the depthwise output
+            channels = dw_inst.get_nodeattr("Channels")
+            dim_h, dim_w = dw_inst.get_nodeattr("Dim")
+            if pw_inst.get_nodeattr("MW") != channels:
+                continue
+            if list(pw_inst.get_nodeattr("numInputVectors")) != [1, dim_h, dim_w]:
+                continue
+            # PE of the VVAU and SIMD of the MVAU both divide Channels, keep
+            # the larger one as shared channel parallelism
+            simd = max(dw_inst.get_nodeattr("PE"), pw_inst.get_nodeattr("SIMD"))
+            dw_noact = dw_inst.get_nodeattr("noActivation")
+            pw_noact = pw_inst.get_nodeattr("noActivation")
+            inputs = list(node.input[: 2 if dw_noact == 1 else 3])
+            inputs += list(consumer.input[1 : 2 if pw_noact == 1 else 3])
+            new_node = helper.make_node(
+                "DepthwiseSeparable",
+                inputs,
+                [consumer.output[0]],
+                domain="finn.custom_op.fpgadataflow",
+                backend="fpgadataflow",
+                name="DepthwiseSeparable_" + node.name,
+                Channels=channels,
+                Kernel=dw_inst.get_nodeattr("Kernel"),
+                Dim=[dim_h, dim_w],
+                MH=pw_inst.get_nodeattr("MH"),
+                KernelSIMD=dw_inst.get_nodeattr("SIMD"),
+                SIMD=simd,
+                PE=pw_inst.get_nodeattr("PE"),
+                resType=dw_inst.get_nodeattr("resType"),
+                inputDataType=dw_inst.get_nodeattr("inputDataType"),
+                dwWeightDataType=dw_inst.get_nodeattr("weightDataType"),
+                dwAccDataType=dw_inst.get_nodeattr("accDataType"),
+                dwOutputDataType=dw_inst.get_nodeattr("outputDataType"),
+                dwActVal=dw_inst.get_nodeattr("ActVal"),
+                dwNoActivation=dw_noact,
+                pwWeightDataType=pw_inst.get_nodeattr("weightDataType"),
+                pwAccDataType=pw_inst.get_nodeattr("accDataType"),
+                outputDataType=pw_inst.get_nodeattr("outputDataType"),
+                pwActVal=pw_inst.get_nodeattr("ActVal"),
+                pwNoActivation=pw_noact,
+                binaryXnorMode=pw_inst.get_nodeattr("binaryXnorMode"),
+            )
+            # the depthwise SWG must produce SIMD channels at a time
+            producer = model.find_producer(node.input[0])
+            if producer is not None and producer.op_type.startswith("ConvolutionInputGenerator"):
+                getCustomOp(producer).set_nodeattr("SIMD", simd)
+            graph.node.insert(node_ind, new_node)
+            # remove old nodes
+            graph.node.remove(node)
+            graph.node.remove(consumer)
+            graph_modified = True
+
+        if graph_modified:
+            model = model.transform(InferShapes())
+            model = model.transform(InferDataTypes())
+        return (model, graph_modified)
@@ -30,12 +30,15 @@
 import os
 import qonnx.custom_op.registry as registry
 import warnings
-from qonnx.transformation.base import NodeLocalTransformation
 
+from finn.transformation.fpgadataflow.scheduled_node_local import (
+    ScheduledNodeLocalTransformation,
+)
+from finn.util.build_dirs import build_output_done
 from finn.util.fpgadataflow import is_hls_node
 
 
-class HLSSynthIP(NodeLocalTransformation):
+class HLSSynthIP(ScheduledNodeLocalTransformation):
     """For each HLS node: generate IP block from code in folder
     that is referenced in node attribute "code_gen_dir_ipgen"
     and save path of generated project in node attribute "ipgen_path".
@@ -48,11 +51,29 @@ class HLSSynthIP(NodeLocalTransformation):
 
     * num_workers (int or None) number of parallel workers, see documentation in
       NodeLocalTransformation for more details.
+
+    The per-node jobs are run longest first within the memory budget of the
+    build hosts, see ScheduledNodeLocalTransformation.
     """
 
+    job_kind = "hlssynth"
+    default_job_mem = 4 * 2**30
+
     def __init__(self, num_workers=None):
         super().__init__(num_workers=num_workers)
 
+    def is_job(self, node):
+        if not super().is_job(node):
+            return False
+        # IP from an earlier run is picked up in place, its near-zero runtime
+        # would only skew the job history
+        inst = registry.getCustomOp(node)
+        code_gen_dir = inst.get_nodeattr("code_gen_dir_ipgen")
+        ipgen_path = inst.get_nodeattr("ipgen_path")
+        if os.path.isdir(ipgen_path) and code_gen_dir in ipgen_path:
+            return False
+        return not build_output_done(code_gen_dir, "ipgen")
+
     def applyNodeLocal(self, node):
         op_type = node.op_type
         if is_hls_node(node):
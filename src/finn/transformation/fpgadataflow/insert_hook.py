@@ -27,6 +27,7 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+
 import numpy as np
 from onnx import TensorProto
 from onnx import helper as oh
@@ -36,9 +37,13 @@ from qonnx.transformation.general import GiveReadableTensorNames, GiveUniqueNode
 
 from finn.util.fpgadataflow import is_hls_node, is_rtl_node
 
+# hook kinds selectable through the output_hook node attribute and the
+# layers implementing them
+hook_op_types = {"checksum": "CheckSum_hls", "tap": "Tap_hls"}
+
 
 def _is_hook_node(node):
-    if node.op_type in ["CheckSum_hls"]:
+    if node.op_type in hook_op_types.values():
         return True
     else:
         return False
@@ -58,74 +63,107 @@ def _suitable_node(node):
 
 
 class InsertHook(Transformation):
-    """Inserting hook layer after each layer that has the node attribute
-    'output_hook' specified"""
+    """Inserting hook layers after each layer that has the node attribute
+    'output_hook' specified, in a single pass over the graph. The attribute
+    holds a comma-separated list of hook kinds, which are chained in the
+    given order. Supported hooks are "checksum", which reduces each frame to
+    a 32-bit checksum, and "tap", which copies sampled frames into a ring
+    buffer of capture_slots frames in DRAM. Outputs that already feed a hook
+    layer are left untouched."""
 
-    def __init__(self):
+    def __init__(self, capture_slots=4):
         super().__init__()
+        self.capture_slots = capture_slots
+
+    def make_hook_node(self, model, hook, producer_inst, ind, input_name):
+        """Returns a hook layer of given kind consuming input_name, which
+        carries output ind of the producer, along with its two output tensors."""
+        normal_oshape = list(producer_inst.get_normal_output_shape(ind))
+        folded_oshape = list(producer_inst.get_folded_output_shape(ind))
+        odt = producer_inst.get_output_datatype(ind)
+        words_per_frame = int(np.prod(folded_oshape[:-1]))
+        hook_otensor = oh.make_tensor_value_info(
+            model.make_new_valueinfo_name(), TensorProto.FLOAT, normal_oshape
+        )
+        if hook == "checksum":
+            result_shape = [1]
+            hook_attrs = {"items_per_word": producer_inst.get_nodeattr("PE")}
+        else:
+            # second output holds the captured frames
+            result_shape = [self.capture_slots] + normal_oshape
+            hook_attrs = {"capture_slots": self.capture_slots}
+        hook_result = oh.make_tensor_value_info(
+            model.make_new_valueinfo_name(), TensorProto.FLOAT, result_shape
+        )
+        hook_node = oh.make_node(
+            hook_op_types[hook],
+            [input_name],
+            outputs=[hook_otensor.name, hook_result.name],
+            domain="finn.custom_op.fpgadataflow.hls",
+            backend="fpgadataflow",
+            words_per_frame=words_per_frame,
+            inputDataType=str(odt.name),
+            folded_shape=folded_oshape,
+            **hook_attrs,
+        )
+        return hook_node, hook_otensor, hook_result
 
     def apply(self, model):
-        list_supported_hooks = ["checksum"]
         graph = model.graph
-        node_ind = -1
-        graph_modified = False
+        # look up consumers once instead of searching the graph per output
+        consumer_map = {}
         for n in graph.node:
+            for inp in n.input:
+                consumer_map.setdefault(inp, []).append(n)
+        node_ind = 0
+        graph_modified = False
+        outputs_replaced = False
+        for n in list(graph.node):
             node_ind += 1
-            if _suitable_node(n):
-                for output_name in n.output:
-                    consumers = model.find_consumers(output_name)
-                    assert len(consumers) <= 1, (
-                        n.name + ": HLS node with fan-out higher than 1 cannot be stitched"
+            if not _suitable_node(n):
+                continue
+            n0 = getCustomOp(n)
+            hooks = [x.strip() for x in n0.get_nodeattr("output_hook").split(",")]
+            hooks = [x for x in hooks if x in hook_op_types.keys()]
+            if hooks == []:
+                continue
+            for ind, output_name in enumerate(n.output):
+                consumers = consumer_map.get(output_name, [])
+                assert len(consumers) <= 1, (
+                    n.name + ": HLS node with fan-out higher than 1 cannot be stitched"
+                )
+                if len(consumers) == 1 and _is_hook_node(consumers[0]):
+                    continue
+                # chain the hook layers behind the output
+                hook_input = output_name
+                for hook in hooks:
+                    hook_node, hook_otensor, hook_result = self.make_hook_node(
+                        model, hook, n0, ind, hook_input
                     )
-                    n0 = getCustomOp(n)
-                    n0_hook = n0.get_nodeattr("output_hook")
-                    if n0_hook in list_supported_hooks:
-                        if n0_hook == "checksum":
-                            if len(consumers) == 1:
-                                if consumers[0].op_type == "CheckSum_hls":
-                                    continue
-                            n0_normal_oshape = n0.get_normal_output_shape()
-                            n0_folded_oshape = n0.get_folded_output_shape()
-                            n0_odt = n0.get_output_datatype()
-                            items_per_word = n0.get_nodeattr("PE")
-                            words_per_frame = np.prod(n0_folded_oshape[:-1])
-                            chk_otensor = oh.make_tensor_value_info(
-                                model.make_new_valueinfo_name(),
-                                TensorProto.FLOAT,
-                                n0_normal_oshape,
-                            )
-                            chk_result = oh.make_tensor_value_info(
-                                model.make_new_valueinfo_name(),
-                                TensorProto.FLOAT,
-                                [1],
-                            )
-                            chk_node = oh.make_node(
-                                "CheckSum_hls",
-                                [output_name],
-                                outputs=[chk_otensor.name, chk_result.name],
-                                domain="finn.custom_op.fpgadataflow.hls",
-                                backend="fpgadataflow",
-                                words_per_frame=words_per_frame,
-                                items_per_word=items_per_word,
-                                inputDataType=str(n0_odt.name),
-                                folded_shape=n0_folded_oshape,
-                            )
-                            # insert checksum node
-                            graph.node.insert(node_ind + 1, chk_node)
-                            # insert newly-created tensors
-                            graph.value_info.append(chk_otensor)
-                            graph.value_info.append(chk_result)
-
-                            # set chk output tensor as new input tensor of second node
-                            if len(consumers) == 1:
-                                consumers[0].input[0] = chk_otensor.name
-                            else:
-                                model.graph.output.pop()
-                                model.graph.output.append(chk_otensor)
-                                model.graph.value_info.remove(chk_otensor)
-                                model = model.transform(GiveUniqueNodeNames())
-                                model = model.transform(GiveReadableTensorNames())
-                            graph_modified = True
-                            return (model, graph_modified)
+                    graph.node.insert(node_ind, hook_node)
+                    node_ind += 1
+                    graph.value_info.append(hook_otensor)
+                    graph.value_info.append(hook_result)
+                    hook_input = hook_otensor.name
+                # set last hook output tensor as new input tensor of consumer
+                if len(consumers) == 1:
+                    for i, inp in enumerate(consumers[0].input):
+                        if inp == output_name:
+                            consumers[0].input[i] = hook_input
+                else:
+                    for i, graph_out in enumerate(graph.output):
+                        if graph_out.name == output_name:
+                            hook_out_vi = model.get_tensor_valueinfo(hook_input)
+                            graph.output.remove(graph_out)
+                            graph.output.insert(i, hook_out_vi)
+                            graph.value_info.remove(hook_out_vi)
+                            outputs_replaced = True
+                            break
+                graph_modified = True
 
-        return (model, graph_modified)
+        if graph_modified:
+            model = model.transform(GiveUniqueNodeNames())
+            if outputs_replaced:
+                model = model.transform(GiveReadableTensorNames())
+        # all hooks are inserted in one pass, no need to rerun
+        return (model, False)
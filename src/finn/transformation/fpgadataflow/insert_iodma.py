@@ -243,6 +243,14 @@ class InsertIODMA(Transformation):
                     domain="finn.custom_op.fpgadataflow.hls",
                     backend="fpgadataflow",
                 )
+                if fc_node.op_type == "MVAU_hls" and fc_inst.uses_batch_tiled_weights():
+                    # fetch the weights once per group of frames and replay
+                    # each tile (one neuron fold) for the whole group
+                    dma_inst = getCustomOp(dma_node)
+                    dma_inst.set_nodeattr("burstMode", "prefetch")
+                    dma_inst.set_nodeattr("prefetchTileWords", fc_inst.get_nodeattr("MW") // simd)
+                    dma_inst.set_nodeattr("prefetchReplays", fc_inst.get_weight_reuse_group())
+                    dma_inst.set_nodeattr("prefetchFrames", fc_inst.get_nodeattr("weightReuse"))
                 fc_node.input[1] = fc_node_in.name
                 model.graph.node.insert(0, dma_node)
                 # expand inFIFODepths for new second input of node
@@ -0,0 +1,275 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import warnings
+from math import gcd
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.base import Transformation
+from qonnx.transformation.infer_datatypes import InferDataTypes
+from qonnx.transformation.infer_shapes import InferShapes
+
+from finn.util.winograd import BT, transform_range, transform_weights
+
+
+def _range_datatype(lo, hi):
+    """Returns the smallest integer DataType covering [lo, hi]."""
+    if lo >= 0:
+        return DataType.get_smallest_possible(hi)
+    return DataType.get_smallest_possible(min(lo, -hi - 1))
+
+
+def _matmul_range(w, lo, hi):
+    """Returns the (min, max) over all columns of x @ w when all elements of
+    x are in [lo, hi]."""
+    pos = np.where(w > 0, w, 0).sum(axis=-2)
+    neg = np.where(w < 0, w, 0).sum(axis=-2)
+    return int((pos * lo + neg * hi).min()), int((pos * hi + neg * lo).max())
+
+
+class LowerConvsToWinograd(Transformation):
+    """Lower 3x3, stride-1 convolutions (a ConvolutionInputGenerator feeding an
+    MVAU) whose MVAU has winograd=1 to Winograd F(2x2, 3x3), i.e. a
+    WinogradInputTransform, a WinogradMVAU and a WinogradOutputTransform, plus
+    a Thresholding layer if the MVAU had an activation. This needs 16
+    multiplications per 2x2 output tile and channel pair instead of 36.
+    Works on HW abstraction layers as well as on specialized layers, so that
+    winograd can be set per layer from the folding config; specialized MVAUs
+    are replaced by HLS layers. The transformed weights are always embedded.
+
+    The weight transform is scaled to integers, so the lowering is exact as
+    long as the weights are integers. It does however widen the multiplier
+    operands: transformed inputs by 2 bits, transformed weights by up to 4.
+    Layers with non-integer weights or operands wider than max_operand_width
+    bits after the transform are left as direct convolutions, as are layers
+    with an odd output size, external or runtime-writeable weights or
+    xnor-popcount mode."""
+
+    def __init__(self, max_operand_width=18):
+        super().__init__()
+        self.max_operand_width = max_operand_width
+
+    def check_layer(self, model, swg, node):
+        """Returns None if the SWG + MVAU pair can be lowered, otherwise the
+        reason why not."""
+        if swg is None or not swg.op_type.startswith("ConvolutionInputGenerator"):
+            return "not fed by a ConvolutionInputGenerator"
+        if model.find_consumers(swg.output[0]) != [node]:
+            return "ConvolutionInputGenerator has other consumers"
+        swg_inst = getCustomOp(swg)
+        mvau = getCustomOp(node)
+        if list(swg_inst.get_nodeattr("ConvKernelDim")) != [3, 3]:
+            return "kernel is not 3x3"
+        if list(swg_inst.get_nodeattr("Stride")) != [1, 1]:
+            return "stride is not 1"
+        if list(swg_inst.get_nodeattr("Dilation")) != [1, 1]:
+            return "dilation is not 1"
+        if swg_inst.get_nodeattr("depthwise") == 1:
+            return "convolution is depthwise"
+        ofm_h, ofm_w = swg_inst.get_nodeattr("OFMDim")
+        if ofm_h % 2 != 0 or ofm_w % 2 != 0:
+            return "output size is odd"
+        if mvau.get_nodeattr("binaryXnorMode") == 1:
+            return "xnor-popcount mode"
+        if mvau.get_nodeattr("mem_mode") == "external":
+            return "weights are external"
+        if mvau.get_nodeattr("runtime_writeable_weights") == 1:
+            return "weights are runtime-writeable"
+        idt = mvau.get_input_datatype()
+        if not idt.is_integer() or idt == DataType["BIPOLAR"]:
+            return "input is not a non-bipolar integer"
+        W = model.get_initializer(node.input[1])
+        if not (W == np.round(W)).all():
+            return "weights are not integers"
+        return None
+
+    def apply(self, model):
+        graph = model.graph
+        # collect layers first, the graph is modified below
+        candidates = []
+        for node in graph.node:
+            if node.op_type not in ["MVAU", "MVAU_hls", "MVAU_rtl"]:
+                continue
+            if getCustomOp(node).get_nodeattr("winograd") != 1:
+                continue
+            swg = model.find_producer(node.input[0])
+            reason = self.check_layer(model, swg, node)
+            if reason is not None:
+                warnings.warn("%s stays a direct convolution: %s" % (node.name, reason))
+                continue
+            candidates.append((swg, node))
+
+        graph_modified = False
+        for swg, node in candidates:
+            swg_inst = getCustomOp(swg)
+            mvau = getCustomOp(node)
+            ch = swg_inst.get_nodeattr("IFMChannels")
+            mh = mvau.get_nodeattr("MH")
+            idt = mvau.get_input_datatype()
+            # MVAU weights are (kh, kw, ch) x mh, transform as (mh, ch, kh, kw)
+            W = model.get_initializer(node.input[1])
+            g = W.reshape(3, 3, ch, mh).transpose(3, 2, 0, 1)
+            U = transform_weights(g)
+            udt = _range_datatype(int(U.min()), int(U.max()))
+            vlo, vhi = transform_range(BT, idt.min(), idt.max())
+            vdt = _range_datatype(vlo, vhi)
+            if max(udt.bitwidth(), vdt.bitwidth()) > self.max_operand_width:
+                warnings.warn(
+                    "%s stays a direct convolution: transformed operands would need %s x %s"
+                    % (node.name, str(vdt), str(udt))
+                )
+                continue
+            mdt = _range_datatype(*_matmul_range(U, vlo, vhi))
+            ydt = _range_datatype(*_matmul_range(W, idt.min(), idt.max()))
+
+            if node.op_type == "MVAU":
+                suffix = ""
+                domain = "finn.custom_op.fpgadataflow"
+            else:
+                suffix = "_hls"
+                domain = "finn.custom_op.fpgadataflow.hls"
+            ifm_h, ifm_w = swg_inst.get_nodeattr("IFMDim")
+            ofm_h, ofm_w = swg_inst.get_nodeattr("OFMDim")
+            tiles = [ofm_h // 2, ofm_w // 2]
+            pe = mvau.get_nodeattr("PE")
+
+            v_tensor = model.make_new_valueinfo_name()
+            m_tensor = model.make_new_valueinfo_name()
+            u_tensor = model.make_new_valueinfo_name()
+            for tname, shape, dt in [
+                (v_tensor, [1] + tiles + [16, ch], vdt),
+                (m_tensor, [1] + tiles + [16, mh], mdt),
+            ]:
+                graph.value_info.append(
+                    helper.make_tensor_value_info(tname, TensorProto.FLOAT, shape)
+                )
+                model.set_tensor_datatype(tname, dt)
+            model.set_initializer(u_tensor, U.astype(np.float32))
+            model.set_tensor_datatype(u_tensor, udt)
+
+            new_nodes = [
+                helper.make_node(
+                    "WinogradInputTransform" + suffix,
+                    [swg.input[0]],
+                    [v_tensor],
+                    domain=domain,
+                    backend="fpgadataflow",
+                    name="WinogradInputTransform_" + node.name,
+                    SIMD=swg_inst.get_nodeattr("SIMD"),
+                    NumChannels=ch,
+                    IFMDim=[ifm_h, ifm_w],
+                    inputDataType=idt.name,
+                    outputDataType=vdt.name,
+                ),
+                helper.make_node(
+                    "WinogradMVAU" + suffix,
+                    [v_tensor, u_tensor],
+                    [m_tensor],
+                    domain=domain,
+                    backend="fpgadataflow",
+                    name="WinogradMVAU_" + node.name,
+                    SIMD=gcd(mvau.get_nodeattr("SIMD"), ch),
+                    PE=pe,
+                    MW=ch,
+                    MH=mh,
+                    Tiles=tiles,
+                    resType=mvau.get_nodeattr("resType"),
+                    inputDataType=vdt.name,
+                    weightDataType=udt.name,
+                    outputDataType=mdt.name,
+                ),
+            ]
+            if mvau.get_nodeattr("noActivation") == 1:
+                y_tensor = node.output[0]
+            else:
+                y_tensor = model.make_new_valueinfo_name()
+                graph.value_info.append(
+                    helper.make_tensor_value_info(
+                        y_tensor, TensorProto.FLOAT, [1, ofm_h, ofm_w, mh]
+                    )
+                )
+                model.set_tensor_datatype(y_tensor, ydt)
+            new_nodes.append(
+                helper.make_node(
+                    "WinogradOutputTransform" + suffix,
+                    [m_tensor],
+                    [y_tensor],
+                    domain=domain,
+                    backend="fpgadataflow",
+                    name="WinogradOutputTransform_" + node.name,
+                    PE=pe,
+                    NumChannels=mh,
+                    OFMDim=[ofm_h, ofm_w],
+                    inputDataType=mdt.name,
+                    outputDataType=ydt.name,
+                )
+            )
+            if mvau.get_nodeattr("noActivation") == 0:
+                # thresholds outside the (now exact) output range act the
+                # same when clipped to it
+                T = model.get_initializer(node.input[2])
+                T = np.clip(T, ydt.min(), ydt.max() + 1)
+                model.set_initializer(node.input[2], T)
+                tdt = _range_datatype(int(min(T.min(), ydt.min())), int(ydt.max() + 1))
+                model.set_tensor_datatype(node.input[2], tdt)
+                new_nodes.append(
+                    helper.make_node(
+                        "Thresholding" + suffix,
+                        [y_tensor, node.input[2]],
+                        [node.output[0]],
+                        domain=domain,
+                        backend="fpgadataflow",
+                        name="Thresholding_" + node.name,
+                        NumChannels=mh,
+                        PE=pe,
+                        numSteps=T.shape[1],
+                        inputDataType=ydt.name,
+                        weightDataType=tdt.name,
+                        outputDataType=mvau.get_nodeattr("outputDataType"),
+                        numInputVectors=[1, ofm_h, ofm_w],
+                        ActVal=mvau.get_nodeattr("ActVal"),
+                    )
+                )
+            insert_point = list(graph.node).index(swg)
+            for i, new_node in enumerate(new_nodes):
+                graph.node.insert(insert_point + i, new_node)
+            # remove old nodes
+            graph.node.remove(swg)
+            graph.node.remove(node)
+            graph_modified = True
+
+        if graph_modified:
+            model = model.transform(InferShapes())
+            model = model.transform(InferDataTypes())
+        # all candidates are collected before the graph is modified, so a
+        # single pass lowers every eligible layer. Another pass would find
+        # nothing new and only repeat the warnings for rejected layers.
+        return (model, False)
@@ -26,6 +26,7 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import json
 import numpy as np
 import os
 import qonnx
@@ -43,6 +44,7 @@ from finn.util.data_packing import (
     hexstring2npbytearray,
     pack_innermost_dim_as_hex_string,
 )
+from finn.util.fpgadataflow import weight_reuse_batch_multiple
 
 from . import template_driver
 
@@ -235,7 +237,8 @@ class MakePYNQDriver(Transformation):
                 df_model = ModelWrapper(sdp_inst.get_nodeattr("model"))
                 assert df_model.graph.node[0].op_type == "IODMA_hls"
                 iodma_node = getCustomOp(df_model.graph.node[0])
-                if iodma_node.get_nodeattr("burstMode") == "wrap":  # input weights dma?
+                # input weights dma?
+                if iodma_node.get_nodeattr("burstMode") in ["wrap", "prefetch"]:
                     init_tensor = df_model.get_initializer(iodma_node.onnx_node.input[0])
                     ext_weight_dma_cnt += 1
                     w_dtype = df_model.get_tensor_datatype(iodma_node.onnx_node.input[0])
@@ -243,6 +246,43 @@ class MakePYNQDriver(Transformation):
                     np.save(weights_dir + "/" + idma_name + ".npy", init_external_tensor)
                 idma_idx += 1
 
+        # memory banks the DMAs were connected to at link time
+        dma_mem_bank = {}
+        for node in model.graph.node:
+            sdp_inst = getCustomOp(node)
+            instance_name = sdp_inst.get_nodeattr("instance_name")
+            mem_port = sdp_inst.get_nodeattr("mem_port")
+            if instance_name != "" and mem_port != "":
+                dma_mem_bank[instance_name] = mem_port
+
+        # hook layers inside the dataflow partitions, addressed through the
+        # AXI lite interfaces the partitions expose for them
+        hooks = {}
+        for node in model.graph.node:
+            sdp_inst = getCustomOp(node)
+            df_model = ModelWrapper(sdp_inst.get_nodeattr("model"))
+            ifnames = df_model.get_metadata_prop("vivado_stitch_ifnames")
+            if ifnames is None:
+                continue
+            for hook in json.loads(ifnames).get("hooks", []):
+                hook_inst = getCustomOp(df_model.get_node_from_name(hook["name"]))
+                hooks[hook["name"]] = {
+                    "hook": hook["hook"],
+                    "ip": sdp_inst.get_nodeattr("instance_name"),
+                    "axilite": hook["axilite"],
+                    "regs": hook_inst.register_offsets,
+                }
+                if hook["hook"] == "tap":
+                    hooks[hook["name"]].update(
+                        {
+                            "dtype": hook_inst.get_output_datatype().name,
+                            "folded_shape": tuple(hook_inst.get_folded_output_shape()),
+                            "normal_shape": tuple(hook_inst.get_normal_output_shape()),
+                            "mem_width": hook_inst.get_mem_width(),
+                            "slots": hook_inst.get_nodeattr("capture_slots"),
+                        }
+                    )
+
         # fill in the driver template
         driver_py = pynq_driver_dir + "/driver.py"
         driver = template_driver.pynq_driver_template
@@ -261,6 +301,9 @@ class MakePYNQDriver(Transformation):
         driver = driver.replace("$NUM_INPUTS$", str(len(idma_names)))
         driver = driver.replace("$NUM_OUTPUTS$", str(len(odma_names)))
         driver = driver.replace("$EXT_WEIGHT_NUM$", str(ext_weight_dma_cnt))
+        driver = driver.replace("$DMA_MEM_BANK$", str(dma_mem_bank))
+        driver = driver.replace("$HOOKS$", str(hooks))
+        driver = driver.replace("$BATCH_MULTIPLE$", str(weight_reuse_batch_multiple(model)))
 
         with open(driver_py, "w") as f:
             f.write(driver)
@@ -272,6 +315,13 @@ class MakePYNQDriver(Transformation):
         )
         shutil.copy(validate_template, validate_py)
 
+        # non-dataflow nodes around the accelerator, run on the host by
+        # FINNHostPipeline (see step_create_dataflow_partition)
+        for kind in ["head", "tail"]:
+            host_model_fn = model.get_metadata_prop("host_%s_model" % kind)
+            if host_model_fn is not None and os.path.isfile(host_model_fn):
+                shutil.copy(host_model_fn, pynq_driver_dir + "/host_%s.onnx" % kind)
+
         # generate weight files for runtime-writable layers
 
         for sdp_ind, sdp_node in enumerate(model.graph.node):
@@ -201,6 +201,14 @@ class MakeZYNQProject(Transformation):
                         % (instance_names[node.name], axilite_intf_name)
                     )
                     axilite_idx += 1
+                # e.g. off-chip FIFOs (StreamingFIFO impl_style=dram)
+                for aximm_intf in ifnames["aximm"]:
+                    config.append(
+                        "connect_bd_intf_net [get_bd_intf_pins %s/%s] "
+                        "[get_bd_intf_pins smartconnect_0/S%02d_AXI]"
+                        % (instance_names[node.name], aximm_intf[0], aximm_idx)
+                    )
+                    aximm_idx += 1
             sdp_node.set_nodeattr("instance_name", instance_names[node.name])
 
             config.append(
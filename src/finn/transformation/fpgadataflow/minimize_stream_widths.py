@@ -0,0 +1,280 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+import warnings
+from qonnx.core.datatype import DataType
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.base import Transformation
+from qonnx.transformation.infer_datatypes import InferDataTypes
+
+from finn.util.fpgadataflow import is_fpgadataflow_node
+
+# ops whose output values are a subset of their input values
+_passthrough_ops = [
+    "ConvolutionInputGenerator",
+    "DownSampler",
+    "DuplicateStreams",
+    "StreamingConcat",
+    "StreamingDataWidthConverter",
+    "StreamingFIFO",
+    "StreamingMaxPool",
+    "UpsampleNearestNeighbour",
+]
+# ops that insert zero-valued padding around their input values
+_padding_ops = ["FMPadding", "FMPadding_Pixel"]
+# ops whose implementation is indexed by the value range of the input
+# datatype (e.g. lookup tables), so their input must not be narrowed
+_dtype_sensitive_ops = [
+    "Lookup",
+    "LookupActivation",
+    "StreamingLayerNorm",
+    "StreamingSoftmax",
+]
+# ops that use a single datatype for all of their inputs
+_shared_input_dtype_ops = ["AddStreams", "StreamingConcat"]
+
+
+def _base_op_type(node):
+    """Returns the op_type of node without the _hls/_rtl specialization."""
+    op_type = node.op_type
+    for suffix in ["_hls", "_rtl"]:
+        if op_type.endswith(suffix):
+            return op_type[: -len(suffix)]
+    return op_type
+
+
+def _range_datatype(lo, hi, signed):
+    """Returns the narrowest integer DataType covering [lo, hi] with the given
+    signedness."""
+    lo, hi = int(lo), int(hi)
+    if signed:
+        bits = max(-lo - 1, hi, 0).bit_length() + 1
+        return DataType["INT%d" % bits]
+    return DataType["UINT%d" % max(1, hi.bit_length())]
+
+
+def _accumulator_range(weights, lo, hi):
+    """Returns per-output (min, max) arrays of a dot product between the columns
+    of weights (shape [K, N]) and inputs in [lo, hi]. Every term is widened to
+    include zero, so the bounds also hold for all partial sums."""
+    weights = weights.astype(np.float64)
+    t_lo = np.minimum(weights * lo, weights * hi)
+    t_hi = np.maximum(weights * lo, weights * hi)
+    acc_lo = np.minimum(t_lo, 0).sum(axis=0)
+    acc_hi = np.maximum(t_hi, 0).sum(axis=0)
+    return (acc_lo, acc_hi)
+
+
+def _threshold_range(thresholds, acc_lo, acc_hi, act_val):
+    """Returns the output range of a multithreshold activation with the given
+    per-channel thresholds (shape [C, steps] or [1, steps]) and per-channel
+    input bounds, output = act_val + number of thresholds <= input."""
+    n_ch = max(thresholds.shape[0], np.size(acc_lo))
+    thresholds = np.broadcast_to(thresholds, (n_ch, thresholds.shape[1]))
+    acc_lo = np.broadcast_to(acc_lo, (n_ch,))
+    acc_hi = np.broadcast_to(acc_hi, (n_ch,))
+    cnt_lo = (thresholds <= acc_lo[:, None]).sum(axis=1).min()
+    cnt_hi = (thresholds <= acc_hi[:, None]).sum(axis=1).max()
+    return (act_val + int(cnt_lo), act_val + int(cnt_hi))
+
+
+class MinimizeStreamWidths(Transformation):
+    """Propagate value intervals through the dataflow graph and narrow the
+    DataType of intermediate streams where the interval is known to fit a
+    smaller type than the declared one, e.g. after a Thresholding layer whose
+    thresholds cannot all be crossed or after an AddStreams whose inputs are
+    bounded more tightly than their datatypes.
+
+    Intervals start from the datatypes of the graph inputs and of any tensor
+    produced by a node without a known propagation rule. Only nodes whose
+    output datatype can be set independently of their inputs are narrowed
+    (Thresholding, MVAU/VVAU, ChannelwiseOp, AddStreams); all other tensors
+    pick up the narrower types through InferDataTypes. Layers with runtime
+    writeable weights or thresholds, binary or non-integer datatypes, graph
+    outputs and tensors feeding table-based layers are left unchanged, and the
+    signedness of every stream is preserved.
+
+    Should be applied after MinimizeAccumulatorWidth, since that transformation
+    resets accumulator and output datatypes from the worst-case input range."""
+
+    def __init__(self):
+        super().__init__()
+
+    def apply(self, model):
+        graph_outputs = [x.name for x in model.graph.output]
+        graph_modified = False
+        intervals = {}
+        for node_id in range(len(model.graph.node)):
+            # InferDataTypes changes node attributes in each iteration, so
+            # always look up the node proto by its index
+            node = model.graph.node[node_id]
+            op_type = _base_op_type(node)
+            in_ranges = [self._get_range(model, intervals, x) for x in node.input]
+            out_range = None
+            if is_fpgadataflow_node(node) and in_ranges[0] is not None:
+                out_range = self._propagate(model, node, op_type, in_ranges)
+            for out in node.output:
+                declared = self._declared_range(model, out)
+                if out_range is None or declared is None:
+                    intervals[out] = declared
+                    continue
+                # never report more than the declared datatype can carry
+                lo = max(out_range[0], declared[0])
+                hi = min(out_range[1], declared[1])
+                intervals[out] = (lo, hi)
+            if out_range is None or len(node.output) != 1:
+                continue
+            out = node.output[0]
+            if out in graph_outputs or self._feeds_dtype_sensitive(model, out):
+                continue
+            odt = model.get_tensor_datatype(out)
+            # keep the signedness, since e.g. threshold comparisons of the
+            # consumers depend on it
+            new_odt = _range_datatype(*intervals[out], odt.signed())
+            if new_odt.bitwidth() < odt.bitwidth():
+                if self._narrow(model, node, op_type, new_odt):
+                    # propagate the new datatype to following layers
+                    model = model.transform(InferDataTypes())
+                    graph_modified = True
+        return (model, graph_modified)
+
+    def _declared_range(self, model, tensor):
+        dt = model.get_tensor_datatype(tensor)
+        if not dt.is_integer() or dt.bitwidth() > 32:
+            return None
+        return (int(dt.min()), int(dt.max()))
+
+    def _get_range(self, model, intervals, tensor):
+        if tensor in intervals:
+            return intervals[tensor]
+        if model.get_initializer(tensor) is not None:
+            return None
+        return self._declared_range(model, tensor)
+
+    def _feeds_dtype_sensitive(self, model, tensor):
+        for consumer in model.find_consumers(tensor):
+            op_type = _base_op_type(consumer)
+            if op_type in _dtype_sensitive_ops + _shared_input_dtype_ops:
+                return True
+            if op_type == "ChannelwiseOp":
+                # only add and mul support a changing input datatype
+                if getCustomOp(consumer).get_nodeattr("Func") not in ["add", "mul"]:
+                    return True
+            if op_type in _passthrough_ops + _padding_ops:
+                for out in consumer.output:
+                    if self._feeds_dtype_sensitive(model, out):
+                        return True
+        return False
+
+    def _propagate(self, model, node, op_type, in_ranges):
+        """Returns the (min, max) interval of the output of node given the
+        intervals of its inputs, or None if there is no rule for node."""
+        lo, hi = in_ranges[0]
+        inst = getCustomOp(node)
+        if op_type in _passthrough_ops:
+            if op_type == "StreamingConcat":
+                if any(r is None for r in in_ranges):
+                    return None
+                return (min(r[0] for r in in_ranges), max(r[1] for r in in_ranges))
+            return (lo, hi)
+        if op_type in _padding_ops:
+            return (min(lo, 0), max(hi, 0))
+        if op_type == "Pool":
+            if inst.get_nodeattr("Function") == "MaxPool":
+                return (lo, hi)
+            return None
+        if op_type == "AddStreams":
+            if in_ranges[1] is None:
+                return None
+            return (lo + in_ranges[1][0], hi + in_ranges[1][1])
+        if op_type == "GlobalAccPool":
+            n_pix = int(np.prod(inst.get_normal_input_shape()[1:-1]))
+            return (min(n_pix * lo, 0), max(n_pix * hi, 0))
+        if op_type == "ChannelwiseOp":
+            param = model.get_initializer(node.input[1])
+            func = inst.get_nodeattr("Func")
+            if param is None:
+                return None
+            if func == "add":
+                return (lo + param.min(), hi + param.max())
+            if func == "mul":
+                limits = [lo * param.min(), lo * param.max(), hi * param.min(), hi * param.max()]
+                return (min(limits), max(limits))
+            return (0, 1)
+        if op_type == "Thresholding":
+            if inst.get_nodeattr("runtime_writeable_weights"):
+                return None
+            if inst.get_output_datatype() == DataType["BIPOLAR"]:
+                return None
+            thresholds = model.get_initializer(node.input[1])
+            return _threshold_range(thresholds, lo, hi, inst.get_nodeattr("ActVal"))
+        if op_type in ["MVAU", "VVAU"]:
+            return self._propagate_mac(model, node, op_type, inst, lo, hi)
+        return None
+
+    def _propagate_mac(self, model, node, op_type, inst, lo, hi):
+        if inst.get_nodeattr("runtime_writeable_weights"):
+            return None
+        if inst.get_nodeattr("binaryXnorMode"):
+            return None
+        if not inst.get_weight_datatype().is_integer():
+            return None
+        if inst.get_output_datatype() == DataType["BIPOLAR"]:
+            return None
+        weights = model.get_initializer(node.input[1])
+        if op_type == "VVAU":
+            # put weights into [k_h * k_w, channels] layout
+            ch = inst.get_nodeattr("Channels")
+            weights = weights.reshape(ch, -1).transpose()
+        (acc_lo, acc_hi) = _accumulator_range(weights, lo, hi)
+        if inst.get_nodeattr("noActivation"):
+            return (int(acc_lo.min()), int(acc_hi.max()))
+        thresholds = model.get_initializer(node.input[2])
+        return _threshold_range(thresholds, acc_lo, acc_hi, inst.get_nodeattr("ActVal"))
+
+    def _narrow(self, model, node, op_type, new_odt):
+        """Sets the output datatype of node to new_odt. Returns False if the
+        output datatype of node can not be set independently."""
+        inst = getCustomOp(node)
+        if op_type in ["MVAU", "VVAU"]:
+            if inst.get_nodeattr("noActivation"):
+                # for no-activation nodes, output dt = acc dt
+                inst.set_nodeattr("accDataType", new_odt.name)
+        elif op_type not in ["Thresholding", "ChannelwiseOp", "AddStreams"]:
+            return False
+        elif node.op_type == "Thresholding_rtl":
+            # the RTL thresholding core derives its number of thresholds
+            # from the output width
+            return False
+        old_odt = inst.get_output_datatype()
+        inst.set_nodeattr("outputDataType", new_odt.name)
+        model.set_tensor_datatype(node.output[0], new_odt)
+        warnings.warn("Narrowing output of %s: %s -> %s" % (node.name, old_odt.name, new_odt.name))
+        return True
@@ -27,7 +27,6 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-import copy
 import multiprocessing as mp
 import os
 import qonnx.custom_op.registry as registry
@@ -84,21 +83,20 @@ class PrepareCppSim(Transformation):
         return (node, False)
 
     def apply(self, model):
-        # Remove old nodes from the current model
-        self.model = copy.deepcopy(model)
-        old_nodes = []
-        for i in range(len(model.graph.node)):
-            old_nodes.append(model.graph.node.pop())
+        # code generation only reads the model, so the workers can use it as
+        # is, with the nodes left in place until the new ones are attached
+        self.model = model
+        old_nodes = list(model.graph.node)
 
         # Execute transformation in parallel
         with mp.Pool(self._num_workers) as p:
             new_nodes_and_bool = p.map(self.prepareCppSim_node, old_nodes, chunksize=1)
+        self.model = None
 
-        # extract nodes and check if the transformation needs to run again
-        # Note: .pop() had initially reversed the node order
+        # replace the nodes and check if the transformation needs to run again
+        del model.graph.node[:]
         run_again = False
-        for node, run in reversed(new_nodes_and_bool):
-            # Reattach new nodes to old model
+        for node, run in new_nodes_and_bool:
             model.graph.node.append(node)
             if run is True:
                 run_again = True
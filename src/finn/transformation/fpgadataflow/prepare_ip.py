@@ -32,7 +32,7 @@ import qonnx.custom_op.registry as registry
 import warnings
 from qonnx.transformation.base import Transformation
 
-from finn.util.basic import make_build_dir
+from finn.util.build_dirs import build_dir_lock, make_node_build_dir
 from finn.util.fpgadataflow import is_hls_node, is_rtl_node
 
 
@@ -48,10 +48,13 @@ def _codegen_single_node(node, model, fpgapart, clk):
         code_gen_dir = inst.get_nodeattr("code_gen_dir_ipgen")
         # ensure that there is a directory
         if code_gen_dir == "" or not os.path.isdir(code_gen_dir):
-            code_gen_dir = make_build_dir(prefix="code_gen_ipgen_" + str(node.name) + "_")
+            code_gen_dir = make_node_build_dir(
+                "code_gen_ipgen_" + str(node.name) + "_", "ipgen", model, node, fpgapart, clk
+            )
             inst.set_nodeattr("code_gen_dir_ipgen", code_gen_dir)
             # ensure that there is generated code inside the dir
-            inst.code_generation_ipgen(model, fpgapart, clk)
+            with build_dir_lock(code_gen_dir):
+                inst.code_generation_ipgen(model, fpgapart, clk)
         else:
             warnings.warn("Using pre-existing code for %s" % node.name)
     except KeyError:
@@ -0,0 +1,384 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import copy
+import numpy as np
+import os
+import re
+import subprocess
+from concurrent.futures import ThreadPoolExecutor
+from qonnx.core.datatype import DataType
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.base import Transformation
+from qonnx.util.basic import get_num_default_workers
+
+from finn.custom_op.fpgadataflow import templates
+from finn.util.basic import clone_model, get_finn_root, make_build_dir
+from finn.util.fpgadataflow import is_hls_node, is_rtl_node
+
+# nodes that only forward their input words, simulated by a pass-through model
+passthrough_op_types = ["StreamingFIFO_rtl", "TLastMarker_hls"]
+# nodes simulated by the data width converter model
+dwc_op_types = ["StreamingDataWidthConverter_rtl"]
+# RTL compute nodes without a C++ model, simulated through their HLS variant
+hls_stand_ins = {
+    "MVAU_rtl": "MVAU_hls",
+    "VVAU_rtl": "VVAU_hls",
+    "Thresholding_rtl": "Thresholding_hls",
+    "FMPadding_rtl": "FMPadding_hls",
+    "ConvolutionInputGenerator_rtl": "ConvolutionInputGenerator_hls",
+}
+
+
+def _cpp_name(name):
+    return re.sub(r"[^0-9a-zA-Z_]", "_", name)
+
+
+def _stream_type(decls, port):
+    """Returns the element type of the hls::stream declared for the given port
+    in the $STREAMDECLARATIONS$ of a node, or None if there is none."""
+    pattern = re.compile(r"hls::stream<(.*)>\s*%s\s*[\(;]" % re.escape(port))
+    for decl in decls:
+        m = pattern.search(decl)
+        if m is not None:
+            return m.group(1).strip()
+    return None
+
+
+def _uses_port(code, port):
+    return re.search(r"\b%s\b" % re.escape(port), code) is not None
+
+
+def _type_width(stream_type):
+    m = re.match(r"ap_uint<\s*(\d+)\s*>$", stream_type)
+    return int(m.group(1)) if m is not None else 0
+
+
+def _io_elem_types(dt):
+    # bipolar values are exchanged as binary, like in cppsim
+    if dt == DataType["BIPOLAR"]:
+        dt = DataType["BINARY"]
+    return dt.get_hls_datatype_str(), dt.bitwidth()
+
+
+class PrepareStitchedCppSim(Transformation):
+    """Assemble the functional C++ (cppsim) models of all nodes into a single
+    executable that simulates the whole dataflow graph in the topology that
+    CreateStitchedIP stitches: each node output stream is connected to the
+    consumer input it feeds, and graph inputs/outputs become the top-level
+    streams. HLS nodes use their own cppsim code, FIFOs and TLastMarkers a
+    pass-through model and RTL data width converters a bit-exact width
+    conversion model. RTL compute nodes are simulated through their HLS
+    variant (see hls_stand_ins). All nodes run concurrently as threads
+    connected by thread-safe hls::streams, one process for the whole graph.
+
+    Only the functional behavior is simulated: stream contents match the
+    stitched design, but FIFO depths and timing are not modelled.
+
+    Outcome if successful: sets the stitched_cppsim_exe metadata property to
+    the compiled executable, used by execute_onnx when the exec_mode metadata
+    property is set to "stitched_cppsim"."""
+
+    def __init__(self, num_workers=None):
+        super().__init__()
+        if num_workers is None:
+            self._num_workers = get_num_default_workers()
+        else:
+            self._num_workers = num_workers
+        if self._num_workers <= 0:
+            self._num_workers = os.cpu_count()
+
+    def _hls_node_function(self, model, node, node_dir):
+        """Generates the cppsim code of the given HLS node as a function with
+        its stream interfaces as arguments. Returns the function name, the
+        (name, type) lists of its input and output ports and the source file."""
+        inst = getCustomOp(node)
+        inst.set_nodeattr("code_gen_dir_cppsim", node_dir)
+        inst.code_gen_dict["$AP_INT_MAX_W$"] = [str(inst.get_ap_int_max_w())]
+        inst.generate_params(model, node_dir)
+        inst.global_includes()
+        inst.defines("cppsim")
+        inst.read_npy_data()
+        inst.strm_decl()
+        inst.pragmas()
+        inst.docompute()
+        intf_names = inst.get_verilog_top_module_intf_names()
+        ports = {
+            "in": [x[0] for x in intf_names["s_axis"]],
+            "out": [x[0] for x in intf_names["m_axis"]],
+        }
+        decls = inst.code_gen_dict["$STREAMDECLARATIONS$"]
+        port_types = {}
+        for port in ports["in"] + ports["out"]:
+            port_type = _stream_type(decls, port)
+            if port_type is None:
+                raise Exception(
+                    "Found no stream declaration for port %s of node %s" % (port, node.name)
+                )
+            port_types[port] = port_type
+        # the ports become function arguments: drop their declarations and
+        # any reading of cppsim input files into them
+        code = dict(inst.code_gen_dict)
+        for key in ["$STREAMDECLARATIONS$", "$READNPYDATA$"]:
+            code[key] = [
+                x for x in code.get(key, []) if not any(_uses_port(x, p) for p in port_types)
+            ]
+        fxn_name = "stitched_" + _cpp_name(node.name)
+        args = ["hls::stream<%s> &%s" % (port_types[p], p) for p in ports["in"] + ports["out"]]
+        code["$NODEFUNCTION$"] = ["void %s(%s)" % (fxn_name, ", ".join(args))]
+        template = templates.stitched_cppsim_node_template
+        for key in re.findall(r"\$[A-Z_]+\$", template):
+            template = template.replace(key, "\n".join(code.get(key, [])))
+        src = os.path.join(node_dir, "%s.cpp" % fxn_name)
+        with open(src, "w") as f:
+            f.write(template)
+        in_ports = [(p, port_types[p]) for p in ports["in"]]
+        out_ports = [(p, port_types[p]) for p in ports["out"]]
+        return code["$NODEFUNCTION$"][0], fxn_name, in_ports, out_ports, src
+
+    def _compile(self, build_dir, sources, exe):
+        finn_root = get_finn_root()
+        flags = [
+            "--std=c++14",
+            "-O3",
+            "-pthread",
+            "-DHLS_STREAM_THREAD_SAFE",
+            "-I%s/src/finn/qnn-data/cpp" % finn_root,
+            "-I%s/deps/cnpy/" % finn_root,
+            "-I%s/deps/finn-hlslib" % finn_root,
+            "-I%s/custom_hls" % finn_root,
+            "-I%s/include" % os.environ["HLS_PATH"],
+        ]
+        sources = sources + ["%s/deps/cnpy/cnpy.cpp" % finn_root]
+
+        def compile_one(src):
+            obj = os.path.join(build_dir, _cpp_name(os.path.relpath(src, "/")) + ".o")
+            cmd = ["g++", "-c", src, "-o", obj] + flags
+            ret = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+            with open(obj[:-2] + ".log", "wb") as f:
+                f.write(ret.stdout)
+            if ret.returncode != 0:
+                raise Exception(
+                    "Stitched cppsim compilation of %s failed, see %s.log" % (src, obj[:-2])
+                )
+            return obj
+
+        with ThreadPoolExecutor(self._num_workers) as p:
+            objs = list(p.map(compile_one, sources))
+        # node objects only share templates and internal-linkage parameters,
+        # any other symbol defined twice is an error
+        cmd = ["g++", "-o", exe] + objs + ["-lz", "-pthread"]
+        ret = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if ret.returncode != 0:
+            raise Exception("Stitched cppsim linking failed:\n" + ret.stdout.decode("utf-8"))
+
+    def apply(self, model):
+        # code generation sets node attributes, keep those to the copy
+        gen_model = clone_model(model)
+        build_dir = make_build_dir(prefix="stitched_cppsim_")
+        decls = []
+        reads = []
+        writes = []
+        # simulation stages of each node, in node order so that they can also
+        # run sequentially
+        stages = {}
+        fxn_decls = []
+        sources = []
+        widths = [1]
+        # stream variable feeding each (node name, input index) and
+        # produced by each (node name, output index)
+        in_streams = {}
+        out_streams = {}
+        in_types = {}
+        out_types = {}
+
+        def declare(name, stream_type):
+            decls.append('    hls::stream<%s> %s("%s");' % (stream_type, name, name))
+            widths.append(_type_width(stream_type))
+
+        for node in gen_model.graph.node:
+            inst = getCustomOp(node)
+            if node.op_type == "IODMA_hls":
+                raise Exception("Stitched cppsim cannot simulate IODMA node %s" % node.name)
+            if node.op_type in passthrough_op_types + dwc_op_types:
+                if node.op_type == "TLastMarker_hls":
+                    iw = ow = inst.get_nodeattr("StreamWidth")
+                    n_words = inst.get_nodeattr("NumIters")
+                elif node.op_type == "StreamingFIFO_rtl":
+                    # the FIFO IP carries the AXI stream width padded to bytes
+                    iw = inst.get_instream_width_padded()
+                    ow = inst.get_outstream_width_padded()
+                    n_words = int(np.prod(inst.get_folded_input_shape()[:-1]))
+                else:
+                    iw = inst.get_instream_width()
+                    ow = inst.get_outstream_width()
+                    n_words = int(np.prod(inst.get_folded_input_shape()[:-1]))
+                in_types[(node.name, 0)] = "ap_uint<%d>" % iw
+                out_types[(node.name, 0)] = "ap_uint<%d>" % ow
+                if node.op_type in dwc_op_types:
+                    model_call = "StreamDwcModel<%d, %d>" % (iw, ow)
+                    widths.append(iw + ow)
+                else:
+                    model_call = "StreamPassThroughModel<ap_uint<%d>, ap_uint<%d>>" % (iw, ow)
+                stages[node.name] = [
+                    (
+                        "%s(%%(in0)s, %%(out0)s, batch * %d);" % (model_call, n_words),
+                        node.name,
+                        1,
+                        1,
+                    )
+                ]
+                continue
+            if is_rtl_node(node) and node.op_type in hls_stand_ins:
+                stand_in = copy.deepcopy(node)
+                stand_in.op_type = hls_stand_ins[node.op_type]
+                stand_in.domain = "finn.custom_op.fpgadataflow.hls"
+                hls_node = stand_in
+            elif is_hls_node(node):
+                hls_node = node
+            else:
+                raise Exception(
+                    "Stitched cppsim has no C++ model for node %s (%s)" % (node.name, node.op_type)
+                )
+            node_dir = os.path.join(build_dir, _cpp_name(node.name))
+            os.makedirs(node_dir, exist_ok=True)
+            fxn_decl, fxn_name, in_ports, out_ports, src = self._hls_node_function(
+                gen_model, hls_node, node_dir
+            )
+            fxn_decls.append(fxn_decl + ";")
+            sources.append(src)
+            for i, (port, port_type) in enumerate(in_ports):
+                in_types[(node.name, i)] = port_type
+            for o, (port, port_type) in enumerate(out_ports):
+                out_types[(node.name, o)] = port_type
+            args = ["%%(in%d)s" % i for i in range(len(in_ports))]
+            args += ["%%(out%d)s" % o for o in range(len(out_ports))]
+            stages[node.name] = [
+                (
+                    "for(size_t b = 0; b < batch; b++) %s(%s);" % (fxn_name, ", ".join(args)),
+                    node.name,
+                    len(in_ports),
+                    len(out_ports),
+                )
+            ]
+
+        # connect the streams like CreateStitchedIP does
+        graph_inputs = [x.name for x in gen_model.graph.input]
+        graph_outputs = [x.name for x in gen_model.graph.output]
+        for node in gen_model.graph.node:
+            inst = getCustomOp(node)
+            for o, tensor in enumerate(node.output):
+                if (node.name, o) not in out_types:
+                    continue
+                src_type = out_types[(node.name, o)]
+                stream = "s_%s_%d" % (_cpp_name(node.name), o)
+                declare(stream, src_type)
+                out_streams[(node.name, o)] = stream
+                consumers = gen_model.find_consumers(tensor)
+                if tensor in graph_outputs:
+                    assert len(consumers) == 0, "Graph output %s must not be consumed" % tensor
+                    o_ind = graph_outputs.index(tensor)
+                    odt = gen_model.get_tensor_datatype(tensor)
+                    elem_type, elem_bits = _io_elem_types(odt)
+                    oshape = list(inst.get_folded_output_shape(o))[1:]
+                    writes.append(
+                        "    apintstream2npy<%s, %s, %d, float>(%s, {batch%s}, "
+                        '(npy_dir + "/output_%d.npy").c_str(), false);'
+                        % (
+                            src_type,
+                            elem_type,
+                            elem_bits,
+                            stream,
+                            "".join([", %d" % x for x in oshape]),
+                            o_ind,
+                        )
+                    )
+                    continue
+                assert len(consumers) == 1, "Stream %s must have a single consumer" % tensor
+                consumer = consumers[0]
+                i = list(consumer.input).index(tensor)
+                dst_type = in_types[(consumer.name, i)]
+                if dst_type != src_type:
+                    # e.g. padded vs. unpadded widths on either side
+                    dst_stream = stream + "_r"
+                    declare(dst_stream, dst_type)
+                    n_words = int(np.prod(inst.get_folded_output_shape(o)[:-1]))
+                    stages[node.name].append(
+                        (
+                            "StreamPassThroughModel<%s, %s>(%s, %s, batch * %d);"
+                            % (src_type, dst_type, stream, dst_stream, n_words),
+                            None,
+                            0,
+                            0,
+                        )
+                    )
+                    stream = dst_stream
+                in_streams[(consumer.name, i)] = stream
+        for i_ind, tensor in enumerate(graph_inputs):
+            consumer = gen_model.find_consumer(tensor)
+            assert consumer is not None, "Graph input %s is not consumed" % tensor
+            i = list(consumer.input).index(tensor)
+            stream_type = in_types[(consumer.name, i)]
+            stream = "s_input_%d" % i_ind
+            declare(stream, stream_type)
+            in_streams[(consumer.name, i)] = stream
+            elem_type, elem_bits = _io_elem_types(gen_model.get_tensor_datatype(tensor))
+            reads.append(
+                '    npy2apintstream<%s, %s, %d, float>((npy_dir + "/input_%d.npy").c_str(), '
+                "%s, false);" % (stream_type, elem_type, elem_bits, i_ind, stream)
+            )
+
+        stage_lines = []
+        for call, node_name, n_in, n_out in [
+            x for node in gen_model.graph.node for x in stages[node.name]
+        ]:
+            if node_name is not None:
+                streams = {}
+                for i in range(n_in):
+                    streams["in%d" % i] = in_streams[(node_name, i)]
+                for o in range(n_out):
+                    streams["out%d" % o] = out_streams[(node_name, o)]
+                call = call % streams
+            stage_lines.append("        [&]() { %s }," % call)
+
+        main = templates.stitched_cppsim_main_template
+        main = main.replace("$AP_INT_MAX_W$", str(max(widths)))
+        main = main.replace("$NODEFUNCTIONS$", "\n".join(fxn_decls))
+        main = main.replace("$STREAMDECLARATIONS$", "\n".join(decls))
+        main = main.replace("$READNPYDATA$", "\n".join(reads))
+        main = main.replace("$STAGES$", "\n".join(stage_lines))
+        main = main.replace("$DATAOUTSTREAM$", "\n".join(writes))
+        main_src = os.path.join(build_dir, "stitched_main.cpp")
+        with open(main_src, "w") as f:
+            f.write(main)
+
+        exe = os.path.join(build_dir, "stitched_model")
+        self._compile(build_dir, sources + [main_src], exe)
+        model.set_metadata_prop("stitched_cppsim_exe", exe)
+        return (model, False)
@@ -0,0 +1,128 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import hashlib
+import numpy as np
+from onnx import AttributeProto
+from qonnx.transformation.base import NodeLocalTransformation
+
+from finn.util.fpgadataflow import is_hls_node, sim_only_attrs
+from finn.util.job_scheduler import Job, JobScheduler, get_build_hosts, get_job_history
+
+
+def node_job_key(kind, model, node):
+    """Returns a key identifying the job of given kind for the node across
+    builds: a hash over op type, attributes and parameter shapes. Attributes
+    that do not affect the hardware (sim_only_attrs) and string attributes
+    holding paths, which differ between builds, are left out."""
+    h = hashlib.sha1()
+    h.update(("%s:%s" % (kind, node.op_type)).encode())
+    for attr in sorted(node.attribute, key=lambda a: a.name):
+        if attr.name in sim_only_attrs:
+            continue
+        if attr.type == AttributeProto.STRING and b"/" in attr.s:
+            continue
+        h.update(attr.SerializeToString())
+    for inp in node.input:
+        init = model.get_initializer(inp)
+        if init is not None:
+            h.update(str(init.shape).encode())
+    return "%s:%s:%s" % (kind, node.op_type, h.hexdigest())
+
+
+def node_job_cost(model, node):
+    """Returns the number of parameters of the node as a size proxy for its
+    job, used to order jobs that have no runtime history yet."""
+    cost = 0
+    for inp in node.input:
+        init = model.get_initializer(inp)
+        if init is not None:
+            cost += int(np.prod(init.shape))
+    return cost
+
+
+class ScheduledNodeLocalTransformation(NodeLocalTransformation):
+    """NodeLocalTransformation running applyNodeLocal for the selected nodes as
+    jobs of the JobScheduler instead of a fixed-order worker pool: longest
+    predicted runtime first, within the memory budget of the build hosts.
+    Predictions come from the runtime and peak memory of previous builds in
+    the job history, see finn.util.job_scheduler.get_job_history. Build
+    hosts are configured through FINN_BUILD_HOSTS, by default num_workers
+    slots on this machine.
+
+    Subclasses set job_kind to tell their jobs apart in the history and
+    default_job_mem (bytes) for jobs without history."""
+
+    job_kind = "node_local"
+    default_job_mem = 2 * 2**30
+
+    def is_job(self, node):
+        """Whether applyNodeLocal runs as a scheduled job for the node, other
+        nodes are processed in place. Subclasses also process nodes in place
+        whose outputs already exist, so that only jobs that do the actual
+        work end up in the job history."""
+        return is_hls_node(node)
+
+    def apply(self, model):
+        old_nodes = []
+        for i in range(len(model.graph.node)):
+            old_nodes.append(model.graph.node.pop())
+        old_nodes.reverse()
+
+        new_nodes_and_bool = [None] * len(old_nodes)
+        jobs = []
+        job_inds = []
+        for ind, node in enumerate(old_nodes):
+            if self.is_job(node):
+                job = Job(
+                    node_job_key(self.job_kind, model, node),
+                    self.applyNodeLocal,
+                    (node,),
+                    group="%s:%s" % (self.job_kind, node.op_type),
+                    cost=node_job_cost(model, node),
+                )
+                jobs.append(job)
+                job_inds.append(ind)
+            else:
+                new_nodes_and_bool[ind] = self.applyNodeLocal(node)
+
+        scheduler = JobScheduler(
+            get_build_hosts(self._num_workers),
+            get_job_history(),
+            default_mem=self.default_job_mem,
+        )
+        for ind, ret in zip(job_inds, scheduler.run(jobs)):
+            new_nodes_and_bool[ind] = ret
+
+        run_again = False
+        for node, run in new_nodes_and_bool:
+            model.graph.node.append(node)
+            if run is True:
+                run_again = True
+        return (model, run_again)
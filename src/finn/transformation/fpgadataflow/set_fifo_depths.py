@@ -40,8 +40,10 @@ from qonnx.transformation.general import (
     GiveUniqueNodeNames,
     SortGraph,
 )
+from qonnx.util.basic import roundup_to_integer_multiple
 
 from finn.analysis.fpgadataflow.dataflow_performance import dataflow_performance
+from finn.custom_op.fpgadataflow.rtl.streamingfifo_rtl import dram_fifo_max_width
 from finn.transformation.fpgadataflow.annotate_cycles import AnnotateCycles
 from finn.transformation.fpgadataflow.create_stitched_ip import CreateStitchedIP
 from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
@@ -211,6 +213,12 @@ class InsertAndSetFIFODepths(Transformation):
         smaller where appropriate
     :parameter vivado_ram_style: the StreamingFIFO.ram_style attribute to be used
         for large FIFOs implemented by Vivado afterwards
+    :parameter max_onchip_depth: FIFOs deeper than this will spill to off-chip
+        memory (impl_style=dram). If set to None, all FIFOs stay on-chip
+    :parameter dram_base_addr: byte address from which the off-chip ring buffers
+        of impl_style=dram FIFOs are allocated, one after another. The region
+        must be reserved for the accelerator, so it has no default and must be
+        given whenever max_onchip_depth is set
 
     Assumed input graph properties:
 
@@ -246,6 +254,8 @@ class InsertAndSetFIFODepths(Transformation):
         swg_exception=False,
         vivado_ram_style="auto",
         force_python_sim=False,
+        max_onchip_depth=None,
+        dram_base_addr=None,
     ):
         super().__init__()
         self.fpgapart = fpgapart
@@ -255,6 +265,11 @@ class InsertAndSetFIFODepths(Transformation):
         self.swg_exception = swg_exception
         self.vivado_ram_style = vivado_ram_style
         self.force_python_sim = force_python_sim
+        self.max_onchip_depth = max_onchip_depth
+        self.dram_base_addr = dram_base_addr
+        assert (
+            max_onchip_depth is None or dram_base_addr is not None
+        ), "dram_base_addr must point to a reserved memory region when max_onchip_depth is set"
 
     def apply(self, model):
         # these optypes may potentially use external weights
@@ -402,6 +417,7 @@ class InsertAndSetFIFODepths(Transformation):
         # Apply depths back into the model;
         # also set in/outFIFODepths to zero for non-FIFO
         # nodes, preventing further FIFO insertion
+        dram_addr = self.dram_base_addr
         for node in model.graph.node:
             # set FIFO depth, reset FIFO implementation,
             # and set implementation/ram styles
@@ -418,7 +434,18 @@ class InsertAndSetFIFODepths(Transformation):
                 toplevel_out = node.output[0] in [x.name for x in model.graph.output]
                 toplevel_style_exception = toplevel_in or toplevel_out
                 # Set FIFO implementation/ram styles
-                if (depth > self.max_qsrl_depth) and (not toplevel_style_exception):
+                use_dram = self.max_onchip_depth is not None and depth > self.max_onchip_depth
+                if use_dram and node_inst.get_instream_width_padded() > dram_fifo_max_width:
+                    warnings.warn(
+                        "%s: stream too wide for impl_style=dram, keeping FIFO on-chip" % node.name
+                    )
+                    use_dram = False
+                if use_dram and (not toplevel_style_exception):
+                    node_inst.set_nodeattr("impl_style", "dram")
+                    node_inst.set_nodeattr("dram_base_addr", dram_addr)
+                    # keep ring buffers 4k-aligned
+                    dram_addr += roundup_to_integer_multiple(node_inst.get_dram_bytes(), 4096)
+                elif (depth > self.max_qsrl_depth) and (not toplevel_style_exception):
                     node_inst.set_nodeattr("impl_style", "vivado")
                     node_inst.set_nodeattr("ram_style", self.vivado_ram_style)
                 else:
@@ -572,6 +599,9 @@ class SplitLargeFIFOs(Transformation):
             node_ind += 1
             if node.op_type == ("StreamingFIFO_rtl"):
                 n_inst = getCustomOp(node)
+                if n_inst.get_nodeattr("impl_style") == "dram":
+                    # off-chip FIFOs are not limited in depth
+                    continue
                 depth = n_inst.get_nodeattr("depth")
                 cfgs = get_fifo_split_configs(depth, self.max_qsrl_depth, self.max_vivado_depth)
                 if len(cfgs) > 1:
@@ -69,6 +69,9 @@ class SetFolding(Transformation):
     * first increases SIMD while weight stream width per PE is <= mvau_wwidth_max
       (configurable in the SetFolding initializer, defaults to 36)
     * then increases PE until the target is met or max PE reached
+    * if mvau_bit_serial is enabled, RTL MVAUs are first folded as bit-serial
+      units (no DSPs, cycles scaled by the input bitwidth) and only switched
+      back to bit-parallel if that misses the target
 
     When folding depthwise convolutions ("VVAU"/VectorVectorActivation)
     or spatial reduction ops (Pool_Batch):
@@ -79,13 +82,38 @@ class SetFolding(Transformation):
     * the VVAU also supports SIMD ("input window") parallelism next to
       PE ("channels"), but current ConvInpGen limitations require PE to be fully
       unfolded before SIMD is increased
+
+    When folding the products of Winograd-lowered convolutions ("WinogradMVAU"):
+
+    * first increases SIMD (over input channels), then PE (over output
+      channels); the input and output transforms are folded independently,
+      with data width converters in between if needed
+
+    When folding activation-activation matrix multiplies ("DynamicMatMul"):
+
+    * first increases SIMD (over the reduction dim K), then PE (over N), since
+      the time spent buffering the second operand only shrinks with PE
+
+    When folding fused depthwise-separable blocks ("DepthwiseSeparable"):
+
+    * first increases the shared SIMD (channel parallelism of both stages)
+    * then increases KernelSIMD only if the depthwise stage still misses
+      the target, and PE only if the pointwise stage still misses it
+    * the producer ConvolutionInputGenerator is set as for a VVAU
     """
 
-    def __init__(self, target_cycles_per_frame=1000, mvau_wwidth_max=36, two_pass_relaxation=True):
+    def __init__(
+        self,
+        target_cycles_per_frame=1000,
+        mvau_wwidth_max=36,
+        two_pass_relaxation=True,
+        mvau_bit_serial=False,
+    ):
         super().__init__()
         self.target_cycles_per_frame = target_cycles_per_frame
         self.mvau_wwidth_max = mvau_wwidth_max
         self.two_pass_relaxation = two_pass_relaxation
+        self.mvau_bit_serial = mvau_bit_serial
 
     def optimize_attribute_val(self, node_inst, max_val, attr_name):
         node_inst.set_nodeattr(attr_name, 1)
@@ -96,6 +124,31 @@ class SetFolding(Transformation):
                 # finish if target met
                 break
 
+    def optimize_mvau_folding(self, node_inst):
+        max_simd = node_inst.get_nodeattr("MW")
+        max_pe = node_inst.get_nodeattr("MH")
+        node_inst.set_nodeattr("PE", 1)
+        node_inst.set_nodeattr("SIMD", 1)
+        # increase SIMD until either we meet
+        # the target or weight stream becomes
+        # too wide
+        for simd_val in divisors(max_simd):
+            prev_simd_val = node_inst.get_nodeattr("SIMD")
+            node_inst.set_nodeattr("SIMD", simd_val)
+            cyc = node_inst.get_exp_cycles()
+            if cyc < self.target_cycles_per_frame:
+                # finish if target met
+                break
+            if (
+                node_inst.get_weight_datatype().bitwidth() * node_inst.get_nodeattr("SIMD")
+                > self.mvau_wwidth_max
+            ):
+                # revert if we've gone above width threshold
+                node_inst.set_nodeattr("SIMD", prev_simd_val)
+                break
+        # increase PE until target met or reached max_pe
+        self.optimize_attribute_val(node_inst, max_pe, "PE")
+
     def apply(self, model):
         graph = model.graph
         # these ops use PE parallelism, up to a max value of NumChannels
@@ -104,8 +157,12 @@ class SetFolding(Transformation):
             "ChannelwiseOp_hls",
             "DuplicateStreams_hls",
             "GlobalAccPool_hls",
+            "LookupActivation_hls",
+            "StreamingLayerNorm_hls",
+            "StreamingSoftmax_hls",
             "Thresholding_hls",
             "Thresholding_rtl",
+            "WinogradOutputTransform_hls",
         ]
         # these ops use SIMD parallelism, up to a max value of NumChannels
         # ConvolutionInputGenerator* has a special case when depthwise=1
@@ -117,6 +174,7 @@ class SetFolding(Transformation):
             "FMPadding_Pixel_hls",
             "ConvolutionInputGenerator_hls",
             "ConvolutionInputGenerator_rtl",
+            "WinogradInputTransform_hls",
         ]
         # these ops are preceded by depthwise SWG and have special behavior,
         # as explained in the SetFolding docstring
@@ -126,30 +184,53 @@ class SetFolding(Transformation):
                 continue
             op_type = node.op_type
             node_inst = getCustomOp(node)
-            if op_type in ["MVAU_hls", "MVAU_rtl"]:
-                max_simd = node_inst.get_nodeattr("MW")
-                max_pe = node_inst.get_nodeattr("MH")
+            if op_type == "MVAU_hls":
+                self.optimize_mvau_folding(node_inst)
+            elif op_type == "MVAU_rtl":
+                node_inst.set_nodeattr("bitSerial", 1 if self.mvau_bit_serial else 0)
+                self.optimize_mvau_folding(node_inst)
+                if (
+                    node_inst.get_nodeattr("bitSerial") == 1
+                    and node_inst.get_exp_cycles() >= self.target_cycles_per_frame
+                ):
+                    # bit-serial misses the target, fall back to bit-parallel
+                    node_inst.set_nodeattr("bitSerial", 0)
+                    self.optimize_mvau_folding(node_inst)
+            elif op_type == "WinogradMVAU_hls":
+                node_inst.set_nodeattr("PE", 1)
+                self.optimize_attribute_val(node_inst, node_inst.get_nodeattr("MW"), "SIMD")
+                self.optimize_attribute_val(node_inst, node_inst.get_nodeattr("MH"), "PE")
+            elif op_type == "DynamicMatMul_hls":
+                node_inst.set_nodeattr("PE", 1)
+                self.optimize_attribute_val(node_inst, node_inst.get_nodeattr("K"), "SIMD")
+                self.optimize_attribute_val(node_inst, node_inst.get_nodeattr("N"), "PE")
+            elif op_type == "DepthwiseSeparable_hls":
+                node_inst.set_nodeattr("KernelSIMD", 1)
                 node_inst.set_nodeattr("PE", 1)
-                node_inst.set_nodeattr("SIMD", 1)
-                # increase SIMD until either we meet
-                # the target or weight stream becomes
-                # too wide
-                for simd_val in divisors(max_simd):
-                    prev_simd_val = node_inst.get_nodeattr("SIMD")
-                    node_inst.set_nodeattr("SIMD", simd_val)
-                    cyc = node_inst.get_exp_cycles()
-                    if cyc < self.target_cycles_per_frame:
-                        # finish if target met
+                self.optimize_attribute_val(node_inst, node_inst.get_nodeattr("Channels"), "SIMD")
+                # spend the stage-local parallelism only on the stage that
+                # still misses the target
+                ksize = np.prod(node_inst.get_nodeattr("Kernel"))
+                for ksimd_val in divisors(ksize):
+                    node_inst.set_nodeattr("KernelSIMD", ksimd_val)
+                    if node_inst.get_stage_exp_cycles()[0] < self.target_cycles_per_frame:
                         break
-                    if (
-                        node_inst.get_weight_datatype().bitwidth() * node_inst.get_nodeattr("SIMD")
-                        > self.mvau_wwidth_max
-                    ):
-                        # revert if we've gone above width threshold
-                        node_inst.set_nodeattr("SIMD", prev_simd_val)
+                for pe_val in divisors(node_inst.get_nodeattr("MH")):
+                    node_inst.set_nodeattr("PE", pe_val)
+                    if node_inst.get_stage_exp_cycles()[1] < self.target_cycles_per_frame:
                         break
-                # increase PE until target met or reached max_pe
-                self.optimize_attribute_val(node_inst, max_pe, "PE")
+                swu_node = model.find_producer(node.input[0])
+                if swu_node is not None and swu_node.op_type.startswith(
+                    "ConvolutionInputGenerator"
+                ):
+                    swu_node_inst = getCustomOp(swu_node)
+                    swu_node_inst.set_nodeattr("SIMD", node_inst.get_nodeattr("SIMD"))
+                    # enable parallel_window mode of RTL SWG if needed
+                    if swu_node.op_type == "ConvolutionInputGenerator_rtl":
+                        if node_inst.get_nodeattr("KernelSIMD") > 1:
+                            swu_node_inst.set_nodeattr("parallel_window", 1)
+                        else:
+                            swu_node_inst.set_nodeattr("parallel_window", 0)
             elif op_type in pe_ops:
                 max_pe = node_inst.get_nodeattr("NumChannels")
                 self.optimize_attribute_val(node_inst, max_pe, "PE")
@@ -239,6 +320,7 @@ class SetFolding(Transformation):
                         target_cycles_per_frame=perf_dict["max_cycles"],
                         mvau_wwidth_max=self.mvau_wwidth_max,
                         two_pass_relaxation=False,
+                        mvau_bit_serial=self.mvau_bit_serial,
                     )
                 )
 
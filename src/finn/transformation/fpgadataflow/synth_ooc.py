@@ -26,11 +26,21 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import hashlib
+import json
 import os
+import warnings
+from qonnx.custom_op.registry import getCustomOp
 from qonnx.transformation.base import Transformation
 from shutil import copy2
 
+from finn.transformation.fpgadataflow.scheduled_node_local import (
+    node_job_cost,
+    node_job_key,
+)
 from finn.util.basic import make_build_dir
+from finn.util.fpgadataflow import is_hls_node, is_rtl_node
+from finn.util.job_scheduler import Job, JobScheduler, get_build_hosts, get_job_history
 from finn.util.vivado import out_of_context_synth
 
 
@@ -63,3 +73,130 @@ class SynthOutOfContext(Transformation):
         )
         model.set_metadata_prop("res_total_ooc_synth", str(ret))
         return (model, False)
+
+
+def get_node_ooc_sources(node):
+    """Returns (top module name, list of source files) to synthesize the IP
+    of given HLS or RTL node on its own, or None if the node is not built from
+    sources of its own (e.g. vivado-style FIFOs instantiating Xilinx IP)."""
+    inst = getCustomOp(node)
+    if is_hls_node(node):
+        vlnv = inst.get_nodeattr("ip_vlnv")
+        assert vlnv != "", "Node %s has no IP, run HLSSynthIP first." % node.name
+        top = vlnv.split(":")[2]
+        # take all files in the verilog dirs, these include ROM init files
+        srcs = []
+        for verilog_path in inst.get_all_verilog_paths():
+            for f in sorted(os.listdir(verilog_path)):
+                if os.path.isfile(os.path.join(verilog_path, f)):
+                    srcs.append(os.path.join(verilog_path, f))
+        return (top, srcs)
+    # RTL nodes: use the sources and module their IPI TCL instantiates
+    top = None
+    srcs = []
+    for cmd in inst.code_generation_ipi():
+        tokens = cmd.split()
+        if tokens[:1] == ["add_files"]:
+            srcs.append(tokens[-1])
+        elif tokens[:1] == ["create_bd_cell"] and "-reference" in tokens:
+            top = tokens[tokens.index("-reference") + 1]
+    if top is None:
+        return None
+    return (top, srcs)
+
+
+def ooc_synth_cache_key(top, srcs, part, clk_name, clk_period_ns):
+    """Returns a hash over the contents of the source files, the top module
+    and the synthesis settings to look up previous results by."""
+    h = hashlib.sha256()
+    h.update(("%s:%s:%s:%f" % (top, part, clk_name, float(clk_period_ns))).encode())
+    for src in sorted(srcs, key=os.path.basename):
+        h.update(os.path.basename(src).encode())
+        with open(src, "rb") as f:
+            h.update(f.read())
+    return h.hexdigest()
+
+
+def _synth_node_ooc(top, srcs, part, clk_name, clk_period_ns):
+    build_dir = make_build_dir("synth_out_of_context_%s_" % top)
+    for src in srcs:
+        copy2(src, build_dir)
+    return out_of_context_synth(build_dir, top, part, clk_name, clk_period_ns)
+
+
+class SynthOutOfContextPerNode(Transformation):
+    """Run out-of-context Vivado synthesis separately for the IP of each HLS
+    and RTL node, in parallel as jobs of the JobScheduler (see
+    finn.util.job_scheduler). Results are cached under cache_dir by a hash of
+    the node sources and synthesis settings, so that only nodes whose IP
+    changed are synthesized again in later builds. By default the cache is
+    kept in ooc_synth_cache under FINN_BUILD_DIR.
+
+    The results are stored in the res_synth attribute of each node. Their sum
+    is stored in the res_total_ooc_synth metadata property like for
+    SynthOutOfContext, with the lowest per-node fmax_mhz. This does not cover
+    the FIFOs and interconnect between nodes, and the fmax of the whole design
+    may be lower."""
+
+    def __init__(self, part, clk_period_ns, clk_name="ap_clk", num_workers=None, cache_dir=None):
+        super().__init__()
+        self.part = part
+        self.clk_period_ns = clk_period_ns
+        self.clk_name = clk_name
+        if num_workers is None:
+            num_workers = os.cpu_count()
+        self.num_workers = num_workers
+        if cache_dir is None:
+            cache_dir = os.path.join(os.environ["FINN_BUILD_DIR"], "ooc_synth_cache")
+        self.cache_dir = cache_dir
+
+    def apply(self, model):
+        os.makedirs(self.cache_dir, exist_ok=True)
+        node_res = {}
+        jobs = []
+        job_nodes = []
+        for node in model.graph.node:
+            if not (is_hls_node(node) or is_rtl_node(node)):
+                continue
+            node_srcs = get_node_ooc_sources(node)
+            if node_srcs is None:
+                warnings.warn("No sources for out-of-context synthesis of %s, skipping" % node.name)
+                continue
+            top, srcs = node_srcs
+            key = ooc_synth_cache_key(top, srcs, self.part, self.clk_name, self.clk_period_ns)
+            cache_file = os.path.join(self.cache_dir, key + ".json")
+            if os.path.isfile(cache_file):
+                with open(cache_file, "r") as f:
+                    node_res[node.name] = json.load(f)
+                continue
+            job = Job(
+                node_job_key("ooc_synth", model, node),
+                _synth_node_ooc,
+                (top, srcs, self.part, self.clk_name, self.clk_period_ns),
+                group="ooc_synth:%s" % node.op_type,
+                cost=node_job_cost(model, node),
+            )
+            jobs.append(job)
+            job_nodes.append((node.name, cache_file))
+
+        scheduler = JobScheduler(
+            get_build_hosts(self.num_workers), get_job_history(), default_mem=4 * 2**30
+        )
+        for (node_name, cache_file), ret in zip(job_nodes, scheduler.run(jobs)):
+            tmp_file = "%s.%d.tmp" % (cache_file, os.getpid())
+            with open(tmp_file, "w") as f:
+                json.dump(ret, f, indent=2)
+            os.replace(tmp_file, cache_file)
+            node_res[node_name] = ret
+
+        total = {}
+        for node_name, res in node_res.items():
+            getCustomOp(model.get_node_from_name(node_name)).set_nodeattr("res_synth", str(res))
+            for res_key, res_val in res.items():
+                if res_key in ["vivado_proj_folder", "WNS", "fmax_mhz"]:
+                    continue
+                total[res_key] = total.get(res_key, 0) + res_val
+        fmax = [res["fmax_mhz"] for res in node_res.values() if res["fmax_mhz"] > 0]
+        total["fmax_mhz"] = min(fmax) if len(fmax) > 0 else 0
+        model.set_metadata_prop("res_total_ooc_synth", str(total))
+        return (model, False)
@@ -61,7 +61,7 @@ import argparse
 import numpy as np
 import os
 from qonnx.core.datatype import DataType
-from driver_base import FINNExampleOverlay
+from driver_base import FINNExampleOverlay, FINNHostPipeline, FINNMultiDeviceOverlay
 from pynq.pl_server.device import Device
 
 # dictionary describing the I/O of the FINN-generated accelerator
@@ -82,6 +82,12 @@ io_shape_dict = {
     "input_dma_name" : $INPUT_DMA_NAME$,
     "output_dma_name" : $OUTPUT_DMA_NAME$,
     "number_of_external_weights": $EXT_WEIGHT_NUM$,
+    # memory bank of each DMA (Alveo only), buffers are allocated there
+    "dma_mem_bank" : $DMA_MEM_BANK$,
+    # checksum and tap hook layers, see read_hooks
+    "hooks" : $HOOKS$,
+    # the batch size must be a multiple of this (weightReuse of batch-tiled layers)
+    "batch_multiple" : $BATCH_MULTIPLE$,
     "num_inputs" : $NUM_INPUTS$,
     "num_outputs" : $NUM_OUTPUTS$,
 }
@@ -92,10 +98,12 @@ if __name__ == "__main__":
     parser.add_argument('--platform', help='Target platform: zynq-iodma alveo', default="$PLATFORM$")
     parser.add_argument('--batchsize', help='number of samples for inference', type=int, default=1)
     parser.add_argument('--device', help='FPGA device to be used', type=int, default=0)
+    parser.add_argument('--devices', help='FPGA devices to shard batches across (Alveo only), overrides --device', nargs="*", type=int, default=None)
     parser.add_argument('--bitfile', help='name of bitfile (i.e. "resizer.bit")', default="resizer.bit")
     parser.add_argument('--inputfile', help='name(s) of input npy file(s) (i.e. "input.npy")', nargs="*", type=str, default=["input.npy"])
     parser.add_argument('--outputfile', help='name(s) of output npy file(s) (i.e. "output.npy")', nargs="*", type=str, default=["output.npy"])
     parser.add_argument('--runtime_weight_dir', help='path to folder containing runtime-writable .dat weights', default="runtime_weights/")
+    parser.add_argument('--host_partitions', help='in execute mode, run the full network: host_head.onnx/host_tail.onnx around the accelerator (requires onnxruntime)', action='store_true')
     # parse arguments
     args = parser.parse_args()
     exec_mode = args.exec_mode
@@ -109,15 +117,26 @@ if __name__ == "__main__":
     device = Device.devices[devID]
 
     # instantiate FINN accelerator driver and pass batchsize and bitfile
-    accel = FINNExampleOverlay(
-        bitfile_name = bitfile, platform = platform,
-        io_shape_dict = io_shape_dict, batch_size = batch_size,
-        runtime_weight_dir = runtime_weight_dir, device=device
-    )
+    if args.devices is not None and len(args.devices) > 1:
+        accel = FINNMultiDeviceOverlay(
+            bitfile_name = bitfile, platform = platform,
+            io_shape_dict = io_shape_dict, batch_size = batch_size,
+            runtime_weight_dir = runtime_weight_dir, devices=args.devices
+        )
+    else:
+        if args.devices:
+            device = Device.devices[args.devices[0]]
+        accel = FINNExampleOverlay(
+            bitfile_name = bitfile, platform = platform,
+            io_shape_dict = io_shape_dict, batch_size = batch_size,
+            runtime_weight_dir = runtime_weight_dir, device=device
+        )
 
     # for the remote execution the data from the input npy file has to be loaded,
     # packed and copied to the PYNQ buffer
     if exec_mode == "execute":
+        if args.host_partitions:
+            accel = FINNHostPipeline(accel)
         # load desired input .npy file(s)
         ibuf_normal = []
         for ifn in inputfile:
@@ -40,6 +40,7 @@ from qonnx.transformation.general import (
     RemoveUnusedTensors,
 )
 
+from finn.transformation.fpgadataflow.assign_hbm_channels import AssignHBMChannels
 from finn.transformation.fpgadataflow.create_dataflow_partition import (
     CreateDataflowPartition,
 )
@@ -98,6 +99,15 @@ class CreateVitisXO(Transformation):
         # developed from instructions in UG1393 (v2019.2) and package_xo documentation
         # package_xo is responsible for generating the kernel xml
         assert len(interfaces["axilite"]) <= 1, "CreateVitisXO supports max 1 AXI lite interface"
+        # AXI-MM interfaces are passed as kernel arguments through AXI lite, so
+        # e.g. off-chip FIFOs (StreamingFIFO impl_style=dram) are not supported
+        assert len(interfaces["aximm"]) <= len(
+            interfaces["axilite"]
+        ), "CreateVitisXO supports max 1 AXI MM interface, set via AXI lite"
+        # the kernel arguments below assume the AXI-MM interface belongs to an IODMA
+        assert (
+            model.get_nodes_by_op_type("Tap_hls") == []
+        ), "CreateVitisXO does not support tap hooks, use a Zynq build"
         axilite_intf_name = None
         if len(interfaces["axilite"]) == 1:
             axilite_intf_name = interfaces["axilite"][0]
@@ -229,7 +239,7 @@ class VitisLink(Transformation):
             if node_slr != -1:
                 config.append("slr=%s:SLR%d" % (instance_names[node.name], node_slr))
             # assign memory banks
-            if producer is None or consumer is None:
+            if producer is None or consumer == []:
                 node_mem_port = sdp_node.get_nodeattr("mem_port")
                 if node_mem_port == "":
                     # configure good defaults based on board
@@ -252,6 +262,8 @@ class VitisLink(Transformation):
                         mem_type = "DDR"
                         mem_idx = 1
                     node_mem_port = "%s[%d]" % (mem_type, mem_idx)
+                    # record the bank for buffer allocation in the driver
+                    sdp_node.set_nodeattr("mem_port", node_mem_port)
                 config.append("sp=%s.m_axi_gmem0:%s" % (instance_names[node.name], node_mem_port))
             # connect streams
             if producer is not None:
@@ -417,6 +429,8 @@ class VitisBuild(Transformation):
             kernel_model = kernel_model.transform(CreateVitisXO(sdp_node.onnx_node.name))
             kernel_model.set_metadata_prop("platform", "alveo")
             kernel_model.save(dataflow_model_filename)
+        # spread the DMAs over the HBM pseudo-channels, if any
+        model = model.transform(AssignHBMChannels(self.platform, round(1000 / self.period_ns)))
         # Assemble design from kernels
         if self.enable_link:
             model = model.transform(
@@ -72,26 +72,29 @@ class ConvertQONNXtoFINN(Transformation):
         self._filter_function = filter_function
 
     def apply(self, model):
+        # model is already a copy made by ModelWrapper.transform, so the
+        # individual steps work in place instead of copying the model again
         # Extract the bias from Conv node
-        model = model.transform(ExtractBiasFromConv())
+        model = model.transform(ExtractBiasFromConv(), make_deepcopy=False)
         # Gemm operations are not supported by FINN, so we convert them to MatMul
-        model = model.transform(GemmToMatMul())
-        model = model.transform(FoldTransposeIntoQuantInit())
+        model = model.transform(GemmToMatMul(), make_deepcopy=False)
+        model = model.transform(FoldTransposeIntoQuantInit(), make_deepcopy=False)
         # Make sure the datatypes exist, these are required for folding the weights
-        model = model.transform(InferDataTypes())
+        model = model.transform(InferDataTypes(), make_deepcopy=False)
         # Fold weights
-        model = model.transform(FoldQuantWeights())
+        model = model.transform(FoldQuantWeights(), make_deepcopy=False)
         # Convert activations
         model = model.transform(
             ConvertQuantActToMultiThreshold(
                 filter_function=self._filter_function,
-            )
+            ),
+            make_deepcopy=False,
         )
         # Recompute datatypes
-        model = model.transform(InferDataTypes())
+        model = model.transform(InferDataTypes(), make_deepcopy=False)
         # Convert AvgPool -> Mul -> Trunc structure to QuantAvgPool2d
-        model = model.transform(AvgPoolAndTruncToQuantAvgPool())
+        model = model.transform(AvgPoolAndTruncToQuantAvgPool(), make_deepcopy=False)
         # Remove empty padding if it exists
-        model = model.transform(RemoveIdentityOps())
+        model = model.transform(RemoveIdentityOps(), make_deepcopy=False)
 
         return model, False
@@ -94,10 +94,12 @@ class Streamline(Transformation):
             Absorb1BitMulIntoConv(),
             RoundAndClipThresholds(),
         ]
+        # model is already a copy made by ModelWrapper.transform, so the
+        # individual steps work in place instead of copying the model again
         for trn in streamline_transformations:
-            model = model.transform(trn)
-            model = model.transform(RemoveIdentityOps())
-            model = model.transform(GiveUniqueNodeNames())
-            model = model.transform(GiveReadableTensorNames())
-            model = model.transform(InferDataTypes())
+            model = model.transform(trn, make_deepcopy=False)
+            model = model.transform(RemoveIdentityOps(), make_deepcopy=False)
+            model = model.transform(GiveUniqueNodeNames(), make_deepcopy=False)
+            model = model.transform(GiveReadableTensorNames(), make_deepcopy=False)
+            model = model.transform(InferDataTypes(), make_deepcopy=False)
         return (model, False)
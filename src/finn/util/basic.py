@@ -26,10 +26,14 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import copy
 import os
 import subprocess
 import sys
 import tempfile
+from google.protobuf.descriptor import FieldDescriptor
+from onnx import ModelProto
+from qonnx.core.modelwrapper import ModelWrapper
 from qonnx.util.basic import roundup_to_integer_multiple
 
 # test boards
@@ -132,11 +136,20 @@ def pyverilate_get_liveness_threshold_cycles():
     return int(os.getenv("LIVENESS_THRESHOLD", 10000))
 
 
-def make_build_dir(prefix=""):
+def make_build_dir(prefix="", key=None):
     """Creates a folder with given prefix to be used as a build dir.
     Use this function instead of tempfile.mkdtemp to ensure any generated files
-    will survive on the host after the FINN Docker container exits."""
+    will survive on the host after the FINN Docker container exits.
+    If a key is given, the folder is named after the key instead of randomly,
+    and an existing folder with the same name is returned as is, see
+    finn.util.build_dirs."""
     try:
+        if key is not None:
+            newdir = os.path.join(os.environ["FINN_BUILD_DIR"], prefix + key)
+            os.makedirs(newdir, exist_ok=True)
+            # mark as recently used for finn.util.build_dirs.collect_garbage
+            os.utime(newdir)
+            return newdir
         tmpdir = tempfile.mkdtemp(prefix=prefix)
         newdir = tmpdir.replace("/tmp", os.environ["FINN_BUILD_DIR"])
         os.makedirs(newdir)
@@ -305,3 +318,28 @@ def get_dsp_block(fpgapart):
         return "DSP48E1"
     else:
         return "DSP48E2"
+
+
+def _copy_proto_fields(dst, src, skip=[]):
+    for field, value in src.ListFields():
+        if field.name in skip:
+            continue
+        if field.label == FieldDescriptor.LABEL_REPEATED:
+            getattr(dst, field.name).extend(value)
+        elif field.type == FieldDescriptor.TYPE_MESSAGE:
+            getattr(dst, field.name).CopyFrom(value)
+        else:
+            setattr(dst, field.name, value)
+
+
+def clone_model(model, initializers=True):
+    """Returns a copy of the ModelWrapper. If initializers is False, the copy
+    is made without any initializers, so that weights are not duplicated when
+    the caller sets all initializers of the copy anyway."""
+    if initializers:
+        return copy.deepcopy(model)
+    new_model = ModelProto()
+    _copy_proto_fields(new_model, model.model, skip=["graph"])
+    new_model.graph.SetInParent()
+    _copy_proto_fields(new_model.graph, model.graph, skip=["initializer"])
+    return ModelWrapper(new_model)
@@ -0,0 +1,210 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import fcntl
+import hashlib
+import onnx
+import os
+import subprocess
+import time
+from contextlib import contextmanager
+from onnx import AttributeProto
+from shutil import rmtree
+
+from finn.util.basic import make_build_dir
+from finn.util.fpgadataflow import sim_only_attrs
+
+# entries of FINN_BUILD_DIR that collect_garbage never removes
+gc_keep = ["ooc_synth_cache", "job_history.json"]
+
+_tool_versions = None
+
+
+def deterministic_build_dirs():
+    """Whether per-node build dirs are named after a hash of their inputs,
+    enabled by setting FINN_DETERMINISTIC_BUILD_DIRS=1."""
+    return os.environ.get("FINN_DETERMINISTIC_BUILD_DIRS", "0").lower() in ["1", "true"]
+
+
+def get_tool_versions():
+    """Returns a string identifying the FINN sources and Xilinx tools in use,
+    from the FINN git commit, uncommitted changes and the tool install paths
+    which carry the tool versions."""
+    global _tool_versions
+    if _tool_versions is None:
+        versions = []
+        for var in ["XILINX_VIVADO", "HLS_PATH", "VITIS_PATH"]:
+            versions.append("%s=%s" % (var, os.environ.get(var, "")))
+        finn_root = os.environ.get("FINN_ROOT", "")
+        for cmd in [["git", "rev-parse", "HEAD"], ["git", "diff", "HEAD"]]:
+            try:
+                out = subprocess.run(cmd, cwd=finn_root, capture_output=True).stdout
+            except OSError:
+                out = b""
+            versions.append(hashlib.sha1(out).hexdigest())
+        _tool_versions = ";".join(versions)
+    return _tool_versions
+
+
+def node_build_key(kind, model, node, *args):
+    """Returns a hash over everything that determines the outputs of the
+    build step of given kind for the node: its name, op type and attributes,
+    the datatypes and shapes of its tensors, its initializer contents, the
+    extra args (e.g. part and clock) and the tool versions. Attributes that
+    do not affect the hardware (sim_only_attrs, e.g. exec_mode or estimates)
+    and string attributes holding paths, which point to outputs, are left
+    out."""
+    h = hashlib.sha256()
+    h.update(("%s:%s:%s:%s" % (kind, node.name, node.op_type, get_tool_versions())).encode())
+    h.update(str(args).encode())
+    for attr in sorted(node.attribute, key=lambda a: a.name):
+        if attr.name in sim_only_attrs:
+            continue
+        if attr.type == AttributeProto.STRING and b"/" in attr.s:
+            continue
+        h.update(attr.SerializeToString())
+    for tensor in list(node.input) + list(node.output):
+        h.update(
+            ("%s:%s" % (model.get_tensor_datatype(tensor), model.get_tensor_shape(tensor))).encode()
+        )
+        init = model.get_initializer(tensor)
+        if init is not None:
+            h.update(init.tobytes())
+    return h.hexdigest()[:20]
+
+
+def make_node_build_dir(prefix, kind, model, node, *args):
+    """Creates the build dir for the build step of given kind for the node,
+    named after node_build_key if deterministic_build_dirs() is enabled.
+    Identical nodes then use the same dir, within and across builds."""
+    if deterministic_build_dirs():
+        return make_build_dir(prefix, key=node_build_key(kind, model, node, *args))
+    return make_build_dir(prefix)
+
+
+@contextmanager
+def build_dir_lock(build_dir):
+    """Holds an exclusive lock on the build dir, so that builds sharing the
+    dir produce its outputs one at a time."""
+    with open(os.path.join(build_dir, ".lock"), "w") as f:
+        fcntl.flock(f, fcntl.LOCK_EX)
+        try:
+            yield
+        finally:
+            fcntl.flock(f, fcntl.LOCK_UN)
+
+
+def build_output_done(build_dir, name):
+    """Whether the output called name was already produced in the build dir
+    and can be reused. Only used with deterministic build dirs."""
+    return deterministic_build_dirs() and os.path.isfile(os.path.join(build_dir, ".done_" + name))
+
+
+def mark_build_output_done(build_dir, name):
+    with open(os.path.join(build_dir, ".done_" + name), "w"):
+        pass
+
+
+def referenced_build_dirs(model_filenames):
+    """Returns the names of the entries of FINN_BUILD_DIR referenced by node
+    attributes or metadata of the given models, and of the models these
+    refer to (e.g. dataflow partitions)."""
+    build_dir = os.path.realpath(os.environ["FINN_BUILD_DIR"])
+    referenced = set()
+    visited = set()
+    pending = [os.path.realpath(x) for x in model_filenames]
+    while len(pending) > 0:
+        model_filename = pending.pop()
+        if model_filename in visited or not os.path.isfile(model_filename):
+            continue
+        visited.add(model_filename)
+        model = onnx.load(model_filename, load_external_data=False)
+        values = [x.value for x in model.metadata_props]
+        for node in model.graph.node:
+            for attr in node.attribute:
+                if attr.type == AttributeProto.STRING:
+                    values.append(attr.s.decode(errors="ignore"))
+                elif attr.type == AttributeProto.STRINGS:
+                    values += [x.decode(errors="ignore") for x in attr.strings]
+        for value in values:
+            path = os.path.realpath(value) if value.startswith("/") else ""
+            if path.startswith(build_dir + "/"):
+                referenced.add(os.path.relpath(path, build_dir).split("/")[0])
+                if path.endswith(".onnx"):
+                    pending.append(path)
+    return referenced
+
+
+def collect_garbage(model_filenames, keep_hours=24.0, dry_run=False):
+    """Removes the entries of FINN_BUILD_DIR that are not referenced by the
+    given models (see referenced_build_dirs) and were not modified during
+    the last keep_hours, which protects the outputs of running builds.
+    Returns the names of the removed entries."""
+    build_dir = os.environ["FINN_BUILD_DIR"]
+    referenced = referenced_build_dirs(model_filenames)
+    deadline = time.time() - keep_hours * 3600
+    removed = []
+    for name in sorted(os.listdir(build_dir)):
+        path = os.path.join(build_dir, name)
+        if name in referenced or name in gc_keep or os.path.getmtime(path) > deadline:
+            continue
+        if not dry_run:
+            if os.path.isdir(path) and not os.path.islink(path):
+                rmtree(path)
+            else:
+                os.remove(path)
+        removed.append(name)
+    return removed
+
+
+def build_dir_gc(*models, keep_hours: float = 24.0, dry_run: bool = False):
+    """Removes build dirs under FINN_BUILD_DIR that are not used by the given
+    models.
+
+    :param models: .onnx files or directories to search for .onnx files,
+        e.g. the output dirs of builds to keep
+    :param keep_hours: keep anything modified within this many hours
+    :param dry_run: only list what would be removed
+    """
+    model_filenames = []
+    for x in models:
+        if os.path.isdir(x):
+            for root, dirs, files in os.walk(x):
+                model_filenames += [os.path.join(root, f) for f in files if f.endswith(".onnx")]
+        else:
+            model_filenames.append(x)
+    removed = collect_garbage(model_filenames, keep_hours, dry_run)
+    for name in removed:
+        print(("Would remove " if dry_run else "Removed ") + name)
+
+
+def main():
+    import clize
+
+    clize.run(build_dir_gc)
@@ -26,8 +26,26 @@
 # OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+import math
+from qonnx.core.modelwrapper import ModelWrapper
 from qonnx.util.basic import get_by_name, is_finn_op
 
+# node attributes that do not affect the generated hardware, left out when
+# comparing or hashing nodes to decide whether their hardware changed
+sim_only_attrs = [
+    "exec_mode",
+    "code_gen_dir_cppsim",
+    "executable_path",
+    "cycles_rtlsim",
+    "cycles_estimate",
+    "rtlsim_trace",
+    "rtlsim_so",
+    "res_estimate",
+    "res_hls",
+    "res_synth",
+    "ip_vlnv",
+]
+
 
 def is_fpgadataflow_node(node):
     """Returns True if given node is fpgadataflow node. Otherwise False."""
@@ -69,3 +87,42 @@ def is_rtl_node(node):
                     is_node = True
 
     return is_node
+
+
+def buffer_resource_estimation(depth, width):
+    """Returns the estimated (RAMB18, LUT) cost of an on-chip buffer of depth
+    words of width bits. Shallow buffers of up to 64 words are assumed to map
+    to LUTRAM, deeper ones to SDP mode RAMB18s (see UG573 Table 1-10)."""
+    if depth <= 64:
+        return (0, width * math.ceil(depth / 64))
+    if width == 1:
+        brams = math.ceil(depth / 16384)
+    elif width == 2:
+        brams = math.ceil(depth / 8192)
+    elif width <= 4:
+        brams = math.ceil(depth / 4096) * math.ceil(width / 4)
+    elif width <= 9:
+        brams = math.ceil(depth / 2048) * math.ceil(width / 9)
+    elif width <= 18 or depth > 512:
+        brams = math.ceil(depth / 1024) * math.ceil(width / 18)
+    else:
+        brams = math.ceil(depth / 512) * math.ceil(width / 36)
+    return (brams, 0)
+
+
+def weight_reuse_batch_multiple(model):
+    """Returns the number of frames the batch size of given model must be a
+    multiple of, i.e. the least common multiple of the weightReuse of its
+    batch-tiled MVAU layers (1 if there are none). Dataflow partitions are
+    searched recursively."""
+    ret = 1
+    for node in model.graph.node:
+        if node.op_type == "StreamingDataflowPartition":
+            child = ModelWrapper(get_by_name(node.attribute, "model").s.decode("UTF-8"))
+            ret = math.lcm(ret, weight_reuse_batch_multiple(child))
+        elif node.op_type.startswith("MVAU"):
+            reuse = get_by_name(node.attribute, "weightReuse")
+            mem_mode = get_by_name(node.attribute, "mem_mode")
+            if reuse is not None and mem_mode is not None and mem_mode.s == b"external":
+                ret = math.lcm(ret, max(reuse.i, 1))
+    return ret
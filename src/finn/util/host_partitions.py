@@ -0,0 +1,141 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import copy
+import os
+import warnings
+from onnx import helper
+from qonnx.core.modelwrapper import ModelWrapper
+
+# op_type of the nodes the host partitions are cut around
+sdp_op_type = "StreamingDataflowPartition"
+
+
+def _batch_value_info(model, tensor_name):
+    """Returns a copy of the ValueInfoProto of the given tensor with a symbolic
+    batch dimension, so the host partitions can run on whole batches."""
+    graph = model.graph
+    for vi in list(graph.input) + list(graph.output) + list(graph.value_info):
+        if vi.name == tensor_name:
+            ret = copy.deepcopy(vi)
+            dims = ret.type.tensor_type.shape.dim
+            if len(dims) > 0:
+                dims[0].Clear()
+                dims[0].dim_param = "N"
+            return ret
+    raise Exception("No shape information for tensor %s" % tensor_name)
+
+
+def _make_host_model(model, nodes, inputs, outputs, name):
+    """Builds a standalone ONNX model from the given nodes of model, or returns
+    None if it would be empty or contains nodes outside the default ONNX
+    domain (which a host runtime like onnxruntime cannot execute)."""
+    if len(nodes) == 0:
+        return None
+    custom = [n.name for n in nodes if n.domain not in ["", "ai.onnx"]]
+    if len(custom) > 0:
+        warnings.warn(
+            "Host %s partition not exported, it contains custom nodes: %s" % (name, str(custom))
+        )
+        return None
+    used = set()
+    produced = set()
+    for n in nodes:
+        used.update(n.input)
+        produced.update(n.output)
+    inits = [copy.deepcopy(x) for x in model.graph.initializer if x.name in used]
+    external = used - produced - set([x.name for x in inits]) - set(inputs) - set([""])
+    if len(external) > 0:
+        warnings.warn(
+            "Host %s partition not exported, it depends on tensors crossing the "
+            "accelerator: %s" % (name, str(sorted(external)))
+        )
+        return None
+    graph = helper.make_graph(
+        nodes=[copy.deepcopy(n) for n in nodes],
+        name="host_" + name,
+        inputs=[_batch_value_info(model, x) for x in inputs],
+        outputs=[_batch_value_info(model, x) for x in outputs],
+        initializer=inits,
+    )
+    opset_imports = [x for x in model.model.opset_import if x.domain in ["", "ai.onnx"]]
+    host_model = helper.make_model(graph, opset_imports=opset_imports)
+    host_model.ir_version = model.model.ir_version
+    return ModelWrapper(host_model)
+
+
+def extract_host_partitions(parent_model):
+    """Splits the non-dataflow nodes of a dataflow parent model (as produced by
+    CreateDataflowPartition, with a single StreamingDataflowPartition) into a
+    head model running before the accelerator and a tail model running after
+    it. Returns a dict with the "head" and "tail" ModelWrappers, a value is
+    None if there are no such nodes or they cannot be run on the host."""
+    sdp_nodes = parent_model.get_nodes_by_op_type(sdp_op_type)
+    assert len(sdp_nodes) == 1, "Only a single StreamingDataflowPartition supported."
+    sdp_node = sdp_nodes[0]
+    # head: everything the partition transitively depends on
+    head_nodes = []
+    to_visit = list(sdp_node.input)
+    visited = set()
+    while len(to_visit) > 0:
+        tensor = to_visit.pop()
+        if tensor in visited:
+            continue
+        visited.add(tensor)
+        producer = parent_model.find_producer(tensor)
+        if producer is not None and producer not in head_nodes:
+            head_nodes.append(producer)
+            to_visit.extend(producer.input)
+    # keep the original (topological) order
+    head_nodes = [n for n in parent_model.graph.node if n in head_nodes]
+    tail_nodes = [
+        n for n in parent_model.graph.node if n not in head_nodes and n.name != sdp_node.name
+    ]
+    graph_inputs = [x.name for x in parent_model.graph.input]
+    graph_outputs = [x.name for x in parent_model.graph.output]
+    sdp_inputs = [x for x in sdp_node.input if parent_model.get_initializer(x) is None]
+    head = _make_host_model(parent_model, head_nodes, graph_inputs, sdp_inputs, "head")
+    tail = _make_host_model(parent_model, tail_nodes, list(sdp_node.output), graph_outputs, "tail")
+    return {"head": head, "tail": tail}
+
+
+def save_host_partitions(parent_model, out_dir):
+    """Extracts the host partitions of the given dataflow parent model and
+    saves them as host_head.onnx / host_tail.onnx into out_dir. Returns a dict
+    mapping "head" / "tail" to the saved filenames, for the partitions that
+    exist."""
+    ret = {}
+    for kind, host_model in extract_host_partitions(parent_model).items():
+        if host_model is None:
+            continue
+        os.makedirs(out_dir, exist_ok=True)
+        filename = os.path.join(out_dir, "host_%s.onnx" % kind)
+        host_model.save(filename)
+        ret[kind] = filename
+    return ret
@@ -0,0 +1,107 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import hashlib
+import onnx
+import os
+from onnx import TensorProto, numpy_helper
+from onnx.external_data_helper import set_external_data, uses_external_data
+from qonnx.core.modelwrapper import ModelWrapper
+
+
+def save_model(model, filename, blob_dir="blobs", min_bytes=1024):
+    """Saves the ModelWrapper to filename with initializers of at least
+    min_bytes stored as ONNX external data in content-addressed blobs: one
+    file per distinct tensor content, named by its SHA-256 hash, under
+    blob_dir relative to the model file. Tensors that are already stored
+    are not written again, so models sharing most of their weights (e.g.
+    the intermediate models of a build) share their blobs.
+
+    The model in memory is left unchanged. The saved model can be loaded by
+    ModelWrapper and onnx.load as usual, or with load_model."""
+    model_dir = os.path.dirname(os.path.abspath(filename))
+    os.makedirs(os.path.join(model_dir, blob_dir), exist_ok=True)
+    stored = []
+    for init in model.graph.initializer:
+        if uses_external_data(init):
+            continue
+        original = None
+        if not init.HasField("raw_data"):
+            if init.data_type == TensorProto.STRING:
+                continue
+            # typed fields (e.g. float_data) are converted to raw_data for
+            # saving, the original tensor is put back afterwards
+            tensor = numpy_helper.from_array(numpy_helper.to_array(init), init.name)
+            if len(tensor.raw_data) < min_bytes:
+                continue
+            original = TensorProto()
+            original.CopyFrom(init)
+            init.CopyFrom(tensor)
+        raw = init.raw_data
+        if len(raw) < min_bytes:
+            continue
+        location = os.path.join(blob_dir, hashlib.sha256(raw).hexdigest())
+        blob_path = os.path.join(model_dir, location)
+        if not os.path.isfile(blob_path):
+            tmp_path = "%s.%d.tmp" % (blob_path, os.getpid())
+            with open(tmp_path, "wb") as f:
+                f.write(raw)
+            os.replace(tmp_path, blob_path)
+        set_external_data(init, location, length=len(raw))
+        init.ClearField("raw_data")
+        stored.append((init, raw, original))
+    try:
+        onnx.save(model.model, filename)
+    finally:
+        # restore the tensor data in memory
+        for init, raw, original in stored:
+            if original is not None:
+                init.CopyFrom(original)
+                continue
+            init.raw_data = raw
+            init.data_location = TensorProto.DEFAULT
+            del init.external_data[:]
+
+
+def load_model(filename):
+    """Loads a model saved by save_model into a ModelWrapper. The blobs are
+    read directly into the tensors, as protobuf needs its own copy of the
+    bytes anyway. Models without external data load as usual."""
+    model_dir = os.path.dirname(os.path.abspath(filename))
+    model_proto = onnx.load(filename, load_external_data=False)
+    for init in model_proto.graph.initializer:
+        if not uses_external_data(init):
+            continue
+        info = {entry.key: entry.value for entry in init.external_data}
+        with open(os.path.join(model_dir, info["location"]), "rb") as f:
+            f.seek(int(info.get("offset", 0)))
+            init.raw_data = f.read(int(info.get("length", -1)))
+        init.data_location = TensorProto.DEFAULT
+        del init.external_data[:]
+    return ModelWrapper(model_proto)
@@ -0,0 +1,236 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import json
+import multiprocessing as mp
+import os
+import resource
+import time
+import traceback
+from multiprocessing.connection import wait
+
+
+class Job:
+    """A unit of work for the JobScheduler, fn(*args) is run in a separate
+    process and must return a picklable result.
+
+    * key identifies the job across builds in the JobHistory
+    * group names a class of similar jobs whose average is used as
+      prediction for jobs without history of their own
+    * cost is a relative size used to order jobs without any history
+    """
+
+    def __init__(self, key, fn, args=(), group="", cost=0):
+        self.key = key
+        self.fn = fn
+        self.args = args
+        self.group = group
+        self.cost = cost
+
+
+class JobHistory:
+    """Runtime in seconds and peak memory in bytes of previous jobs, kept per
+    job key and per job group. Persisted as JSON under the given path, or only
+    kept in memory if path is None."""
+
+    def __init__(self, path=None):
+        self.path = path
+        self.entries = {}
+        if path is not None and os.path.isfile(path):
+            with open(path, "r") as f:
+                self.entries = json.load(f)
+
+    def _keys(self, job):
+        return [job.key, "group:" + job.group]
+
+    def predict(self, job):
+        """Returns predicted (runtime, memory) of the job, None if unknown."""
+        for key in self._keys(job):
+            if key in self.entries:
+                return (self.entries[key]["runtime"], self.entries[key]["mem"])
+        return (None, None)
+
+    def record(self, job, runtime, mem):
+        for key in self._keys(job):
+            entry = self.entries.get(key, {"runtime": 0.0, "mem": 0, "count": 0})
+            # average over the last few runs to follow tool and host changes
+            n = min(entry["count"], 3)
+            entry["runtime"] = (entry["runtime"] * n + runtime) / (n + 1)
+            entry["mem"] = max(entry["mem"], mem)
+            entry["count"] += 1
+            self.entries[key] = entry
+
+    def save(self):
+        if self.path is None:
+            return
+        # merge with entries of concurrent builds that saved in the meantime
+        entries = JobHistory(self.path).entries
+        entries.update(self.entries)
+        tmp_path = "%s.%d.tmp" % (self.path, os.getpid())
+        with open(tmp_path, "w") as f:
+            json.dump(entries, f, indent=2)
+        os.replace(tmp_path, self.path)
+
+
+def get_job_history():
+    """Returns the JobHistory at FINN_JOB_HISTORY, or at job_history.json in
+    FINN_BUILD_DIR if that is not set."""
+    path = os.environ.get("FINN_JOB_HISTORY")
+    if path is None and "FINN_BUILD_DIR" in os.environ:
+        path = os.path.join(os.environ["FINN_BUILD_DIR"], "job_history.json")
+    return JobHistory(path)
+
+
+def _run_job(fn, args, conn):
+    start = time.time()
+    try:
+        ret = (True, fn(*args))
+    except Exception:
+        ret = (False, traceback.format_exc())
+    runtime = time.time() - start
+    # the heavy lifting is done by tool subprocesses, ru_maxrss is in KiB
+    mem = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss * 1024
+    conn.send(ret + (runtime, mem))
+    conn.close()
+
+
+class LocalBuildHost:
+    """Build host running jobs as processes on this machine, with a number of
+    job slots and a memory budget in bytes. Several instances stand in for
+    separate build hosts sharing a job queue."""
+
+    def __init__(self, name, slots, mem):
+        self.name = name
+        self.slots = slots
+        self.mem = mem
+        self.running = 0
+        self.mem_used = 0
+
+    def fits(self, mem):
+        """Whether a job with given peak memory can start now. An idle host
+        accepts any job so that oversized jobs still run, one at a time."""
+        if self.running >= self.slots:
+            return False
+        return self.running == 0 or self.mem_used + mem <= self.mem
+
+    def start(self, job, mem):
+        """Starts the job and returns its process and the connection its
+        result arrives on."""
+        recv_conn, send_conn = mp.Pipe(duplex=False)
+        proc = mp.Process(target=_run_job, args=(job.fn, job.args, send_conn))
+        proc.start()
+        send_conn.close()
+        self.running += 1
+        self.mem_used += mem
+        return proc, recv_conn
+
+    def finish(self, mem):
+        self.running -= 1
+        self.mem_used -= mem
+
+
+def get_build_hosts(num_workers):
+    """Returns the build hosts to dispatch jobs to. FINN_BUILD_HOSTS lists
+    them as comma-separated name:slots:mem_gb entries. Otherwise, a single
+    host with num_workers slots and 80% of the system memory is used."""
+    hosts_str = os.environ.get("FINN_BUILD_HOSTS", "")
+    if hosts_str != "":
+        hosts = []
+        for host_str in hosts_str.split(","):
+            name, slots, mem_gb = host_str.strip().split(":")
+            hosts.append(LocalBuildHost(name, int(slots), int(float(mem_gb) * 2**30)))
+        return hosts
+    mem = os.sysconf("SC_PAGE_SIZE") * os.sysconf("SC_PHYS_PAGES")
+    return [LocalBuildHost("localhost", num_workers, int(0.8 * mem))]
+
+
+class JobScheduler:
+    """Runs jobs on the given build hosts, longest predicted runtime first so
+    that long jobs do not end up dominating the makespan by starting last.
+    Jobs without history are started first, largest cost first, since their
+    runtime is unknown. A job only starts on a host where its predicted peak
+    memory fits next to the jobs already running there; smaller jobs may
+    start ahead of it in the meantime. Jobs without memory history are
+    assumed to need default_mem bytes.
+
+    Measured runtimes and peak memory are recorded in the history."""
+
+    def __init__(self, hosts, history=None, default_mem=0):
+        self.hosts = hosts
+        self.history = history if history is not None else JobHistory()
+        self.default_mem = default_mem
+
+    def order(self, jobs):
+        """Returns (job index, predicted memory) in the order jobs start."""
+        keyed = []
+        for ind, job in enumerate(jobs):
+            runtime, mem = self.history.predict(job)
+            known = runtime is not None
+            sort_key = (known, -runtime if known else -job.cost, ind)
+            keyed.append((sort_key, ind, mem if mem is not None else self.default_mem))
+        keyed.sort()
+        return [(ind, mem) for (_, ind, mem) in keyed]
+
+    def run(self, jobs):
+        """Runs all jobs and returns their results in the order of jobs."""
+        pending = self.order(jobs)
+        results = [None] * len(jobs)
+        running = {}
+        try:
+            while len(pending) > 0 or len(running) > 0:
+                # start as many pending jobs as the hosts admit, in order
+                for ind, mem in list(pending):
+                    hosts = [h for h in self.hosts if h.fits(mem)]
+                    if hosts == []:
+                        continue
+                    host = max(hosts, key=lambda h: h.mem - h.mem_used)
+                    proc, conn = host.start(jobs[ind], mem)
+                    running[conn] = (ind, mem, host, proc)
+                    pending.remove((ind, mem))
+                # collect finished jobs
+                for conn in wait(list(running.keys())):
+                    ind, mem, host, proc = running.pop(conn)
+                    try:
+                        ok, ret, runtime, peak_mem = conn.recv()
+                    except EOFError:
+                        ok, ret = (False, "Job process exited with code %s" % proc.exitcode)
+                    conn.close()
+                    proc.join()
+                    host.finish(mem)
+                    if not ok:
+                        raise Exception("Job %s failed:\n%s" % (jobs[ind].key, ret))
+                    results[ind] = ret
+                    self.history.record(jobs[ind], runtime, peak_mem)
+        finally:
+            for ind, mem, host, proc in running.values():
+                proc.terminate()
+                proc.join()
+                host.finish(mem)
+            self.history.save()
+        return results
@@ -0,0 +1,112 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+
+# Vectorised kernels for the python-mode execution of the streaming HW layers
+# that operate on NHWC feature maps. All of them work directly on the NHWC
+# layout and, when the data type is integer, on int64 arrays, so there are no
+# layout transposes and no float rounding inside the computation.
+
+
+def to_compute_array(x, dt):
+    """Returns x as an int64 array if the FINN DataType dt is integer, and as
+    a float32 array otherwise."""
+    if dt.is_integer():
+        return np.asarray(x).astype(np.int64)
+    return np.asarray(x, dtype=np.float32)
+
+
+def pad_nhwc(x, pad):
+    """Zero-pads the spatial dimensions of an NHWC tensor. pad is given as
+    [top, left, bottom, right], matching the FMPadding Padding attribute."""
+    n, h, w, c = x.shape
+    ret = np.zeros((n, h + pad[0] + pad[2], w + pad[1] + pad[3], c), dtype=x.dtype)
+    ret[:, pad[0] : pad[0] + h, pad[1] : pad[1] + w, :] = x
+    return ret
+
+
+def maxpool_nhwc(x, kernel, oshape):
+    """Non-overlapping max pooling (stride equal to kernel) of an NHWC tensor.
+    The expected NHWC output shape oshape decides whether incomplete windows
+    at the bottom and right border are dropped (floor mode) or pooled over the
+    available pixels (ceil mode). 1D inputs (H or W equal to 1) are pooled
+    along the non-unit dimension with a kernel of kernel[0] * kernel[1]."""
+    n, h, w, c = x.shape
+    kh, kw = kernel
+    if h == 1 or w == 1:
+        x = x.reshape(n, 1, h * w, c)
+        h, w = 1, h * w
+        kh, kw = 1, kernel[0] * kernel[1]
+        oh, ow = 1, oshape[1] * oshape[2]
+    else:
+        oh, ow = oshape[1], oshape[2]
+    ph, pw = oh * kh, ow * kw
+    if ph > h or pw > w:
+        if np.issubdtype(x.dtype, np.integer):
+            fill = np.iinfo(x.dtype).min
+        else:
+            fill = -np.inf
+        tmp = np.full((n, max(ph, h), max(pw, w), c), fill, dtype=x.dtype)
+        tmp[:, :h, :w, :] = x
+        x = tmp
+    x = x[:, :ph, :pw, :].reshape(n, oh, kh, ow, kw, c)
+    return x.max(axis=(2, 4)).reshape(oshape)
+
+
+def pool_windows_nhwc(x, k2, fnx, shift_bits=0):
+    """Reduces the pooling windows of an NHWC tensor whose last dimension
+    holds k2 window pixels of C channels each, as produced by the sliding
+    window generator. fnx is either MaxPool or QuantAvgPool; the latter sums
+    the window and right-shifts the sum by shift_bits."""
+    x = x.reshape(x.shape[:-1] + (k2, x.shape[-1] // k2))
+    if fnx == "MaxPool":
+        return x.max(axis=-2)
+    elif fnx == "QuantAvgPool":
+        return np.right_shift(x.astype(np.int64).sum(axis=-2), shift_bits)
+    else:
+        raise Exception("Unsupported pooling function: %s" % fnx)
+
+
+def global_sum_nhwc(x):
+    """Sums an NHWC tensor over its spatial dimensions, keeping them as
+    size 1 dimensions."""
+    return x.sum(axis=(1, 2), keepdims=True)
+
+
+def upsample_nearest_nhwc(x, scales):
+    """Nearest-neighbour upsampling of an NHWC tensor by the integer factors
+    scales = (scale_h, scale_w). This matches ONNX Resize in nearest mode with
+    the default half_pixel / round_prefer_floor settings for integer scales."""
+    ret = x
+    if scales[0] != 1:
+        ret = np.repeat(ret, scales[0], axis=1)
+    if scales[1] != 1:
+        ret = np.repeat(ret, scales[1], axis=2)
+    return ret
@@ -75,6 +75,8 @@ class Platform:
         ndevices=1,
         sll_count=[],
         hbm_slr=-1,
+        hbm_channels=0,
+        hbm_channel_gbytes=0,
         ddr_slr=[0],
         eth_slr=0,
         eth_gbps=0,
@@ -87,6 +89,9 @@ class Platform:
         self.eth_gbps = eth_gbps
         self.ndevices = ndevices
         self.hbm_slr = hbm_slr
+        # number of HBM pseudo-channels and bandwidth of each in GB/s
+        self.hbm_channels = hbm_channels
+        self.hbm_channel_gbytes = hbm_channel_gbytes
         self.ddr_slr = ddr_slr
         # limits must be a np.array either of
         # the same shape as compute_resources
@@ -343,6 +348,8 @@ class Alveo_NxU50_Platform(Platform):
             sll_count=sll_counts,
             ddr_slr=[],
             hbm_slr=0,
+            hbm_channels=32,
+            hbm_channel_gbytes=316 / 32,
             eth_slr=1,
             eth_gbps=100,
             limits=limits,
@@ -441,6 +448,8 @@ class Alveo_NxU280_Platform(Platform):
             sll_count=sll_counts,
             ddr_slr=[0, 1],
             hbm_slr=0,
+            hbm_channels=32,
+            hbm_channel_gbytes=460 / 32,
             eth_slr=2,
             eth_gbps=100,
             limits=limits,
@@ -475,6 +484,8 @@ class Alveo_NxU55C_Platform(Platform):
             sll_count=sll_counts,
             ddr_slr=[],
             hbm_slr=0,
+            hbm_channels=32,
+            hbm_channel_gbytes=460 / 32,
             eth_slr=1,
             eth_gbps=100,
             limits=limits,
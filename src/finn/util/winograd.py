@@ -0,0 +1,85 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+
+# Transform matrices for Winograd F(2x2, 3x3), see Lavin & Gray, "Fast
+# Algorithms for Convolutional Neural Networks". The weight transform G is
+# scaled by 2 so that it stays integer; this scales the transformed weights by
+# 4, which the output transform removes again with an exact division, since
+# the untransformed result is an integer sum of products.
+BT = np.asarray([[1, 0, -1, 0], [0, 1, 1, 0], [0, -1, 1, 0], [0, 1, 0, -1]])
+G2 = np.asarray([[2, 0, 0], [1, 1, 1], [1, -1, 1], [0, 0, 2]])
+AT = np.asarray([[1, 1, 1, 0], [0, 1, -1, -1]])
+# scaling of the transformed weights by G2
+SCALE = 4
+
+
+def transform_weights(w):
+    """Transforms 3x3 convolution weights of shape (K, C, 3, 3) into the
+    scaled Winograd domain. Returns an integer array of shape (16, C, K), where
+    the first dimension enumerates the 4x4 tile positions in row-major order."""
+    u = np.einsum("ai,kcij,bj->abck", G2, w, G2)
+    return u.reshape(16, w.shape[1], w.shape[0])
+
+
+def input_transform(x):
+    """Applies the Winograd input transform to an NHWC tensor of shape
+    (1, H, W, C) that already includes the convolution padding. The 4x4 input
+    tiles overlap by 2 pixels, so H and W must be even. Returns a tensor of
+    shape (1, (H-2)/2, (W-2)/2, 16, C)."""
+    _, h, w, c = x.shape
+    th = (h - 2) // 2
+    tw = (w - 2) // 2
+    tiles = np.empty((th, tw, 4, 4, c), dtype=x.dtype)
+    for i in range(4):
+        for j in range(4):
+            tiles[:, :, i, j, :] = x[0, i : i + 2 * th : 2, j : j + 2 * tw : 2, :]
+    v = np.einsum("ai,hwijc,bj->hwabc", BT, tiles, BT)
+    return v.reshape(1, th, tw, 16, c)
+
+
+def output_transform(m):
+    """Applies the Winograd output transform to a tensor of shape
+    (1, TH, TW, 16, K) holding the products of transformed weights and inputs
+    summed over the input channels. Undoes the weight scaling and returns the
+    convolution output of shape (1, 2*TH, 2*TW, K)."""
+    _, th, tw, _, k = m.shape
+    m = m.reshape(th, tw, 4, 4, k)
+    y = np.einsum("ai,hwijk,bj->hawbk", AT, m, AT) / SCALE
+    return y.reshape(1, 2 * th, 2 * tw, k)
+
+
+def transform_range(mat, lo, hi):
+    """Returns the (min, max) over all elements of mat @ x @ mat^T when all
+    elements of x are in [lo, hi]."""
+    coef = np.einsum("ai,bj->abij", mat, mat).reshape(-1, mat.shape[1] ** 2)
+    pos = np.where(coef > 0, coef, 0).sum(axis=1)
+    neg = np.where(coef < 0, coef, 0).sum(axis=1)
+    return int((pos * lo + neg * hi).min()), int((pos * hi + neg * lo).max())
@@ -29,7 +29,11 @@
 
 import pytest
 
+import json
 import numpy as np
+import os
+import shutil
+import subprocess
 from onnx import TensorProto, helper
 from pyverilator.util.axi_utils import axilite_read, axilite_write
 from qonnx.core.datatype import DataType
@@ -50,6 +54,7 @@ from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
 from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
 from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
 from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+from finn.util.basic import make_build_dir
 
 test_fpga_part = "xczu3eg-sbva484-1-e"
 target_clk_ns = 5
@@ -222,3 +227,202 @@ def test_fpgadataflow_checksum():
     assert checksum1_drain == 0, "Drain read doesn't match drain write for second checksum"
 
     # TODO: test for drain set to true
+
+
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_insert_hook_multiple():
+    # several hook kinds per output are chained in a single pass
+    model = create_two_fc_model()
+    for n in model.graph.node:
+        getCustomOp(n).set_nodeattr("output_hook", "checksum,tap")
+
+    model = model.transform(InsertHook(capture_slots=2))
+    model = model.transform(InferShapes())
+
+    op_types = [n.op_type for n in model.graph.node]
+    assert op_types == ["MVAU_hls", "CheckSum_hls", "Tap_hls"] * 2
+    for i in range(len(model.graph.node) - 1):
+        producer = model.graph.node[i]
+        consumer = model.graph.node[i + 1]
+        assert consumer.input[0] == producer.output[0]
+    assert model.graph.output[0].name == model.graph.node[-1].output[0]
+
+    # outputs that already feed a hook layer are left untouched
+    num_nodes = len(model.graph.node)
+    model = model.transform(InsertHook(capture_slots=2))
+    assert len(model.graph.node) == num_nodes
+
+
+@pytest.mark.vivado
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_tap():
+    # use a graph consisting of two fc layers and tap the stream in between
+    model = create_two_fc_model()
+    getCustomOp(model.graph.node[0]).set_nodeattr("output_hook", "tap")
+
+    model = model.transform(InsertHook(capture_slots=2))
+    model = model.transform(GiveUniqueNodeNames())
+    model = model.transform(GiveReadableTensorNames())
+    model = model.transform(InferShapes())
+
+    assert len(model.get_nodes_by_op_type("Tap_hls")) == 1, "Insertion of tap layer failed"
+    assert model.graph.node[1].op_type == "Tap_hls"
+    assert model.get_tensor_shape("Tap_hls_0_out1") == [2, 1, 4]
+
+    x = gen_finn_dt_tensor(DataType["INT32"], (1, 4))
+    inp = {"global_in": x}
+
+    # cppsim captures the only frame into the first slot of the ring buffer
+    model = model.transform(SetExecMode("cppsim"))
+    model = model.transform(PrepareCppSim())
+    model = model.transform(CompileCppSim())
+    y_cppsim = oxe.execute_onnx(model, inp, return_full_exec_context=True)
+    captures = y_cppsim["Tap_hls_0_out1"]
+    assert (captures[0] == y_cppsim["MVAU_hls_0_out0"]).all()
+    assert (captures[1] == 0).all()
+    assert (y_cppsim["global_out"] == y_cppsim["MVAU_hls_0_out0"]).all()
+
+    # rtlsim: the tap is idle after reset and must pass the stream through
+    model = model.transform(InsertFIFO(True))
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    model = model.transform(GiveUniqueNodeNames())
+    model = model.transform(PrepareIP(test_fpga_part, target_clk_ns))
+    model = model.transform(HLSSynthIP())
+    model = model.transform(CreateStitchedIP(test_fpga_part, target_clk_ns))
+    model.set_metadata_prop("exec_mode", "rtlsim")
+    hooks = json.loads(model.get_metadata_prop("vivado_stitch_ifnames"))["hooks"]
+    assert hooks == [{"name": "Tap_hls_0", "hook": "tap", "axilite": "s_axi_control_0"}]
+
+    tap_count = []
+
+    def read_tap_count(sim):
+        tap_inst = getCustomOp(model.get_nodes_by_op_type("Tap_hls")[0])
+        addr = tap_inst.register_offsets["count"]
+        tap_count.append(axilite_read(sim, addr, basename="s_axi_control_0_"))
+
+    ctx = {"global_in": x}
+    rtlsim_exec(model, ctx, post_hook=read_tap_count)
+    assert (ctx["global_out"] == y_cppsim["global_out"]).all()
+    assert int(tap_count[0]) == 0
+
+
+# sequential hls::stream with a capacity: a blocking write into a full stream
+# would stall the pipeline in hardware and fails the assertion here
+tap_bounded_stream = """#ifndef HLS_STREAM_H
+#define HLS_STREAM_H
+#include <cassert>
+#include <cstddef>
+#include <deque>
+// sequential stand-in for hls::stream with an optional capacity, a blocking
+// write to a full stream would deadlock in hardware and fails here
+namespace hls {
+template<typename T>
+class stream {
+    std::deque<T>  q;
+    std::size_t    depth;
+public:
+    stream(char const *name = "", std::size_t depth = 0) : depth(depth) {}
+    bool empty() const { return q.empty(); }
+    bool full() const { return (depth != 0) && (q.size() >= depth); }
+    void write(T const &x) {
+        assert(!full() && "blocking write to a full stream");
+        q.push_back(x);
+    }
+    bool write_nb(T const &x) { if(full())  return false; q.push_back(x); return true; }
+    T read() {
+        assert(!q.empty() && "blocking read from an empty stream");
+        T x = q.front();
+        q.pop_front();
+        return x;
+    }
+    bool read_nb(T &x) { if(q.empty())  return false; x = q.front(); q.pop_front(); return true; }
+};
+}
+#endif
+"""
+
+tap_stall_tb = """#include <cstdio>
+#include "ap_int.h"
+#include "hls_stream.h"
+#include "tap.hpp"
+
+constexpr unsigned  N = 8;
+constexpr unsigned  SLOTS = 4;
+using T = ap_uint<16>;
+using TM = ap_uint<32>;
+static TM  mem[SLOTS*N];
+
+int main() {
+    hls::stream<T>  src("src");
+    hls::stream<T>  dst("dst");
+    hls::stream<TapWord<T>>  cap("cap", 4*N);
+    hls::stream<TapEnd>  end("end", 2);
+    ap_uint<32>  count = 0;
+    ap_uint<32>  dropped = 0;
+    unsigned  errors = 0;
+
+    // capture every frame, the forwarded stream must pass unchanged
+    auto const  forward = [&](unsigned f) {
+        for(unsigned  i = 0; i < N; i++)  src.write(T(f*N + i));
+        tap_forward<N>(src, dst, cap, end, 1, 0, dropped);
+        for(unsigned  i = 0; i < N; i++) {
+            if(dst.empty() || (unsigned(dst.read()) != f*N + i))  errors++;
+        }
+    };
+    auto const  drain = [&]() {
+        for(unsigned  k = 0; k < 4*SLOTS; k++)  tap_writer<N>(cap, end, mem, SLOTS, count);
+    };
+    auto const  check_slot = [&](unsigned s, unsigned f) {
+        for(unsigned  i = 0; i < N; i++) {
+            if(unsigned(mem[s*N + i]) != f*N + i)  errors++;
+        }
+    };
+
+    // stalled writer: frames 0-3 fill the capture queue, the end markers of
+    // frames 2 and 3 and all words of frames 4 and 5 are dropped
+    for(unsigned  f = 0; f < 6; f++)  forward(f);
+    if(dropped != 4)  errors++;
+    drain();
+    if(count != 2)  errors++;
+    check_slot(0, 0);
+    check_slot(1, 1);
+    // frames without an end marker are not merged into the next capture
+    forward(6);
+    drain();
+    if(count != 3)  errors++;
+    if(dropped != 4)  errors++;
+    check_slot(2, 6);
+    std::printf("count=%u dropped=%u errors=%u\\n", unsigned(count), unsigned(dropped), errors);
+    return errors;
+}
+"""
+
+
+@pytest.mark.vivado
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_tap_stalled_writer():
+    # the capture path must never hold up the forwarded stream, even when the
+    # writer does not run at all for several frames
+    test_dir = make_build_dir(prefix="test_tap_stalled_writer_")
+    with open(test_dir + "/hls_stream.h", "w") as f:
+        f.write(tap_bounded_stream)
+    with open(test_dir + "/test.cpp", "w") as f:
+        f.write(tap_stall_tb)
+    cmd_compile = """
+g++ -o test_tap test.cpp -I. -I{}/include -I$FINN_ROOT/custom_hls --std=c++14
+""".format(
+        os.environ["HLS_PATH"]
+    )
+    with open(test_dir + "/compile.sh", "w") as f:
+        f.write(cmd_compile)
+    compile = subprocess.Popen(["sh", "compile.sh"], stdout=subprocess.PIPE, cwd=test_dir)
+    compile.communicate()
+    assert compile.returncode == 0, "Compilation of the tap testbench failed"
+    execute = subprocess.Popen("./test_tap", stdout=subprocess.PIPE, cwd=test_dir)
+    (stdout, stderr) = execute.communicate()
+    success = execute.returncode == 0
+    # only delete generated code if test has passed
+    # useful for debug otherwise
+    if success:
+        shutil.rmtree(test_dir)
+    assert success, stdout.decode()
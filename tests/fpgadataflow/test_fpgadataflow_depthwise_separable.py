@@ -0,0 +1,218 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.general import GiveUniqueNodeNames
+from qonnx.transformation.infer_datatypes import InferDataTypes
+from qonnx.transformation.infer_shapes import InferShapes
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+import finn.core.onnx_exec as oxe
+from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.transformation.fpgadataflow.compile_cppsim import CompileCppSim
+from finn.transformation.fpgadataflow.fuse_depthwise_separable import (
+    FuseDepthwiseSeparable,
+)
+from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
+from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
+from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
+from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
+from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
+from finn.transformation.fpgadataflow.set_folding import SetFolding
+from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+
+test_fpga_part = "xczu3eg-sbva484-1-e"
+target_clk_ns = 5
+
+
+def make_dw_pw_model(k, dim, ch, mh, simd, pe, ksimd, idt, dwdt, mdt, pwdt, odt):
+    """Builds a depthwise VVAU followed by a pointwise MVAU. The VVAU uses
+    thresholds to produce mdt, the MVAU uses thresholds if odt is not None."""
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, dim, dim, k * k * ch])
+    mid = helper.make_tensor_value_info("mid", TensorProto.FLOAT, [1, dim, dim, ch])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, dim, dim, mh])
+    dw_node = helper.make_node(
+        "VVAU",
+        ["inp", "dw_weights", "dw_thresh"],
+        ["mid"],
+        domain="finn.custom_op.fpgadataflow",
+        backend="fpgadataflow",
+        PE=simd,
+        SIMD=ksimd,
+        Dim=[dim, dim],
+        Channels=ch,
+        Kernel=[k, k],
+        resType="lut",
+        ActVal=mdt.min(),
+        inputDataType=idt.name,
+        weightDataType=dwdt.name,
+        outputDataType=mdt.name,
+        noActivation=0,
+        mem_mode="internal_embedded",
+    )
+    pw_node = helper.make_node(
+        "MVAU",
+        ["mid", "pw_weights"] + ([] if odt is None else ["pw_thresh"]),
+        ["outp"],
+        domain="finn.custom_op.fpgadataflow",
+        backend="fpgadataflow",
+        MW=ch,
+        MH=mh,
+        SIMD=simd,
+        PE=pe,
+        numInputVectors=[1, dim, dim],
+        resType="lut",
+        ActVal=0 if odt is None else odt.min(),
+        inputDataType=mdt.name,
+        weightDataType=pwdt.name,
+        outputDataType=DataType["INT32"].name if odt is None else odt.name,
+        noActivation=1 if odt is None else 0,
+        mem_mode="internal_embedded",
+    )
+    graph = helper.make_graph(
+        nodes=[dw_node, pw_node],
+        name="dwsep_graph",
+        inputs=[inp],
+        outputs=[outp],
+        value_info=[mid],
+    )
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="dwsep-model"))
+    model.set_tensor_datatype("inp", idt)
+    model.set_initializer("dw_weights", gen_finn_dt_tensor(dwdt, (ch, 1, k, k)))
+    model.set_tensor_datatype("dw_weights", dwdt)
+    # random sorted thresholds within the range of the dot products
+    dw_range = k * k * max(abs(idt.min()), idt.max()) * max(abs(dwdt.min()), dwdt.max())
+    dw_thresh = np.random.randint(-dw_range, dw_range + 1, (ch, mdt.get_num_possible_values() - 1))
+    model.set_initializer("dw_thresh", np.sort(dw_thresh, axis=1).astype(np.float32))
+    model.set_initializer("pw_weights", gen_finn_dt_tensor(pwdt, (ch, mh)))
+    model.set_tensor_datatype("pw_weights", pwdt)
+    if odt is not None:
+        pw_range = ch * max(abs(mdt.min()), mdt.max()) * max(abs(pwdt.min()), pwdt.max())
+        pw_thresh = np.random.randint(
+            -pw_range, pw_range + 1, (mh, odt.get_num_possible_values() - 1)
+        )
+        model.set_initializer("pw_thresh", np.sort(pw_thresh, axis=1).astype(np.float32))
+    model = model.transform(InferShapes())
+    model = model.transform(InferDataTypes())
+    return model
+
+
+# kernel size, feature map size
+@pytest.mark.parametrize("k", [3, 1])
+@pytest.mark.parametrize("dim", [4])
+# channels, output channels
+@pytest.mark.parametrize("ch", [4])
+@pytest.mark.parametrize("mh", [6])
+# SIMD, PE, KernelSIMD
+@pytest.mark.parametrize("folding", [(1, 1, 1), (2, 3, 1), (4, 2, 3)])
+# pointwise activation: None or DataType
+@pytest.mark.parametrize("odt", [None, DataType["UINT4"]])
+@pytest.mark.parametrize("exec_mode", ["cppsim", "rtlsim"])
+@pytest.mark.fpgadataflow
+@pytest.mark.vivado
+def test_fpgadataflow_depthwise_separable(k, dim, ch, mh, folding, odt, exec_mode):
+    simd, pe, ksimd = folding
+    if (k * k) % ksimd != 0:
+        pytest.skip("KernelSIMD does not divide the kernel size")
+    idt = DataType["UINT4"]
+    dwdt = DataType["INT4"]
+    mdt = DataType["UINT4"]
+    pwdt = DataType["INT2"]
+    model = make_dw_pw_model(k, dim, ch, mh, simd, pe, ksimd, idt, dwdt, mdt, pwdt, odt)
+    x = gen_finn_dt_tensor(idt, (1, dim, dim, k * k * ch))
+    idict = {"inp": x}
+    y_expected = oxe.execute_onnx(model, idict)["outp"]
+
+    model = model.transform(FuseDepthwiseSeparable())
+    assert len(model.graph.node) == 1
+    assert model.graph.node[0].op_type == "DepthwiseSeparable"
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all()
+
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    assert model.graph.node[0].op_type == "DepthwiseSeparable_hls"
+    if exec_mode == "cppsim":
+        model = model.transform(PrepareCppSim())
+        model = model.transform(CompileCppSim())
+        model = model.transform(SetExecMode("cppsim"))
+    elif exec_mode == "rtlsim":
+        model = model.transform(SetExecMode("rtlsim"))
+        model = model.transform(GiveUniqueNodeNames())
+        model = model.transform(PrepareIP(test_fpga_part, target_clk_ns))
+        model = model.transform(HLSSynthIP())
+        model = model.transform(PrepareRTLSim())
+    else:
+        raise Exception("Unknown exec_mode")
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all(), exec_mode + " failed"
+    if exec_mode == "rtlsim":
+        node = model.get_nodes_by_op_type("DepthwiseSeparable_hls")[0]
+        cycles_rtlsim = getCustomOp(node).get_nodeattr("cycles_rtlsim")
+        exp_cycles_dict = model.analysis(exp_cycles_per_layer)
+        exp_cycles = exp_cycles_dict[node.name]
+        assert np.isclose(exp_cycles, cycles_rtlsim, atol=15)
+        assert exp_cycles != 0
+
+
+@pytest.mark.fpgadataflow
+def test_fuse_depthwise_separable_folding():
+    model = make_dw_pw_model(
+        3,
+        4,
+        4,
+        6,
+        1,
+        1,
+        1,
+        DataType["UINT4"],
+        DataType["INT4"],
+        DataType["UINT4"],
+        DataType["INT2"],
+        None,
+    )
+    # externally streamed weights can't be embedded into the fused block
+    getCustomOp(model.graph.node[1]).set_nodeattr("mem_mode", "external")
+    assert len(model.transform(FuseDepthwiseSeparable()).graph.node) == 2
+    getCustomOp(model.graph.node[1]).set_nodeattr("mem_mode", "internal_embedded")
+    model = model.transform(FuseDepthwiseSeparable())
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    model = model.transform(SetFolding(target_cycles_per_frame=100, two_pass_relaxation=False))
+    inst = getCustomOp(model.graph.node[0])
+    # the depthwise stage needs KernelSIMD on top of full SIMD, the
+    # pointwise stage does not need its full PE
+    assert inst.get_nodeattr("SIMD") == 4
+    assert inst.get_nodeattr("KernelSIMD") == 3
+    assert inst.get_nodeattr("PE") == 1
+    assert max(inst.get_stage_exp_cycles()) < 100
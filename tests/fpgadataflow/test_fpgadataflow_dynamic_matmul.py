@@ -0,0 +1,138 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.general import GiveUniqueNodeNames
+from qonnx.transformation.infer_shapes import InferShapes
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+import finn.core.onnx_exec as oxe
+from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.transformation.fpgadataflow.compile_cppsim import CompileCppSim
+from finn.transformation.fpgadataflow.convert_to_hw_layers import InferDynamicMatMul
+from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
+from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
+from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
+from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
+from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
+from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+
+test_fpga_part = "xczu3eg-sbva484-1-e"
+target_clk_ns = 5
+
+
+def make_dynamic_matmul_model(vecs, m, k, n, idt0, idt1):
+    ishape0 = vecs + [m, k]
+    ishape1 = vecs + [k, n]
+    oshape = vecs + [m, n]
+    inp0 = helper.make_tensor_value_info("inp0", TensorProto.FLOAT, ishape0)
+    inp1 = helper.make_tensor_value_info("inp1", TensorProto.FLOAT, ishape1)
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, oshape)
+    mm_node = helper.make_node("MatMul", ["inp0", "inp1"], ["outp"])
+    graph = helper.make_graph(
+        nodes=[mm_node], name="dynmm_graph", inputs=[inp0, inp1], outputs=[outp]
+    )
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="dynmm-model"))
+    model.set_tensor_datatype("inp0", idt0)
+    model.set_tensor_datatype("inp1", idt1)
+    model.set_tensor_datatype("outp", DataType["INT32"])
+    model = model.transform(InferShapes())
+    return model
+
+
+# leading dims, e.g. (batch, heads)
+@pytest.mark.parametrize("vecs", [[1], [1, 2]])
+# M, K, N
+@pytest.mark.parametrize("dims", [(4, 8, 6), (3, 4, 4)])
+@pytest.mark.parametrize("idt0", [DataType["INT4"], DataType["UINT4"]])
+@pytest.mark.parametrize("idt1", [DataType["INT3"], DataType["UINT2"]])
+# SIMD, PE
+@pytest.mark.parametrize("folding", [(1, 1), (2, 2), (4, 3)])
+@pytest.mark.parametrize("exec_mode", ["cppsim", "rtlsim"])
+@pytest.mark.fpgadataflow
+@pytest.mark.vivado
+def test_fpgadataflow_dynamic_matmul(vecs, dims, idt0, idt1, folding, exec_mode):
+    m, k, n = dims
+    simd, pe = folding
+    if k % simd != 0 or n % pe != 0:
+        pytest.skip("Folding does not divide matrix dimensions")
+    model = make_dynamic_matmul_model(vecs, m, k, n, idt0, idt1)
+    x0 = gen_finn_dt_tensor(idt0, vecs + [m, k])
+    x1 = gen_finn_dt_tensor(idt1, vecs + [k, n])
+    idict = {"inp0": x0, "inp1": x1}
+    y_expected = np.matmul(x0, x1)
+
+    model = model.transform(InferDynamicMatMul())
+    assert model.graph.node[0].op_type == "DynamicMatMul"
+    odt = model.get_tensor_datatype("outp")
+    assert odt.allowed(y_expected.min()) and odt.allowed(y_expected.max())
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all()
+
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    assert model.graph.node[0].op_type == "DynamicMatMul_hls"
+    inst = getCustomOp(model.graph.node[0])
+    inst.set_nodeattr("SIMD", simd)
+    inst.set_nodeattr("PE", pe)
+    if exec_mode == "cppsim":
+        model = model.transform(PrepareCppSim())
+        model = model.transform(CompileCppSim())
+        model = model.transform(SetExecMode("cppsim"))
+    elif exec_mode == "rtlsim":
+        model = model.transform(SetExecMode("rtlsim"))
+        model = model.transform(GiveUniqueNodeNames())
+        model = model.transform(PrepareIP(test_fpga_part, target_clk_ns))
+        model = model.transform(HLSSynthIP())
+        model = model.transform(PrepareRTLSim())
+    else:
+        raise Exception("Unknown exec_mode")
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all(), exec_mode + " failed"
+    if exec_mode == "rtlsim":
+        node = model.get_nodes_by_op_type("DynamicMatMul_hls")[0]
+        cycles_rtlsim = getCustomOp(node).get_nodeattr("cycles_rtlsim")
+        exp_cycles_dict = model.analysis(exp_cycles_per_layer)
+        exp_cycles = exp_cycles_dict[node.name]
+        assert np.isclose(exp_cycles, cycles_rtlsim, atol=15)
+        assert exp_cycles != 0
+
+
+@pytest.mark.fpgadataflow
+def test_infer_dynamic_matmul_skips_static_weights():
+    # MatMul with an initializer belongs to InferQuantizedMatrixVectorActivation
+    model = make_dynamic_matmul_model([1], 2, 4, 4, DataType["INT4"], DataType["INT4"])
+    model.set_initializer("inp1", gen_finn_dt_tensor(DataType["INT4"], [1, 4, 4]))
+    model = model.transform(InferDynamicMatMul())
+    assert model.graph.node[0].op_type == "MatMul"
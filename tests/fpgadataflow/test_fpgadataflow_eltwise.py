@@ -51,16 +51,16 @@ from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
 from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
 
 
-def build_model(shp, dt0, dt1, do_abs):
+def build_model(shp, dt0, dt1, eltwise_op):
     np.random.seed(0)
     shp_str = str(shp)
-    if do_abs:
+    if eltwise_op == "AbsDiff":
         graph = """
         sub_out = Sub(in0, in1)
         out0 = Abs(sub_out)
         """
     else:
-        graph = "out0 = Sub(in0, in1)"
+        graph = "out0 = %s(in0, in1)" % eltwise_op
 
     input = f"""
     <
@@ -88,13 +88,13 @@ def build_model(shp, dt0, dt1, do_abs):
 @pytest.mark.parametrize("ch", [1, 64])
 # folding
 @pytest.mark.parametrize("fold", [-1, 2, 1])
-# include Abs output node or not
-@pytest.mark.parametrize("do_abs", [True, False])
+# eltwise op, AbsDiff is built as Sub -> Abs
+@pytest.mark.parametrize("eltwise_op", ["Sub", "AbsDiff", "Mul", "Max", "Min"])
 # execution mode
 @pytest.mark.parametrize("exec_mode", ["cppsim", "rtlsim"])
 @pytest.mark.fpgadataflow
 @pytest.mark.vivado
-def test_fpgadataflow_eltwise(dt0, ch, fold, do_abs, exec_mode):
+def test_fpgadataflow_eltwise(dt0, ch, fold, eltwise_op, exec_mode):
     if fold == -1:
         pe = 1
     else:
@@ -102,7 +102,7 @@ def test_fpgadataflow_eltwise(dt0, ch, fold, do_abs, exec_mode):
     assert ch % pe == 0
     dt1 = DataType["UINT8"]
     shp = [1, 4, 2, ch]
-    model = build_model(shp, dt0, dt1, do_abs)
+    model = build_model(shp, dt0, dt1, eltwise_op)
     in0 = gen_finn_dt_tensor(dt0, shp)
     in1 = gen_finn_dt_tensor(dt1, shp)
     idict = {"in0": in0, "in1": in1}
@@ -110,6 +110,7 @@ def test_fpgadataflow_eltwise(dt0, ch, fold, do_abs, exec_mode):
     model = model.transform(to_hw.InferStreamingEltwise())
     assert len(model.graph.node) == 1
     assert model.graph.node[0].op_type == "StreamingEltwise"
+    assert getCustomOp(model.graph.node[0]).get_nodeattr("eltwiseOp") == eltwise_op
 
     y_produced = execute_onnx(model, idict)["out0"]
     assert (y_produced == y_expected).all(), exec_mode + " failed"
@@ -141,3 +142,23 @@ def test_fpgadataflow_eltwise(dt0, ch, fold, do_abs, exec_mode):
         exp_cycles = exp_cycles_dict[node.name]
         assert np.isclose(exp_cycles, cycles_rtlsim, atol=10)
         assert exp_cycles != 0
+
+
+@pytest.mark.parametrize(
+    "eltwise_op, dt0, dt1, exp_odt",
+    [
+        ("Mul", DataType["UINT4"], DataType["UINT8"], DataType["UINT12"]),
+        ("Mul", DataType["INT4"], DataType["UINT4"], DataType["INT8"]),
+        ("Max", DataType["INT4"], DataType["UINT4"], DataType["UINT4"]),
+        ("Min", DataType["INT4"], DataType["UINT4"], DataType["INT4"]),
+        ("Min", DataType["UINT4"], DataType["UINT8"], DataType["UINT4"]),
+    ],
+)
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_eltwise_odt(eltwise_op, dt0, dt1, exp_odt):
+    model = build_model([1, 4], dt0, dt1, eltwise_op)
+    model = model.transform(to_hw.InferStreamingEltwise())
+    inst = getCustomOp(model.graph.node[0])
+    assert inst.get_output_datatype() == exp_odt
+    exp_dsp = 1 if eltwise_op == "Mul" and min(dt0.bitwidth(), dt1.bitwidth()) > 4 else 0
+    assert inst.dsp_estimation("xc7z020clg400-1") == exp_dsp
@@ -33,14 +33,20 @@ import os
 from onnx import TensorProto, helper
 from qonnx.core.datatype import DataType
 from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
 from qonnx.transformation.general import GiveUniqueNodeNames
-from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+from qonnx.util.basic import (
+    gen_finn_dt_tensor,
+    qonnx_make_model,
+    roundup_to_integer_multiple,
+)
 
 import finn.core.onnx_exec as oxe
 from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
 from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
 from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
 from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
+from finn.transformation.fpgadataflow.set_fifo_depths import InsertAndSetFIFODepths
 from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
 
 build_dir = os.environ["FINN_BUILD_DIR"]
@@ -109,3 +115,52 @@ def test_fpgadataflow_fifo_rtlsim(Shape, folded_shape, depth, finn_dtype):
     ).all(), """The output values are not the same as the
        input values anymore."""
     assert y.shape == tuple(Shape), """The output shape is incorrect."""
+
+
+@pytest.mark.parametrize("depth", [1000, 4096])
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_fifo_dram(depth):
+    Shape = [1, 128]
+    folded_shape = [1, 1, 128]
+    finn_dtype = DataType["INT2"]
+    model = make_single_fifo_modelwrapper(Shape, depth, folded_shape, finn_dtype)
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    model = model.transform(GiveUniqueNodeNames())
+    node = model.get_nodes_by_op_type("StreamingFIFO_rtl")[0]
+    inst = getCustomOp(node)
+    inst.set_nodeattr("impl_style", "dram")
+    inst.set_nodeattr("dram_base_addr", 0x10000000)
+
+    # 256-bit stream words, one per memory beat, in bursts of 64 beats
+    assert inst.get_dram_mem_width() == 256
+    assert inst.get_dram_burst_len() == 64
+    assert inst.get_adjusted_depth() == roundup_to_integer_multiple(depth, 64)
+    assert inst.get_dram_bytes() == inst.get_adjusted_depth() * 32
+    assert inst.get_verilog_top_module_intf_names()["aximm"] == [("m_axi_gmem", 256)]
+    assert inst.bram_estimation() == 0
+    assert inst.uram_estimation() == 0
+
+    model = model.transform(PrepareIP(test_fpga_part, target_clk_ns))
+    inst = getCustomOp(model.get_nodes_by_op_type("StreamingFIFO_rtl")[0])
+    code_gen_dir = inst.get_nodeattr("code_gen_dir_ipgen")
+    assert os.path.isfile(code_gen_dir + "/dram_fifo.sv")
+    with open(code_gen_dir + "/" + inst.get_nodeattr("gen_top_module") + ".v") as f:
+        top = f.read()
+    assert "64'h10000000" in top
+    assert "dram_fifo #(" in top
+
+
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_fifo_dram_limits():
+    # 2048-bit stream words exceed the widest legal AXI-MM data bus
+    Shape = [1, 1024]
+    folded_shape = [1, 1, 1024]
+    model = make_single_fifo_modelwrapper(Shape, 4096, folded_shape, DataType["INT2"])
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    inst = getCustomOp(model.get_nodes_by_op_type("StreamingFIFO_rtl")[0])
+    inst.set_nodeattr("impl_style", "dram")
+    with pytest.raises(AssertionError):
+        inst.get_dram_mem_width()
+    # the ring buffer needs an explicitly reserved memory region
+    with pytest.raises(AssertionError):
+        InsertAndSetFIFODepths(test_fpga_part, max_onchip_depth=1024)
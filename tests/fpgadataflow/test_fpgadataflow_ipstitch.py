@@ -40,19 +40,37 @@ from qonnx.transformation.infer_data_layouts import InferDataLayouts
 from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
 
 from finn.core.onnx_exec import execute_onnx
+from finn.transformation.fpgadataflow.assign_hbm_channels import (
+    AssignHBMChannels,
+    balance_hbm_channels,
+)
 from finn.transformation.fpgadataflow.create_dataflow_partition import (
     CreateDataflowPartition,
 )
 from finn.transformation.fpgadataflow.create_stitched_ip import CreateStitchedIP
 from finn.transformation.fpgadataflow.floorplan import Floorplan
 from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
+from finn.transformation.fpgadataflow.insert_dwc import InsertDWC
+from finn.transformation.fpgadataflow.insert_fifo import InsertFIFO
 from finn.transformation.fpgadataflow.insert_iodma import InsertIODMA
 from finn.transformation.fpgadataflow.insert_tlastmarker import InsertTLastMarker
 from finn.transformation.fpgadataflow.make_zynq_proj import ZynqBuild
 from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
-from finn.transformation.fpgadataflow.synth_ooc import SynthOutOfContext
+from finn.transformation.fpgadataflow.prepare_stitched_cppsim import (
+    PrepareStitchedCppSim,
+)
+from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+from finn.transformation.fpgadataflow.synth_ooc import (
+    SynthOutOfContext,
+    SynthOutOfContextPerNode,
+)
 from finn.transformation.fpgadataflow.vitis_build import VitisBuild
-from finn.util.basic import alveo_default_platform, alveo_part_map, pynq_part_map
+from finn.util.basic import (
+    alveo_default_platform,
+    alveo_part_map,
+    make_build_dir,
+    pynq_part_map,
+)
 from finn.util.pyverilator import pyverilate_stitched_ip
 from finn.util.test import load_test_checkpoint_or_skip
 
@@ -195,6 +213,149 @@ def create_two_fc_model(mem_mode="internal_decoupled"):
     return model
 
 
+def create_conv_fc_model(mem_mode="internal_decoupled"):
+    # create a model with a sliding window generator feeding two
+    # MatrixVectorActivation instances, the first two layers prefer their RTL
+    # variant and the folding differs between all layers
+    idt = DataType["INT4"]
+    mdt = DataType["INT11"]
+    odt = DataType["INT32"]
+    w0dt = DataType["INT4"]
+    w1dt = DataType["INT2"]
+    ifm_ch = 2
+    ifm_dim = 4
+    k = 2
+    ofm_dim = ifm_dim - k + 1
+    mw0 = k * k * ifm_ch
+    mh = 4
+
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, ifm_dim, ifm_dim, ifm_ch])
+    win = helper.make_tensor_value_info("win", TensorProto.FLOAT, [1, ofm_dim, ofm_dim, mw0])
+    mid = helper.make_tensor_value_info("mid", TensorProto.FLOAT, [1, ofm_dim, ofm_dim, mh])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, ofm_dim, ofm_dim, mh])
+
+    swg = helper.make_node(
+        "ConvolutionInputGenerator",
+        ["inp"],
+        ["win"],
+        domain="finn.custom_op.fpgadataflow",
+        backend="fpgadataflow",
+        ConvKernelDim=[k, k],
+        IFMChannels=ifm_ch,
+        IFMDim=[ifm_dim, ifm_dim],
+        OFMDim=[ofm_dim, ofm_dim],
+        SIMD=ifm_ch,
+        Stride=[1, 1],
+        Dilation=[1, 1],
+        inputDataType=idt.name,
+        outputDataType=idt.name,
+        preferred_impl_style="rtl",
+    )
+
+    fc0 = helper.make_node(
+        "MVAU",
+        ["win", "w0"],
+        ["mid"],
+        domain="finn.custom_op.fpgadataflow",
+        backend="fpgadataflow",
+        MW=mw0,
+        MH=mh,
+        SIMD=4,
+        PE=2,
+        inputDataType=idt.name,
+        weightDataType=w0dt.name,
+        outputDataType=mdt.name,
+        ActVal=0,
+        binaryXnorMode=0,
+        noActivation=1,
+        mem_mode="internal_decoupled",
+        preferred_impl_style="rtl",
+    )
+
+    fc1 = helper.make_node(
+        "MVAU",
+        ["mid", "w1"],
+        ["outp"],
+        domain="finn.custom_op.fpgadataflow",
+        backend="fpgadataflow",
+        MW=mh,
+        MH=mh,
+        SIMD=1,
+        PE=4,
+        inputDataType=mdt.name,
+        weightDataType=w1dt.name,
+        outputDataType=odt.name,
+        ActVal=0,
+        binaryXnorMode=0,
+        noActivation=1,
+        mem_mode=mem_mode,
+        preferred_impl_style="hls",
+    )
+
+    graph = helper.make_graph(
+        nodes=[swg, fc0, fc1],
+        name="convfc_graph",
+        inputs=[inp],
+        outputs=[outp],
+        value_info=[win, mid],
+    )
+
+    model = qonnx_make_model(graph, producer_name="convfc-model")
+    model = ModelWrapper(model)
+
+    model.set_tensor_datatype("inp", idt)
+    model.set_tensor_datatype("win", idt)
+    model.set_tensor_datatype("mid", mdt)
+    model.set_tensor_datatype("outp", odt)
+    model.set_tensor_datatype("w0", w0dt)
+    model.set_tensor_datatype("w1", w1dt)
+
+    # generate weights, narrow range so that the RTL MVAU fits DSP48E1
+    w0 = np.random.randint(w0dt.min() + 1, w0dt.max() + 1, size=(mw0, mh))
+    w1 = gen_finn_dt_tensor(w1dt, (mh, mh))
+    model.set_initializer("w0", w0.astype(np.float32))
+    model.set_initializer("w1", w1)
+
+    return model
+
+
+@pytest.mark.parametrize("mem_mode", ["internal_embedded", "internal_decoupled"])
+@pytest.mark.parametrize("threaded", [True, False])
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_ipstitch_cppsim(mem_mode, threaded):
+    model = create_conv_fc_model(mem_mode)
+    x = gen_finn_dt_tensor(DataType["INT4"], (1, 4, 4, 2))
+    y_expected = execute_onnx(model, {"inp": x})["outp"]
+
+    model = model.transform(InsertDWC())
+    model = model.transform(InsertFIFO(create_shallow_fifos=True))
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    model = model.transform(InsertTLastMarker())
+    model = model.transform(GiveUniqueNodeNames())
+    # the RTL layers are simulated through their HLS variants, the folding
+    # mismatches through RTL data width converters
+    op_types = [n.op_type for n in model.graph.node]
+    assert "ConvolutionInputGenerator_rtl" in op_types
+    assert "MVAU_rtl" in op_types
+    assert "MVAU_hls" in op_types
+    assert op_types.count("StreamingDataWidthConverter_rtl") == 2
+    model = model.transform(PrepareStitchedCppSim())
+    exe = model.get_metadata_prop("stitched_cppsim_exe")
+    assert os.path.isfile(exe)
+    with open(os.path.join(os.path.dirname(exe), "stitched_main.cpp")) as f:
+        main_src = f.read()
+    assert "StreamDwcModel<8, 16>" in main_src
+    assert "StreamDwcModel<22, 11>" in main_src
+    # the 22-bit MVAU output passes through a FIFO of padded width
+    assert "StreamPassThroughModel<ap_uint<22>, ap_uint<24>>" in main_src
+    assert "StreamPassThroughModel<ap_uint<24>, ap_uint<22>>" in main_src
+    model.set_metadata_prop("exec_mode", "stitched_cppsim")
+    if not threaded:
+        model.set_metadata_prop("stitched_cppsim_threads", "0")
+    ret = execute_onnx(model, {"inp": x})
+    assert (ret["outp"] == y_expected).all()
+
+
 @pytest.mark.parametrize("mem_mode", ["internal_embedded", "internal_decoupled"])
 @pytest.mark.fpgadataflow
 @pytest.mark.vivado
@@ -281,6 +442,38 @@ def test_fpgadataflow_ipstitch_rtlsim(mem_mode):
     assert (rtlsim_res == x).all()
 
 
+@pytest.mark.parametrize("mem_mode", ["internal_embedded", "internal_decoupled"])
+@pytest.mark.fpgadataflow
+@pytest.mark.vivado
+def test_fpgadataflow_ipstitch_incremental(mem_mode):
+    model = load_test_checkpoint_or_skip(
+        ip_stitch_model_dir + "/test_fpgadataflow_ip_stitch_%s.onnx" % mem_mode
+    )
+    prev_dir = model.get_metadata_prop("vivado_stitch_proj")
+    # nothing changed, the previous project is kept
+    model = model.transform(CreateStitchedIP(test_fpga_part, 5, incremental=True))
+    assert model.get_metadata_prop("vivado_stitch_proj") == prev_dir
+    # regenerate the MVAU IP, only its cell is replaced in a copy of the project
+    mvau = getCustomOp(model.get_nodes_by_op_type("MVAU_hls")[0])
+    for attr in ["code_gen_dir_ipgen", "ipgen_path", "ip_path"]:
+        mvau.set_nodeattr(attr, "")
+    model = model.transform(PrepareIP(test_fpga_part, 5))
+    model = model.transform(HLSSynthIP())
+    model = model.transform(CreateStitchedIP(test_fpga_part, 5, incremental=True))
+    vivado_stitch_proj_dir = model.get_metadata_prop("vivado_stitch_proj")
+    assert vivado_stitch_proj_dir != prev_dir
+    assert os.path.isfile(vivado_stitch_proj_dir + "/ip/component.xml")
+    with open(vivado_stitch_proj_dir + "/make_project.tcl", "r") as f:
+        tcl = f.read()
+    assert "open_project" in tcl and "create_bd_design" not in tcl
+    model.set_metadata_prop("exec_mode", "rtlsim")
+    idt = model.get_tensor_datatype("inp")
+    ishape = model.get_tensor_shape("inp")
+    x = gen_finn_dt_tensor(idt, ishape)
+    rtlsim_res = execute_onnx(model, {"inp": x})["outp"]
+    assert (rtlsim_res == x).all()
+
+
 @pytest.mark.parametrize("mem_mode", ["internal_embedded", "internal_decoupled"])
 @pytest.mark.fpgadataflow
 @pytest.mark.vivado
@@ -304,6 +497,36 @@ def test_fpgadataflow_ipstitch_synth_ooc(mem_mode):
     assert ret["fmax_mhz"] > 100
 
 
+@pytest.mark.parametrize("mem_mode", ["internal_embedded", "internal_decoupled"])
+@pytest.mark.fpgadataflow
+@pytest.mark.vivado
+@pytest.mark.slow
+def test_fpgadataflow_ipstitch_synth_ooc_per_node(mem_mode):
+    model = load_test_checkpoint_or_skip(
+        ip_stitch_model_dir + "/test_fpgadataflow_ip_stitch_%s.onnx" % mem_mode
+    )
+    cache_dir = make_build_dir("ooc_synth_cache_")
+    model = model.transform(SynthOutOfContextPerNode(test_fpga_part, 5, cache_dir=cache_dir))
+    # every synthesized node (MVAU and TLastMarker) gets results and a cache entry
+    node_res = {}
+    for node in model.graph.node:
+        res = getCustomOp(node).get_nodeattr("res_synth")
+        if res != "":
+            node_res[node.name] = eval(res)
+    mvau_res = [res for name, res in node_res.items() if name.startswith("MVAU")]
+    assert len(mvau_res) > 0
+    assert all([res["LUT"] > 0 for res in mvau_res])
+    assert len(os.listdir(cache_dir)) == len(node_res)
+    ret = eval(model.get_metadata_prop("res_total_ooc_synth"))
+    assert ret["LUT"] >= sum([res["LUT"] for res in node_res.values()])
+    assert ret["fmax_mhz"] > 100
+    # unchanged nodes are taken from the cache on the next run
+    model = model.transform(SynthOutOfContextPerNode(test_fpga_part, 5, cache_dir=cache_dir))
+    for node_name, res in node_res.items():
+        inst = getCustomOp(model.get_node_from_name(node_name))
+        assert eval(inst.get_nodeattr("res_synth")) == res
+
+
 @pytest.mark.fpgadataflow
 def test_fpgadataflow_ipstitch_iodma_floorplan():
     model = create_one_fc_model()
@@ -321,6 +544,36 @@ def test_fpgadataflow_ipstitch_iodma_floorplan():
     model.save(ip_stitch_model_dir + "/test_fpgadataflow_ipstitch_iodma_floorplan.onnx")
 
 
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_ipstitch_hbm_placement():
+    # heaviest streams are spread over separate channels first
+    (assignment, load) = balance_hbm_channels([10, 1, 8, 1], 2)
+    assert assignment == [0, 1, 1, 1]
+    assert load == [10, 10]
+
+    model = create_one_fc_model("external")
+    if model.graph.node[0].op_type == "StreamingDataflowPartition":
+        sdp_node = getCustomOp(model.graph.node[0])
+        model = load_test_checkpoint_or_skip(sdp_node.get_nodeattr("model"))
+    model = model.transform(InferDataLayouts())
+    model = model.transform(InsertIODMA())
+    model = model.transform(Floorplan())
+    model = model.transform(CreateDataflowPartition())
+    model = model.transform(GiveUniqueNodeNames())
+
+    # no HBM, no assignment
+    model_ddr = model.transform(AssignHBMChannels(alveo_default_platform["U250"]))
+    assert all([getCustomOp(x).get_nodeattr("mem_port") == "" for x in model_ddr.graph.node])
+
+    # input, weight and output DMAs each get their own pseudo-channel
+    model = model.transform(AssignHBMChannels(alveo_default_platform["U280"], 200))
+    mem_ports = [getCustomOp(x).get_nodeattr("mem_port") for x in model.graph.node]
+    dma_ports = [x for x in mem_ports if x != ""]
+    assert len(dma_ports) == 3
+    assert len(set(dma_ports)) == 3
+    assert all([x.startswith("HBM[") for x in dma_ports])
+
+
 # board
 @pytest.mark.parametrize("board", ["U250"])
 # clock period
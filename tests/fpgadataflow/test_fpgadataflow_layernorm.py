@@ -0,0 +1,139 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.general import GiveUniqueNodeNames
+from qonnx.transformation.infer_shapes import InferShapes
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+import finn.core.onnx_exec as oxe
+from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.transformation.fpgadataflow.compile_cppsim import CompileCppSim
+from finn.transformation.fpgadataflow.convert_to_hw_layers import (
+    InferStreamingLayerNorm,
+)
+from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
+from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
+from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
+from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
+from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
+from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+
+test_fpga_part = "xczu3eg-sbva484-1-e"
+target_clk_ns = 5
+
+
+def make_layernorm_model(shp, idt, scale, eps):
+    ch = shp[-1]
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, shp)
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, shp)
+    nodes = [
+        helper.make_node("Mul", ["inp", "scale"], ["x"]),
+        helper.make_node(
+            "LayerNormalization", ["x", "gamma", "beta"], ["outp"], axis=-1, epsilon=eps
+        ),
+    ]
+    graph = helper.make_graph(nodes=nodes, name="ln_graph", inputs=[inp], outputs=[outp])
+    model = qonnx_make_model(
+        graph, producer_name="ln-model", opset_imports=[helper.make_opsetid("", 17)]
+    )
+    model = ModelWrapper(model)
+    model.set_initializer("scale", np.asarray(scale, dtype=np.float32))
+    model.set_initializer("gamma", np.random.uniform(0.5, 1.5, ch).astype(np.float32))
+    model.set_initializer("beta", np.random.uniform(-0.5, 0.5, ch).astype(np.float32))
+    model.set_tensor_datatype("inp", idt)
+    model = model.transform(InferShapes())
+    model = model.transform(GiveUniqueNodeNames())
+    return model
+
+
+def layernorm_reference(x, scale, gamma, beta, eps):
+    x = x * scale
+    mean = x.mean(axis=-1, keepdims=True)
+    var = x.var(axis=-1, keepdims=True)
+    return (x - mean) / np.sqrt(var + eps) * gamma + beta
+
+
+@pytest.mark.parametrize("idt", [DataType["INT8"], DataType["UINT4"]])
+@pytest.mark.parametrize("shp", [[1, 16], [2, 5, 24]])
+@pytest.mark.parametrize("fold", [-1, 1, 4])
+@pytest.mark.parametrize("exec_mode", ["cppsim", "rtlsim"])
+@pytest.mark.fpgadataflow
+@pytest.mark.vivado
+def test_fpgadataflow_layernorm(idt, shp, fold, exec_mode):
+    np.random.seed(0)
+    ch = shp[-1]
+    pe = 1 if fold == -1 else ch // fold
+    scale = 0.05
+    eps = 1e-5
+    obits = 8
+    fbits = 5
+    model = make_layernorm_model(shp, idt, scale, eps)
+    gamma = model.get_initializer("gamma")
+    beta = model.get_initializer("beta")
+    x = gen_finn_dt_tensor(idt, shp)
+    idict = {"inp": x}
+    y_float = layernorm_reference(x, scale, gamma, beta, eps)
+
+    model = model.transform(InferStreamingLayerNorm(output_bits=obits, frac_bits=fbits))
+    assert len(model.get_nodes_by_op_type("LayerNormalization")) == 0
+    y_expected = oxe.execute_onnx(model, idict)["outp"]
+    # half an output LSB of rounding plus the rsqrt table error, scaled by gamma
+    assert np.allclose(y_expected, y_float, atol=1.5 * 2.0**-fbits * gamma.max() + 0.01)
+
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    hw_node = model.get_nodes_by_op_type("StreamingLayerNorm_hls")[0]
+    getCustomOp(hw_node).set_nodeattr("PE", pe)
+    if exec_mode == "cppsim":
+        model = model.transform(PrepareCppSim())
+        model = model.transform(CompileCppSim())
+        model = model.transform(SetExecMode("cppsim"))
+    elif exec_mode == "rtlsim":
+        model = model.transform(SetExecMode("rtlsim"))
+        model = model.transform(GiveUniqueNodeNames())
+        model = model.transform(PrepareIP(test_fpga_part, target_clk_ns))
+        model = model.transform(HLSSynthIP())
+        model = model.transform(PrepareRTLSim())
+    else:
+        raise Exception("Unknown exec_mode")
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all(), exec_mode + " failed"
+    if exec_mode == "rtlsim":
+        node = model.get_nodes_by_op_type("StreamingLayerNorm_hls")[0]
+        cycles_rtlsim = getCustomOp(node).get_nodeattr("cycles_rtlsim")
+        exp_cycles_dict = model.analysis(exp_cycles_per_layer)
+        exp_cycles = exp_cycles_dict[node.name]
+        assert np.isclose(exp_cycles, cycles_rtlsim, atol=10)
+        assert exp_cycles != 0
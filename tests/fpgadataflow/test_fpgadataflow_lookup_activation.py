@@ -0,0 +1,212 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.general import GiveUniqueNodeNames
+from qonnx.transformation.infer_shapes import InferShapes
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+import finn.core.onnx_exec as oxe
+from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.transformation.fpgadataflow.compile_cppsim import CompileCppSim
+from finn.transformation.fpgadataflow.convert_to_hw_layers import InferLookupActivation
+from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
+from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
+from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
+from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
+from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
+from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+
+test_fpga_part = "xczu3eg-sbva484-1-e"
+target_clk_ns = 5
+
+
+def make_quant_gelu_model(shp, idt, odt, scale, per_channel_thresholds):
+    """Build x -> scale -> GELU -> MultiThreshold, where x and the result are
+    integers and GELU is expressed with elementwise ONNX ops."""
+    ch = shp[-1]
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, shp)
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, shp)
+    nodes = [
+        helper.make_node("Mul", ["inp", "scale"], ["x"]),
+        helper.make_node("Mul", ["x", "inv_sqrt2"], ["x_div"]),
+        helper.make_node("Erf", ["x_div"], ["x_erf"]),
+        helper.make_node("Add", ["x_erf", "one"], ["x_erf1"]),
+        helper.make_node("Mul", ["x", "x_erf1"], ["x_gelu2"]),
+        helper.make_node("Mul", ["x_gelu2", "half"], ["x_gelu"]),
+        helper.make_node(
+            "MultiThreshold",
+            ["x_gelu", "thresh"],
+            ["outp"],
+            domain="qonnx.custom_op.general",
+            out_dtype=odt.name,
+            out_bias=float(odt.min()),
+            data_layout="NHWC",
+        ),
+    ]
+    graph = helper.make_graph(nodes=nodes, name="gelu_graph", inputs=[inp], outputs=[outp])
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="gelu-model"))
+    model.set_initializer("scale", np.asarray(scale, dtype=np.float32))
+    model.set_initializer("inv_sqrt2", np.asarray(1 / np.sqrt(2), dtype=np.float32))
+    model.set_initializer("one", np.asarray(1.0, dtype=np.float32))
+    model.set_initializer("half", np.asarray(0.5, dtype=np.float32))
+    n_steps = odt.get_num_possible_values() - 1
+    n_thres_ch = ch if per_channel_thresholds else 1
+    thresholds = np.sort(np.random.uniform(-0.2, 2.0, (n_thres_ch, n_steps)), axis=1)
+    model.set_initializer("thresh", thresholds.astype(np.float32))
+    model.set_tensor_datatype("inp", idt)
+    model = model.transform(InferShapes())
+    model = model.transform(GiveUniqueNodeNames())
+    model.set_tensor_datatype("outp", odt)
+    return model
+
+
+@pytest.mark.parametrize("idt", [DataType["INT4"], DataType["UINT6"]])
+@pytest.mark.parametrize("odt", [DataType["INT4"], DataType["UINT2"]])
+@pytest.mark.parametrize("ch", [1, 16])
+@pytest.mark.parametrize("fold", [-1, 1, 2])
+@pytest.mark.parametrize("per_channel_thresholds", [True, False])
+@pytest.mark.parametrize("exec_mode", ["cppsim", "rtlsim"])
+@pytest.mark.fpgadataflow
+@pytest.mark.vivado
+def test_fpgadataflow_lookup_activation(idt, odt, ch, fold, per_channel_thresholds, exec_mode):
+    np.random.seed(0)
+    if fold == -1:
+        pe = 1
+    else:
+        pe = max(1, ch // fold)
+    assert ch % pe == 0
+    shp = [1, 4, 4, ch]
+    scale = 3.0 / max(abs(idt.min()), abs(idt.max()))
+    model = make_quant_gelu_model(shp, idt, odt, scale, per_channel_thresholds)
+    x = gen_finn_dt_tensor(idt, shp)
+    idict = {"inp": x}
+    y_expected = oxe.execute_onnx(model, idict)["outp"]
+
+    model = model.transform(InferLookupActivation())
+    assert len(model.graph.node) == 1
+    assert model.graph.node[0].op_type == "LookupActivation"
+    table = model.get_initializer(model.graph.node[0].input[1])
+    assert table.shape == (ch if per_channel_thresholds else 1, 2 ** idt.bitwidth())
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all()
+
+    model = model.transform(SpecializeLayers(test_fpga_part))
+    assert model.graph.node[0].op_type == "LookupActivation_hls"
+    getCustomOp(model.graph.node[0]).set_nodeattr("PE", pe)
+    if exec_mode == "cppsim":
+        model = model.transform(PrepareCppSim())
+        model = model.transform(CompileCppSim())
+        model = model.transform(SetExecMode("cppsim"))
+    elif exec_mode == "rtlsim":
+        model = model.transform(SetExecMode("rtlsim"))
+        model = model.transform(GiveUniqueNodeNames())
+        model = model.transform(PrepareIP(test_fpga_part, target_clk_ns))
+        model = model.transform(HLSSynthIP())
+        model = model.transform(PrepareRTLSim())
+    else:
+        raise Exception("Unknown exec_mode")
+    y_produced = oxe.execute_onnx(model, idict)["outp"]
+    assert (y_produced == y_expected).all(), exec_mode + " failed"
+    if exec_mode == "rtlsim":
+        node = model.get_nodes_by_op_type("LookupActivation_hls")[0]
+        inst = getCustomOp(node)
+        cycles_rtlsim = inst.get_nodeattr("cycles_rtlsim")
+        exp_cycles_dict = model.analysis(exp_cycles_per_layer)
+        exp_cycles = exp_cycles_dict[node.name]
+        assert np.isclose(exp_cycles, cycles_rtlsim, atol=10)
+        assert exp_cycles != 0
+
+
+@pytest.mark.fpgadataflow
+def test_infer_lookup_activation_skips_thresholding():
+    # a lone MultiThreshold is better served by a Thresholding layer
+    idt = DataType["INT4"]
+    odt = DataType["UINT2"]
+    shp = [1, 8]
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, shp)
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, shp)
+    mt_node = helper.make_node(
+        "MultiThreshold",
+        ["inp", "thresh"],
+        ["outp"],
+        domain="qonnx.custom_op.general",
+        out_dtype=odt.name,
+    )
+    graph = helper.make_graph(nodes=[mt_node], name="mt_graph", inputs=[inp], outputs=[outp])
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="mt-model"))
+    model.set_initializer("thresh", np.asarray([[-2, 0, 2]], dtype=np.float32))
+    model.set_tensor_datatype("inp", idt)
+    model.set_tensor_datatype("outp", odt)
+    model = model.transform(InferShapes())
+    model = model.transform(InferLookupActivation())
+    assert model.graph.node[0].op_type == "MultiThreshold"
+
+
+@pytest.mark.fpgadataflow
+def test_infer_lookup_activation_overlapping_matches():
+    # the integer output of Round starts a second, overlapping match
+    idt = DataType["INT4"]
+    odt = DataType["UINT2"]
+    shp = [1, 8]
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, shp)
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, shp)
+    round_node = helper.make_node("Round", ["inp"], ["rounded"])
+    mul_node = helper.make_node("Mul", ["rounded", "scale"], ["scaled"])
+    mt_node = helper.make_node(
+        "MultiThreshold",
+        ["scaled", "thresh"],
+        ["outp"],
+        domain="qonnx.custom_op.general",
+        out_dtype=odt.name,
+    )
+    graph = helper.make_graph(
+        nodes=[round_node, mul_node, mt_node], name="overlap_graph", inputs=[inp], outputs=[outp]
+    )
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="overlap-model"))
+    model.set_initializer("scale", np.asarray(0.5, dtype=np.float32))
+    model.set_initializer("thresh", np.asarray([[-1, 0, 1]], dtype=np.float32))
+    model = model.transform(InferShapes())
+    model.set_tensor_datatype("inp", idt)
+    model.set_tensor_datatype("rounded", idt)
+    model.set_tensor_datatype("outp", odt)
+    x = gen_finn_dt_tensor(idt, shp)
+    y_expected = oxe.execute_onnx(model, {"inp": x})["outp"]
+
+    model = model.transform(InferLookupActivation())
+    assert [n.op_type for n in model.graph.node] == ["LookupActivation"]
+    assert model.graph.node[0].input[0] == "inp"
+    y_produced = oxe.execute_onnx(model, {"inp": x})["outp"]
+    assert (y_produced == y_expected).all()
@@ -50,11 +50,13 @@ from qonnx.util.basic import (
 import finn.core.onnx_exec as oxe
 import finn.transformation.fpgadataflow.convert_to_hw_layers as to_hw
 from finn.analysis.fpgadataflow.exp_cycles_per_layer import exp_cycles_per_layer
+from finn.analysis.fpgadataflow.exp_dram_bytes_per_layer import exp_dram_bytes_per_layer
 from finn.analysis.fpgadataflow.hls_synth_res_estimation import hls_synth_res_estimation
 from finn.transformation.fpgadataflow.compile_cppsim import CompileCppSim
 from finn.transformation.fpgadataflow.create_stitched_ip import CreateStitchedIP
 from finn.transformation.fpgadataflow.derive_characteristic import DeriveCharacteristic
 from finn.transformation.fpgadataflow.hlssynth_ip import HLSSynthIP
+from finn.transformation.fpgadataflow.insert_iodma import InsertIODMA
 from finn.transformation.fpgadataflow.minimize_accumulator_width import (
     MinimizeAccumulatorWidth,
 )
@@ -66,6 +68,7 @@ from finn.transformation.fpgadataflow.prepare_ip import PrepareIP
 from finn.transformation.fpgadataflow.prepare_rtlsim import PrepareRTLSim
 from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
 from finn.transformation.fpgadataflow.set_fifo_depths import InsertAndSetFIFODepths
+from finn.transformation.fpgadataflow.set_folding import SetFolding
 from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
 
 
@@ -730,3 +733,186 @@ def test_fpgadataflow_rtl_mvau(mh, mw, pe, simd, idt, wdt, part, clk_ns):
     assert (
         output_matmul == output_mvau_rtl_stitch
     ).all(), "Output of ONNX model not matching output of stitched-IP RTL model!"
+
+
+@pytest.mark.parametrize("mh", [16])
+@pytest.mark.parametrize("mw", [32])
+@pytest.mark.parametrize("pe", [1, 4])
+@pytest.mark.parametrize("simd", [1, 8])
+@pytest.mark.parametrize("idt", [DataType["UINT4"], DataType["INT4"], DataType["UINT8"]])
+@pytest.mark.parametrize("wdt", [DataType["INT4"]])
+@pytest.mark.parametrize("part", ["xcvc1902-vsva2197-2MP-e-S", "xcku3p-ffva676-1-e"])
+@pytest.mark.fpgadataflow
+@pytest.mark.slow
+@pytest.mark.vivado
+def test_fpgadataflow_rtl_mvau_bitserial(mh, mw, pe, simd, idt, wdt, part):
+    clk_ns = 4
+    # Create test input vector (produced by SWG)
+    ofm_h, ofm_w = (3, 3)
+    ifm = helper.make_tensor_value_info("ifm", TensorProto.FLOAT, [1, ofm_h, ofm_w, mw])
+    ofm = helper.make_tensor_value_info("ofm", TensorProto.FLOAT, (1, ofm_h, ofm_w, mh))
+    W = gen_finn_dt_tensor(wdt, (mw, mh))
+    model = make_single_matmul_modelwrapper(ifm, ofm, idt, wdt, W)
+    model = model.transform(GiveUniqueNodeNames())
+    model = model.transform(GiveReadableTensorNames())
+
+    A = gen_finn_dt_tensor(
+        model.get_tensor_datatype("global_in"), model.get_tensor_shape("global_in")
+    )
+    input_dict = prepare_inputs(A, idt, wdt, inp_name="global_in")
+    output_matmul = oxe.execute_onnx(model, input_dict)["global_out"]
+
+    model = model.transform(to_hw.InferQuantizedMatrixVectorActivation())
+    model = model.transform(SpecializeLayers(part))
+    model = model.transform(GiveUniqueNodeNames())
+    folding_config = {
+        "Defaults": {},
+        "MVAU_rtl_0": {
+            "PE": pe,
+            "SIMD": simd,
+            "bitSerial": 1,
+        },
+    }
+    model = model.transform(ApplyConfig(folding_config))
+    model = model.transform(MinimizeAccumulatorWidth())
+    model = model.transform(InferDataTypes())
+
+    model = model.transform(SetExecMode("rtlsim"))
+    model = model.transform(PrepareIP(part, clk_ns))
+    model = model.transform(HLSSynthIP())
+    model = model.transform(PrepareRTLSim())
+    output_mvau_rtl = oxe.execute_onnx(model, input_dict)["global_out"]
+    assert (
+        output_matmul == output_mvau_rtl
+    ).all(), "Output of ONNX model not matching output of bit-serial RTLsim!"
+
+    node = model.get_nodes_by_op_type("MVAU_rtl")[0]
+    inst = getCustomOp(node)
+    assert inst.dsp_estimation(part) == 0
+    cycles_rtlsim = inst.get_nodeattr("cycles_rtlsim")
+    exp_cycles_dict = model.analysis(exp_cycles_per_layer)
+    exp_cycles = exp_cycles_dict[node.name]
+    assert np.isclose(exp_cycles, cycles_rtlsim, atol=15)
+    assert exp_cycles != 0
+
+
+@pytest.mark.parametrize("target_cycles", [100000, 10])
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_rtl_mvau_bitserial_folding(target_cycles):
+    part = "xcvc1902-vsva2197-2MP-e-S"
+    mw, mh = 32, 16
+    idt, wdt = DataType["UINT4"], DataType["INT4"]
+    ifm = helper.make_tensor_value_info("ifm", TensorProto.FLOAT, [1, 3, 3, mw])
+    ofm = helper.make_tensor_value_info("ofm", TensorProto.FLOAT, (1, 3, 3, mh))
+    W = gen_finn_dt_tensor(wdt, (mw, mh))
+    model = make_single_matmul_modelwrapper(ifm, ofm, idt, wdt, W)
+    model = model.transform(to_hw.InferQuantizedMatrixVectorActivation())
+    model = model.transform(SpecializeLayers(part))
+    model = model.transform(GiveUniqueNodeNames())
+    model = model.transform(
+        SetFolding(target_cycles, two_pass_relaxation=False, mvau_bit_serial=True)
+    )
+    inst = getCustomOp(model.get_nodes_by_op_type("MVAU_rtl")[0])
+    if target_cycles == 100000:
+        # loose target is met bit-serially
+        assert inst.get_nodeattr("bitSerial") == 1
+        assert inst.get_exp_cycles() < target_cycles
+    else:
+        # unreachable target falls back to bit-parallel
+        assert inst.get_nodeattr("bitSerial") == 0
+        assert inst.dsp_estimation(part) > 0
+
+
+# execution mode
+@pytest.mark.parametrize("exec_mode", ["cppsim", "rtlsim"])
+# activation: None or DataType
+@pytest.mark.parametrize("act", [None, DataType["INT4"]])
+# number of frames sharing one fetch of the external weights
+@pytest.mark.parametrize("weight_reuse", [2, 4])
+@pytest.mark.fpgadataflow
+@pytest.mark.slow
+@pytest.mark.vivado
+def test_fpgadataflow_mvau_weight_reuse(exec_mode, act, weight_reuse):
+    mw = 16
+    mh = 16
+    pe = 4
+    simd = 4
+    n_vecs = 3
+    idt = DataType["INT4"]
+    wdt = DataType["INT4"]
+    W = gen_finn_dt_tensor(wdt, (mw, mh))
+    x = gen_finn_dt_tensor(idt, (n_vecs, mw))
+    if act is None:
+        T = None
+        tdt = None
+        odt = DataType["INT32"]
+    else:
+        odt = act
+        (min, max) = calculate_signed_dot_prod_range(idt, wdt, mw)
+        n_steps = act.get_num_possible_values() - 1
+        T = np.random.randint(min, max - 1, (mh, n_steps)).astype(np.float32)
+        T = np.sort(T, axis=1)
+        tdt = DataType["INT32"]
+    model = make_single_fclayer_modelwrapper(W, pe, simd, wdt, idt, odt, T, tdt)
+    model.set_tensor_shape("inp", [n_vecs, mw])
+    model.set_tensor_shape("outp", [n_vecs, mh])
+    for node in model.graph.node:
+        inst = getCustomOp(node)
+        inst.set_nodeattr("numInputVectors", [n_vecs])
+        inst.set_nodeattr("mem_mode", "external")
+        inst.set_nodeattr("weightReuse", weight_reuse)
+        inst.set_nodeattr("preferred_impl_style", "hls")
+
+    input_dict = prepare_inputs(x, idt, wdt)
+    y = np.matmul(x, W)
+    if T is not None:
+        y = multithreshold(y, T)
+        y += act.min()
+    y_expected = y.reshape(model.get_tensor_shape("outp"))
+
+    model = model.transform(SpecializeLayers("xczu7ev-ffvc1156-2-e"))
+    model = model.transform(GiveUniqueNodeNames())
+    node = model.get_nodes_by_op_type("MVAU_hls")[0]
+    inst = getCustomOp(node)
+    # each weight tile is held against the vectors of weightReuse frames,
+    # the buffered results add one cycle per output word
+    exp_cycles = (mh // pe) * (mw // simd) * n_vecs + (mh // pe) * n_vecs
+    assert model.analysis(exp_cycles_per_layer)[node.name] == exp_cycles
+    wbytes = inst.calc_wmem() * inst.get_weightstream_width_padded() // 8
+    exp_dram_bytes = model.analysis(exp_dram_bytes_per_layer)
+    assert exp_dram_bytes[node.name] == wbytes / weight_reuse
+    # the input and output buffers of a reuse group are part of the estimate
+    group = weight_reuse * n_vecs
+    exp_buffers = [
+        (group * (mw // simd), inst.get_instream_width()),
+        (group * (mh // pe), inst.get_outstream_width()),
+    ]
+    assert inst.get_batch_tiled_buffers() == exp_buffers
+    assert inst.bram_estimation() == 0
+    assert inst.lut_estimation() > 0
+    # reuse groups that do not fit the buffer cap are rejected
+    inst.set_nodeattr("weightReuse", 8192)
+    with pytest.raises(AssertionError):
+        inst.get_batch_tiled_buffers()
+    inst.set_nodeattr("weightReuse", weight_reuse)
+
+    # the weight DMA fetches once per group of frames and replays each tile
+    model_dma = model.transform(InsertIODMA(insert_extmemw=True))
+    mvau = model_dma.get_nodes_by_op_type("MVAU_hls")[0]
+    dma = getCustomOp(model_dma.find_producer(mvau.input[1]))
+    assert dma.get_nodeattr("burstMode") == "prefetch"
+    assert dma.get_nodeattr("prefetchTileWords") == mw // simd
+    assert dma.get_nodeattr("prefetchReplays") == weight_reuse * n_vecs
+    assert dma.get_nodeattr("prefetchFrames") == weight_reuse
+
+    if exec_mode == "cppsim":
+        model = model.transform(SetExecMode("cppsim"))
+        model = model.transform(PrepareCppSim())
+        model = model.transform(CompileCppSim())
+    else:
+        model = model.transform(SetExecMode("rtlsim"))
+        model = model.transform(PrepareIP("xczu7ev-ffvc1156-2-e", 5))
+        model = model.transform(HLSSynthIP())
+        model = model.transform(PrepareRTLSim())
+    y_produced = oxe.execute_onnx(model, input_dict)["outp"]
+    assert (y_produced.reshape(y_expected.shape) == y_expected).all(), exec_mode + " failed"
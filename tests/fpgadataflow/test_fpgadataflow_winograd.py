@@ -0,0 +1,206 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.custom_op.registry import getCustomOp
+from qonnx.transformation.general import GiveUniqueNodeNames
+from qonnx.transformation.infer_datatypes import InferDataTypes
+from qonnx.transformation.infer_shapes import InferShapes
+from qonnx.transformation.lower_convs_to_matmul import LowerConvsToMatMul
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+import finn.core.onnx_exec as oxe
+import finn.transformation.fpgadataflow.convert_to_hw_layers as to_hw
+from finn.transformation.fpgadataflow.compile_cppsim import CompileCppSim
+from finn.transformation.fpgadataflow.lower_winograd import LowerConvsToWinograd
+from finn.transformation.fpgadataflow.prepare_cppsim import PrepareCppSim
+from finn.transformation.fpgadataflow.set_exec_mode import SetExecMode
+from finn.transformation.fpgadataflow.specialize_layers import SpecializeLayers
+from finn.transformation.streamline.absorb import AbsorbTransposeIntoMultiThreshold
+from finn.util.fpgadataflow import is_fpgadataflow_node
+
+test_fpga_part = "xczu3eg-sbva484-1-e"
+
+
+def make_conv_model(ifm, ich, och, pad, idt, wdt, act):
+    """Builds a 3x3, stride-1 Conv, followed by a MultiThreshold producing
+    act if act is not None."""
+    ofm = ifm + 2 * pad - 2
+    conv_out = "conv_out" if act is not None else "outp"
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, ich, ifm, ifm])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, och, ofm, ofm])
+    nodes = [
+        helper.make_node(
+            "Conv",
+            ["inp", "weights"],
+            [conv_out],
+            dilations=[1, 1],
+            group=1,
+            kernel_shape=[3, 3],
+            pads=[pad, pad, pad, pad],
+            strides=[1, 1],
+        )
+    ]
+    if act is not None:
+        nodes.append(
+            helper.make_node(
+                "MultiThreshold",
+                [conv_out, "thresh"],
+                ["outp"],
+                domain="qonnx.custom_op.general",
+                out_dtype=act.name,
+            )
+        )
+    graph = helper.make_graph(nodes=nodes, name="conv_graph", inputs=[inp], outputs=[outp])
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="conv-model"))
+    model.set_tensor_datatype("inp", idt)
+    model.set_tensor_datatype("weights", wdt)
+    model.set_initializer("weights", gen_finn_dt_tensor(wdt, [och, ich, 3, 3]))
+    if act is not None:
+        n_steps = act.get_num_possible_values() - 1
+        thresh = np.sort(np.random.randint(-100, 100, (och, n_steps)), axis=1)
+        model.set_initializer("thresh", thresh.astype(np.float32))
+        model.set_tensor_datatype("outp", act)
+    model = model.transform(InferShapes())
+    model = model.transform(InferDataTypes())
+    return model
+
+
+def convert_to_hw(model):
+    model = model.transform(LowerConvsToMatMul())
+    # move the activation next to the MatMul, so that it becomes part of the MVAU
+    model = model.transform(AbsorbTransposeIntoMultiThreshold())
+    model = model.transform(to_hw.InferConvInpGen())
+    model = model.transform(to_hw.InferQuantizedMatrixVectorActivation())
+    model = model.transform(GiveUniqueNodeNames())
+    model = model.transform(InferShapes())
+    model = model.transform(InferDataTypes())
+    return model
+
+
+# input datatype
+@pytest.mark.parametrize("idt", [DataType["UINT4"], DataType["INT4"]])
+# weight datatype
+@pytest.mark.parametrize("wdt", [DataType["INT4"]])
+# activation datatype, None for raw accumulators
+@pytest.mark.parametrize("act", [None, DataType["UINT4"]])
+# input feature map size, padding
+@pytest.mark.parametrize("ifm_pad", [(6, 1), (8, 0)])
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_winograd_lowering(idt, wdt, act, ifm_pad):
+    ifm, pad = ifm_pad
+    ich, och = 4, 6
+    model = make_conv_model(ifm, ich, och, pad, idt, wdt, act)
+    hw_model = convert_to_hw(model)
+    mvau = getCustomOp(hw_model.get_nodes_by_op_type("MVAU")[0])
+    mvau.set_nodeattr("SIMD", 2)
+    mvau.set_nodeattr("PE", 3)
+    direct_cycles = mvau.get_exp_cycles()
+    mvau.set_nodeattr("winograd", 1)
+    wg_model = hw_model.transform(LowerConvsToWinograd())
+
+    op_types = [n.op_type for n in wg_model.graph.node]
+    assert "MVAU" not in op_types
+    assert "ConvolutionInputGenerator" not in op_types
+    assert "WinogradInputTransform" in op_types
+    assert "WinogradOutputTransform" in op_types
+    assert ("Thresholding" in op_types) == (act is not None)
+    wg_inst = getCustomOp(wg_model.get_nodes_by_op_type("WinogradMVAU")[0])
+    assert wg_inst.get_nodeattr("SIMD") == 2
+    assert wg_inst.get_nodeattr("PE") == 3
+    # 16 instead of 36 products per 2x2 output tile
+    assert direct_cycles / wg_inst.get_exp_cycles() == 2.25
+
+    x = gen_finn_dt_tensor(idt, [1, ich, ifm, ifm])
+    inp_dict = {"inp": x}
+    y_expected = oxe.execute_onnx(model, inp_dict)["outp"]
+    y_produced = oxe.execute_onnx(wg_model, inp_dict)["outp"]
+    assert (y_produced == y_expected).all()
+
+
+@pytest.mark.fpgadataflow
+def test_fpgadataflow_winograd_fallback():
+    idt = wdt = DataType["INT4"]
+    # odd output size
+    model = convert_to_hw(make_conv_model(7, 4, 6, 1, idt, wdt, None))
+    getCustomOp(model.get_nodes_by_op_type("MVAU")[0]).set_nodeattr("winograd", 1)
+    with pytest.warns(UserWarning, match="output size is odd"):
+        model = model.transform(LowerConvsToWinograd())
+    assert len(model.get_nodes_by_op_type("MVAU")) == 1
+    # transformed operands too wide
+    model = convert_to_hw(make_conv_model(8, 4, 6, 1, idt, wdt, None))
+    getCustomOp(model.get_nodes_by_op_type("MVAU")[0]).set_nodeattr("winograd", 1)
+    with pytest.warns(UserWarning, match="transformed operands"):
+        model = model.transform(LowerConvsToWinograd(max_operand_width=6))
+    assert len(model.get_nodes_by_op_type("MVAU")) == 1
+    # layers without winograd=1 are left alone
+    model = convert_to_hw(make_conv_model(8, 4, 6, 1, idt, wdt, None))
+    model = model.transform(LowerConvsToWinograd())
+    assert len(model.get_nodes_by_op_type("MVAU")) == 1
+
+
+@pytest.mark.parametrize("idt", [DataType["UINT4"], DataType["INT4"]])
+@pytest.mark.parametrize("act", [None, DataType["UINT4"]])
+@pytest.mark.parametrize("simd_pe", [(1, 1), (2, 3), (4, 6)])
+@pytest.mark.fpgadataflow
+@pytest.mark.slow
+@pytest.mark.vivado
+def test_fpgadataflow_winograd_cppsim(idt, act, simd_pe):
+    ich, och = 4, 6
+    simd, pe = simd_pe
+    model = make_conv_model(6, ich, och, 1, idt, DataType["INT4"], act)
+    hw_model = convert_to_hw(model)
+    for node in hw_model.graph.node:
+        if is_fpgadataflow_node(node):
+            getCustomOp(node).set_nodeattr("preferred_impl_style", "hls")
+    hw_model = hw_model.transform(SpecializeLayers(test_fpga_part))
+    # select Winograd per layer after specialization, as a folding config would
+    mvau = getCustomOp(hw_model.get_nodes_by_op_type("MVAU_hls")[0])
+    mvau.set_nodeattr("SIMD", simd)
+    mvau.set_nodeattr("PE", pe)
+    mvau.set_nodeattr("winograd", 1)
+    swg = getCustomOp(hw_model.get_nodes_by_op_type("ConvolutionInputGenerator_hls")[0])
+    swg.set_nodeattr("SIMD", simd)
+    wg_model = hw_model.transform(LowerConvsToWinograd())
+    assert len(wg_model.get_nodes_by_op_type("WinogradMVAU_hls")) == 1
+    wg_model = wg_model.transform(GiveUniqueNodeNames())
+    wg_model = wg_model.transform(SetExecMode("cppsim"))
+    wg_model = wg_model.transform(PrepareCppSim())
+    wg_model = wg_model.transform(CompileCppSim())
+
+    x = gen_finn_dt_tensor(idt, [1, ich, 6, 6])
+    inp_dict = {"inp": x}
+    y_expected = oxe.execute_onnx(model, inp_dict)["outp"]
+    y_produced = oxe.execute_onnx(wg_model, inp_dict)["outp"]
+    assert (y_produced == y_expected).all()
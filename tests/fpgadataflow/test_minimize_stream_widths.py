@@ -0,0 +1,163 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+import finn.core.onnx_exec as oxe
+from finn.transformation.fpgadataflow.minimize_stream_widths import MinimizeStreamWidths
+
+CH = 4
+MH = 8
+
+
+def make_thresholding_node(inp, outp, steps, odt):
+    return helper.make_node(
+        "Thresholding",
+        [inp, outp + "_thres"],
+        [outp],
+        domain="finn.custom_op.fpgadataflow",
+        backend="fpgadataflow",
+        NumChannels=steps.shape[0],
+        PE=1,
+        numSteps=steps.shape[1],
+        inputDataType="INT32",
+        weightDataType="INT32",
+        outputDataType=odt.name,
+        ActVal=0,
+    )
+
+
+def make_unit_test_model():
+    """Two thresholding layers with unreachable thresholds feed an AddStreams,
+    followed by another thresholding layer, an MVAU and a final thresholding
+    layer producing the graph output."""
+    inp1 = helper.make_tensor_value_info("inp1", TensorProto.FLOAT, [1, CH])
+    inp2 = helper.make_tensor_value_info("inp2", TensorProto.FLOAT, [1, CH])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, MH])
+    # with UINT4 inputs only the first four thresholds can be crossed
+    thres_in = np.tile(4 * np.arange(15), (CH, 1)).astype(np.float32)
+    # the sum of both branches lies in [2, 8]
+    thres_sum = np.tile(4 * np.arange(15), (CH, 1)).astype(np.float32)
+    thres_out = np.tile(np.arange(-7, 8), (MH, 1)).astype(np.float32)
+    # alternating columns of ones and minus ones
+    W = np.ones((CH, MH), dtype=np.float32)
+    W[:, ::2] = -1
+    nodes = [
+        make_thresholding_node("inp1", "a", thres_in, DataType["UINT4"]),
+        make_thresholding_node("inp2", "b", thres_in, DataType["UINT4"]),
+        helper.make_node(
+            "AddStreams",
+            ["a", "b"],
+            ["c"],
+            domain="finn.custom_op.fpgadataflow",
+            backend="fpgadataflow",
+            NumChannels=CH,
+            PE=1,
+            inputDataType="UINT4",
+        ),
+        make_thresholding_node("c", "d", thres_sum, DataType["UINT4"]),
+        helper.make_node(
+            "MVAU",
+            ["d", "W"],
+            ["e"],
+            domain="finn.custom_op.fpgadataflow",
+            backend="fpgadataflow",
+            MW=CH,
+            MH=MH,
+            SIMD=1,
+            PE=1,
+            inputDataType="UINT4",
+            weightDataType="INT2",
+            outputDataType="INT32",
+            accDataType="INT32",
+            noActivation=1,
+        ),
+        make_thresholding_node("e", "outp", thres_out, DataType["UINT4"]),
+    ]
+    graph = helper.make_graph(
+        nodes=nodes,
+        name="stream_width_graph",
+        inputs=[inp1, inp2],
+        outputs=[outp],
+        value_info=[helper.make_tensor_value_info(x, TensorProto.FLOAT, [1, CH]) for x in "abcd"]
+        + [helper.make_tensor_value_info("e", TensorProto.FLOAT, [1, MH])],
+    )
+    model = ModelWrapper(qonnx_make_model(graph, producer_name="stream-width-model"))
+    for x in ["inp1", "inp2"]:
+        model.set_tensor_datatype(x, DataType["UINT4"])
+    for x in ["a", "b", "d", "outp"]:
+        model.set_tensor_datatype(x, DataType["UINT4"])
+    model.set_tensor_datatype("c", DataType["UINT5"])
+    model.set_tensor_datatype("e", DataType["INT32"])
+    model.set_initializer("a_thres", thres_in)
+    model.set_initializer("b_thres", thres_in)
+    model.set_initializer("d_thres", thres_sum)
+    model.set_initializer("outp_thres", thres_out)
+    model.set_initializer("W", W)
+    model.set_tensor_datatype("W", DataType["INT2"])
+    for x in ["a_thres", "b_thres", "d_thres", "outp_thres"]:
+        model.set_tensor_datatype(x, DataType["INT32"])
+    return model
+
+
+@pytest.mark.fpgadataflow
+def test_minimize_stream_widths():
+    model = make_unit_test_model()
+    input_dict = {
+        "inp1": gen_finn_dt_tensor(DataType["UINT4"], (1, CH)),
+        "inp2": gen_finn_dt_tensor(DataType["UINT4"], (1, CH)),
+    }
+    y_expected = oxe.execute_onnx(model, input_dict)["outp"]
+
+    model = model.transform(MinimizeStreamWidths())
+    # inputs of AddStreams share one datatype and are left unchanged
+    assert model.get_tensor_datatype("a") == DataType["UINT4"]
+    assert model.get_tensor_datatype("b") == DataType["UINT4"]
+    # the sum of two values in [1, 4] fits UINT4 instead of UINT5
+    assert model.get_tensor_datatype("c") == DataType["UINT4"]
+    # at most three thresholds of the second layer can be crossed
+    assert model.get_tensor_datatype("d") == DataType["UINT2"]
+    mvau = model.get_nodes_by_op_type("MVAU")[0]
+    assert model.get_tensor_datatype(mvau.input[0]) == DataType["UINT2"]
+    # MVAU accumulator lies in [-12, 12] and stays signed
+    assert model.get_tensor_datatype("e") == DataType["INT5"]
+    # graph outputs keep their datatype
+    assert model.get_tensor_datatype("outp") == DataType["UINT4"]
+
+    y_produced = oxe.execute_onnx(model, input_dict)["outp"]
+    assert (y_produced == y_expected).all()
+    # the first pass reports its changes, a minimized graph stays unchanged
+    assert MinimizeStreamWidths().apply(make_unit_test_model())[1]
+    assert not MinimizeStreamWidths().apply(model)[1]
@@ -0,0 +1,94 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+import os
+import time
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import qonnx_make_model
+
+from finn.util.basic import make_build_dir
+from finn.util.build_dirs import collect_garbage, make_node_build_dir, node_build_key
+
+
+def make_model():
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, 8])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, 8])
+    node = helper.make_node("MatMul", ["inp", "w"], ["outp"], name="MatMul_0")
+    graph = helper.make_graph([node], "build_dirs", [inp], [outp])
+    model = ModelWrapper(qonnx_make_model(graph))
+    model.set_initializer("w", np.eye(8, dtype=np.float32))
+    model.set_tensor_datatype("w", DataType["INT2"])
+    return model
+
+
+@pytest.mark.util
+def test_node_build_dirs(monkeypatch):
+    model = make_model()
+    node = model.graph.node[0]
+    key = node_build_key("ipgen", model, node, "xc7z020clg400-1", 5)
+    assert key == node_build_key("ipgen", model, node, "xc7z020clg400-1", 5)
+    assert key != node_build_key("ipgen", model, node, "xc7z020clg400-1", 4)
+    # attributes that do not affect the hardware leave the key unchanged
+    node.attribute.append(helper.make_attribute("exec_mode", "rtlsim"))
+    node.attribute.append(helper.make_attribute("res_estimate", "{'LUT': 10}"))
+    assert key == node_build_key("ipgen", model, node, "xc7z020clg400-1", 5)
+    node.attribute.append(helper.make_attribute("PE", 2))
+    assert key != node_build_key("ipgen", model, node, "xc7z020clg400-1", 5)
+    del node.attribute[-1]
+    model.set_initializer("w", -np.eye(8, dtype=np.float32))
+    assert key != node_build_key("ipgen", model, node, "xc7z020clg400-1", 5)
+
+    monkeypatch.setenv("FINN_DETERMINISTIC_BUILD_DIRS", "1")
+    build_dir = make_node_build_dir("test_build_dirs_", "ipgen", model, node)
+    assert build_dir == make_node_build_dir("test_build_dirs_", "ipgen", model, node)
+    monkeypatch.setenv("FINN_DETERMINISTIC_BUILD_DIRS", "0")
+    assert build_dir != make_node_build_dir("test_build_dirs_", "ipgen", model, node)
+
+
+@pytest.mark.util
+def test_build_dir_gc(monkeypatch, tmp_path):
+    monkeypatch.setenv("FINN_BUILD_DIR", make_build_dir("test_build_dir_gc_"))
+    used_dir = make_build_dir("used_")
+    unused_dir = make_build_dir("unused_")
+    model = make_model()
+    model.set_metadata_prop("vivado_stitch_proj", used_dir)
+    model_filename = str(tmp_path / "model.onnx")
+    model.save(model_filename)
+    time.sleep(0.1)
+    # recently modified dirs are kept
+    assert collect_garbage([model_filename], keep_hours=1) == []
+    removed = collect_garbage([model_filename], keep_hours=0)
+    assert removed == [os.path.basename(unused_dir)]
+    assert os.path.isdir(used_dir)
+    assert not os.path.isdir(unused_dir)
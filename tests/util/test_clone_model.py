@@ -0,0 +1,68 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import qonnx_make_model
+
+from finn.core.onnx_exec import execute_onnx_and_make_model
+from finn.util.basic import clone_model
+
+
+@pytest.mark.util
+def test_clone_model():
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, 8])
+    mid = helper.make_tensor_value_info("mid", TensorProto.FLOAT, [1, 8])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, 8])
+    nodes = [
+        helper.make_node("MatMul", ["inp", "w"], ["mid"]),
+        helper.make_node("Relu", ["mid"], ["outp"]),
+    ]
+    graph = helper.make_graph(nodes, "clone_model", [inp], [outp], value_info=[mid])
+    model = ModelWrapper(qonnx_make_model(graph))
+    w = np.random.rand(8, 8).astype(np.float32)
+    model.set_initializer("w", w)
+    model.set_metadata_prop("key", "value")
+
+    clone = clone_model(model, initializers=False)
+    assert len(clone.graph.initializer) == 0
+    assert clone.graph.node == model.graph.node
+    assert clone.graph.value_info == model.graph.value_info
+    assert clone.get_metadata_prop("key") == "value"
+    assert clone.model.opset_import == model.model.opset_import
+    # the original is left untouched
+    assert (model.get_initializer("w") == w).all()
+
+    x = np.random.rand(1, 8).astype(np.float32)
+    ret = execute_onnx_and_make_model(model, {"inp": x})
+    assert (ret.get_initializer("w") == w).all()
+    assert np.isclose(ret.get_initializer("outp"), np.maximum(x @ w, 0)).all()
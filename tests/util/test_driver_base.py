@@ -0,0 +1,188 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import importlib.util
+import numpy as np
+import os
+import sys
+import types
+
+
+@pytest.fixture
+def driver_base(monkeypatch):
+    """Imports the PYNQ driver template with stand-ins for the pynq modules,
+    which are only available on the board."""
+    pynq = types.ModuleType("pynq")
+    pynq.MMIO = object
+    pynq.Overlay = object
+    pynq.allocate = None
+    pynq_ps = types.ModuleType("pynq.ps")
+    pynq_ps.Clocks = None
+    pynq.ps = pynq_ps
+    monkeypatch.setitem(sys.modules, "pynq", pynq)
+    monkeypatch.setitem(sys.modules, "pynq.ps", pynq_ps)
+    path = os.environ["FINN_ROOT"] + "/src/finn/qnn-data/templates/driver/driver_base.py"
+    spec = importlib.util.spec_from_file_location("driver_base", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+class FakeBuffer(np.ndarray):
+    """Host array standing in for a pynq device buffer."""
+
+    def flush(self):
+        pass
+
+    def invalidate(self):
+        pass
+
+
+def make_fake_overlay(driver_base, batch_size, batch_multiple=1):
+    """Returns a FINNExampleOverlay on a fake accelerator that computes the
+    sum of each packed input sample. Results appear in the output buffer once
+    the run is waited for, like from a real DMA."""
+
+    class FakeOverlay(driver_base.FINNExampleOverlay):
+        def __init__(self):
+            self._io_shape_dict = {
+                "num_inputs": 1,
+                "num_outputs": 1,
+                "ishape_packed": [(1, 3)],
+                "oshape_packed": [(1, 1)],
+                "batch_multiple": batch_multiple,
+            }
+            self.platform = "alveo"
+            self.ibuf_packed_device = None
+            self.obuf_packed_device = None
+            self.running = None
+            self.runs = []
+            self.batch_size = batch_size
+
+        def _allocate_buffers(self):
+            ibuf = np.zeros(self.ishape_packed(), dtype=np.uint8).view(FakeBuffer)
+            obuf = np.zeros(self.oshape_packed(), dtype=np.uint8).view(FakeBuffer)
+            return [ibuf], [obuf]
+
+        def execute_on_buffers(self, asynch=False, batch_size=None):
+            assert self.running is None, "accelerator is already running"
+            self._check_batch_size(batch_size)
+            self.running = (self.ibuf_packed_device, self.obuf_packed_device, batch_size)
+            self.runs.append((self.ibuf_packed_device[0], batch_size))
+            if not asynch:
+                self.wait_until_finished()
+
+        def wait_until_finished(self):
+            ibufs, obufs, n = self.running
+            obufs[0][:n, 0] = ibufs[0][:n].sum(axis=1)
+            self.running = None
+
+    return FakeOverlay()
+
+
+class FakeCard:
+    def __init__(self, batch_multiple):
+        self.batch_multiple = batch_multiple
+
+
+def make_multi_device(driver_base, throughput, batch_multiple=1):
+    overlay = object.__new__(driver_base.FINNMultiDeviceOverlay)
+    overlay.accels = [FakeCard(batch_multiple) for t in throughput]
+    overlay.throughput = list(throughput)
+    return overlay
+
+
+@pytest.mark.util
+def test_shard_sizes_proportional(driver_base):
+    overlay = make_multi_device(driver_base, [1.0, 1.0, 2.0])
+    assert overlay.shard_sizes(8) == [2, 2, 4]
+    assert overlay.shard_sizes(0) == [0, 0, 0]
+    # leftover samples go to the largest remainders
+    overlay = make_multi_device(driver_base, [1.0, 1.0, 1.0])
+    sizes = overlay.shard_sizes(10)
+    assert sum(sizes) == 10
+    assert max(sizes) - min(sizes) == 1
+
+
+@pytest.mark.util
+def test_shard_sizes_batch_multiple(driver_base):
+    overlay = make_multi_device(driver_base, [3.0, 1.0, 1.0], batch_multiple=4)
+    for n_samples in [0, 4, 12, 40, 100]:
+        sizes = overlay.shard_sizes(n_samples)
+        assert sum(sizes) == n_samples
+        assert all([x % 4 == 0 for x in sizes])
+    assert overlay.shard_sizes(40) == [24, 8, 8]
+    with pytest.raises(AssertionError):
+        overlay.shard_sizes(10)
+
+
+@pytest.mark.util
+def test_execute_pipelined(driver_base):
+    accel = make_fake_overlay(driver_base, batch_size=4, batch_multiple=2)
+    default_ibuf = accel.ibuf_packed_device[0]
+    x = np.random.randint(0, 64, (11, 3)).astype(np.uint8)
+    batches = [x[i : i + 4] for i in range(0, 11, 4)]
+    outputs = []
+    for i, out in enumerate(accel.execute_pipelined(iter(batches))):
+        # batch i+1 is started before the outputs of batch i are handed out
+        assert len(accel.runs) == min(i + 2, len(batches))
+        outputs.append(out)
+    assert [x.shape[0] for x in outputs] == [4, 4, 3]
+    assert (np.concatenate(outputs)[:, 0] == x.sum(axis=1).astype(np.uint8)).all()
+    # consecutive batches alternate between the two buffer sets
+    assert accel.runs[0][0] is not accel.runs[1][0]
+    assert accel.runs[0][0] is accel.runs[2][0]
+    # the partial batch of 3 samples runs as 4, the padding output is dropped
+    assert [n for (buf, n) in accel.runs] == [4, 4, 4]
+    assert accel.pipeline_stats["batches"] == 3
+    assert accel.pipeline_stats["samples"] == 11
+    assert accel.ibuf_packed_device[0] is default_ibuf
+    assert accel.running is None
+
+
+@pytest.mark.util
+def test_execute_pipelined_early_exit(driver_base):
+    accel = make_fake_overlay(driver_base, batch_size=2)
+    x = np.ones((8, 3), dtype=np.uint8)
+    gen = accel.execute_pipelined(x[i : i + 2] for i in range(0, 8, 2))
+    assert (next(gen) == 3).all()
+    # closing the generator waits for the running batch and stops the producer
+    gen.close()
+    assert accel.running is None
+    assert accel.pipeline_stats["batches"] == 1
+
+    def failing_batches():
+        yield x[:2]
+        raise ValueError("input failure")
+
+    with pytest.raises(ValueError, match="input failure"):
+        list(accel.execute_pipelined(failing_batches()))
+    assert accel.running is None
@@ -0,0 +1,80 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+from onnx import TensorProto, helper
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import qonnx_make_model
+
+from finn.core.onnx_exec import ExecutionSession, execute_onnx
+
+
+def make_chain_model():
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, 8])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, 8])
+    mids = ["mid0", "mid1", "mid2", "mid3"]
+    value_info = [helper.make_tensor_value_info(x, TensorProto.FLOAT, [1, 8]) for x in mids]
+    nodes = [
+        helper.make_node("MatMul", ["inp", "w"], ["mid0"]),
+        helper.make_node("Relu", ["mid0"], ["mid1"]),
+        helper.make_node("Add", ["mid1", "b"], ["mid2"]),
+        helper.make_node("Mul", ["mid2", "mid0"], ["mid3"]),
+        helper.make_node("Relu", ["mid3"], ["outp"]),
+    ]
+    graph = helper.make_graph(nodes, "chain", [inp], [outp], value_info=value_info)
+    model = ModelWrapper(qonnx_make_model(graph))
+    model.set_initializer("w", np.random.rand(8, 8).astype(np.float32) - 0.5)
+    model.set_initializer("b", np.random.rand(1, 8).astype(np.float32))
+    return model
+
+
+@pytest.mark.util
+def test_execution_session():
+    model = make_chain_model()
+    session = ExecutionSession(model)
+    # mid0 is used until the Mul, so mid1 and mid3 can share a placeholder
+    assert session.buffer_of["mid1"] == session.buffer_of["mid3"]
+    assert session.buffer_of["mid0"] != session.buffer_of["mid2"]
+    for i in range(3):
+        x = np.random.rand(1, 8).astype(np.float32)
+        expected = execute_onnx(model, {"inp": x})
+        ret = session.run({"inp": x})
+        assert list(ret.keys()) == ["outp"]
+        assert np.isclose(ret["outp"], expected["outp"]).all()
+        expected_ctx = execute_onnx(model, {"inp": x}, True)
+        ret_ctx = session.run({"inp": x}, True)
+        assert set(ret_ctx.keys()) == set(expected_ctx.keys())
+        for k in expected_ctx.keys():
+            assert np.isclose(ret_ctx[k], expected_ctx[k]).all()
+    # initializers are shared between runs and must not be modified
+    assert not session.initializers["w"].flags.writeable
+    with pytest.raises(Exception):
+        session.run({"inp": np.zeros((1, 4), dtype=np.float32)})
@@ -0,0 +1,98 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+import onnxruntime as rt
+from onnx import TensorProto, helper
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import qonnx_make_model
+
+from finn.util.host_partitions import extract_host_partitions, save_host_partitions
+
+
+def make_parent_model():
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, 4, 4, 2])
+    t = helper.make_tensor_value_info("t", TensorProto.FLOAT, [1, 2, 4, 4])
+    a = helper.make_tensor_value_info("a", TensorProto.FLOAT, [1, 8])
+    m = helper.make_tensor_value_info("m", TensorProto.FLOAT, [1, 5])
+    vals = helper.make_tensor_value_info("vals", TensorProto.FLOAT, [1, 2])
+    idx = helper.make_tensor_value_info("idx", TensorProto.INT64, [1, 2])
+    nodes = [
+        helper.make_node("Transpose", ["inp"], ["t"], name="Transpose_0", perm=[0, 3, 1, 2]),
+        helper.make_node(
+            "StreamingDataflowPartition",
+            ["t"],
+            ["a"],
+            name="StreamingDataflowPartition_0",
+            domain="finn.custom_op.fpgadataflow",
+            model="",
+        ),
+        helper.make_node("MatMul", ["a", "w"], ["m"], name="MatMul_0"),
+        helper.make_node("TopK", ["m", "k"], ["vals", "idx"], name="TopK_0"),
+    ]
+    graph = helper.make_graph(nodes, "host_partitions", [inp], [vals, idx], value_info=[t, a, m])
+    model = ModelWrapper(qonnx_make_model(graph))
+    model.set_initializer("w", np.random.rand(8, 5).astype(np.float32))
+    model.set_initializer("k", np.asarray([2], dtype=np.int64))
+    return model
+
+
+@pytest.mark.util
+def test_host_partitions():
+    model = make_parent_model()
+    parts = extract_host_partitions(model)
+    assert [n.op_type for n in parts["head"].graph.node] == ["Transpose"]
+    assert [n.op_type for n in parts["tail"].graph.node] == ["MatMul", "TopK"]
+    assert [x.name for x in parts["tail"].graph.initializer] == ["w", "k"]
+
+    # host partitions run on whole batches with onnxruntime
+    x = np.random.rand(3, 4, 4, 2).astype(np.float32)
+    head = rt.InferenceSession(parts["head"].model.SerializeToString())
+    (t,) = head.run(None, {"inp": x})
+    assert (t == x.transpose(0, 3, 1, 2)).all()
+    a = np.random.rand(3, 8).astype(np.float32)
+    tail = rt.InferenceSession(parts["tail"].model.SerializeToString())
+    vals, idx = tail.run(None, {"a": a})
+    m = a @ model.get_initializer("w")
+    exp_idx = np.argsort(-m, axis=1)[:, :2]
+    assert (idx == exp_idx).all()
+    assert np.isclose(vals, np.take_along_axis(m, exp_idx, axis=1)).all()
+
+
+@pytest.mark.util
+def test_host_partitions_custom_nodes(tmp_path):
+    model = make_parent_model()
+    # tail with a node onnxruntime cannot run is not exported
+    model.graph.node[2].domain = "qonnx.custom_op.general"
+    with pytest.warns(UserWarning):
+        saved = save_host_partitions(model, str(tmp_path))
+    assert list(saved.keys()) == ["head"]
+    assert (tmp_path / "host_head.onnx").is_file()
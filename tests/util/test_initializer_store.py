@@ -0,0 +1,99 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+import os
+from onnx import TensorProto, helper
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import qonnx_make_model
+
+from finn.util.basic import make_build_dir
+from finn.util.initializer_store import load_model, save_model
+
+
+def make_model():
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, 64])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, 64])
+    nodes = [
+        helper.make_node("MatMul", ["inp", "w0"], ["mid0"]),
+        helper.make_node("MatMul", ["mid0", "w1"], ["mid1"]),
+        helper.make_node("Add", ["mid1", "b"], ["outp"]),
+    ]
+    graph = helper.make_graph(nodes, "initializer_store", [inp], [outp])
+    model = ModelWrapper(qonnx_make_model(graph))
+    w = np.random.rand(64, 64).astype(np.float32)
+    model.set_initializer("w0", w)
+    model.set_initializer("w1", w.copy())
+    model.set_initializer("b", np.random.rand(1, 64).astype(np.float32))
+    return model
+
+
+@pytest.mark.util
+def test_initializer_store():
+    model = make_model()
+    w = model.get_initializer("w0")
+    b = model.get_initializer("b")
+    model_dir = make_build_dir("test_initializer_store_")
+    save_model(model, model_dir + "/step0.onnx")
+    # identical weights are stored once, small tensors stay inline
+    assert len(os.listdir(model_dir + "/blobs")) == 1
+    assert os.path.getsize(model_dir + "/step0.onnx") < w.nbytes
+    # the model in memory is unchanged
+    assert (model.get_initializer("w1") == w).all()
+    model.set_initializer("w1", 2 * w)
+    save_model(model, model_dir + "/step1.onnx")
+    assert len(os.listdir(model_dir + "/blobs")) == 2
+    for load_fxn in [ModelWrapper, load_model]:
+        loaded = load_fxn(model_dir + "/step0.onnx")
+        assert (loaded.get_initializer("w0") == w).all()
+        assert (loaded.get_initializer("w1") == w).all()
+        assert (loaded.get_initializer("b") == b).all()
+        loaded = load_fxn(model_dir + "/step1.onnx")
+        assert (loaded.get_initializer("w1") == 2 * w).all()
+
+
+@pytest.mark.util
+def test_initializer_store_typed_fields():
+    # tensors given in typed fields are stored as blobs too, but stay typed
+    # in the model in memory
+    model = make_model()
+    t = np.random.rand(32, 32).astype(np.float32)
+    typed = helper.make_tensor("t", TensorProto.FLOAT, t.shape, t.flatten().tolist())
+    model.graph.initializer.append(typed)
+    model_dir = make_build_dir("test_initializer_store_typed_")
+    save_model(model, model_dir + "/model.onnx")
+    init = model.graph.initializer[-1]
+    assert not init.HasField("raw_data")
+    assert len(init.float_data) == t.size
+    assert len(init.external_data) == 0
+    assert len(os.listdir(model_dir + "/blobs")) == 2
+    loaded = load_model(model_dir + "/model.onnx")
+    assert (loaded.get_initializer("t") == t).all()
@@ -0,0 +1,135 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import os
+import time
+from onnx import TensorProto, helper
+from qonnx.core.modelwrapper import ModelWrapper
+from qonnx.util.basic import qonnx_make_model
+
+from finn.transformation.fpgadataflow.scheduled_node_local import node_job_key
+from finn.util.basic import make_build_dir
+from finn.util.job_scheduler import Job, JobHistory, JobScheduler, LocalBuildHost
+
+
+def sleep_job(duration):
+    start = time.time()
+    time.sleep(duration)
+    return (start, time.time())
+
+
+def failing_job():
+    raise ValueError("job failure")
+
+
+def make_jobs(durations):
+    return [Job("job%d" % i, sleep_job, (d,), group="sleep") for i, d in enumerate(durations)]
+
+
+@pytest.mark.util
+def test_job_scheduler_longest_first():
+    durations = [0.1, 0.3, 0.2]
+    jobs = make_jobs(durations)
+    history = JobHistory()
+    for job, d in zip(jobs, durations):
+        history.record(job, d, 0)
+    scheduler = JobScheduler([LocalBuildHost("host0", 1, 2**30)], history)
+    intervals = scheduler.run(jobs)
+    # a single slot runs the jobs back to back, longest predicted first
+    start_order = sorted(range(len(jobs)), key=lambda i: intervals[i][0])
+    assert start_order == [1, 2, 0]
+
+
+@pytest.mark.util
+def test_job_scheduler_memory_budget():
+    jobs = make_jobs([0.2] * 3)
+    history = JobHistory()
+    for job in jobs:
+        history.record(job, 0.2, 600)
+    # two slots, but the memory budget only admits one job at a time
+    scheduler = JobScheduler([LocalBuildHost("host0", 2, 1000)], history)
+    intervals = sorted(scheduler.run(jobs))
+    for prev, cur in zip(intervals[:-1], intervals[1:]):
+        assert prev[1] <= cur[0]
+    # a second host runs jobs in parallel again
+    hosts = [LocalBuildHost("host0", 2, 1000), LocalBuildHost("host1", 2, 1000)]
+    intervals = sorted(JobScheduler(hosts, history).run(jobs))
+    assert intervals[1][0] < intervals[0][1]
+
+
+@pytest.mark.util
+def test_job_scheduler_history():
+    history_path = make_build_dir("test_job_history_") + "/job_history.json"
+    jobs = make_jobs([0.1, 0.2])
+    JobScheduler([LocalBuildHost("host0", 2, 2**30)], JobHistory(history_path)).run(jobs)
+    assert os.path.isfile(history_path)
+    history = JobHistory(history_path)
+    runtime, mem = history.predict(jobs[1])
+    assert runtime >= 0.2
+    # jobs without history of their own are predicted from their group
+    runtime, mem = history.predict(Job("job2", sleep_job, group="sleep"))
+    assert runtime is not None
+
+
+@pytest.mark.util
+def test_job_scheduler_failure():
+    jobs = [Job("fail", failing_job)] + make_jobs([0.1])
+    with pytest.raises(Exception, match="job failure"):
+        JobScheduler([LocalBuildHost("host0", 2, 2**30)]).run(jobs)
+
+
+def make_node_model(**attrs):
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, [1, 8])
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, [1, 8])
+    node = helper.make_node(
+        "Thresholding_hls",
+        ["inp"],
+        ["outp"],
+        domain="finn.custom_op.fpgadataflow.hls",
+        backend="fpgadataflow",
+        **attrs,
+    )
+    graph = helper.make_graph([node], "job_key", [inp], [outp])
+    return ModelWrapper(qonnx_make_model(graph))
+
+
+@pytest.mark.util
+def test_node_job_key():
+    def key(**attrs):
+        model = make_node_model(**attrs)
+        return node_job_key("hlssynth", model, model.graph.node[0])
+
+    ref = key(PE=2, exec_mode="", code_gen_dir_ipgen="/tmp/a")
+    # attributes that do not affect the hardware and paths are left out
+    assert key(PE=2, exec_mode="rtlsim", code_gen_dir_ipgen="/tmp/b") == ref
+    assert key(PE=2, exec_mode="", code_gen_dir_ipgen="/tmp/a", res_estimate="{}") == ref
+    assert key(PE=2, exec_mode="", code_gen_dir_ipgen="/tmp/a", cycles_estimate=10) == ref
+    assert key(PE=4, exec_mode="", code_gen_dir_ipgen="/tmp/a") != ref
@@ -0,0 +1,102 @@
+# Copyright (C) 2024, Advanced Micro Devices, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of FINN nor the names of its
+#   contributors may be used to endorse or promote products derived from
+#   this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import pytest
+
+import numpy as np
+import onnxruntime as rt
+from onnx import TensorProto, helper
+from qonnx.core.datatype import DataType
+from qonnx.util.basic import gen_finn_dt_tensor, qonnx_make_model
+
+from finn.util.nhwc_kernels import (
+    maxpool_nhwc,
+    pad_nhwc,
+    pool_windows_nhwc,
+    to_compute_array,
+    upsample_nearest_nhwc,
+)
+
+
+def run_single_node(node, x, oshape, opset=13, extra=None):
+    inp = helper.make_tensor_value_info("inp", TensorProto.FLOAT, x.shape)
+    outp = helper.make_tensor_value_info("outp", TensorProto.FLOAT, oshape)
+    graph = helper.make_graph([node], "single-node-exec", [inp], [outp], initializer=extra)
+    model = qonnx_make_model(graph, opset_imports=[helper.make_opsetid("", opset)])
+    sess = rt.InferenceSession(model.SerializeToString())
+    return sess.run(None, {"inp": x.astype(np.float32)})[0]
+
+
+@pytest.mark.util
+@pytest.mark.parametrize("ifm_dim", [(6, 6), (7, 5), (9, 1)])
+@pytest.mark.parametrize("k", [(2, 2), (3, 3)])
+@pytest.mark.parametrize("ceil_mode", [0, 1])
+def test_maxpool_nhwc(ifm_dim, k, ceil_mode):
+    dt = DataType["INT4"]
+    x = gen_finn_dt_tensor(dt, (2, ifm_dim[0], ifm_dim[1], 3))
+    if ifm_dim[1] == 1:
+        k = (k[0] * k[1], 1)
+    # reference: standard ONNX MaxPool in NCHW layout
+    x_nchw = x.transpose(0, 3, 1, 2)
+    node = helper.make_node(
+        "MaxPool", ["inp"], ["outp"], kernel_shape=k, strides=k, ceil_mode=ceil_mode
+    )
+    odim = [(d - kd + (kd - 1) * ceil_mode) // kd + 1 for (d, kd) in zip(ifm_dim, k)]
+    expected = run_single_node(node, x_nchw, [2, 3] + odim).transpose(0, 2, 3, 1)
+    ret = maxpool_nhwc(to_compute_array(x, dt), k, expected.shape)
+    assert ret.dtype == np.int64
+    assert (ret == expected).all()
+
+
+@pytest.mark.util
+@pytest.mark.parametrize("scales", [(2, 2), (3, 3), (2, 1)])
+def test_upsample_nearest_nhwc(scales):
+    dt = DataType["UINT8"]
+    x = gen_finn_dt_tensor(dt, (1, 4, 4 if scales[1] > 1 else 1, 5))
+    oshape = [1, x.shape[1] * scales[0], x.shape[2] * scales[1], 5]
+    scales_init = helper.make_tensor("scales", TensorProto.FLOAT, [4], [1, *scales, 1])
+    node = helper.make_node("Resize", ["inp", "", "scales"], ["outp"], mode="nearest")
+    expected = run_single_node(node, x, oshape, extra=[scales_init])
+    ret = upsample_nearest_nhwc(to_compute_array(x, dt), scales)
+    assert (ret == expected).all()
+
+
+@pytest.mark.util
+def test_pad_and_pool_windows_nhwc():
+    dt = DataType["INT8"]
+    x = to_compute_array(gen_finn_dt_tensor(dt, (1, 3, 4, 2)), dt)
+    pad = [1, 0, 2, 3]
+    expected = np.pad(x, ((0, 0), (1, 2), (0, 3), (0, 0)))
+    assert (pad_nhwc(x, pad) == expected).all()
+    # four window pixels of two channels each
+    w = x.reshape(1, 3, 1, 8)
+    windows = w.reshape(1, 3, 1, 4, 2)
+    assert (pool_windows_nhwc(w, 4, "MaxPool") == windows.max(axis=3)).all()
+    expected = np.right_shift(windows.sum(axis=3), 2)
+    assert (pool_windows_nhwc(w, 4, "QuantAvgPool", 2) == expected).all()